@@ -22,30 +22,79 @@
 #ifndef EXIT_HANDLER_INTEL_X64_EAPIS_H
 #define EXIT_HANDLER_INTEL_X64_EAPIS_H
 
+#include <map>
+#include <array>
+#include <mutex>
+#include <atomic>
 #include <vector>
+#include <functional>
 
 #include <vmcs/vmcs_intel_x64_eapis.h>
+#include <vmcs/page_merger_intel_x64.h>
+#include <vmcs/page_age_sampler_intel_x64.h>
 #include <vmcs/vmcs_intel_x64_32bit_control_fields.h>
 
 #include <exit_handler/exit_handler_intel_x64.h>
 #include <exit_handler/exit_handler_intel_x64_eapis_verifiers.h>
+#include <exit_handler/io_port_handler_intel_x64.h>
+#include <exit_handler/io_access_log_intel_x64.h>
+#include <exit_handler/msr_handler_intel_x64.h>
+#include <exit_handler/msr_access_log_intel_x64.h>
+#include <exit_handler/exit_stats_intel_x64.h>
+#include <exit_handler/exit_trace_intel_x64.h>
+#include <exit_handler/io_trace_intel_x64.h>
+#include <exit_handler/step_trace_intel_x64.h>
+#include <exit_handler/uart_16550_intel_x64.h>
+
+#include <memory_manager/map_ptr_x64.h>
 
 #include <intrinsics/portio_x64.h>
 
+#ifndef IO_STRING_EMULATION_MAX_BYTES
+#define IO_STRING_EMULATION_MAX_BYTES 0x10000
+#endif
+
+#ifndef MONITOR_TRAP_CALLBACK_QUEUE_SIZE
+#define MONITOR_TRAP_CALLBACK_QUEUE_SIZE 8
+#endif
+
+/// IO Storm Policy
+///
+/// Describes when a trapped port is automatically passed through. A port
+/// that traps threshold times (or more) within a window of TSC ticks is
+/// passed through, and trapped again (re-armed) rearm TSC ticks later. A
+/// threshold of 0 disables the policy, and a rearm of 0 leaves the port
+/// passed through until the policy changes.
+///
+struct io_storm_policy_intel_x64
+{
+    uint64_t threshold = 0;
+    uint64_t window = 0;
+    uint64_t rearm = 0;
+};
+
 class exit_handler_intel_x64_eapis : public exit_handler_intel_x64
 {
 public:
 
     typedef void (exit_handler_intel_x64_eapis::*monitor_trap_callback)();
+    typedef void (exit_handler_intel_x64_eapis::*exit_handler_delegate)();
+    using step_predicate_type = std::function<bool(uintptr_t rip)>;
 
 public:
 
     using count_type = uint64_t;
     using port_type = x64::portio::port_addr_type;
     using port_list_type = std::vector<port_type>;
-    using port_log_type = std::map<port_type, count_type>;
+    using port_log_type = io_access_log_intel_x64::snapshot_type;
+    using msr_type = vmcs_intel_x64_eapis::msr_type;
+    using msr_list_type = vmcs_intel_x64_eapis::msr_list_type;
+    using msr_log_type = msr_access_log_intel_x64::snapshot_type;
     using denial_list_type = std::vector<std::string>;
+    using integer_pointer = uintptr_t;
     using policy_type = std::map<vp::index_type, std::unique_ptr<vmcall_verifier>>;
+    using vmcs_update_type = std::function<void(gsl::not_null<vmcs_intel_x64_eapis *>)>;
+    using io_storm_policy_type = io_storm_policy_intel_x64;
 
     /// Default Constructor
     ///
@@ -59,7 +108,7 @@ public:
     /// @expects
     /// @ensures
     ///
-    ~exit_handler_intel_x64_eapis() override = default;
+    ~exit_handler_intel_x64_eapis() override;
 
     /// Resume
     ///
@@ -70,6 +119,10 @@ public:
     /// eapis_vmcs()->resume();
     /// @endcode
     ///
+    /// Any VMCS updates broadcast by other vCPUs are applied by the VMCS
+    /// right before the guest is entered (see broadcast()), which is also
+    /// the case when the guest is resumed by the base exit handler.
+    ///
     /// @expects
     /// @ensures
     ///
@@ -90,16 +143,89 @@ public:
     ///
     void advance_and_resume();
 
+    /// Max Exit Reasons
+    ///
+    /// The number of basic exit reasons that can be handled by a
+    /// registered exit handler delegate. VM exits with a larger basic exit
+    /// reason are always handled by the base exit handler.
+    ///
+    static constexpr const std::size_t max_exit_reasons = 0x80;
+
+    /// Register Exit Handler
+    ///
+    /// Registers the member function that handles the VM exits with the
+    /// provided basic exit reason, replacing any delegate that was
+    /// previously registered for it (including the EAPIs' own delegates
+    /// for monitor trap flag, IO instruction, EPT violation, RDMSR and
+    /// WRMSR VM exits). This lets features add (or replace) the handling
+    /// of an exit reason without having to override handle_exit().
+    ///
+    /// @note: the delegate must be a member function of the
+    ///     exit_handler (and it's subclasses), and is responsible for
+    ///     resuming the guest.
+    ///
+    /// Example:
+    /// @code
+    ///
+    /// class my_exit_handler : public exit_handler_intel_x64_eapis
+    /// {
+    /// public:
+    ///     void handle_cpuid()
+    ///     { <do awesome stuff here>; this->advance_and_resume(); }
+    /// };
+    ///
+    /// ehlr->register_exit_handler(exit_reason::basic_exit_reason::cpuid, &my_exit_handler::handle_cpuid);
+    ///
+    /// @endcode
+    ///
+    /// @expects reason < max_exit_reasons
+    /// @ensures
+    ///
+    /// @param reason the basic exit reason to handle
+    /// @param handler the function to be called on a VM exit with this reason
+    ///
+    template<class T, typename = typename std::enable_if<std::is_member_function_pointer<T>::value>>
+    void register_exit_handler(intel_x64::vmcs::value_type reason, T handler)
+    { this->set_exit_handler(reason, static_cast<exit_handler_delegate>(handler)); }
+
+    /// Unregister Exit Handler
+    ///
+    /// Removes the delegate that handles the VM exits with the provided
+    /// basic exit reason. These VM exits are handled by the base exit
+    /// handler again.
+    ///
+    /// @code
+    /// ehlr->unregister_exit_handler(exit_reason::basic_exit_reason::cpuid);
+    /// @endcode
+    ///
+    /// @expects reason < max_exit_reasons
+    /// @ensures
+    ///
+    /// @param reason the basic exit reason to stop handling
+    ///
+    void unregister_exit_handler(intel_x64::vmcs::value_type reason)
+    { this->set_exit_handler(reason, nullptr); }
+
     /// Register Monitor Trap
     ///
     /// Registers a callback function that will be called
     /// after the next instruction is executed by the guest
-    /// by setting the monitor trap flag, and storing the
+    /// by setting the monitor trap flag, and queuing the
     /// callback to be called on the next VM exit associated
     /// with the monitor trap flag.
     ///
+    /// Up to MONITOR_TRAP_CALLBACK_QUEUE_SIZE callbacks can be
+    /// queued, and all of them are called (in the order they
+    /// were registered) on the same VM exit, after which the
+    /// guest is resumed. Registering a callback that is already
+    /// queued does nothing. A callback can register itself
+    /// again, in which case it is called on the following
+    /// monitor trap VM exit.
+    ///
     /// @note: the callback must be a member function of the
-    ///     exit_handler (and it's subclasses)
+    ///     exit_handler (and it's subclasses), and should not
+    ///     resume the guest itself. If it does, the callbacks
+    ///     that have not been called yet remain queued.
     ///
     /// Example:
     /// @code
@@ -122,17 +248,14 @@ public:
     ///
     template<class T, typename = typename std::enable_if<std::is_member_function_pointer<T>::value>>
     void register_monitor_trap(T callback)
-    {
-        intel_x64::vmcs::primary_processor_based_vm_execution_controls::monitor_trap_flag::enable();
-        m_monitor_trap_callback = static_cast<monitor_trap_callback>(callback);
-    }
+    { this->queue_monitor_trap_callback(static_cast<monitor_trap_callback>(callback)); }
 
     /// Clear Monitor Trap
     ///
-    /// Clears the monitor trap flag in the VMCS and registers an unhandled
-    /// callback. This is used internally to disabled the monitor trap
-    /// prior to calling a registered callback, but it can be used to
-    /// cancel an existing registered callback.
+    /// Clears the monitor trap flag in the VMCS and removes all of the
+    /// queued callbacks. This can be used to cancel the registered
+    /// callbacks, in which case the next monitor trap VM exit (if any) is
+    /// unhandled.
     ///
     /// @code
     /// ehlr->clear_monitor_trap();
@@ -143,6 +266,64 @@ public:
     ///
     void clear_monitor_trap();
 
+    /// Start Stepping
+    ///
+    /// Single steps the guest using the monitor trap flag, recording the
+    /// guest's RIP (and general purpose registers) after each instruction
+    /// in a trace ring stored in the provided buffer. The monitor trap
+    /// flag stays enabled until budget instructions have been executed,
+    /// or the predicate returns true for the guest's RIP (whichever comes
+    /// first), so each step costs a single VM exit. Stepping never
+    /// allocates, and if the ring is full, the record is dropped (and
+    /// counted) instead.
+    ///
+    /// Monitor trap callbacks can still be registered while stepping, and
+    /// are called on the same VM exits as the stepping engine.
+    ///
+    /// @code
+    /// ehlr->start_stepping(buffer, 1000, [](auto rip) { return rip == 0x1000; });
+    /// @endcode
+    ///
+    /// @expects budget != 0
+    /// @ensures
+    ///
+    /// @param buffer the memory used to store the trace ring
+    /// @param budget the max number of instructions to step
+    /// @param predicate if provided, stepping stops once this returns true
+    ///
+    void start_stepping(gsl::span<uint8_t> buffer, uint64_t budget, step_predicate_type predicate = nullptr);
+
+    /// Stop Stepping
+    ///
+    /// Stops the stepping engine. The records that were already written to
+    /// the trace ring are kept.
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    void stop_stepping();
+
+    /// Is Stepping
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @return true if the stepping engine is active, false otherwise
+    ///
+    bool is_stepping() const noexcept
+    { return m_stepping; }
+
+    /// Step Count
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @return the number of instructions stepped since the last call to
+    ///     start_stepping()
+    ///
+    uint64_t step_count() const noexcept
+    { return m_step_count; }
+
     /// Log IO Access
     ///
     /// Enables / disables IO access logging.
@@ -160,8 +341,8 @@ public:
 
     /// Clear IO Access Log
     ///
-    /// Clears the IO access log. All previously logged IO accesses will be
-    /// removed.
+    /// Clears the IO access log of this vCPU. All previously logged IO
+    /// accesses will be removed.
     ///
     /// @code
     /// ehlr->clear_io_access_log();
@@ -172,14 +353,435 @@ public:
     ///
     void clear_io_access_log();
 
+    /// Log MSR Access
+    ///
+    /// Enables / disables MSR access logging. Only the RDMSR / WRMSR
+    /// instructions that trap (see the MSR bitmaps) are logged.
+    ///
+    /// @code
+    /// ehlr->log_msr_access(true);
+    /// @endcode
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param enable set to true to enable MSR access logging, false otherwise
+    ///
+    void log_msr_access(bool enable);
+
+    /// Clear MSR Access Log
+    ///
+    /// Clears the MSR access log of this vCPU. All previously logged MSR
+    /// accesses will be removed.
+    ///
+    /// @code
+    /// ehlr->clear_msr_access_log();
+    /// @endcode
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    void clear_msr_access_log();
+
+    /// Set IO Storm Policy
+    ///
+    /// Guards against exit storms (e.g. a guest polling a trapped status
+    /// register) by automatically passing through the ports that trap too
+    /// often (see io_storm_policy_intel_x64). The exit rate of each port
+    /// is measured using the IO access log, which is enabled by this
+    /// function if the policy is enabled. Ports that have an IO port
+    /// handler are never passed through. Setting a new policy re-arms
+    /// every port that was passed through by the previous policy. Once
+    /// the policy of a port is changed by a vmcall (e.g.
+    /// pass_through_io_access), that port is no longer re-armed.
+    ///
+    /// @note: when the IO bitmaps are shared, a port is passed through on
+    ///     every vCPU that shares them.
+    ///
+    /// @code
+    /// io_storm_policy_intel_x64 policy;
+    /// policy.threshold = 10000;
+    /// policy.window = 1000000;
+    /// policy.rearm = 1000000000;
+    ///
+    /// ehlr->set_io_storm_policy(policy);
+    /// @endcode
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param policy the policy to use
+    ///
+    void set_io_storm_policy(const io_storm_policy_type &policy);
+
+    /// IO Storm Ports
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @return the list of ports that are currently passed through by the
+    ///     IO storm policy
+    ///
+    port_list_type io_storm_ports() const;
+
+    /// Emulate IO Access
+    ///
+    /// Enables / disables IO access emulation. By default, a trapped IO
+    /// access is executed by the guest itself: the IO bitmaps are disabled,
+    /// and a monitor trap is used to re-enable them once the instruction
+    /// completes (i.e. two VM exits per access). When emulation is enabled,
+    /// trapped IN / OUT instructions are instead executed by the hypervisor
+    /// on behalf of the guest (updating RAX and advancing RIP), so that each
+    /// access costs a single VM exit.
+    ///
+    /// String instructions (INS / OUTS, with or without a REP prefix) are
+    /// emulated by translating the guest's buffer once (through the
+    /// guest's page tables and the EPT), and performing up to
+    /// IO_STRING_EMULATION_MAX_BYTES of the transfer in a single VM exit
+    /// (updating RCX, RSI / RDI). Longer transfers are split into several
+    /// VM exits by letting the guest re-execute the REP instruction.
+    ///
+    /// @note: string instructions with the direction flag set, executed
+    ///     without 4-level or PAE paging, or whose buffer the guest (or the
+    ///     EPT) does not allow the access to (e.g. an INS into a merged or
+    ///     SPP protected page), are still executed by the guest.
+    ///
+    /// @code
+    /// ehlr->emulate_io_access(true);
+    /// @endcode
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param enable set to true to enable IO access emulation, false
+    ///     otherwise
+    ///
+    void emulate_io_access(bool enable);
+
+    /// Emulate UART
+    ///
+    /// Routes the guest's accesses to COM1 (0x3F8 - 0x3FF) to the
+    /// emulated 16550 UART that is shared by all vCPUs (see uart()), so
+    /// that console output is captured using a single VM exit per byte,
+    /// with no status polling. When disabled, the ports are passed through
+    /// to the physical UART again.
+    ///
+    /// @note: the emulation is enabled / disabled on every vCPU, as the
+    ///     ports are trapped in the IO bitmaps that the vCPUs share. The
+    ///     vCPU associated with this exit handler is updated right away,
+    ///     and the other vCPUs at their next VM entry (see broadcast()).
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param enable set to true to enable UART emulation, false otherwise
+    ///
+    void emulate_uart(bool enable);
+
+    /// UART
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @return the emulated UART that is shared by all vCPUs
+    ///
+    static uart_16550_intel_x64 &uart();
+
+    /// Trace IO Access
+    ///
+    /// Records each trapped IO access (TSC, port, direction, size, value
+    /// and RIP) in a trace ring stored in the provided buffer. The buffer
+    /// is usually shared with a consumer in the guest (see the
+    /// trace_io_access vmcall), which drains the ring directly instead of
+    /// going through a vmcall. Recording a trace never allocates, and if
+    /// the ring is full, the record is dropped (and counted) instead.
+    /// Passing an empty buffer stops the trace.
+    ///
+    /// @code
+    /// ehlr->trace_io_access(gsl::span<uint8_t>(buffer.get(), x64::page_size));
+    /// @endcode
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param buffer the memory used to store the trace ring
+    ///
+    void trace_io_access(gsl::span<uint8_t> buffer);
+
+    /// Trace Exits
+    ///
+    /// Records each VM exit (TSC, basic exit reason, exit qualification,
+    /// guest RIP, and the number of TSC ticks spent handling it) in a trace
+    /// ring stored in the provided buffer. Like the IO trace, the buffer is
+    /// usually shared with a consumer in the guest (see the trace_exits
+    /// vmcall) that drains the ring directly. A record is pushed right
+    /// before the guest is entered again, so VM exits that are handled by
+    /// the base exit handler are recorded as well. Recording a VM exit
+    /// never allocates or takes a lock. When the ring is full, new records
+    /// are either dropped or overwrite the oldest records, and are counted
+    /// in the ring's header in both cases. Passing an empty buffer stops
+    /// the trace.
+    ///
+    /// @note: this only affects the vCPU associated with this exit handler
+    ///
+    /// @code
+    /// ehlr->trace_exits(gsl::span<uint8_t>(buffer.get(), x64::page_size), true);
+    /// @endcode
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param buffer the memory used to store the trace ring
+    /// @param overwrite set to true to overwrite the oldest records when
+    ///     the ring is full, false to drop the new records instead
+    ///
+    void trace_exits(gsl::span<uint8_t> buffer, bool overwrite = false);
+
+    /// Broadcast
+    ///
+    /// Applies a VMCS update to the vCPU associated with this exit handler
+    /// right away, and to every other vCPU at its next VM entry. Since a
+    /// VMCS can only be modified by the CPU it is loaded on, the update is
+    /// queued on each of the other vCPUs instead of interrupting them,
+    /// which means that a vCPU that does not exit will not see the update
+    /// until it does.
+    ///
+    /// @code
+    /// ehlr->broadcast([](auto vmcs) { vmcs->enable_vpid(); });
+    /// @endcode
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param update the update to apply to each vCPU's VMCS
+    /// @return the number of vCPUs the update is applied to (including
+    ///     the vCPU associated with this exit handler)
+    ///
+    std::size_t broadcast(const vmcs_update_type &update);
+
+    /// Broadcast INVEPT
+    ///
+    /// Queues a global INVEPT on every vCPU, including the current one,
+    /// which performs it at its next VM entry. The returned ticket counts
+    /// the vCPUs that have yet to perform their INVEPT (a vCPU that is
+    /// destroyed first no longer counts). This is the flush
+    /// delegate that is given to the page merger (see set_page_merger()).
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @return a ticket that reaches 0 once every vCPU has flushed its
+    ///     EPT translations
+    ///
+    static page_merger_intel_x64::flush_ticket_type broadcast_invept();
+
+    /// Register IO Port Handler
+    ///
+    /// Routes guest IN / OUT instructions on the ports [first, last] to
+    /// the provided handler (e.g. an in-VMM device model), and traps on
+    /// access to these ports. The access is emulated in a single VM exit,
+    /// regardless of emulate_io_access(). Registering a handler for a port
+    /// replaces the port's previous handler. Note that the handler is not
+    /// owned by the exit handler.
+    ///
+    /// @code
+    /// ehlr->register_io_port_handler(0x3F8, 0x3FF, g_uart.get());
+    /// @endcode
+    ///
+    /// @expects first <= last
+    /// @ensures
+    ///
+    /// @param first the first port in the range
+    /// @param last the last port in the range (inclusive)
+    /// @param handler the handler to call for each access
+    ///
+    void register_io_port_handler(port_type first, port_type last,
+                                  gsl::not_null<io_port_handler_intel_x64 *> handler);
+
+    /// Unregister IO Port Handler
+    ///
+    /// Removes the handler for the ports [first, last]. The ports remain
+    /// trapped, and fall back to the default IO access behavior (i.e. they
+    /// are passed through to the physical ports).
+    ///
+    /// @code
+    /// ehlr->unregister_io_port_handler(0x3F8, 0x3FF);
+    /// @endcode
+    ///
+    /// @expects first <= last
+    /// @ensures
+    ///
+    /// @param first the first port in the range
+    /// @param last the last port in the range (inclusive)
+    ///
+    void unregister_io_port_handler(port_type first, port_type last);
+
+    /// Register MSR Handler
+    ///
+    /// Routes guest RDMSR / WRMSR instructions on the MSRs [first, last]
+    /// to the provided handler (e.g. an in-VMM model of IA32_TSC_DEADLINE
+    /// or the x2APIC), and traps on reads and writes of these MSRs. The
+    /// access is emulated in a single VM exit, and MSRs without a handler
+    /// fall back to the default RDMSR / WRMSR behavior. Registering a
+    /// handler for an MSR replaces the MSR's previous handler. The range
+    /// must either be within one of the ranges covered by the MSR bitmaps
+    /// ([0x0, 0x1FFF] or [0xC0000000, 0xC0001FFF]), or not overlap them at
+    /// all (these MSRs always trap). The caller keeps ownership of the
+    /// handler, which must stay alive until it is unregistered.
+    ///
+    /// @code
+    /// ehlr->register_msr_handler(0x800, 0x8FF, g_x2apic.get());
+    /// @endcode
+    ///
+    /// @expects first <= last
+    /// @expects [first, last] does not straddle an MSR bitmap range
+    /// @ensures
+    ///
+    /// @param first the first MSR in the range
+    /// @param last the last MSR in the range (inclusive)
+    /// @param handler the handler to call for each access
+    ///
+    void register_msr_handler(msr_type first, msr_type last,
+                              gsl::not_null<msr_handler_intel_x64 *> handler);
+
+    /// Unregister MSR Handler
+    ///
+    /// Removes the handler for the MSRs [first, last]. The MSRs remain
+    /// trapped, and fall back to the default RDMSR / WRMSR behavior.
+    ///
+    /// @code
+    /// ehlr->unregister_msr_handler(0x800, 0x8FF);
+    /// @endcode
+    ///
+    /// @expects first <= last
+    /// @expects [first, last] does not straddle an MSR bitmap range
+    /// @ensures
+    ///
+    /// @param first the first MSR in the range
+    /// @param last the last MSR in the range (inclusive)
+    ///
+    void unregister_msr_handler(msr_type first, msr_type last);
+
+    /// Set Page Merger
+    ///
+    /// Registers the page merger that owns the merged (read-only) pages in
+    /// the extended page tables. EPT violations that are caused by the
+    /// guest writing to a merged page are handled by breaking the sharing
+    /// (copy-on-write), and the faulting instruction is executed again.
+    /// The merger flushes the EPT translations of every vCPU using
+    /// broadcast_invept(), and must outlive each exit handler it is
+    /// registered with.
+    ///
+    /// @code
+    /// ehlr->set_page_merger(g_merger.get());
+    /// @endcode
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param merger the page merger to use, or nullptr to disable
+    ///
+    void set_page_merger(page_merger_intel_x64 *merger)
+    {
+        if (merger != nullptr)
+            merger->set_flush_delegate(&exit_handler_intel_x64_eapis::broadcast_invept);
+
+        m_page_merger = merger;
+    }
+
+    /// Set Page Age Sampler
+    ///
+    /// Registers the page age sampler that is used by the page age vmcalls
+    /// (i.e. sample_page_ages, page_age_histogram and cold_ranges). The
+    /// same sampler can be given to every vCPU, as it serializes access to
+    /// its tables, in which case any vCPU can drive it. The sampler flushes
+    /// the EPT translations of every vCPU using broadcast_invept().
+    ///
+    /// @code
+    /// ehlr->set_page_age_sampler(g_sampler.get());
+    /// @endcode
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param sampler the page age sampler to use, or nullptr to disable
+    ///
+    void set_page_age_sampler(page_age_sampler_intel_x64 *sampler)
+    {
+        if (sampler != nullptr)
+            sampler->set_flush_delegate(&exit_handler_intel_x64_eapis::broadcast_invept);
+
+        m_page_age_sampler = sampler;
+    }
+
 protected:
 
     void handle_exit(intel_x64::vmcs::value_type reason) override;
 
+    virtual integer_pointer io_string_gla_to_hpa(integer_pointer gla, bool write);
+    virtual gsl::span<uint8_t> map_io_string_buffer(integer_pointer hpa, std::size_t size);
+
 private:
 
+    void set_exit_handler(intel_x64::vmcs::value_type reason, exit_handler_delegate handler);
+    std::array<exit_handler_delegate, max_exit_reasons> m_exit_handlers;
+
+    // The time spent handling a VM exit is measured from the start of
+    // handle_exit() until the next VM entry (see vm_entry()), or until
+    // handle_exit() returns, whichever comes first. Since vm_entry() is
+    // called by the VMCS right before the guest is resumed, VM exits that
+    // are handled by the base exit handler are recorded as well.
+
+    void begin_exit(intel_x64::vmcs::value_type reason)
+    {
+        if (!ENABLE_EXIT_STATS && !m_exit_trace)
+            return;
+
+        m_exit_reason = reason;
+        m_exit_tsc = trace_ring_timestamp();
+
+        if (m_exit_trace)
+            this->begin_exit_trace();
+    }
+
+    void end_exit() noexcept
+    {
+        if (m_exit_tsc == 0)
+            return;
+
+        auto &&ticks = trace_ring_timestamp() - m_exit_tsc;
+
+#if ENABLE_EXIT_STATS
+        m_exit_stats.record(m_exit_reason, ticks);
+#endif
+
+        if (m_exit_trace_pending)
+            this->end_exit_trace(ticks);
+
+        m_exit_tsc = 0;
+    }
+
+    void begin_exit_trace();
+    void end_exit_trace(uint64_t ticks) noexcept;
+
+    uint64_t m_exit_tsc;
+    intel_x64::vmcs::value_type m_exit_reason;
+
+#if ENABLE_EXIT_STATS
+    exit_stats_intel_x64 m_exit_stats;
+#endif
+
+    bool m_exit_trace_pending;
+    exit_trace_record_intel_x64 m_exit_trace_record;
+    std::unique_ptr<exit_trace_intel_x64> m_exit_trace;
+    bfn::unique_map_ptr_x64<uint8_t> m_exit_trace_map;
+    integer_pointer m_exit_trace_gpa;
+
     void handle_exit__monitor_trap_flag();
     void handle_exit__io_instruction();
+    void handle_exit__ept_violation();
+    void handle_exit__rdmsr();
+    void handle_exit__wrmsr();
 
 protected:
 
@@ -190,10 +792,14 @@ private:
 
     void handle_vmcall_registers__io_instruction(vmcall_registers_t &regs);
     void handle_vmcall_registers__vpid(vmcall_registers_t &regs);
+    void handle_vmcall_registers__msr(vmcall_registers_t &regs);
 
     bool handle_vmcall_json__verifiers(const json &ijson, json &ojson);
     bool handle_vmcall_json__io_instruction(const json &ijson, json &ojson);
     bool handle_vmcall_json__vpid(const json &ijson, json &ojson);
+    bool handle_vmcall_json__page_age(const json &ijson, json &ojson);
+    bool handle_vmcall_json__msr(const json &ijson, json &ojson);
+    bool handle_vmcall_json__exit_stats(const json &ijson, json &ojson);
 
 private:
 
@@ -209,25 +815,207 @@ private:
     void handle_vmcall__pass_through_all_io_accesses();
     void handle_vmcall__whitelist_io_access(const port_list_type &ports);
     void handle_vmcall__blacklist_io_access(const port_list_type &ports);
+    void handle_vmcall__trap_on_io_range(port_type first, port_type last);
+    void handle_vmcall__pass_through_io_range(port_type first, port_type last);
+    void handle_vmcall__share_io_bitmaps(bool enabled);
     void handle_vmcall__log_io_access(bool enabled);
     void handle_vmcall__clear_io_access_log();
     void handle_vmcall__io_access_log(json &ojson);
+    void handle_vmcall__trace_io_access(integer_pointer gpa);
+    void handle_vmcall__io_storm_policy(const io_storm_policy_type &storm);
+    void handle_vmcall__io_storms(json &ojson);
+    void handle_vmcall__emulate_uart(bool enabled);
+    void handle_vmcall__uart_output(json &ojson);
 
 private:
 
     void handle_vmcall__enable_vpid(bool enabled);
 
+private:
+
+    void handle_vmcall__sample_page_ages();
+    void handle_vmcall__page_age_histogram(json &ojson);
+    void handle_vmcall__cold_ranges(page_age_sampler_intel_x64::size_type count, json &ojson);
+
+    page_age_sampler_intel_x64 *page_age_sampler();
+
+private:
+
+    void handle_vmcall__trap_on_rdmsr_access(msr_type msr);
+    void handle_vmcall__trap_on_wrmsr_access(msr_type msr);
+    void handle_vmcall__trap_on_all_rdmsr_accesses();
+    void handle_vmcall__trap_on_all_wrmsr_accesses();
+    void handle_vmcall__pass_through_rdmsr_access(msr_type msr);
+    void handle_vmcall__pass_through_wrmsr_access(msr_type msr);
+    void handle_vmcall__pass_through_all_rdmsr_accesses();
+    void handle_vmcall__pass_through_all_wrmsr_accesses();
+    void handle_vmcall__whitelist_rdmsr_access(const msr_list_type &msrs);
+    void handle_vmcall__whitelist_wrmsr_access(const msr_list_type &msrs);
+    void handle_vmcall__blacklist_rdmsr_access(const msr_list_type &msrs);
+    void handle_vmcall__blacklist_wrmsr_access(const msr_list_type &msrs);
+    void handle_vmcall__log_msr_access(bool enabled);
+    void handle_vmcall__clear_msr_access_log();
+    void handle_vmcall__msr_access_log(json &ojson);
+
+private:
+
+#if ENABLE_EXIT_STATS
+    void handle_vmcall__exit_stats(json &ojson);
+    void handle_vmcall__clear_exit_stats();
+#endif
+    void handle_vmcall__trace_exits(integer_pointer gpa, bool overwrite);
+
+private:
+
+    template<class F>
+    void update_vmcs(F &&update)
+    {
+        if (m_broadcast)
+            this->broadcast(update);
+        else
+            update(eapis_vmcs());
+    }
+
+    void apply_pending_vmcs_updates();
+
+    // Installed as the VMCS's entry delegate the first time the VMCS is
+    // resolved (see eapis_vmcs()), so that it runs on every VM entry, no
+    // matter which exit handler resumes the guest.
+
+    void vm_entry();
+
+    static std::size_t queue_vmcs_update(const vmcs_update_type &update, exit_handler_intel_x64_eapis *skip);
+    void push_vmcs_update(const vmcs_update_type &update);
+
+    // INVEPT requests are queued as flush tickets rather than as VMCS
+    // updates, so that a vCPU that goes away before its next VM entry can
+    // still release its share of each ticket (see the destructor).
+
+    void push_invept(const page_merger_intel_x64::flush_ticket_type &ticket);
+    void release_invept_tickets(std::vector<page_merger_intel_x64::flush_ticket_type> &tickets) noexcept;
+
+    // Same as broadcast(), but for state that belongs to the exit handler
+    // itself (e.g. the IO port handlers). The update rides along with the
+    // VMCS updates, so each vCPU applies it to its own exit handler.
+
+    using exit_handler_update_type = std::function<void(gsl::not_null<exit_handler_intel_x64_eapis *>)>;
+    void broadcast_exit_handler_update(const exit_handler_update_type &update);
+
+    static std::mutex &registry_mutex();
+    static std::vector<exit_handler_intel_x64_eapis *> &registry();
+
+    bool m_broadcast;
+
+    std::mutex m_vmcs_updates_mutex;
+    std::atomic<bool> m_vmcs_updates_pending;
+    std::vector<vmcs_update_type> m_vmcs_updates;
+    std::vector<page_merger_intel_x64::flush_ticket_type> m_invept_tickets;
+
 private:
 
     void unhandled_monitor_trap_callback();
-    monitor_trap_callback m_monitor_trap_callback;
+    void queue_monitor_trap_callback(monitor_trap_callback callback);
+    monitor_trap_callback dequeue_monitor_trap_callback();
+
+    std::size_t m_monitor_trap_callback_count;
+    std::array<monitor_trap_callback, MONITOR_TRAP_CALLBACK_QUEUE_SIZE> m_monitor_trap_callbacks;
+
+private:
+
+    void step();
+
+    bool m_stepping;
+    uint64_t m_step_budget;
+    uint64_t m_step_count;
+    step_predicate_type m_step_predicate;
+    std::unique_ptr<step_trace_intel_x64> m_step_trace;
 
 private:
 
     void trap_on_io_access_callback();
+    void emulate_io_instruction();
+
+    bool emulate_io_string_instruction(bool &done);
+    void transfer_io_string(port_type port, std::size_t size, bool in, gsl::span<uint8_t> buffer);
 
-    bool m_io_access_log_enabled;
-    port_log_type m_io_access_log;
+    integer_pointer gla_to_gpa(integer_pointer gla, bool write);
+    uint64_t read_guest_qword(integer_pointer gpa);
+
+    void record_io_trace(bool has_value);
+
+    io_port_handler_intel_x64 *io_port_handler(port_type port) const noexcept;
+
+    void emulate_uart_on_this_vcpu(bool enable);
+
+    void check_io_storm(port_type port);
+    void rearm_io_storms();
+    void forget_io_storms(port_type first = 0x0000, port_type last = 0xFFFF);
+
+    struct io_storm_window_type
+    {
+        uint64_t start;
+        count_type base;
+    };
+
+    io_storm_policy_type m_io_storm_policy;
+    std::map<port_type, io_storm_window_type> m_io_storm_windows;
+    std::map<port_type, uint64_t> m_io_storm_ports;
+
+    bool m_io_access_emulation_enabled;
+    io_access_log_intel_x64 m_io_access_log;
+
+    bool m_io_trace_pending;
+    io_trace_record_intel_x64 m_io_trace_record;
+    std::unique_ptr<io_trace_intel_x64> m_io_trace;
+    bfn::unique_map_ptr_x64<uint8_t> m_io_trace_map;
+    integer_pointer m_io_trace_gpa;
+    bfn::unique_map_ptr_x64<uint8_t> m_io_string_map;
+    std::vector<uint8_t> m_io_string_buffer;
+
+    // The IO port handlers are stored in a two level table indexed by the
+    // upper and lower byte of the port. Second level tables are only
+    // allocated for the ranges of ports that have a handler.
+    using io_port_handler_table_type = std::array<io_port_handler_intel_x64 *, 0x100>;
+    std::array<std::unique_ptr<io_port_handler_table_type>, 0x100> m_io_port_handlers;
+
+private:
+
+    msr_handler_intel_x64 *msr_handler(msr_type msr) const;
+
+    msr_access_log_intel_x64 m_msr_access_log;
+
+    // The handlers of the MSRs covered by the MSR bitmaps (i.e. [0x0,
+    // 0x1FFF] and [0xC0000000, 0xC0001FFF]) are stored in a two level
+    // table, the same way the IO port handlers are, so that the lookup
+    // on each RDMSR / WRMSR exit is O(1) and lock free. Handlers for any
+    // other MSR are stored by range, keyed by the first MSR of the range,
+    // so that a large range (e.g. the hypervisor MSRs) is a single entry.
+    using msr_handler_table_type = std::array<msr_handler_intel_x64 *, 0x100>;
+    std::array<std::unique_ptr<msr_handler_table_type>, 0x40> m_msr_handlers;
+
+    struct msr_handler_range_type
+    {
+        msr_type last;
+        msr_handler_intel_x64 *handler;
+    };
+
+    void erase_msr_handler_ranges(msr_type first, msr_type last);
+    std::map<msr_type, msr_handler_range_type> m_msr_handlers_other;
+
+private:
+
+    // Guest pages that the VMM accesses on the guest's behalf are resolved
+    // through the EPT, so that the guest cannot reach a frame that it is
+    // not allowed to access itself (e.g. a merged or SPP protected page).
+    // Pages that the VMM keeps mapped (e.g. the trace rings) are pinned so
+    // that the page merger never shares them.
+
+    integer_pointer gpa_to_hpa(integer_pointer gpa, bool write);
+    bfn::unique_map_ptr_x64<uint8_t> map_guest_page(integer_pointer gpa);
+    void unpin_guest_page(integer_pointer gpa);
+
+    page_merger_intel_x64 *m_page_merger;
+    page_age_sampler_intel_x64 *m_page_age_sampler;
 
 private:
 
@@ -253,8 +1041,13 @@ public:
     auto eapis_vmcs()
     {
         if (m_vmcs_eapis == nullptr)
+        {
             m_vmcs_eapis = dynamic_cast<vmcs_intel_x64_eapis *>(m_vmcs);
 
+            if (m_vmcs_eapis != nullptr)
+                m_vmcs_eapis->set_entry_delegate([this] { this->vm_entry(); });
+        }
+
         return m_vmcs_eapis;
     }
 
@@ -0,0 +1,62 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef EXIT_HANDLER_INTEL_X64_EAPIS_EXIT_STATS_VERIFIERS_H
+#define EXIT_HANDLER_INTEL_X64_EAPIS_EXIT_STATS_VERIFIERS_H
+
+#include <exit_handler/exit_handler_intel_x64_eapis.h>
+#include <exit_handler/exit_handler_intel_x64_eapis_verifiers.h>
+
+#if ENABLE_EXIT_STATS
+
+class default_verifier__exit_stats : public vmcall_verifier
+{
+public:
+    default_verifier__exit_stats() = default;
+    ~default_verifier__exit_stats() override = default;
+
+    verifier_result verify()
+    { return default_verify(); }
+};
+
+class default_verifier__clear_exit_stats : public vmcall_verifier
+{
+public:
+    default_verifier__clear_exit_stats() = default;
+    ~default_verifier__clear_exit_stats() override = default;
+
+    verifier_result verify()
+    { return default_verify(); }
+};
+
+#endif
+
+class default_verifier__trace_exits : public vmcall_verifier
+{
+public:
+    default_verifier__trace_exits() = default;
+    ~default_verifier__trace_exits() override = default;
+
+    verifier_result verify(exit_handler_intel_x64_eapis::integer_pointer gpa, bool overwrite)
+    { (void) gpa; (void) overwrite; return default_verify(); }
+};
+
+#endif
@@ -115,4 +115,86 @@ public:
     { return default_verify(); }
 };
 
+class default_verifier__trace_io_access : public vmcall_verifier
+{
+public:
+    default_verifier__trace_io_access() = default;
+    ~default_verifier__trace_io_access() override = default;
+
+    verifier_result verify(exit_handler_intel_x64_eapis::integer_pointer gpa)
+    { (void) gpa; return default_verify(); }
+};
+
+class default_verifier__trap_on_io_range : public vmcall_verifier
+{
+public:
+    default_verifier__trap_on_io_range() = default;
+    ~default_verifier__trap_on_io_range() override = default;
+
+    verifier_result verify(exit_handler_intel_x64_eapis::port_type first,
+                           exit_handler_intel_x64_eapis::port_type last)
+    { (void) first; (void) last; return default_verify(); }
+};
+
+class default_verifier__pass_through_io_range : public vmcall_verifier
+{
+public:
+    default_verifier__pass_through_io_range() = default;
+    ~default_verifier__pass_through_io_range() override = default;
+
+    verifier_result verify(exit_handler_intel_x64_eapis::port_type first,
+                           exit_handler_intel_x64_eapis::port_type last)
+    { (void) first; (void) last; return default_verify(); }
+};
+
+class default_verifier__share_io_bitmaps : public vmcall_verifier
+{
+public:
+    default_verifier__share_io_bitmaps() = default;
+    ~default_verifier__share_io_bitmaps() override = default;
+
+    verifier_result verify(bool enabled)
+    { (void) enabled; return default_verify(); }
+};
+
+class default_verifier__io_storm_policy : public vmcall_verifier
+{
+public:
+    default_verifier__io_storm_policy() = default;
+    ~default_verifier__io_storm_policy() override = default;
+
+    verifier_result verify(const exit_handler_intel_x64_eapis::io_storm_policy_type &policy)
+    { (void) policy; return default_verify(); }
+};
+
+class default_verifier__io_storms : public vmcall_verifier
+{
+public:
+    default_verifier__io_storms() = default;
+    ~default_verifier__io_storms() override = default;
+
+    verifier_result verify()
+    { return default_verify(); }
+};
+
+class default_verifier__emulate_uart : public vmcall_verifier
+{
+public:
+    default_verifier__emulate_uart() = default;
+    ~default_verifier__emulate_uart() override = default;
+
+    verifier_result verify(bool enabled)
+    { (void) enabled; return default_verify(); }
+};
+
+class default_verifier__uart_output : public vmcall_verifier
+{
+public:
+    default_verifier__uart_output() = default;
+    ~default_verifier__uart_output() override = default;
+
+    verifier_result verify()
+    { return default_verify(); }
+};
+
 #endif
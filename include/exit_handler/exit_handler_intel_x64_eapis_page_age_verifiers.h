@@ -0,0 +1,58 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef EXIT_HANDLER_INTEL_X64_EAPIS_PAGE_AGE_VERIFIERS_H
+#define EXIT_HANDLER_INTEL_X64_EAPIS_PAGE_AGE_VERIFIERS_H
+
+#include <exit_handler/exit_handler_intel_x64_eapis.h>
+#include <exit_handler/exit_handler_intel_x64_eapis_verifiers.h>
+
+class default_verifier__sample_page_ages : public vmcall_verifier
+{
+public:
+    default_verifier__sample_page_ages() = default;
+    ~default_verifier__sample_page_ages() override = default;
+
+    verifier_result verify()
+    { return default_verify(); }
+};
+
+class default_verifier__page_age_histogram : public vmcall_verifier
+{
+public:
+    default_verifier__page_age_histogram() = default;
+    ~default_verifier__page_age_histogram() override = default;
+
+    verifier_result verify()
+    { return default_verify(); }
+};
+
+class default_verifier__cold_ranges : public vmcall_verifier
+{
+public:
+    default_verifier__cold_ranges() = default;
+    ~default_verifier__cold_ranges() override = default;
+
+    verifier_result verify(page_age_sampler_intel_x64::size_type count)
+    { (void) count; return default_verify(); }
+};
+
+#endif
@@ -99,9 +99,41 @@ constexpr const auto index_blacklist_io_access                 = 0x0001006UL;
 constexpr const auto index_log_io_access                       = 0x0001007UL;
 constexpr const auto index_clear_io_access_log                 = 0x0001008UL;
 constexpr const auto index_io_access_log                       = 0x0001009UL;
+constexpr const auto index_trace_io_access                     = 0x000100AUL;
+constexpr const auto index_trap_on_io_range                    = 0x000100BUL;
+constexpr const auto index_pass_through_io_range               = 0x000100CUL;
+constexpr const auto index_share_io_bitmaps                    = 0x000100DUL;
+constexpr const auto index_io_storm_policy                     = 0x000100EUL;
+constexpr const auto index_io_storms                           = 0x000100FUL;
+constexpr const auto index_emulate_uart                        = 0x0001010UL;
+constexpr const auto index_uart_output                         = 0x0001011UL;
 
 constexpr const auto index_enable_vpid                         = 0x0002001UL;
 
+constexpr const auto index_sample_page_ages                    = 0x0003001UL;
+constexpr const auto index_page_age_histogram                  = 0x0003002UL;
+constexpr const auto index_cold_ranges                         = 0x0003003UL;
+
+constexpr const auto index_trap_on_rdmsr_access                = 0x0004001UL;
+constexpr const auto index_trap_on_wrmsr_access                = 0x0004002UL;
+constexpr const auto index_trap_on_all_rdmsr_accesses          = 0x0004003UL;
+constexpr const auto index_trap_on_all_wrmsr_accesses          = 0x0004004UL;
+constexpr const auto index_pass_through_rdmsr_access           = 0x0004005UL;
+constexpr const auto index_pass_through_wrmsr_access           = 0x0004006UL;
+constexpr const auto index_pass_through_all_rdmsr_accesses     = 0x0004007UL;
+constexpr const auto index_pass_through_all_wrmsr_accesses     = 0x0004008UL;
+constexpr const auto index_whitelist_rdmsr_access              = 0x0004009UL;
+constexpr const auto index_whitelist_wrmsr_access              = 0x000400AUL;
+constexpr const auto index_blacklist_rdmsr_access              = 0x000400BUL;
+constexpr const auto index_blacklist_wrmsr_access              = 0x000400CUL;
+constexpr const auto index_log_msr_access                      = 0x000400DUL;
+constexpr const auto index_clear_msr_access_log                = 0x000400EUL;
+constexpr const auto index_msr_access_log                      = 0x000400FUL;
+
+constexpr const auto index_exit_stats                          = 0x0005001UL;
+constexpr const auto index_clear_exit_stats                    = 0x0005002UL;
+constexpr const auto index_trace_exits                         = 0x0005003UL;
+
 }
 
 #define policy(a) \
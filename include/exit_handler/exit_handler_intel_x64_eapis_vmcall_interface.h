@@ -36,6 +36,7 @@ enum eapis_vmcall_categories
 {
     eapis_cat__io_instruction = 0x1000,
     eapis_cat__vpid = 0x2000,
+    eapis_cat__msr = 0x3000,
 };
 
 /*
@@ -50,6 +51,15 @@ enum eapis_vmcall_functions
 
     eapis_fun__enable_vpid = 0x1,
     eapis_fun__disable_vpid = 0x2,
+
+    eapis_fun__trap_on_rdmsr_access = 0x1,
+    eapis_fun__trap_on_wrmsr_access = 0x2,
+    eapis_fun__trap_on_all_rdmsr_accesses = 0x3,
+    eapis_fun__trap_on_all_wrmsr_accesses = 0x4,
+    eapis_fun__pass_through_rdmsr_access = 0x5,
+    eapis_fun__pass_through_wrmsr_access = 0x6,
+    eapis_fun__pass_through_all_rdmsr_accesses = 0x7,
+    eapis_fun__pass_through_all_wrmsr_accesses = 0x8,
 };
 
 /**
@@ -57,6 +67,16 @@ enum eapis_vmcall_functions
  *
  * @tableofcontents
  *
+ * @section broadcast Broadcast
+ *
+ * The JSON based vmcalls that change the VMCS of the vCPU that executes
+ * the vmcall (IO instruction, VPID and MSR "set" vmcalls) accept an optional
+ * <b>"broadcast": true</b>, in which case the change is applied to the
+ * calling vCPU right away, and to every other vCPU at its next VM entry.
+ * For example:
+ *
+ * <b>{"set":"vpid", "enabled": true, "broadcast": true}</b>
+ *
  * @section vmcall_denials VMCall Denials
  *
  * @subsection vmcall_denials_register Register Based VMCalls
@@ -77,6 +97,11 @@ enum eapis_vmcall_functions
  *
  * @section io_instruction IO Instruction
  *
+ * @note By default, each vCPU shares the same IO bitmaps, in which case the
+ * vmcalls that trap / pass through ports update the policy of each vCPU
+ * that shares the bitmaps (i.e. the whole VM). Use share_io_bitmaps to
+ * give a vCPU its own policy.
+ *
  * @subsection io_instruction_register Register Based VMCalls
  *
  * <b>trap_on_io_access</b>:
@@ -111,6 +136,14 @@ enum eapis_vmcall_functions
  * <b>{"set":"pass_through_io_access", "port_hex": "hex"}</b>:
  * Instructs the hypervisor to pass through the provided port
  *
+ * <b>{"set":"trap_on_io_range", "first": dec, "last": dec}</b>:
+ * <b>{"set":"trap_on_io_range", "first_hex": "hex", "last_hex": "hex"}</b>:
+ * Instructs the hypervisor to trap on each port in [first, last]
+ *
+ * <b>{"set":"pass_through_io_range", "first": dec, "last": dec}</b>:
+ * <b>{"set":"pass_through_io_range", "first_hex": "hex", "last_hex": "hex"}</b>:
+ * Instructs the hypervisor to pass through each port in [first, last]
+ *
  * <b>{"set":"whitelist_io_access", "ports": [dec]}</b>:
  * <b>{"set":"whitelist_io_access", "ports_hex": ["hex"]}</b>:
  * Instructs the hypervisor to trap on all ports minus the ports provided
@@ -119,14 +152,52 @@ enum eapis_vmcall_functions
  * <b>{"set":"blacklist_io_access", "ports_hex": ["hex"]}</b>:
  * Instructs the hypervisor to pass through all ports minus the ports provided
  *
+ * <b>{"set":"share_io_bitmaps", "enabled": true/false}</b>:
+ * Instructs the hypervisor to use the shared IO bitmaps on this vCPU (the
+ * default), or to give this vCPU a private copy of the IO bitmaps the
+ * next time its policy is changed
+ *
  * <b>{"set":"log_io_access", "enabled": true/false}</b>:
  * Instructs the hypervisor to log trapped IO access
  *
  * <b>{"run":"clear_io_access_log"}</b>:
- * Clears logged IO accesses
+ * Clears logged IO accesses (on all vCPUs)
  *
  * <b>{"get":"io_access_log"}</b>:
- * Returns the list of logged IO accesses
+ * Returns the list of logged IO accesses, summed over all vCPUs
+ *
+ * <b>{"set":"trace_io_access", "gpa": dec}</b>:
+ * <b>{"set":"trace_io_access", "gpa_hex": "hex"}</b>:
+ * Instructs the hypervisor to record each trapped IO access in a trace ring
+ * stored in the provided (page aligned) page, or to stop tracing if the gpa
+ * is 0. The page starts with a header (magic "TRCE", record size, capacity,
+ * head, tail, number of dropped records, overwrite mode and number of
+ * overwritten records, see trace_ring_intel_x64), and is followed by 24
+ * byte io_trace_record_intel_x64 records. The hypervisor
+ * advances the head, and the guest consumes records by advancing the tail.
+ * Records are dropped (and counted) if the ring is full. The page must be
+ * mapped writable in the EPT, and must not be merged or SPP protected. It
+ * is excluded from page merging until tracing stops.
+ *
+ * <b>{"set":"io_storm_policy", "threshold": dec, "window": dec, "rearm": dec}</b>:
+ * <b>{"set":"io_storm_policy", "threshold_hex": "hex", "window_hex": "hex", "rearm_hex": "hex"}</b>:
+ * Instructs the hypervisor to pass through any port (without an IO port
+ * handler) that traps threshold times within window TSC ticks, and to trap
+ * it again rearm TSC ticks later (never if rearm is 0). A threshold of 0
+ * disables the policy. Ports passed through by a previous policy are
+ * trapped again. The policy is per vCPU, and enables the IO access log.
+ *
+ * <b>{"get":"io_storms"}</b>:
+ * Returns the list of ports that are currently passed through by the IO
+ * storm policy of this vCPU
+ *
+ * <b>{"set":"emulate_uart", "enabled": true/false}</b>:
+ * Instructs the hypervisor to emulate the 16550 UART at COM1 (0x3F8) on
+ * this vCPU, capturing the guest's console output in a VMM side buffer
+ * that is shared by all vCPUs
+ *
+ * <b>{"get":"uart_output"}</b>:
+ * Returns (and clears) the console output captured by the emulated UART
  *
  *
  *
@@ -149,6 +220,167 @@ enum eapis_vmcall_functions
  * <b>{"set":"vpid", "enabled": true/false}</b>:
  * Instructs the hypervisor to enable/disable vpid
  *
+ *
+ *
+ * @section msr MSR
+ *
+ * @note MSRs that are not covered by the MSR bitmaps (i.e. outside of
+ * [0x0, 0x1FFF] and [0xC0000000, 0xC0001FFF]) always trap, and cannot be
+ * passed through. By default, every MSR access traps.
+ *
+ * @subsection msr_register Register Based VMCalls
+ *
+ * <b>trap_on_rdmsr_access</b>:
+ * Instructs the hypervisor to trap on reads from the provided MSR
+ * - r02 = eapis_cat__msr
+ * - r03 = eapis_fun__trap_on_rdmsr_access
+ * - r04 = msr #
+ *
+ * <b>trap_on_wrmsr_access</b>:
+ * Instructs the hypervisor to trap on writes to the provided MSR
+ * - r02 = eapis_cat__msr
+ * - r03 = eapis_fun__trap_on_wrmsr_access
+ * - r04 = msr #
+ *
+ * <b>trap_on_all_rdmsr_accesses</b>:
+ * Instructs the hypervisor to trap on reads from all MSRs
+ * - r02 = eapis_cat__msr
+ * - r03 = eapis_fun__trap_on_all_rdmsr_accesses
+ *
+ * <b>trap_on_all_wrmsr_accesses</b>:
+ * Instructs the hypervisor to trap on writes to all MSRs
+ * - r02 = eapis_cat__msr
+ * - r03 = eapis_fun__trap_on_all_wrmsr_accesses
+ *
+ * <b>pass_through_rdmsr_access</b>:
+ * Instructs the hypervisor to pass through reads from the provided MSR
+ * - r02 = eapis_cat__msr
+ * - r03 = eapis_fun__pass_through_rdmsr_access
+ * - r04 = msr #
+ *
+ * <b>pass_through_wrmsr_access</b>:
+ * Instructs the hypervisor to pass through writes to the provided MSR
+ * - r02 = eapis_cat__msr
+ * - r03 = eapis_fun__pass_through_wrmsr_access
+ * - r04 = msr #
+ *
+ * <b>pass_through_all_rdmsr_accesses</b>:
+ * Instructs the hypervisor to pass through reads from all MSRs
+ * - r02 = eapis_cat__msr
+ * - r03 = eapis_fun__pass_through_all_rdmsr_accesses
+ *
+ * <b>pass_through_all_wrmsr_accesses</b>:
+ * Instructs the hypervisor to pass through writes to all MSRs
+ * - r02 = eapis_cat__msr
+ * - r03 = eapis_fun__pass_through_all_wrmsr_accesses
+ *
+ * @subsection msr_json JSON Based VMCalls
+ *
+ * <b>{"set":"trap_on_rdmsr_access", "msr": dec}</b>:
+ * <b>{"set":"trap_on_rdmsr_access", "msr_hex": "hex"}</b>:
+ * Instructs the hypervisor to trap on reads from the provided MSR
+ *
+ * <b>{"set":"trap_on_wrmsr_access", "msr": dec}</b>:
+ * <b>{"set":"trap_on_wrmsr_access", "msr_hex": "hex"}</b>:
+ * Instructs the hypervisor to trap on writes to the provided MSR
+ *
+ * <b>{"set":"pass_through_rdmsr_access", "msr": dec}</b>:
+ * <b>{"set":"pass_through_rdmsr_access", "msr_hex": "hex"}</b>:
+ * Instructs the hypervisor to pass through reads from the provided MSR
+ *
+ * <b>{"set":"pass_through_wrmsr_access", "msr": dec}</b>:
+ * <b>{"set":"pass_through_wrmsr_access", "msr_hex": "hex"}</b>:
+ * Instructs the hypervisor to pass through writes to the provided MSR
+ *
+ * <b>{"set":"whitelist_rdmsr_access", "msrs": [dec]}</b>:
+ * <b>{"set":"whitelist_rdmsr_access", "msrs_hex": ["hex"]}</b>:
+ * Instructs the hypervisor to trap on reads from all MSRs minus the MSRs
+ * provided
+ *
+ * <b>{"set":"whitelist_wrmsr_access", "msrs": [dec]}</b>:
+ * <b>{"set":"whitelist_wrmsr_access", "msrs_hex": ["hex"]}</b>:
+ * Instructs the hypervisor to trap on writes to all MSRs minus the MSRs
+ * provided
+ *
+ * <b>{"set":"blacklist_rdmsr_access", "msrs": [dec]}</b>:
+ * <b>{"set":"blacklist_rdmsr_access", "msrs_hex": ["hex"]}</b>:
+ * Instructs the hypervisor to pass through reads from all MSRs minus the
+ * MSRs provided
+ *
+ * <b>{"set":"blacklist_wrmsr_access", "msrs": [dec]}</b>:
+ * <b>{"set":"blacklist_wrmsr_access", "msrs_hex": ["hex"]}</b>:
+ * Instructs the hypervisor to pass through writes to all MSRs minus the
+ * MSRs provided
+ *
+ * <b>{"set":"log_msr_access", "enabled": true/false}</b>:
+ * Instructs the hypervisor to log trapped MSR access
+ *
+ * <b>{"run":"clear_msr_access_log"}</b>:
+ * Clears logged MSR accesses (on all vCPUs)
+ *
+ * <b>{"get":"msr_access_log"}</b>:
+ * Returns the list of logged MSR accesses, summed over all vCPUs. Accesses
+ * to MSRs that are not covered by the MSR bitmaps are reported as MSR
+ * 0xFFFFFFFF
+ *
+ *
+ *
+ * @section page_age Page Age
+ *
+ * @subsection page_age_register Register Based VMCalls
+ * There are no register based vmcalls for page ages
+ *
+ * @subsection page_age_json JSON Based VMCalls
+ *
+ * <b>{"run":"sample_page_ages"}</b>:
+ * Samples (and clears) the EPT accessed bits of the next window of pages,
+ * updating the age of each page. Does nothing until every vCPU has flushed
+ * its EPT translations since the previous sample
+ *
+ * <b>{"get":"page_age_histogram"}</b>:
+ * Returns the number of pages in each age bucket (bucket 0 is hot, bucket
+ * "i" holds the pages whose age is in [2^(i - 1), 2^i - 1])
+ *
+ * <b>{"get":"cold_ranges", "count": dec}</b>:
+ * <b>{"get":"cold_ranges", "count_hex": "hex"}</b>:
+ * Returns up to "count" of the coldest guest physical address ranges,
+ * coldest first
+ *
+ *
+ *
+ * @section exit_stats Exit Stats
+ *
+ * @subsection exit_stats_register Register Based VMCalls
+ * There are no register based vmcalls for exit stats
+ *
+ * @subsection exit_stats_json JSON Based VMCalls
+ *
+ * <b>{"get":"exit_stats"}</b>:
+ * Returns, for each basic exit reason (in hex) with at least one VM exit,
+ * the number of VM exits ("count"), the total number of TSC ticks spent
+ * handling them ("ticks"), and a histogram of the number of ticks spent
+ * handling each VM exit ("histogram", bucket "i" holds the VM exits that
+ * took [2^(i - 1), 2^i - 1] ticks), summed over all of the vCPUs. Only
+ * available if the EAPIs were built with ENABLE_EXIT_STATS set to 1 (the
+ * default)
+ *
+ * <b>{"run":"clear_exit_stats"}</b>:
+ * Resets the exit stats of every vCPU. Only available if the EAPIs were
+ * built with ENABLE_EXIT_STATS set to 1 (the default)
+ *
+ * <b>{"set":"trace_exits", "gpa": dec, "overwrite": bool}</b>:
+ * <b>{"set":"trace_exits", "gpa_hex": "hex", "overwrite": bool}</b>:
+ * Records each VM exit of the vCPU that executes the vmcall (TSC, basic
+ * exit reason, exit qualification, guest RIP and handling time) in a trace
+ * ring stored in the (page aligned) guest page at "gpa", which the guest
+ * drains directly. When the ring is full, new records are dropped, or
+ * overwrite the oldest records if "overwrite" is true (defaults to false),
+ * and are counted in the ring's header. The page uses the same layout as
+ * the IO trace, with 40 byte exit_trace_record_intel_x64 records, and has
+ * to be mapped writable in the EPT without being merged or SPP protected
+ * (it is excluded from page merging until the trace stops). A "gpa" of 0
+ * stops the trace
+ *
  */
 
 #ifdef __cplusplus
@@ -0,0 +1,207 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef EXIT_STATS_INTEL_X64_H
+#define EXIT_STATS_INTEL_X64_H
+
+#include <gsl/gsl>
+
+#include <map>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <vector>
+
+#ifndef ENABLE_EXIT_STATS
+#define ENABLE_EXIT_STATS 1
+#endif
+
+#if ENABLE_EXIT_STATS
+
+/// Exit Stats
+///
+/// Records how long a single vCPU spends in the VMM for each basic exit
+/// reason, as the number of VM exits, the total number of TSC ticks, and a
+/// histogram of the number of TSC ticks spent handling each VM exit.
+/// Bucket "i" of the histogram counts the VM exits that took
+/// [2^(i - 1), 2^i - 1] ticks (bucket 0 counts the VM exits that took 0
+/// ticks), and the last bucket also counts the VM exits that took longer.
+///
+/// The counters are stored in fixed size arrays, and are only written by
+/// the vCPU that owns them (other vCPUs only read them, or reset them),
+/// so recording a VM exit never allocates or takes a lock.
+///
+class exit_stats_intel_x64
+{
+public:
+
+    using reason_type = uint64_t;
+    using count_type = uint64_t;
+
+    static constexpr const reason_type max_exit_reasons = 0x80;
+    static constexpr const std::size_t num_buckets = 32;
+
+    using histogram_type = std::array<count_type, num_buckets>;
+
+    struct stats_type
+    {
+        count_type count;
+        count_type ticks;
+        histogram_type histogram;
+    };
+
+    using snapshot_type = std::map<reason_type, stats_type>;
+
+    /// Default Constructor
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    exit_stats_intel_x64();
+
+    /// Destructor
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    virtual ~exit_stats_intel_x64();
+
+    /// Record
+    ///
+    /// Records a VM exit. VM exits with a basic exit reason that is
+    /// larger than max_exit_reasons are ignored.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param reason the basic exit reason of the VM exit
+    /// @param ticks the number of TSC ticks spent handling the VM exit
+    ///
+    void record(reason_type reason, count_type ticks) noexcept
+    {
+        if (reason >= max_exit_reasons)
+            return;
+
+        auto &&counters = m_counters[reason];
+
+        increment(counters.count, 1);
+        increment(counters.ticks, ticks);
+        increment(counters.histogram[bucket(ticks)], 1);
+    }
+
+    /// Stats
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param reason the basic exit reason to lookup
+    /// @return the stats recorded for the provided exit reason
+    ///
+    stats_type stats(reason_type reason) const noexcept;
+
+    /// Clear
+    ///
+    /// Resets all of the counters to 0.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    void clear() noexcept;
+
+    /// Snapshot
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return the stats of each exit reason with at least one VM exit
+    ///
+    snapshot_type snapshot() const;
+
+    /// Aggregate
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return the sum of the snapshots of every vCPU's stats
+    ///
+    static snapshot_type aggregate();
+
+    /// Clear All
+    ///
+    /// Clears the stats of every vCPU.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    static void clear_all();
+
+    /// Bucket
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param ticks the number of TSC ticks to convert
+    /// @return the histogram bucket for the provided number of ticks
+    ///
+    static std::size_t bucket(count_type ticks) noexcept
+    {
+        if (ticks == 0)
+            return 0;
+
+        auto &&bucket = gsl::narrow_cast<std::size_t>(64 - __builtin_clzl(ticks));
+        return bucket < num_buckets ? bucket : num_buckets - 1;
+    }
+
+private:
+
+    struct counters_type
+    {
+        std::atomic<count_type> count;
+        std::atomic<count_type> ticks;
+        std::array<std::atomic<count_type>, num_buckets> histogram;
+    };
+
+    static void increment(std::atomic<count_type> &counter, count_type value) noexcept
+    { counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed); }
+
+    void snapshot(snapshot_type &snapshot) const;
+
+    static std::mutex &registry_mutex();
+    static std::vector<exit_stats_intel_x64 *> &registry();
+
+private:
+
+    std::array<counters_type, max_exit_reasons> m_counters;
+
+public:
+
+    friend class eapis_ut;
+
+    exit_stats_intel_x64(exit_stats_intel_x64 &&) = delete;
+    exit_stats_intel_x64 &operator=(exit_stats_intel_x64 &&) = delete;
+
+    exit_stats_intel_x64(const exit_stats_intel_x64 &) = delete;
+    exit_stats_intel_x64 &operator=(const exit_stats_intel_x64 &) = delete;
+};
+
+#endif
+
+#endif
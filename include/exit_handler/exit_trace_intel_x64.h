@@ -0,0 +1,43 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef EXIT_TRACE_INTEL_X64_H
+#define EXIT_TRACE_INTEL_X64_H
+
+#include <exit_handler/trace_ring_intel_x64.h>
+
+/// Exit Trace Record
+///
+/// Describes a single VM exit.
+///
+struct exit_trace_record_intel_x64
+{
+    uint64_t tsc;           // TSC at the time of the VM exit
+    uint64_t ticks;         // TSC ticks spent handling the VM exit
+    uint64_t rip;           // guest RIP at the time of the VM exit
+    uint64_t qualification;
+    uint32_t reason;        // basic exit reason
+    uint32_t reserved;
+};
+
+using exit_trace_intel_x64 = trace_ring_intel_x64<exit_trace_record_intel_x64>;
+
+#endif
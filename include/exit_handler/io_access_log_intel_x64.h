@@ -0,0 +1,180 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef IO_ACCESS_LOG_INTEL_X64_H
+#define IO_ACCESS_LOG_INTEL_X64_H
+
+#include <gsl/gsl>
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <intrinsics/portio_x64.h>
+
+/// IO Access Log
+///
+/// Counts the number of trapped accesses made to each IO port by a single
+/// vCPU. The counters are stored in a flat array indexed by port (allocated
+/// the first time the log is enabled), so logging an access is a single
+/// increment, and never allocates or takes a lock. Each counter is only
+/// written by the vCPU that owns the log, while snapshots may be taken by
+/// any vCPU.
+///
+/// Every log registers itself on construction, so that aggregate() can
+/// merge the logs of all of the vCPUs.
+///
+class io_access_log_intel_x64
+{
+public:
+
+    using port_type = x64::portio::port_addr_type;
+    using count_type = uint64_t;
+    using snapshot_type = std::map<port_type, count_type>;
+
+    static constexpr const auto num_ports = 0x10000UL;
+
+    /// Default Constructor
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    io_access_log_intel_x64();
+
+    /// Destructor
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    virtual ~io_access_log_intel_x64();
+
+    /// Enable
+    ///
+    /// Enables / disables logging. The counters are allocated the first
+    /// time the log is enabled, and are kept when the log is disabled.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param enable set to true to enable logging, false otherwise
+    ///
+    void enable(bool enable);
+
+    /// Is Enabled
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return true if logging is enabled, false otherwise
+    ///
+    bool is_enabled() const noexcept
+    { return m_enabled; }
+
+    /// Log
+    ///
+    /// Counts an access to the provided port if logging is enabled.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param port the port that was accessed
+    ///
+    void log(port_type port) noexcept
+    {
+        if (!m_enabled)
+            return;
+
+        auto &&counter = m_counters[port];
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    /// Count
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param port the port to lookup
+    /// @return the number of accesses logged for the provided port
+    ///
+    count_type count(port_type port) const noexcept;
+
+    /// Clear
+    ///
+    /// Resets all of the counters to 0.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    void clear() noexcept;
+
+    /// Snapshot
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return the ports (and their counts) with at least one logged access
+    ///
+    snapshot_type snapshot() const;
+
+    /// Aggregate
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return the sum of the snapshots of every vCPU's log
+    ///
+    static snapshot_type aggregate();
+
+    /// Clear All
+    ///
+    /// Clears the logs of every vCPU.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    static void clear_all();
+
+private:
+
+    void snapshot(snapshot_type &snapshot) const;
+
+    static std::mutex &registry_mutex();
+    static std::vector<io_access_log_intel_x64 *> &registry();
+
+private:
+
+    bool m_enabled;
+    std::unique_ptr<std::atomic<count_type>[]> m_counters;
+
+public:
+
+    friend class eapis_ut;
+
+    io_access_log_intel_x64(io_access_log_intel_x64 &&) = delete;
+    io_access_log_intel_x64 &operator=(io_access_log_intel_x64 &&) = delete;
+
+    io_access_log_intel_x64(const io_access_log_intel_x64 &) = delete;
+    io_access_log_intel_x64 &operator=(const io_access_log_intel_x64 &) = delete;
+};
+
+#endif
@@ -0,0 +1,96 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef IO_PORT_HANDLER_INTEL_X64_H
+#define IO_PORT_HANDLER_INTEL_X64_H
+
+#include <gsl/gsl>
+#include <intrinsics/portio_x64.h>
+
+/// IO Port Handler
+///
+/// Interface for device models that emulate IO ports inside the
+/// hypervisor. A handler is registered with the exit handler for a range
+/// of ports (see exit_handler_intel_x64_eapis::register_io_port_handler),
+/// and is called in place of the physical port whenever the guest executes
+/// an IN / OUT instruction on one of these ports.
+///
+class io_port_handler_intel_x64
+{
+public:
+
+    using port_type = x64::portio::port_addr_type;
+    using size_type = std::size_t;
+    using value_type = uint32_t;
+
+    /// Default Constructor
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    io_port_handler_intel_x64() = default;
+
+    /// Destructor
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    virtual ~io_port_handler_intel_x64() = default;
+
+    /// Read
+    ///
+    /// Called when the guest executes an IN instruction on a registered
+    /// port.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param port the port being read
+    /// @param size the size of the access in bytes (1, 2 or 4)
+    /// @return the value returned to the guest. Only the lower "size"
+    ///     bytes are used.
+    ///
+    virtual value_type read(port_type port, size_type size) = 0;
+
+    /// Write
+    ///
+    /// Called when the guest executes an OUT instruction on a registered
+    /// port.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param port the port being written
+    /// @param size the size of the access in bytes (1, 2 or 4)
+    /// @param value the value written by the guest
+    ///
+    virtual void write(port_type port, size_type size, value_type value) = 0;
+
+public:
+
+    io_port_handler_intel_x64(io_port_handler_intel_x64 &&) = default;
+    io_port_handler_intel_x64 &operator=(io_port_handler_intel_x64 &&) = default;
+
+    io_port_handler_intel_x64(const io_port_handler_intel_x64 &) = delete;
+    io_port_handler_intel_x64 &operator=(const io_port_handler_intel_x64 &) = delete;
+};
+
+#endif
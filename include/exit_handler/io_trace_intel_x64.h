@@ -0,0 +1,46 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef IO_TRACE_INTEL_X64_H
+#define IO_TRACE_INTEL_X64_H
+
+#include <exit_handler/trace_ring_intel_x64.h>
+
+/// IO Trace Record
+///
+/// Describes a single trapped IO access. For an IN, value is the value
+/// returned to the guest, and for an OUT, value is the value written by
+/// the guest. The value of a string instruction (INS / OUTS) is not
+/// recorded (i.e. it is always 0).
+///
+struct io_trace_record_intel_x64
+{
+    uint64_t tsc;           // TSC at the time of the VM exit
+    uint64_t rip;           // guest RIP of the IO instruction
+    uint32_t value;
+    uint16_t port;
+    uint8_t size;           // size of the access in bytes (1, 2 or 4)
+    uint8_t direction;      // 0 == out, 1 == in
+};
+
+using io_trace_intel_x64 = trace_ring_intel_x64<io_trace_record_intel_x64>;
+
+#endif
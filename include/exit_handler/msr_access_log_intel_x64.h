@@ -0,0 +1,200 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef MSR_ACCESS_LOG_INTEL_X64_H
+#define MSR_ACCESS_LOG_INTEL_X64_H
+
+#include <gsl/gsl>
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <intrinsics/msrs_x64.h>
+
+/// MSR Access Log
+///
+/// Counts the number of trapped RDMSR / WRMSR instructions executed on
+/// each MSR by a single vCPU. Like the IO access log, the counters are
+/// stored in a flat array (allocated the first time the log is enabled),
+/// so logging an access is a single increment, and never allocates or
+/// takes a lock.
+///
+/// The array has one counter for each MSR covered by the MSR bitmaps
+/// (i.e. [0x0, 0x1FFF] and [0xC0000000, 0xC0001FFF]). Accesses to any
+/// other MSR are counted together, and are reported as other_msrs.
+///
+class msr_access_log_intel_x64
+{
+public:
+
+    using msr_type = x64::msrs::field_type;
+    using count_type = uint64_t;
+    using snapshot_type = std::map<msr_type, count_type>;
+
+    static constexpr const msr_type low_msrs = 0x00000000U;
+    static constexpr const msr_type high_msrs = 0xC0000000U;
+    static constexpr const msr_type msrs_per_range = 0x2000U;
+    static constexpr const msr_type other_msrs = 0xFFFFFFFFU;
+
+    static constexpr const auto num_counters = (msrs_per_range * 2UL) + 1UL;
+
+    /// Default Constructor
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    msr_access_log_intel_x64();
+
+    /// Destructor
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    virtual ~msr_access_log_intel_x64();
+
+    /// Enable
+    ///
+    /// Enables / disables logging. The counters are allocated the first
+    /// time the log is enabled, and are kept when the log is disabled.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param enable set to true to enable logging, false otherwise
+    ///
+    void enable(bool enable);
+
+    /// Is Enabled
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return true if logging is enabled, false otherwise
+    ///
+    bool is_enabled() const noexcept
+    { return m_enabled; }
+
+    /// Log
+    ///
+    /// Counts an access to the provided MSR if logging is enabled.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param msr the MSR that was accessed
+    ///
+    void log(msr_type msr) noexcept
+    {
+        if (!m_enabled)
+            return;
+
+        auto &&counter = m_counters[index(msr)];
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    /// Count
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param msr the MSR to lookup
+    /// @return the number of accesses logged for the provided MSR. For
+    ///     an MSR outside of the covered ranges, this is the number of
+    ///     accesses logged for all of these MSRs.
+    ///
+    count_type count(msr_type msr) const noexcept;
+
+    /// Clear
+    ///
+    /// Resets all of the counters to 0.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    void clear() noexcept;
+
+    /// Snapshot
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return the MSRs (and their counts) with at least one logged access
+    ///
+    snapshot_type snapshot() const;
+
+    /// Aggregate
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return the sum of the snapshots of every vCPU's log
+    ///
+    static snapshot_type aggregate();
+
+    /// Clear All
+    ///
+    /// Clears the logs of every vCPU.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    static void clear_all();
+
+private:
+
+    static std::size_t index(msr_type msr) noexcept
+    {
+        if (msr < msrs_per_range)
+            return msr - low_msrs;
+
+        if (msr - high_msrs < msrs_per_range)
+            return msrs_per_range + (msr - high_msrs);
+
+        return num_counters - 1;
+    }
+
+    static msr_type to_msr(std::size_t index) noexcept;
+
+    void snapshot(snapshot_type &snapshot) const;
+
+    static std::mutex &registry_mutex();
+    static std::vector<msr_access_log_intel_x64 *> &registry();
+
+private:
+
+    bool m_enabled;
+    std::unique_ptr<std::atomic<count_type>[]> m_counters;
+
+public:
+
+    friend class eapis_ut;
+
+    msr_access_log_intel_x64(msr_access_log_intel_x64 &&) = delete;
+    msr_access_log_intel_x64 &operator=(msr_access_log_intel_x64 &&) = delete;
+
+    msr_access_log_intel_x64(const msr_access_log_intel_x64 &) = delete;
+    msr_access_log_intel_x64 &operator=(const msr_access_log_intel_x64 &) = delete;
+};
+
+#endif
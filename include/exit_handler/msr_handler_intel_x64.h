@@ -0,0 +1,91 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef MSR_HANDLER_INTEL_X64_H
+#define MSR_HANDLER_INTEL_X64_H
+
+#include <gsl/gsl>
+#include <intrinsics/msrs_x64.h>
+
+/// MSR Handler
+///
+/// Interface for MSRs that are emulated inside the hypervisor (e.g.
+/// IA32_TSC_DEADLINE, the x2APIC registers or IA32_SPEC_CTRL). A handler is
+/// registered with the exit handler for a range of MSRs (see
+/// exit_handler_intel_x64_eapis::register_msr_handler), and is called in
+/// place of the physical MSR whenever the guest executes a RDMSR / WRMSR
+/// on one of these MSRs.
+///
+class msr_handler_intel_x64
+{
+public:
+
+    using msr_type = x64::msrs::field_type;
+    using value_type = x64::msrs::value_type;
+
+    /// Default Constructor
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    msr_handler_intel_x64() = default;
+
+    /// Destructor
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    virtual ~msr_handler_intel_x64() = default;
+
+    /// Read
+    ///
+    /// Called when the guest executes a RDMSR on a registered MSR.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param msr the MSR being read
+    /// @return the value returned to the guest in EDX:EAX
+    ///
+    virtual value_type read(msr_type msr) = 0;
+
+    /// Write
+    ///
+    /// Called when the guest executes a WRMSR on a registered MSR.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param msr the MSR being written
+    /// @param value the value written by the guest (EDX:EAX)
+    ///
+    virtual void write(msr_type msr, value_type value) = 0;
+
+public:
+
+    msr_handler_intel_x64(msr_handler_intel_x64 &&) = default;
+    msr_handler_intel_x64 &operator=(msr_handler_intel_x64 &&) = default;
+
+    msr_handler_intel_x64(const msr_handler_intel_x64 &) = delete;
+    msr_handler_intel_x64 &operator=(const msr_handler_intel_x64 &) = delete;
+};
+
+#endif
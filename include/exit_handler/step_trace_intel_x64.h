@@ -0,0 +1,49 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef STEP_TRACE_INTEL_X64_H
+#define STEP_TRACE_INTEL_X64_H
+
+#include <exit_handler/trace_ring_intel_x64.h>
+
+/// Step Trace Record
+///
+/// Describes the state of the guest after a single instruction was
+/// executed by the stepping engine (i.e. rip is the address of the next
+/// instruction that the guest will execute).
+///
+struct step_trace_record_intel_x64
+{
+    uint64_t tsc;           // TSC at the time of the VM exit
+    uint64_t step;          // 1 for the first instruction that was stepped
+    uint64_t rip;
+    uint64_t rsp;
+    uint64_t rax;
+    uint64_t rbx;
+    uint64_t rcx;
+    uint64_t rdx;
+    uint64_t rsi;
+    uint64_t rdi;
+};
+
+using step_trace_intel_x64 = trace_ring_intel_x64<step_trace_record_intel_x64>;
+
+#endif
@@ -0,0 +1,275 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef TRACE_RING_INTEL_X64_H
+#define TRACE_RING_INTEL_X64_H
+
+#include <gsl/gsl>
+
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+/// Trace Ring Timestamp
+///
+/// @return the current value of the TSC, used to timestamp trace records
+///
+inline uint64_t
+trace_ring_timestamp() noexcept
+{ return __builtin_ia32_rdtsc(); }
+
+/// Trace Ring
+///
+/// A single producer / single consumer ring buffer of fixed size records,
+/// stored in a caller provided buffer (e.g. a page that is shared with the
+/// guest). The buffer starts with a header, followed by an array of
+/// records:
+///
+/// @code
+/// struct header
+/// {
+///     uint32_t magic;         // trace_ring_magic
+///     uint32_t record_size;   // sizeof(T)
+///     uint64_t capacity;      // number of records
+///     uint64_t head;          // written by the producer
+///     uint64_t tail;          // written by the consumer
+///     uint64_t dropped;       // records dropped because the ring was full
+///     uint64_t overwrite;     // 1 if the ring is in overwrite mode
+///     uint64_t overwritten;   // records overwritten before being consumed
+/// };
+/// @endcode
+///
+/// head and tail are free running counters (record "i" is stored in slot
+/// i % capacity). The producer publishes a record by incrementing head
+/// (release), and a consumer frees a record by incrementing tail. The ring
+/// never blocks the producer: when it is full, the new record is dropped
+/// and counted (drop mode, the default), or the oldest record is
+/// overwritten and counted (overwrite mode).
+///
+/// In overwrite mode, the slot of record "head" is being written by the
+/// producer at any time, so the ring holds at most capacity - 1 records,
+/// and a consumer that falls further behind skips ahead to the oldest
+/// record that is still in the ring (tail = head - capacity + 1). Since
+/// the producer could also overwrite the record that is being copied, the
+/// consumer re-reads head once the copy is done, and discards the record
+/// if head - tail >= capacity (i.e. the producer could have been writing to
+/// the same slot). This relies on the stores of the producer becoming
+/// visible in order, as they do on x64.
+///
+template<class T>
+class trace_ring_intel_x64
+{
+    static_assert(std::is_trivially_copyable<T>::value, "trace records must be trivially copyable");
+
+public:
+
+    using record_type = T;
+    using size_type = uint64_t;
+
+    static constexpr const uint32_t trace_ring_magic = 0x54524345;
+
+    struct header_type
+    {
+        uint32_t magic;
+        uint32_t record_size;
+        size_type capacity;
+        std::atomic<size_type> head;
+        std::atomic<size_type> tail;
+        std::atomic<size_type> dropped;
+        size_type overwrite;
+        std::atomic<size_type> overwritten;
+    };
+
+    /// Constructor
+    ///
+    /// Initializes the header in the provided buffer. Any records that
+    /// were previously in the buffer are discarded.
+    ///
+    /// @expects buffer is large enough to hold the header and a record (two
+    ///     records in overwrite mode)
+    /// @ensures none
+    ///
+    /// @param buffer the memory backing the ring
+    /// @param overwrite set to true to overwrite the oldest records when
+    ///     the ring is full, false to drop the new records instead
+    ///
+    trace_ring_intel_x64(gsl::span<uint8_t> buffer, bool overwrite = false) :
+        m_header(reinterpret_cast<header_type *>(buffer.data())),
+        m_records(reinterpret_cast<record_type *>(buffer.data() + sizeof(header_type))),
+        m_overwrite(overwrite)
+    {
+        expects(static_cast<size_t>(buffer.size()) >= sizeof(header_type) + sizeof(record_type));
+
+        m_capacity = (static_cast<size_t>(buffer.size()) - sizeof(header_type)) / sizeof(record_type);
+        m_window = overwrite ? m_capacity - 1 : m_capacity;
+
+        expects(m_window != 0);
+
+        m_header->magic = trace_ring_magic;
+        m_header->record_size = sizeof(record_type);
+        m_header->capacity = m_capacity;
+        m_header->overwrite = overwrite ? 1 : 0;
+        m_header->head.store(0, std::memory_order_relaxed);
+        m_header->tail.store(0, std::memory_order_relaxed);
+        m_header->overwritten.store(0, std::memory_order_relaxed);
+        m_header->dropped.store(0, std::memory_order_release);
+    }
+
+    /// Destructor
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    virtual ~trace_ring_intel_x64() = default;
+
+    /// Push
+    ///
+    /// Adds a record to the ring (producer only)
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param record the record to add
+    /// @return true if the record was added, false if the ring was full
+    ///     and the record was dropped (drop mode only)
+    ///
+    bool push(const record_type &record) noexcept
+    {
+        auto &&head = m_header->head.load(std::memory_order_relaxed);
+        auto &&tail = m_header->tail.load(std::memory_order_acquire);
+
+        if (head - tail >= m_window)
+        {
+            if (!m_overwrite)
+            {
+                m_header->dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            m_header->overwritten.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        memcpy(&m_records[head % m_capacity], &record, sizeof(record_type));
+        m_header->head.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /// Pop
+    ///
+    /// Removes the oldest record from the ring (consumer only). Note that
+    /// the consumer is usually the guest, reading the shared buffer
+    /// directly.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param record where to store the record
+    /// @return true if a record was removed, false if the ring was empty
+    ///
+    bool pop(record_type &record) noexcept
+    {
+        while (true)
+        {
+            auto tail = m_header->tail.load(std::memory_order_relaxed);
+            auto &&head = m_header->head.load(std::memory_order_acquire);
+
+            if (head == tail)
+                return false;
+
+            if (head - tail > m_window)
+                tail = head - m_window;
+
+            memcpy(&record, &m_records[tail % m_capacity], sizeof(record_type));
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            m_header->tail.store(tail + 1, std::memory_order_release);
+
+            if (!m_overwrite || m_header->head.load(std::memory_order_relaxed) - tail < m_capacity)
+                return true;
+        }
+    }
+
+    /// Capacity
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return the number of record slots in the ring. The ring holds at
+    ///     most capacity() - 1 records in overwrite mode.
+    ///
+    size_type capacity() const noexcept
+    { return m_capacity; }
+
+    /// Size
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return the number of records waiting to be consumed
+    ///
+    size_type size() const noexcept
+    {
+        auto &&tail = m_header->tail.load(std::memory_order_acquire);
+        auto &&head = m_header->head.load(std::memory_order_acquire);
+
+        return head - tail < m_window ? head - tail : m_window;
+    }
+
+    /// Dropped
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return the number of records dropped because the ring was full
+    ///
+    size_type dropped() const noexcept
+    { return m_header->dropped.load(std::memory_order_relaxed); }
+
+    /// Overwritten
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return the number of records that were overwritten before they
+    ///     were consumed (overwrite mode only)
+    ///
+    size_type overwritten() const noexcept
+    { return m_header->overwritten.load(std::memory_order_relaxed); }
+
+private:
+
+    header_type *m_header;
+    record_type *m_records;
+    size_type m_capacity;
+    size_type m_window;
+    bool m_overwrite;
+
+public:
+
+    trace_ring_intel_x64(trace_ring_intel_x64 &&) = delete;
+    trace_ring_intel_x64 &operator=(trace_ring_intel_x64 &&) = delete;
+
+    trace_ring_intel_x64(const trace_ring_intel_x64 &) = delete;
+    trace_ring_intel_x64 &operator=(const trace_ring_intel_x64 &) = delete;
+};
+
+#endif
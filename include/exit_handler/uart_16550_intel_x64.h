@@ -0,0 +1,164 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef UART_16550_INTEL_X64_H
+#define UART_16550_INTEL_X64_H
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <exit_handler/io_port_handler_intel_x64.h>
+
+#ifndef UART_16550_BUFFER_SIZE
+#define UART_16550_BUFFER_SIZE 0x10000
+#endif
+
+/// 16550 UART
+///
+/// Emulates the register interface of a 16550 UART (e.g. COM1 at 0x3F8)
+/// so that guest console output can be captured in a single VM exit per
+/// byte. The transmit holding register is always reported as empty, so
+/// the guest never has to poll the line status register, and each byte
+/// that is transmitted is stored in a VMM side ring that is drained in
+/// bulk using drain(). If the ring is full, the oldest bytes are dropped
+/// (and counted) in favor of the newest.
+///
+/// The receiver is never ready (i.e. the guest cannot read from the
+/// UART), the modem lines are always asserted, and no interrupts are
+/// injected. If the guest enables the transmitter holding register empty
+/// interrupt, the IIR reports it as pending, which is true at all times.
+///
+class uart_16550_intel_x64 : public io_port_handler_intel_x64
+{
+public:
+
+    using output_type = std::string;
+
+    static constexpr const port_type com1 = 0x3F8;
+    static constexpr const port_type num_ports = 8;
+
+    /// Constructor
+    ///
+    /// @expects capacity != 0
+    /// @ensures none
+    ///
+    /// @param base the first port of the UART's register interface
+    /// @param capacity the max number of bytes that are buffered
+    ///
+    uart_16550_intel_x64(port_type base = com1, size_type capacity = UART_16550_BUFFER_SIZE);
+
+    /// Destructor
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    ~uart_16550_intel_x64() override = default;
+
+    /// Read
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param port the port being read
+    /// @param size the size of the access in bytes (1, 2 or 4)
+    /// @return the value of the register at port
+    ///
+    value_type read(port_type port, size_type size) override;
+
+    /// Write
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param port the port being written
+    /// @param size the size of the access in bytes (1, 2 or 4)
+    /// @param value the value written by the guest
+    ///
+    void write(port_type port, size_type size, value_type value) override;
+
+    /// Base
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return the first port of the UART's register interface
+    ///
+    port_type base() const noexcept
+    { return m_base; }
+
+    /// Drain
+    ///
+    /// Returns (and forgets) the bytes that the guest has transmitted
+    /// since the previous call to drain().
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return the buffered output
+    ///
+    output_type drain();
+
+    /// Dropped
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return the number of bytes that were dropped because the ring was
+    ///     full
+    ///
+    size_type dropped() const;
+
+private:
+
+    void transmit(char c);
+
+private:
+
+    port_type m_base;
+
+    uint8_t m_ier;
+    uint8_t m_fcr;
+    uint8_t m_lcr;
+    uint8_t m_mcr;
+    uint8_t m_scr;
+    uint8_t m_dll;
+    uint8_t m_dlm;
+
+    mutable std::mutex m_mutex;
+
+    std::vector<char> m_buffer;
+    size_type m_head;
+    size_type m_size;
+    size_type m_dropped;
+
+public:
+
+    friend class eapis_ut;
+
+    uart_16550_intel_x64(uart_16550_intel_x64 &&) = delete;
+    uart_16550_intel_x64 &operator=(uart_16550_intel_x64 &&) = delete;
+
+    uart_16550_intel_x64(const uart_16550_intel_x64 &) = delete;
+    uart_16550_intel_x64 &operator=(const uart_16550_intel_x64 &) = delete;
+};
+
+#endif
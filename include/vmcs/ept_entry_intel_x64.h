@@ -24,6 +24,18 @@
 
 #include <gsl/gsl>
 
+// -----------------------------------------------------------------------------
+// Configuration
+// -----------------------------------------------------------------------------
+
+// The number of levels in the extended page tables (4 or 5). A 4-level walk
+// covers 256 TB of guest physical memory, while a 5-level walk (which adds
+// a PML5 above the PML4) covers 128 PB at the cost of an extra memory
+// reference on each TLB miss.
+#ifndef EPT_PAGE_WALK_LENGTH
+#define EPT_PAGE_WALK_LENGTH 4
+#endif
+
 // -----------------------------------------------------------------------------
 // Constants
 // -----------------------------------------------------------------------------
@@ -40,6 +52,14 @@ namespace ept
     template<class T, class F> auto index(const T virt, const F from)
     { return (virt & ((0x1FFULL) << from)) >> from; }
 
+    // 256 TB per page entry
+    namespace pml5
+    {
+        constexpr const auto from = 48U;
+        constexpr const auto size = 9U;
+        constexpr const auto size_bytes = 0x1000000000000UL;
+    }
+
     // 512 GB per page entry
     namespace pml4
     {
@@ -72,6 +92,25 @@ namespace ept
         constexpr const auto size_bytes = 0x1000UL;
     }
 
+    // Describes the root of an extended page table with "N" levels
+    template<unsigned N> struct levels;
+
+    template<> struct levels<4>
+    {
+        static constexpr const auto page_walk_length = 4U;
+        static constexpr const auto root_from = pml4::from;
+        static constexpr const auto max_gpa = pml4::size_bytes * num_entries;
+    };
+
+    template<> struct levels<5>
+    {
+        static constexpr const auto page_walk_length = 5U;
+        static constexpr const auto root_from = pml5::from;
+        static constexpr const auto max_gpa = pml5::size_bytes * num_entries;
+    };
+
+    using page_walk = levels<EPT_PAGE_WALK_LENGTH>;
+
     namespace memory_type
     {
         constexpr const auto uc = 0;
@@ -320,6 +359,29 @@ public:
     ///
     void set_suppress_ve(bool enabled) noexcept;
 
+    /// Sub-Page Write Permissions
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return true if writes to this 4k page are checked against the
+    ///     sub-page permission table, false otherwise
+    ///
+    bool sub_page_write_permissions() const noexcept;
+
+    /// Set Sub-Page Write Permissions
+    ///
+    /// @note: sub-page write permissions are only consulted by hardware
+    ///     for 4k pages that do not have write access.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param enabled true if writes to this 4k page should be checked
+    ///     against the sub-page permission table, false otherwise
+    ///
+    void set_sub_page_write_permissions(bool enabled) noexcept;
+
     /// Trap On Access
     ///
     /// Disables read, write and execute access
@@ -47,8 +47,12 @@ public:
     ///
     /// @param epte the parent extended page table entry that points to this
     ///     table
+    /// @param bits the guest physical address bits that index this table.
+    ///     For the root table, this defines the number of levels in the
+    ///     extended page tables (pml4::from for 4 levels, pml5::from for 5)
     ///
-    ept_intel_x64(pointer epte = nullptr);
+    ept_intel_x64(pointer epte = nullptr,
+                  integer_pointer bits = intel_x64::ept::page_walk::root_from);
 
     /// Destructor
     ///
@@ -67,13 +71,25 @@ public:
     ///
     size_type global_size() const noexcept;
 
+    /// Max Guest Physical Address
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return returns the first guest physical address that cannot be
+    ///     mapped by this table (i.e. the size of the address space that
+    ///     this table covers)
+    ///
+    integer_pointer max_gpa() const noexcept
+    { return 1UL << (m_bits + intel_x64::ept::pt::size); }
+
     /// Add Page (1 Gigabyte Granularity)
     ///
     /// Adds a page to the extended page table structure. Note that this is the
     /// public function, and should only be used to add pages to the
-    /// PML4 extended page table. This function will call a private version that
-    /// will parse through the different levels making sure the virtual
-    /// address provided is valid.
+    /// root (PML4 or PML5) extended page table. This function will call a
+    /// private version that will parse through the different levels making
+    /// sure the virtual address provided is valid.
     ///
     /// @expects none
     /// @ensures none
@@ -83,15 +99,15 @@ public:
     ///     properties should be set by the caller
     ///
     gsl::not_null<ept_entry_intel_x64 *> add_page_1g(integer_pointer addr)
-    { return add_page(addr, intel_x64::ept::pml4::from, intel_x64::ept::pdpt::from); }
+    { return add_page(check_gpa(addr), m_bits, intel_x64::ept::pdpt::from); }
 
     /// Add Page (2 Megabyte Granularity)
     ///
     /// Adds a page to the extended page table structure. Note that this is the
     /// public function, and should only be used to add pages to the
-    /// PML4 extended page table. This function will call a private version that
-    /// will parse through the different levels making sure the virtual
-    /// address provided is valid.
+    /// root (PML4 or PML5) extended page table. This function will call a
+    /// private version that will parse through the different levels making
+    /// sure the virtual address provided is valid.
     ///
     /// @expects none
     /// @ensures none
@@ -101,15 +117,15 @@ public:
     ///     properties should be set by the caller
     ///
     gsl::not_null<ept_entry_intel_x64 *> add_page_2m(integer_pointer addr)
-    { return add_page(addr, intel_x64::ept::pml4::from, intel_x64::ept::pd::from); }
+    { return add_page(check_gpa(addr), m_bits, intel_x64::ept::pd::from); }
 
     /// Add Page (4 Kilobyte Granularity)
     ///
     /// Adds a page to the extended page table structure. Note that this is the
     /// public function, and should only be used to add pages to the
-    /// PML4 extended page table. This function will call a private version that
-    /// will parse through the different levels making sure the virtual
-    /// address provided is valid.
+    /// root (PML4 or PML5) extended page table. This function will call a
+    /// private version that will parse through the different levels making
+    /// sure the virtual address provided is valid.
     ///
     /// @expects none
     /// @ensures none
@@ -119,7 +135,7 @@ public:
     ///     properties should be set by the caller
     ///
     gsl::not_null<ept_entry_intel_x64 *> add_page_4k(integer_pointer addr)
-    { return add_page(addr, intel_x64::ept::pml4::from, intel_x64::ept::pt::from); }
+    { return add_page(check_gpa(addr), m_bits, intel_x64::ept::pt::from); }
 
     /// Remove Page
     ///
@@ -135,7 +151,7 @@ public:
     /// @param addr the virtual address of the page to remove
     ///
     void remove_page(integer_pointer addr)
-    { remove_page(addr, intel_x64::ept::pml4::from); }
+    { remove_page(check_gpa(addr), m_bits); }
 
     /// Find Extended Page Table Entry
     ///
@@ -147,11 +163,77 @@ public:
     /// @param addr the virtual address of the page to lookup
     ///
     gsl::not_null<ept_entry_intel_x64 *> find_epte(integer_pointer addr)
-    { return find_epte(addr, intel_x64::ept::pml4::from); }
+    { return find_epte(check_gpa(addr), m_bits); }
+
+    /// Visit Range
+    ///
+    /// Walks the extended page tables, calling the provided function for
+    /// each mapped page (of any granularity) that overlaps the provided
+    /// guest physical address range. The function has the signature:
+    ///
+    /// @code
+    /// bool func(integer_pointer gpa, size_type size_bytes, ept_entry_intel_x64 *epte)
+    /// @endcode
+    ///
+    /// and returns false to stop the walk early. Note that the walk only
+    /// touches tables that are present, so sparse ranges are cheap.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param saddr the starting guest physical address of the range
+    /// @param eaddr the ending guest physical address of the range
+    /// @param func the function to call for each mapped page
+    /// @return false if the walk was stopped by func, true otherwise
+    ///
+    template<class F>
+    bool visit_range(integer_pointer saddr, integer_pointer eaddr, F &&func)
+    { return visit_range(saddr, eaddr, func, m_bits, 0); }
 
 private:
 
-    template<class T> std::unique_ptr<T> add_epte(pointer p);
+    template<class F>
+    bool visit_range(integer_pointer saddr, integer_pointer eaddr, F &func,
+                     integer_pointer bits, integer_pointer base)
+    {
+        if (eaddr <= base)
+            return true;
+
+        auto &&size_bytes = 1UL << bits;
+        auto &&sindex = saddr > base ? ((saddr - base) >> bits) : 0UL;
+        auto &&eindex = ((eaddr - 1 - base) >> bits) + 1;
+
+        if (eindex > intel_x64::ept::num_entries)
+            eindex = intel_x64::ept::num_entries;
+
+        for (auto index = sindex; index < eindex; index++)
+        {
+            auto &&epte = m_eptes[index];
+            auto &&gpa = base + (index << bits);
+
+            if (!epte)
+                continue;
+
+            if (auto pt = dynamic_cast<ept_intel_x64 *>(epte.get()))
+            {
+                if (!pt->visit_range(saddr, eaddr, func, bits - intel_x64::ept::pt::size, gpa))
+                    return false;
+
+                continue;
+            }
+
+            if (!func(gpa, size_bytes, epte.get()))
+                return false;
+        }
+
+        return true;
+    }
+
+private:
+
+    integer_pointer check_gpa(integer_pointer addr) const;
+
+    template<class T, class... Args> std::unique_ptr<T> add_epte(pointer p, Args &&... args);
     template<class T> std::unique_ptr<T> remove_epte();
 
     gsl::not_null<ept_entry_intel_x64 *> add_page(
@@ -170,6 +252,7 @@ private:
     std::unique_ptr<integer_pointer[]> m_ept_owner;
 
     size_type m_size;
+    integer_pointer m_bits;
     integer_pointer m_bitbucket;
     std::vector<std::unique_ptr<ept_entry_intel_x64>> m_eptes;
 
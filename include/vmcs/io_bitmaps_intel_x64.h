@@ -0,0 +1,156 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef IO_BITMAPS_INTEL_X64_H
+#define IO_BITMAPS_INTEL_X64_H
+
+#include <gsl/gsl>
+
+#include <mutex>
+#include <memory>
+
+#include <intrinsics/x64.h>
+#include <intrinsics/portio_x64.h>
+
+/// IO Bitmaps
+///
+/// The pair of IO bitmaps (bitmap A covers ports 0x0000 - 0x7FFF, and
+/// bitmap B covers ports 0x8000 - 0xFFFF) that the VMCS points to. Since
+/// the hardware reads the bitmaps directly on each IO instruction, a
+/// single instance can be shared by any number of vCPUs, and an update
+/// made to a shared instance applies to each vCPU at once. A vCPU that
+/// needs its own policy clones the shared instance instead (see
+/// vmcs_intel_x64_eapis::share_io_bitmaps).
+///
+/// Both bitmaps start out with every port passed through.
+///
+class io_bitmaps_intel_x64
+{
+public:
+
+    using port_type = x64::portio::port_addr_type;
+
+    /// Default Constructor
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    io_bitmaps_intel_x64();
+
+    /// Destructor
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    virtual ~io_bitmaps_intel_x64() = default;
+
+    /// Clone
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return a new instance with the same bitmaps as this one
+    ///
+    virtual std::shared_ptr<io_bitmaps_intel_x64> clone() const;
+
+    /// Trap On IO Access
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param port the port to trap on
+    ///
+    virtual void trap_on_io_access(port_type port);
+
+    /// Pass Through IO Access
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param port the port to pass through
+    ///
+    virtual void pass_through_io_access(port_type port);
+
+    /// Trap On IO Range
+    ///
+    /// @expects first <= last
+    /// @ensures none
+    ///
+    /// @param first the first port to trap on
+    /// @param last the last port to trap on
+    ///
+    virtual void trap_on_io_range(port_type first, port_type last);
+
+    /// Pass Through IO Range
+    ///
+    /// @expects first <= last
+    /// @ensures none
+    ///
+    /// @param first the first port to pass through
+    /// @param last the last port to pass through
+    ///
+    virtual void pass_through_io_range(port_type first, port_type last);
+
+    /// Bitmap A
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return the bitmap covering ports 0x0000 - 0x7FFF
+    ///
+    gsl::span<uint8_t> bitmap_a() const noexcept
+    { return m_bitmapa_view; }
+
+    /// Bitmap B
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return the bitmap covering ports 0x8000 - 0xFFFF
+    ///
+    gsl::span<uint8_t> bitmap_b() const noexcept
+    { return m_bitmapb_view; }
+
+private:
+
+    void fill(uint32_t first, uint32_t last, bool trap);
+
+private:
+
+    mutable std::mutex m_mutex;
+
+    std::unique_ptr<uint8_t[]> m_bitmapa;
+    std::unique_ptr<uint8_t[]> m_bitmapb;
+    gsl::span<uint8_t> m_bitmapa_view;
+    gsl::span<uint8_t> m_bitmapb_view;
+
+public:
+
+    friend class eapis_ut;
+
+    io_bitmaps_intel_x64(io_bitmaps_intel_x64 &&) = delete;
+    io_bitmaps_intel_x64 &operator=(io_bitmaps_intel_x64 &&) = delete;
+
+    io_bitmaps_intel_x64(const io_bitmaps_intel_x64 &) = delete;
+    io_bitmaps_intel_x64 &operator=(const io_bitmaps_intel_x64 &) = delete;
+};
+
+#endif
@@ -0,0 +1,262 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef PAGE_AGE_SAMPLER_INTEL_X64_H
+#define PAGE_AGE_SAMPLER_INTEL_X64_H
+
+#include <gsl/gsl>
+
+#include <map>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <functional>
+
+#include <vmcs/vmcs_intel_x64_eapis.h>
+
+#ifndef PAGE_AGE_SAMPLER_PAGES_PER_TICK
+#define PAGE_AGE_SAMPLER_PAGES_PER_TICK 512
+#endif
+
+/// Page Age Sampler
+///
+/// Classifies guest memory as hot or cold using the EPT accessed bits. Each
+/// call to tick() walks a bounded window of the extended page tables,
+/// picking up where the previous call left off. Pages whose accessed bit is
+/// set have their age reset to 0 (and the accessed bit is cleared so that
+/// the next pass can tell if the page was touched again), while the age of
+/// every other page is incremented (saturating at max_age). The age of a
+/// page is therefore the number of passes since the guest last touched it.
+/// A page that is seen for the first time starts with an age of 0 if its
+/// accessed bit is set, and 1 otherwise.
+///
+/// A vCPU that has a translation cached does not set the accessed bit
+/// again once it has been cleared. Each tick that clears accessed bits
+/// therefore flushes the EPT translations of every vCPU (see
+/// set_flush_delegate()), and the next tick waits for that flush to
+/// complete, so that a page is never aged because a vCPU was using a stale
+/// translation.
+///
+/// Ages of 4k pages are stored using one byte per page, in tables that
+/// cover 2M of guest physical memory each. Large pages are aged as a whole
+/// using a single entry, so that each mapping (regardless of its size)
+/// costs the same amount of work per tick, and report the same age for
+/// each 4k page they contain.
+///
+/// @note: the EPT accessed / dirty flags must be enabled in the EPTP.
+///
+class page_age_sampler_intel_x64
+{
+public:
+
+    using integer_pointer = uintptr_t;
+    using size_type = std::size_t;
+    using age_type = uint8_t;
+
+    // Bucket "i" of the histogram counts the pages whose age is in the
+    // range [2^(i - 1), 2^i - 1], with bucket 0 counting the hot pages
+    // (age 0).
+    using histogram_type = std::array<size_type, 9>;
+
+    struct range_type
+    {
+        integer_pointer gpa;
+        size_type size;
+        age_type age;
+    };
+
+    using range_list_type = std::vector<range_type>;
+
+    // Same as the page merger's flush tickets (see page_merger_intel_x64)
+    using flush_ticket_type = std::shared_ptr<std::atomic<size_type>>;
+    using flush_delegate_type = std::function<flush_ticket_type()>;
+
+    static constexpr const age_type max_age = 0xFE;
+
+    /// Constructor
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param vmcs the vmcs whose extended page tables will be sampled
+    /// @param pages_per_tick the max number of pages examined by tick()
+    ///
+    page_age_sampler_intel_x64(gsl::not_null<vmcs_intel_x64_eapis *> vmcs,
+                               size_type pages_per_tick = PAGE_AGE_SAMPLER_PAGES_PER_TICK);
+
+    /// Destructor
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    virtual ~page_age_sampler_intel_x64() = default;
+
+    /// Set Range
+    ///
+    /// Sets the guest physical address range that is sampled. Ages that
+    /// were collected outside of the new range are dropped.
+    ///
+    /// @expects saddr < eaddr
+    /// @ensures none
+    ///
+    /// @param saddr the starting guest physical address of the range
+    /// @param eaddr the ending guest physical address of the range
+    ///
+    virtual void set_range(integer_pointer saddr, integer_pointer eaddr);
+
+    /// Set Flush Delegate
+    ///
+    /// Sets the function that is called each time the EPT translations of
+    /// every vCPU need to be flushed, which works the same way as the page
+    /// merger's flush delegate. By default, the EPT translations are only
+    /// flushed on the current CPU, which is only correct if the EPT is used
+    /// by a single vCPU.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param delegate the function used to flush the EPT translations
+    ///
+    virtual void set_flush_delegate(flush_delegate_type delegate);
+
+    /// Tick
+    ///
+    /// Samples (and clears) the accessed bits of up to pages_per_tick
+    /// mappings (a large page is a single mapping, and costs the same as a
+    /// 4k page), continuing from where the previous tick stopped, and
+    /// wrapping back to the start of the range once the end is reached.
+    /// Pages that are no longer mapped are forgotten. While the flush
+    /// requested by a previous tick is outstanding, tick() does nothing.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return true if this tick completed a pass over the range
+    ///
+    virtual bool tick();
+
+    /// Age
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param gpa the guest physical address to lookup
+    /// @return the age of the page containing gpa. Throws if the page has
+    ///     not been sampled.
+    ///
+    virtual age_type age(integer_pointer gpa) const;
+
+    /// Histogram
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return the number of sampled 4k pages in each age bucket
+    ///
+    virtual histogram_type histogram() const;
+
+    /// Cold Ranges
+    ///
+    /// Returns the coldest ranges of guest physical memory. A range is a
+    /// run of contiguous, sampled 4k pages whose ages share the same
+    /// histogram bucket, and the age of a range is the age of its hottest
+    /// page. Ranges are sorted from coldest to hottest, with larger ranges
+    /// first when the ages are equal.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param count the max number of ranges to return
+    /// @return the coldest ranges
+    ///
+    virtual range_list_type cold_ranges(size_type count) const;
+
+    /// Bucket
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param age the age to convert
+    /// @return the histogram bucket for the provided age
+    ///
+    static size_type bucket(age_type age) noexcept;
+
+private:
+
+    static constexpr const age_type not_present = 0xFF;
+
+    struct table_type
+    {
+        std::array<age_type, intel_x64::ept::num_entries> ages;
+        size_type present;
+    };
+
+    struct large_type
+    {
+        size_type size;
+        age_type age;
+    };
+
+    static age_type next_age(age_type age, bool accessed) noexcept;
+
+    void update(integer_pointer gpa, size_type size, bool accessed);
+    void update_page(integer_pointer gpa, bool accessed);
+    void update_large(integer_pointer gpa, size_type size, bool accessed);
+
+    void forget(integer_pointer saddr, integer_pointer eaddr);
+    void forget_pages(integer_pointer saddr, integer_pointer eaddr);
+    void forget_large(integer_pointer saddr, integer_pointer eaddr);
+
+    void flush();
+    bool flushed();
+
+private:
+
+    vmcs_intel_x64_eapis *m_vmcs;
+    size_type m_pages_per_tick;
+
+    integer_pointer m_saddr;
+    integer_pointer m_eaddr;
+    integer_pointer m_cursor;
+
+    mutable std::mutex m_mutex;
+
+    histogram_type m_histogram;
+    std::map<integer_pointer, std::unique_ptr<table_type>> m_tables;
+    std::map<integer_pointer, large_type> m_large;
+
+    flush_ticket_type m_flush;
+    flush_delegate_type m_flush_delegate;
+
+public:
+
+    friend class eapis_ut;
+
+    page_age_sampler_intel_x64(page_age_sampler_intel_x64 &&) = delete;
+    page_age_sampler_intel_x64 &operator=(page_age_sampler_intel_x64 &&) = delete;
+
+    page_age_sampler_intel_x64(const page_age_sampler_intel_x64 &) = delete;
+    page_age_sampler_intel_x64 &operator=(const page_age_sampler_intel_x64 &) = delete;
+};
+
+#endif
@@ -0,0 +1,312 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef PAGE_MERGER_INTEL_X64_H
+#define PAGE_MERGER_INTEL_X64_H
+
+#include <gsl/gsl>
+
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <unordered_set>
+#include <unordered_map>
+
+#include <vmcs/vmcs_intel_x64_eapis.h>
+
+#ifndef PAGE_MERGER_PAGES_PER_SCAN
+#define PAGE_MERGER_PAGES_PER_SCAN 256
+#endif
+
+/// Page Merger
+///
+/// Implements same-page merging on top of the extended page tables. Each
+/// call to scan() examines a bounded window of 4k pages, picking up where
+/// the previous call left off. A page is only hashed when its EPT dirty bit
+/// is clear (i.e. it has not been written since it was last seen), and it
+/// only becomes a merge candidate once two scans in a row agree on its
+/// hash. Candidates with identical contents (hashes are only used as a
+/// hint, pages are always compared byte for byte prior to merging) are
+/// remapped read-only onto a single shared frame, and the frames that are
+/// no longer referenced are placed on a reclaimable list.
+///
+/// The extended page tables are shared by every vCPU, but INVEPT only
+/// invalidates the TLB of the CPU that executes it. Candidates are
+/// therefore write-protected first, and are only compared once every vCPU
+/// has flushed its EPT translations (see set_flush_delegate()), so that
+/// no vCPU can modify a page while, or after, it is compared. Likewise,
+/// a frame that is freed by merging only becomes reclaimable once every
+/// vCPU has flushed the translations that still point to it.
+///
+/// When the guest writes to a merged (or write-protected) page, the
+/// resulting EPT violation should be passed to handle_write_violation(),
+/// which breaks the sharing by giving the page a private copy of the
+/// shared frame. The copy only becomes writable once every vCPU has
+/// flushed its translations to the shared frame, and until then, the
+/// write keeps being retried.
+///
+/// @note: dirty tracking requires the EPT accessed / dirty flags to be
+///     enabled in the EPTP. If they are not, every page is re-hashed on
+///     each scan instead.
+///
+class page_merger_intel_x64
+{
+public:
+
+    using integer_pointer = uintptr_t;
+    using size_type = std::size_t;
+    using hash_type = uint64_t;
+    using frame_list_type = std::vector<integer_pointer>;
+    using qualification_type = uint64_t;
+
+    // A flush ticket counts the vCPUs that have yet to flush their EPT
+    // translations. The flush is complete once the count reaches 0.
+    using flush_ticket_type = std::shared_ptr<std::atomic<size_type>>;
+    using flush_delegate_type = std::function<flush_ticket_type()>;
+
+    /// Constructor
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param vmcs the vmcs whose extended page tables will be merged
+    /// @param pages_per_scan the max number of pages examined by scan()
+    ///
+    page_merger_intel_x64(gsl::not_null<vmcs_intel_x64_eapis *> vmcs,
+                          size_type pages_per_scan = PAGE_MERGER_PAGES_PER_SCAN);
+
+    /// Destructor
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    virtual ~page_merger_intel_x64() = default;
+
+    /// Set Flush Delegate
+    ///
+    /// Sets the function that is called each time the EPT translations of
+    /// every vCPU need to be flushed. The delegate should queue an INVEPT
+    /// on each vCPU, and return a ticket that each vCPU decrements once it
+    /// has performed its INVEPT. By default, the EPT translations are only
+    /// flushed on the current CPU, which is only correct if the EPT is used
+    /// by a single vCPU.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param delegate the function used to flush the EPT translations
+    ///
+    void set_flush_delegate(flush_delegate_type delegate);
+
+    /// Scan
+    ///
+    /// Examines up to pages_per_scan 4k pages in the provided guest physical
+    /// address range. Duplicates that are found are write-protected, and
+    /// are merged as soon as the EPT translations of every vCPU have been
+    /// flushed, which is either right away, or during a later scan. While a
+    /// flush is outstanding, scan() does nothing. Subsequent calls continue
+    /// where the previous call stopped, wrapping back to the start of the
+    /// range once the end is reached.
+    ///
+    /// @expects saddr < eaddr
+    /// @ensures none
+    ///
+    /// @param saddr the starting guest physical address of the range
+    /// @param eaddr the ending guest physical address of the range
+    /// @return the number of frames that were freed by this scan. Freed
+    ///     frames are reclaimable once the flush that follows completes.
+    ///
+    size_type scan(integer_pointer saddr, integer_pointer eaddr);
+
+    /// Handle Write Violation
+    ///
+    /// Breaks the sharing of a merged page (copy-on-write). If the page
+    /// is the last user of its shared frame, the frame is simply made
+    /// writable again, otherwise the page is given a private copy, which
+    /// is made writable by the first write violation that sees the EPT
+    /// flush of every vCPU complete (see set_flush_delegate()). Pages
+    /// that were write-protected, but not merged yet, are made writable
+    /// again and are no longer merge candidates. A write to a page that is
+    /// already writable comes from a stale translation, which is flushed.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param gpa the guest physical address that caused the EPT violation
+    /// @param qualification the exit qualification of the EPT violation
+    /// @return true if the violation was a write that has been handled,
+    ///     false otherwise
+    ///
+    bool handle_write_violation(integer_pointer gpa, qualification_type qualification);
+
+    /// Pin
+    ///
+    /// Excludes the 4k page containing the provided guest physical address
+    /// from merging, e.g. because the VMM writes to the page's frame
+    /// directly. A page that is write-protected, but not merged yet, is
+    /// made writable again. Pins are counted, so a page that is pinned more
+    /// than once has to be unpinned as many times.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param gpa the guest physical address of the page to pin
+    /// @return false if the page is currently merged (in which case it is
+    ///     not pinned), true otherwise
+    ///
+    bool pin(integer_pointer gpa);
+
+    /// Unpin
+    ///
+    /// Removes a pin that was added by pin(). Unpinning a page that is not
+    /// pinned does nothing.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param gpa the guest physical address of the page to unpin
+    ///
+    void unpin(integer_pointer gpa);
+
+    /// Merged Pages
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return the number of guest pages currently backed by a shared frame
+    ///
+    size_type merged_pages() const;
+
+    /// Shared Frames
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return the number of shared frames currently in use
+    ///
+    size_type shared_frames() const;
+
+    /// Reclaimable Frames
+    ///
+    /// Returns (and forgets) the list of frames that are no longer mapped
+    /// into the guest as a result of merging. These frames can be handed
+    /// back to the host. Frames that are not reclaimed are reused the next
+    /// time a merged page needs a private copy.
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return the list of physical addresses that can be reclaimed
+    ///
+    frame_list_type reclaim_frames();
+
+protected:
+
+    virtual hash_type hash_page(integer_pointer phys);
+    virtual bool compare_pages(integer_pointer phys1, integer_pointer phys2);
+    virtual void copy_page(integer_pointer dst_phys, integer_pointer src_phys);
+
+private:
+
+    struct candidate_type
+    {
+        integer_pointer gpa;
+        integer_pointer phys;
+        hash_type hash;
+    };
+
+    struct frame_type
+    {
+        hash_type hash;
+        size_type refs;
+    };
+
+    // A match is a write-protected candidate that is waiting for the EPT
+    // flush before it is compared, either with the shared frame that has
+    // the same hash, or with a write-protected partner page.
+    struct match_type
+    {
+        integer_pointer gpa;
+        integer_pointer partner;
+        hash_type hash;
+        bool stable;
+    };
+
+    void match(const candidate_type &candidate);
+    size_type merge_matches();
+    size_type merge(const match_type &match);
+    size_type join(integer_pointer gpa, hash_type hash);
+
+    ept_entry_intel_x64 *lookup(integer_pointer gpa);
+    ept_entry_intel_x64 *find_protected(integer_pointer gpa);
+    bool is_candidate(integer_pointer gpa, ept_entry_intel_x64 *epte) const;
+
+    void protect(gsl::not_null<ept_entry_intel_x64 *> epte, integer_pointer gpa);
+    void unprotect(integer_pointer gpa);
+
+    void share(gsl::not_null<ept_entry_intel_x64 *> epte, integer_pointer gpa, integer_pointer phys);
+    bool release(integer_pointer phys, integer_pointer shared);
+
+    void flush();
+    bool flushed();
+
+    integer_pointer alloc_frame();
+
+private:
+
+    vmcs_intel_x64_eapis *m_vmcs;
+    size_type m_pages_per_scan;
+
+    integer_pointer m_cursor;
+    mutable std::mutex m_mutex;
+
+    std::unordered_map<integer_pointer, hash_type> m_hashes;
+    std::unordered_map<hash_type, integer_pointer> m_unstable;
+    std::unordered_map<hash_type, integer_pointer> m_stable;
+    std::unordered_map<integer_pointer, frame_type> m_frames;
+    std::unordered_map<integer_pointer, integer_pointer> m_merged;
+
+    std::vector<match_type> m_matches;
+    std::unordered_set<integer_pointer> m_protected;
+    std::unordered_map<integer_pointer, flush_ticket_type> m_breaking;
+    std::unordered_map<integer_pointer, size_type> m_pinned;
+
+    flush_ticket_type m_flush;
+    flush_delegate_type m_flush_delegate;
+
+    frame_list_type m_released;
+    frame_list_type m_reclaimable;
+    std::vector<std::unique_ptr<uint8_t[]>> m_owned_frames;
+
+public:
+
+    friend class eapis_ut;
+
+    page_merger_intel_x64(page_merger_intel_x64 &&) = delete;
+    page_merger_intel_x64 &operator=(page_merger_intel_x64 &&) = delete;
+
+    page_merger_intel_x64(const page_merger_intel_x64 &) = delete;
+    page_merger_intel_x64 &operator=(const page_merger_intel_x64 &) = delete;
+};
+
+#endif
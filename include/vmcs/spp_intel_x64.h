@@ -0,0 +1,210 @@
+//
+// Bareflank Hypervisor
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef SPP_INTEL_X64_H
+#define SPP_INTEL_X64_H
+
+#include <gsl/gsl>
+
+#include <vector>
+#include <memory>
+#include <vmcs/ept_entry_intel_x64.h>
+
+// -----------------------------------------------------------------------------
+// Constants
+// -----------------------------------------------------------------------------
+
+// *INDENT-OFF*
+
+namespace intel_x64
+{
+namespace spp
+{
+    // 128 bytes per sub-page, 32 sub-pages per 4k page
+    constexpr const auto sub_page_size = 0x80UL;
+    constexpr const auto num_sub_pages = 32UL;
+
+    // Non-leaf SPPT entries only have a valid bit and a physical address
+    constexpr const auto valid = 0x0000000000000001UL;
+    constexpr const auto phys_addr_mask = 0x000FFFFFFFFFF000UL;
+
+    // Only the even bits of a leaf entry are defined (write permission for
+    // sub-page "i" is bit "2i"), the odd bits are reserved and must be 0.
+    constexpr const auto write_bits_mask = 0x5555555555555555UL;
+
+    // The SPPT is always 4-level (even with a 5-level EPT), so it can only
+    // describe guest physical addresses below 2^48
+    constexpr const auto max_gpa = 0x0001000000000000UL;
+}
+}
+
+// *INDENT-ON*
+
+// -----------------------------------------------------------------------------
+// Definition
+// -----------------------------------------------------------------------------
+
+/// Sub-Page Permission Table (SPPT)
+///
+/// The SPPT is walked by hardware when a write is made to a 4k page whose
+/// EPTE has write access disabled, and its sub-page write permissions bit
+/// set. It has the same layout as a 4-level EPT (indexed using the same
+/// guest physical address bits), but the leaf entries are 64bit sub-page
+/// permission vectors describing which 128 byte sub-pages can be written.
+///
+class spp_intel_x64
+{
+public:
+
+    using pointer = uintptr_t *;
+    using integer_pointer = uintptr_t;
+    using size_type = std::size_t;
+    using mask_type = uint32_t;
+    using vector_type = uint64_t;
+
+    /// Constructor
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param bits the guest physical address bits that index this table.
+    ///     The root of the SPPT is always the SPP PML4.
+    ///
+    spp_intel_x64(integer_pointer bits = intel_x64::ept::pml4::from);
+
+    /// Destructor
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    virtual ~spp_intel_x64() = default;
+
+    /// Physical Address
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return the physical address of this table. For the root table, this
+    ///     is the value that is written to the SPPTP in the VMCS.
+    ///
+    integer_pointer phys_addr() const noexcept
+    { return m_phys_addr; }
+
+    /// Global Size
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return returns the number of entries in the entire sppt
+    ///     tree. Note that this function is expensive.
+    ///
+    size_type global_size() const noexcept;
+
+    /// Set Write Mask
+    ///
+    /// Sets the sub-page write permissions for the 4k page containing the
+    /// provided guest physical address, creating any missing tables. Bit
+    /// "i" of the mask grants write access to bytes [i * 128, i * 128 + 127]
+    /// of the page.
+    ///
+    /// @expects gpa < intel_x64::spp::max_gpa
+    /// @ensures none
+    ///
+    /// @param gpa the guest physical address of the page
+    /// @param mask the sub-page write mask (1 == writable)
+    ///
+    void set_write_mask(integer_pointer gpa, mask_type mask);
+
+    /// Write Mask
+    ///
+    /// @expects gpa < intel_x64::spp::max_gpa
+    /// @ensures none
+    ///
+    /// @param gpa the guest physical address of the page
+    /// @return the sub-page write mask for the page. Throws if the page has
+    ///     no sub-page write permissions.
+    ///
+    mask_type write_mask(integer_pointer gpa) const;
+
+    /// Clear Write Mask
+    ///
+    /// Removes the sub-page permission vector for the page containing the
+    /// provided guest physical address. Empty tables are removed as well.
+    ///
+    /// @expects gpa < intel_x64::spp::max_gpa
+    /// @ensures none
+    ///
+    /// @param gpa the guest physical address of the page
+    ///
+    void clear_write_mask(integer_pointer gpa);
+
+    /// Mask To Vector
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param mask a 32bit sub-page write mask
+    /// @return the SPPT leaf entry for the mask (bit i moved to bit 2i)
+    ///
+    static vector_type mask_to_vector(mask_type mask) noexcept;
+
+    /// Vector To Mask
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param vector a SPPT leaf entry
+    /// @return the 32bit sub-page write mask for the entry
+    ///
+    static mask_type vector_to_mask(vector_type vector) noexcept;
+
+private:
+
+    auto empty() const noexcept
+    { return m_size == 0; }
+
+    auto leaf() const noexcept
+    { return m_bits == intel_x64::ept::pt::from; }
+
+private:
+
+    integer_pointer m_bits;
+    integer_pointer m_phys_addr;
+
+    gsl::span<integer_pointer> m_sppt;
+    std::unique_ptr<integer_pointer[]> m_sppt_owner;
+
+    size_type m_size;
+    std::vector<bool> m_present;
+    std::vector<std::unique_ptr<spp_intel_x64>> m_sppts;
+
+public:
+
+    friend class eapis_ut;
+
+    spp_intel_x64(spp_intel_x64 &&) noexcept = default;
+    spp_intel_x64 &operator=(spp_intel_x64 &&) noexcept = default;
+
+    spp_intel_x64(const spp_intel_x64 &) = delete;
+    spp_intel_x64 &operator=(const spp_intel_x64 &) = delete;
+};
+
+#endif
@@ -24,7 +24,11 @@
 
 #include <gsl/gsl>
 
+#include <set>
+#include <array>
+#include <atomic>
 #include <mutex>
+#include <functional>
 #include <vector>
 #include <memory>
 
@@ -32,11 +36,33 @@
 
 #include <vmcs/ept_intel_x64.h>
 #include <vmcs/ept_attr_intel_x64.h>
+#include <vmcs/vpid_allocator_intel_x64.h>
+#include <vmcs/spp_intel_x64.h>
+#include <vmcs/io_bitmaps_intel_x64.h>
 
 #include <intrinsics/x64.h>
 #include <intrinsics/msrs_x64.h>
+#include <intrinsics/msrs_intel_x64.h>
 #include <intrinsics/portio_x64.h>
 
+#ifndef VPID_INVALIDATION_QUEUE_SIZE
+#define VPID_INVALIDATION_QUEUE_SIZE 16
+#endif
+
+/// EPT Configuration
+///
+/// Describes how enable_ept() sets up the EPT Pointer (EPTP). The memory
+/// type is the memory type used by hardware to access the EPT paging
+/// structures (only uc and wb are valid), and the accessed / dirty flags
+/// enable hardware tracking of accessed / dirty pages (needed by features
+/// that track the guest's working set).
+///
+struct ept_config_intel_x64
+{
+    uint64_t memory_type = intel_x64::ept::memory_type::wb;
+    bool accessed_and_dirty_flags = false;
+};
+
 class vmcs_intel_x64_eapis : public vmcs_intel_x64
 {
 public:
@@ -45,9 +71,17 @@ public:
     using port_list_type = std::vector<port_type>;
     using msr_type = x64::msrs::field_type;
     using msr_list_type = std::vector<msr_type>;
+    using msr_value_type = x64::msrs::value_type;
     using integer_pointer = uintptr_t;
     using attr_type = intel_x64::ept::memory_attr::attr_type;
     using size_type = size_t;
+    using spp_mask_type = spp_intel_x64::mask_type;
+    using ept_config_type = ept_config_intel_x64;
+    using entry_delegate_type = std::function<void()>;
+
+    // The MSR load / store areas are one page each (16 bytes per MSR),
+    // which is well within the max recommended by IA32_VMX_MISC (512).
+    static constexpr const size_type max_auto_switched_msrs = 0x100;
 
     /// Default Constructor
     ///
@@ -61,13 +95,16 @@ public:
     /// @expects
     /// @ensures
     ///
-    ~vmcs_intel_x64_eapis() override  = default;
+    ~vmcs_intel_x64_eapis() override;
 
     /// Enable VPID
     ///
-    /// Enables VPID. VPIDs cannot be reused. Re-Enabling VPID
-    /// will not consume an additional VPID, but creating a new
-    /// VMCS will, so reuse VMCS structures if possible.
+    /// Enables VPID. A VPID is allocated the first time VPID is enabled
+    /// (see vpid_allocator_intel_x64), and is kept until the VMCS is
+    /// destroyed, so re-enabling VPID will not consume an additional VPID.
+    /// If the VPID was used by a VMCS that has since been destroyed, its
+    /// cached translations are invalidated on first use. Throws if every
+    /// VPID is in use.
     ///
     /// Example:
     /// @code
@@ -93,6 +130,125 @@ public:
     ///
     virtual void disable_vpid();
 
+    /// Invalidate VPID Address
+    ///
+    /// Invalidates the cached translations of the provided guest linear
+    /// address that are tagged with this VMCS's VPID (INVVPID type 0). If
+    /// the CPU does not support individual-address invalidation, the entire
+    /// context is invalidated instead. Does nothing if VPID is disabled, as
+    /// the CPU does not keep the guest's translations across VM exits in
+    /// that case.
+    ///
+    /// Example:
+    /// @code
+    /// this->invalidate_vpid_address(0x1000);
+    /// @endcode
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param addr the guest linear address to invalidate
+    ///
+    virtual void invalidate_vpid_address(integer_pointer addr);
+
+    /// Invalidate VPID Context
+    ///
+    /// Invalidates all of the cached translations tagged with this VMCS's
+    /// VPID (INVVPID type 1), falling back to an all-context invalidation
+    /// if single-context invalidation is not supported. Does nothing if
+    /// VPID is disabled.
+    ///
+    /// Example:
+    /// @code
+    /// this->invalidate_vpid_context();
+    /// @endcode
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    virtual void invalidate_vpid_context();
+
+    /// Invalidate All VPID Contexts
+    ///
+    /// Invalidates the cached translations of every VPID (INVVPID type 2)
+    /// on the current CPU. If all-context invalidation is not supported,
+    /// only this VMCS's VPID is invalidated (INVVPID type 1), which does
+    /// nothing if VPID is disabled.
+    ///
+    /// Example:
+    /// @code
+    /// this->invalidate_all_vpid_contexts();
+    /// @endcode
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    virtual void invalidate_all_vpid_contexts();
+
+    /// Queue VPID Invalidation
+    ///
+    /// Queues the invalidation of the provided guest linear address, which
+    /// is performed right before the next VM entry (see resume()). Queued
+    /// addresses are coalesced by 4k page, and if more than
+    /// VPID_INVALIDATION_QUEUE_SIZE pages are queued, the queue is replaced
+    /// by a single-context invalidation. This way, a handler that changes
+    /// several guest mappings only invalidates what it touched, once.
+    ///
+    /// @note: the queue belongs to this VMCS, and must only be used by the
+    ///     vCPU that owns it.
+    ///
+    /// Example:
+    /// @code
+    /// this->queue_vpid_invalidation(0x1000);
+    /// @endcode
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param addr the guest linear address to invalidate
+    ///
+    virtual void queue_vpid_invalidation(integer_pointer addr);
+
+    /// Flush VPID Invalidations
+    ///
+    /// Performs (and clears) the queued VPID invalidations. This is called
+    /// automatically by resume().
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    virtual void flush_vpid_invalidations();
+
+    /// Set Entry Delegate
+    ///
+    /// Sets a delegate that is called by resume() right before the guest
+    /// is entered, and before the queued VPID invalidations are flushed.
+    /// This gives the exit handler a chance to run its VM entry work even
+    /// when the guest is resumed by code that it does not own (e.g. the
+    /// base exit handler).
+    ///
+    /// Example:
+    /// @code
+    /// this->set_entry_delegate([&]{ bfinfo << "entering the guest\n"; });
+    /// @endcode
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param delegate the delegate to call on VM entry, or nullptr
+    ///
+    virtual void set_entry_delegate(const entry_delegate_type &delegate);
+
+    /// Resume
+    ///
+    /// Calls the entry delegate (if any), flushes the queued VPID
+    /// invalidations, and then resumes the guest.
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    void resume() override;
+
     /// Trap On IO Access
     ///
     /// Sets a '1' in IO bitmaps corresponding with the provided port. All
@@ -165,11 +321,52 @@ public:
     ///
     virtual void pass_through_all_io_accesses();
 
+    /// Trap On IO Range
+    ///
+    /// Sets a '1' in IO bitmaps corresponding with each port in the
+    /// provided (inclusive) range. Unlike calling trap_on_io_access for
+    /// each port, the bitmaps are updated 64 ports at a time.
+    ///
+    /// Example:
+    /// @code
+    /// // Trap on PCI configuration space reads / writes
+    /// this->trap_on_io_range(0xCF8, 0xCFF);
+    /// @endcode
+    ///
+    /// @expects first <= last
+    /// @ensures
+    ///
+    /// @param first the first port to trap on
+    /// @param last the last port to trap on
+    ///
+    virtual void trap_on_io_range(port_type first, port_type last);
+
+    /// Pass Through IO Range
+    ///
+    /// Sets a '0' in IO bitmaps corresponding with each port in the
+    /// provided (inclusive) range. Unlike calling pass_through_io_access
+    /// for each port, the bitmaps are updated 64 ports at a time.
+    ///
+    /// Example:
+    /// @code
+    /// // Pass through PCI configuration space reads / writes
+    /// this->pass_through_io_range(0xCF8, 0xCFF);
+    /// @endcode
+    ///
+    /// @expects first <= last
+    /// @ensures
+    ///
+    /// @param first the first port to pass through
+    /// @param last the last port to pass through
+    ///
+    virtual void pass_through_io_range(port_type first, port_type last);
+
     /// White List IO Access
     ///
     /// Runs trap_on_all_io_accesses, and then runs pass_through_io_access on
     /// each port provided (i.e. white-listed ports are passed through, all
-    /// other ports trap to the hypervisor)
+    /// other ports trap to the hypervisor). Runs of consecutive ports are
+    /// passed through using pass_through_io_range.
     ///
     /// Example:
     /// @code
@@ -189,7 +386,8 @@ public:
     ///
     /// Runs pass_through_all_io_accessed, and then runs trap_on_io_access on
     /// each port provided (i.e. black-listed ports are trapped, all
-    /// other ports are passed through)
+    /// other ports are passed through). Runs of consecutive ports are
+    /// trapped using trap_on_io_range.
     ///
     /// Example:
     /// @code
@@ -205,17 +403,316 @@ public:
     ///
     virtual void blacklist_io_access(const port_list_type &ports);
 
+    /// Share IO Bitmaps
+    ///
+    /// By default, each vCPU shares the same IO bitmaps (see
+    /// shared_io_bitmaps), so trapping / passing through a port on one
+    /// vCPU applies to every vCPU that shares the bitmaps. A vCPU that
+    /// stops sharing gets a private copy of the shared bitmaps the next
+    /// time its IO policy is changed (copy-on-write), and from then on,
+    /// its policy is independent of the other vCPUs. A vCPU that starts
+    /// sharing again drops its private copy.
+    ///
+    /// Example:
+    /// @code
+    /// // Trap on the serial port on this vCPU only
+    /// this->share_io_bitmaps(false);
+    /// this->trap_on_io_access(0x3F8);
+    /// @endcode
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param shared true to use the shared IO bitmaps, false otherwise
+    ///
+    virtual void share_io_bitmaps(bool shared);
+
+    /// Shared IO Bitmaps
+    ///
+    /// The shared IO bitmaps are reset (every port is passed through) when
+    /// a VMCS is set up while no other VMCS is using them, so a policy does
+    /// not survive a restart of the hypervisor.
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @return the IO bitmaps shared by each vCPU that has not diverged
+    ///
+    static std::shared_ptr<io_bitmaps_intel_x64> shared_io_bitmaps();
+
+    /// Trap On RDMSR Access
+    ///
+    /// Sets a '1' in the read bitmap of the MSR bitmaps corresponding with
+    /// the provided MSR. All attempts made by the guest to read the
+    /// provided MSR will trap to hypervisor. MSRs that are not covered by
+    /// the MSR bitmaps (i.e. outside of [0x0, 0x1FFF] and
+    /// [0xC0000000, 0xC0001FFF]) always trap.
+    ///
+    /// Example:
+    /// @code
+    /// // Trap on reads from IA32_APIC_BASE
+    /// this->trap_on_rdmsr_access(0x1B);
+    /// @endcode
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param msr the msr to trap on
+    ///
+    virtual void trap_on_rdmsr_access(msr_type msr);
+
+    /// Trap On WRMSR Access
+    ///
+    /// Sets a '1' in the write bitmap of the MSR bitmaps corresponding with
+    /// the provided MSR. All attempts made by the guest to write the
+    /// provided MSR will trap to hypervisor.
+    ///
+    /// Example:
+    /// @code
+    /// // Trap on writes to IA32_APIC_BASE
+    /// this->trap_on_wrmsr_access(0x1B);
+    /// @endcode
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param msr the msr to trap on
+    ///
+    virtual void trap_on_wrmsr_access(msr_type msr);
+
+    /// Trap On All RDMSR Accesses
+    ///
+    /// Sets a '1' in the read bitmap of the MSR bitmaps for all MSRs
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    virtual void trap_on_all_rdmsr_accesses();
+
+    /// Trap On All WRMSR Accesses
+    ///
+    /// Sets a '1' in the write bitmap of the MSR bitmaps for all MSRs
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    virtual void trap_on_all_wrmsr_accesses();
+
+    /// Pass Through RDMSR Access
+    ///
+    /// Sets a '0' in the read bitmap of the MSR bitmaps corresponding with
+    /// the provided MSR. All attempts made by the guest to read the
+    /// provided MSR will be executed by the guest and will not trap to the
+    /// hypervisor. Throws if the MSR is not covered by the MSR bitmaps.
+    ///
+    /// Example:
+    /// @code
+    /// // Pass through reads from IA32_APIC_BASE
+    /// this->pass_through_rdmsr_access(0x1B);
+    /// @endcode
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param msr the msr to pass through
+    ///
+    virtual void pass_through_rdmsr_access(msr_type msr);
+
+    /// Pass Through WRMSR Access
+    ///
+    /// Sets a '0' in the write bitmap of the MSR bitmaps corresponding with
+    /// the provided MSR. All attempts made by the guest to write the
+    /// provided MSR will be executed by the guest and will not trap to the
+    /// hypervisor. Throws if the MSR is not covered by the MSR bitmaps.
+    ///
+    /// Example:
+    /// @code
+    /// // Pass through writes to IA32_APIC_BASE
+    /// this->pass_through_wrmsr_access(0x1B);
+    /// @endcode
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param msr the msr to pass through
+    ///
+    virtual void pass_through_wrmsr_access(msr_type msr);
+
+    /// Pass Through All RDMSR Accesses
+    ///
+    /// Sets a '0' in the read bitmap of the MSR bitmaps for all MSRs. Note
+    /// that MSRs that are not covered by the MSR bitmaps still trap.
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    virtual void pass_through_all_rdmsr_accesses();
+
+    /// Pass Through All WRMSR Accesses
+    ///
+    /// Sets a '0' in the write bitmap of the MSR bitmaps for all MSRs. Note
+    /// that MSRs that are not covered by the MSR bitmaps still trap.
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    virtual void pass_through_all_wrmsr_accesses();
+
+    /// White List RDMSR Access
+    ///
+    /// Runs trap_on_all_rdmsr_accesses, and then runs
+    /// pass_through_rdmsr_access on each MSR provided (i.e. white-listed
+    /// MSRs are passed through, all other MSRs trap to the hypervisor).
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param msrs the msrs to whitelist
+    ///
+    virtual void whitelist_rdmsr_access(const msr_list_type &msrs);
+
+    /// White List WRMSR Access
+    ///
+    /// Runs trap_on_all_wrmsr_accesses, and then runs
+    /// pass_through_wrmsr_access on each MSR provided (i.e. white-listed
+    /// MSRs are passed through, all other MSRs trap to the hypervisor).
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param msrs the msrs to whitelist
+    ///
+    virtual void whitelist_wrmsr_access(const msr_list_type &msrs);
+
+    /// Black List RDMSR Access
+    ///
+    /// Runs pass_through_all_rdmsr_accesses, and then runs
+    /// trap_on_rdmsr_access on each MSR provided (i.e. black-listed MSRs
+    /// are trapped, all other MSRs are passed through).
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param msrs the msrs to blacklist
+    ///
+    virtual void blacklist_rdmsr_access(const msr_list_type &msrs);
+
+    /// Black List WRMSR Access
+    ///
+    /// Runs pass_through_all_wrmsr_accesses, and then runs
+    /// trap_on_wrmsr_access on each MSR provided (i.e. black-listed MSRs
+    /// are trapped, all other MSRs are passed through).
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param msrs the msrs to blacklist
+    ///
+    virtual void blacklist_wrmsr_access(const msr_list_type &msrs);
+
+    /// Add Auto Switched MSR
+    ///
+    /// Has the CPU switch the provided MSR between a guest and a host value
+    /// on each VM entry / exit, instead of switching it in software. The
+    /// guest value is loaded on VM entry and saved on VM exit (so changes
+    /// made by the guest are kept), while the host value is loaded on VM
+    /// exit. Adding an MSR that is already auto switched replaces its
+    /// values.
+    ///
+    /// IA32_EFER and IA32_PAT are switched using their dedicated VMCS
+    /// fields, which are cheaper than the MSR load / store areas. For
+    /// these, only the guest value is used, as the host fields already
+    /// hold the VMM's own values, and the load / save controls are
+    /// enabled for good (see remove_auto_switched_msr()). All other MSRs
+    /// are added to the VM-entry MSR-load, VM-exit MSR-store and VM-exit
+    /// MSR-load areas (up to max_auto_switched_msrs).
+    ///
+    /// Example:
+    /// @code
+    /// this->add_auto_switched_msr(0xC0000082, guest_lstar, host_lstar);
+    /// @endcode
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param msr the MSR to switch
+    /// @param guest_value the value of the MSR while the guest is running
+    /// @param host_value the value of the MSR while the VMM is running
+    ///     (ignored for IA32_EFER and IA32_PAT)
+    ///
+    virtual void add_auto_switched_msr(msr_type msr, msr_value_type guest_value,
+                                       msr_value_type host_value);
+
+    /// Remove Auto Switched MSR
+    ///
+    /// Stops switching the provided MSR (i.e. the guest and the VMM share
+    /// the same value from now on). Removing an MSR that is not auto
+    /// switched does nothing. IA32_EFER and IA32_PAT are always switched
+    /// by the VMCS, so they cannot be removed (this throws), and their
+    /// load / save controls stay enabled once they are added.
+    ///
+    /// Example:
+    /// @code
+    /// this->remove_auto_switched_msr(0xC0000082);
+    /// @endcode
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param msr the MSR to stop switching
+    ///
+    virtual void remove_auto_switched_msr(msr_type msr);
+
+    /// Auto Switched MSR Guest Value
+    ///
+    /// Example:
+    /// @code
+    /// auto lstar = this->auto_switched_msr_guest_value(0xC0000082);
+    /// @endcode
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param msr the MSR to lookup
+    /// @return the guest's value of the provided MSR, as of the last VM
+    ///     exit. Throws if the MSR is not auto switched.
+    ///
+    virtual msr_value_type auto_switched_msr_guest_value(msr_type msr) const;
+
+    /// Auto Switched MSRs
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @return the MSRs that are switched using the MSR load / store
+    ///     areas (i.e. not including IA32_EFER and IA32_PAT)
+    ///
+    virtual msr_list_type auto_switched_msrs() const;
+
     /// Enable EPT
     ///
     /// Enables EPT, and sets up the EPT Pointer (EPTP) in the VMCS.
     /// By default, the EPTP is setup with the paging structures to use
     /// write_back memory, and the accessed / dirty bits are disabled.
-    /// Once enabling EPT, you can change these values if desired.
+    /// The provided configuration is validated against the EPT
+    /// capabilities that were read when this VMCS was created, and
+    /// enable_ept() throws if the hardware does not support it.
+    ///
+    /// The page walk length is set by EPT_PAGE_WALK_LENGTH (4 by default).
+    /// A 5-level page walk is only used if it is supported by hardware.
+    ///
+    /// Example:
+    /// @code
+    /// // Enable EPT with accessed / dirty tracking
+    /// this->enable_ept({intel_x64::ept::memory_type::wb, true});
+    /// @endcode
     ///
     /// @expects
     /// @ensures
     ///
-    void enable_ept();
+    /// @param config the EPTP configuration
+    ///
+    void enable_ept(const ept_config_type &config = ept_config_type{});
 
     /// Disable EPT
     ///
@@ -381,6 +878,97 @@ public:
     ///
     gsl::not_null<ept_entry_intel_x64 *> gpa_to_epte(integer_pointer gpa);
 
+    /// Visit EPTE Range
+    ///
+    /// Calls the provided function for each mapped page in the extended
+    /// page tables that overlaps the provided guest physical address range,
+    /// while holding the EPT lock. This is far cheaper than calling
+    /// gpa_to_epte for each page in the range as only tables that are
+    /// present are walked. The function has the following signature, and
+    /// returns false to stop the walk early:
+    ///
+    /// @code
+    /// bool func(integer_pointer gpa, size_type size_bytes, ept_entry_intel_x64 *epte)
+    /// @endcode
+    ///
+    /// @note: the function must not call any of the other EPT APIs as the
+    ///     EPT lock is already held.
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param saddr the starting guest physical address of the range
+    /// @param eaddr the ending guest physical address of the range
+    /// @param func the function to call for each mapped page
+    /// @return false if the walk was stopped by func, true otherwise
+    ///
+    template<class F>
+    bool visit_epte_range(integer_pointer saddr, integer_pointer eaddr, F &&func)
+    {
+        std::lock_guard<std::mutex> guard(eptp_mutex());
+        return eptp()->visit_range(saddr, eaddr, std::forward<F>(func));
+    }
+
+    /// Enable Sub-Page Write Permissions (SPP)
+    ///
+    /// Enables SPP, and sets up the SPP Table Pointer (SPPTP) in the VMCS.
+    /// SPP requires EPT, and is only supported by some hardware, in which
+    /// case this function will throw.
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    void enable_spp();
+
+    /// Disable Sub-Page Write Permissions (SPP)
+    ///
+    /// Disables SPP, and sets the SPP Table Pointer (SPPTP) in the VMCS to 0.
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    void disable_spp();
+
+    /// Set SPP Write Mask
+    ///
+    /// Write protects the 4k page containing the provided guest physical
+    /// address with a granularity of 128 bytes. Bit "i" of the mask allows
+    /// the guest to write bytes [i * 128, i * 128 + 127] of the page, while
+    /// writes to a sub-page whose bit is 0 generate an EPT violation. This
+    /// way, a small structure can be protected without trapping on writes
+    /// to unrelated data that happens to share the same page.
+    ///
+    /// @note: the page must be mapped using map_4k, below
+    ///     intel_x64::spp::max_gpa (the SPPT is always 4-level).
+    ///
+    /// Example:
+    /// @code
+    /// // Only allow writes to the first 128 bytes of the page
+    /// this->set_spp_write_mask(0x1000, 0x00000001);
+    /// @endcode
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param gpa the guest physical address of the page to protect
+    /// @param mask the sub-page write mask (1 == writable)
+    ///
+    void set_spp_write_mask(integer_pointer gpa, spp_mask_type mask);
+
+    /// Clear SPP Write Mask
+    ///
+    /// Removes the sub-page write protection for the 4k page containing the
+    /// provided guest physical address. The page gets back the write access
+    /// it had before set_spp_write_mask() was first called on it, so a page
+    /// that was read-only stays read-only.
+    ///
+    /// @expects
+    /// @ensures
+    ///
+    /// @param gpa the guest physical address of the page to unprotect
+    ///
+    void clear_spp_write_mask(integer_pointer gpa);
+
 protected:
 
     void write_fields(gsl::not_null<vmcs_intel_x64_state *> host_state,
@@ -388,19 +976,59 @@ protected:
 
     virtual std::mutex &eptp_mutex() const;
     virtual gsl::not_null<ept_intel_x64 *> eptp() const;
+    virtual gsl::not_null<spp_intel_x64 *> sppt() const;
+    virtual std::set<integer_pointer> &spp_read_only_pages() const;
 
     void map(integer_pointer gpa, integer_pointer phys_addr, attr_type attr, size_type size);
 
+    gsl::not_null<io_bitmaps_intel_x64 *> io_bitmaps();
+    void write_io_bitmap_addresses();
+
+    void setup_io_bitmaps();
+    static std::atomic<size_type> &io_bitmaps_users();
+
+    void set_msr_bitmap_bit(msr_type msr, size_type offset, bool trap);
+
+    void write_auto_switched_msr_fields();
+    size_type find_auto_switched_msr(msr_type msr) const;
+
+    // Each entry of an MSR load / store area is 16 bytes (see the Intel
+    // SDM, Vol. 3, Section 24.7.2).
+    struct auto_msr_entry_type
+    {
+        uint32_t msr;
+        uint32_t reserved;
+        uint64_t value;
+    };
+
 protected:
 
     friend class eapis_ut;
 
     intel_x64::vmcs::value_type m_vpid;
+    bool m_vpid_flush_pending;
+
+    bool m_vpid_invalidate_context;
+    size_type m_vpid_invalidation_count;
+    std::array<integer_pointer, VPID_INVALIDATION_QUEUE_SIZE> m_vpid_invalidations;
+    intel_x64::msrs::value_type m_ept_vpid_cap;
+
+    bool m_io_bitmaps_shared;
+    bool m_io_bitmaps_user;
+    std::shared_ptr<io_bitmaps_intel_x64> m_io_bitmaps;
+
+    std::unique_ptr<uint8_t[]> m_msr_bitmap;
+    gsl::span<uint8_t> m_msr_bitmap_view;
+
+    // The guest area is used as both the VM-entry MSR-load area and the
+    // VM-exit MSR-store area, so that the values saved on VM exit are the
+    // values loaded on the next VM entry. The host area is the VM-exit
+    // MSR-load area. Both are allocated the first time an MSR is added.
+    size_type m_auto_msr_count;
+    std::unique_ptr<auto_msr_entry_type[]> m_auto_msr_guest_area;
+    std::unique_ptr<auto_msr_entry_type[]> m_auto_msr_host_area;
 
-    std::unique_ptr<uint8_t[]> m_io_bitmapa;
-    std::unique_ptr<uint8_t[]> m_io_bitmapb;
-    gsl::span<uint8_t> m_io_bitmapa_view;
-    gsl::span<uint8_t> m_io_bitmapb_view;
+    entry_delegate_type m_entry_delegate;
 };
 
 #endif
@@ -0,0 +1,178 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef VMCS_INTEL_X64_EAPIS_CONTROL_FIELDS_H
+#define VMCS_INTEL_X64_EAPIS_CONTROL_FIELDS_H
+
+#include <vmcs/vmcs_intel_x64_32bit_control_fields.h>
+#include <vmcs/vmcs_intel_x64_64bit_control_fields.h>
+
+#include <intrinsics/msrs_x64.h>
+#include <intrinsics/msrs_intel_x64.h>
+#include <intrinsics/vmx_intel_x64.h>
+
+// -----------------------------------------------------------------------------
+// Definitions
+// -----------------------------------------------------------------------------
+
+// The following VMCS fields (and MSR fields) are used by the extended APIs,
+// but are not (yet) provided by the hypervisor's definitions.
+
+// *INDENT-OFF*
+
+namespace intel_x64
+{
+namespace vmcs
+{
+
+namespace spp_table_pointer
+{
+    constexpr const auto addr = 0x0000000000002030UL;
+    constexpr const auto name = "spp_table_pointer";
+
+    inline auto get()
+    { return vm::read(addr, name); }
+
+    template<class T, class = typename std::enable_if<std::is_integral<T>::value>::type>
+    void set(T val) { vm::write(addr, val, name); }
+}
+
+namespace secondary_processor_based_vm_execution_controls
+{
+    namespace sub_page_write_permissions
+    {
+        constexpr const auto mask = 0x0000000000800000UL;
+        constexpr const auto from = 23;
+        constexpr const auto name = "sub_page_write_permissions";
+
+        inline auto is_allowed1()
+        { return ((x64::msrs::get(msrs::ia32_vmx_procbased_ctls2::addr) >> 32) & mask) != 0; }
+
+        inline auto is_enabled()
+        { return (vm::read(secondary_processor_based_vm_execution_controls::addr, name) & mask) != 0; }
+
+        inline auto is_disabled()
+        { return !is_enabled(); }
+
+        inline void enable()
+        {
+            if (!is_allowed1())
+                throw std::logic_error("enable failed: "_s + name + " is not supported");
+
+            auto &&ctls = vm::read(secondary_processor_based_vm_execution_controls::addr, name);
+            vm::write(secondary_processor_based_vm_execution_controls::addr, ctls | mask, name);
+        }
+
+        inline void disable()
+        {
+            auto &&ctls = vm::read(secondary_processor_based_vm_execution_controls::addr, name);
+            vm::write(secondary_processor_based_vm_execution_controls::addr, ctls & ~mask, name);
+        }
+    }
+}
+
+}
+}
+
+namespace intel_x64
+{
+namespace msrs
+{
+
+namespace ia32_vmx_ept_vpid_cap
+{
+    namespace page_walk_length_of_5
+    {
+        constexpr const auto mask = 0x0000000000000080UL;
+        constexpr const auto from = 7;
+        constexpr const auto name = "page_walk_length_of_5";
+
+        inline auto is_supported(value_type caps) noexcept
+        { return (caps & mask) != 0; }
+    }
+
+    namespace memory_type_uncacheable
+    {
+        constexpr const auto mask = 0x0000000000000100UL;
+        constexpr const auto from = 8;
+        constexpr const auto name = "memory_type_uncacheable";
+
+        inline auto is_supported(value_type caps) noexcept
+        { return (caps & mask) != 0; }
+    }
+
+    namespace memory_type_write_back
+    {
+        constexpr const auto mask = 0x0000000000004000UL;
+        constexpr const auto from = 14;
+        constexpr const auto name = "memory_type_write_back";
+
+        inline auto is_supported(value_type caps) noexcept
+        { return (caps & mask) != 0; }
+    }
+
+    namespace accessed_dirty_flags
+    {
+        constexpr const auto mask = 0x0000000000200000UL;
+        constexpr const auto from = 21;
+        constexpr const auto name = "accessed_dirty_flags";
+
+        inline auto is_supported(value_type caps) noexcept
+        { return (caps & mask) != 0; }
+    }
+
+    namespace invvpid_individual_address
+    {
+        constexpr const auto mask = 0x0000010000000000UL;
+        constexpr const auto from = 40;
+        constexpr const auto name = "invvpid_individual_address";
+
+        inline auto is_supported(value_type caps) noexcept
+        { return (caps & mask) != 0; }
+    }
+
+    namespace invvpid_single_context
+    {
+        constexpr const auto mask = 0x0000020000000000UL;
+        constexpr const auto from = 41;
+        constexpr const auto name = "invvpid_single_context";
+
+        inline auto is_supported(value_type caps) noexcept
+        { return (caps & mask) != 0; }
+    }
+
+    namespace invvpid_all_context
+    {
+        constexpr const auto mask = 0x0000040000000000UL;
+        constexpr const auto from = 42;
+        constexpr const auto name = "invvpid_all_context";
+
+        inline auto is_supported(value_type caps) noexcept
+        { return (caps & mask) != 0; }
+    }
+}
+
+}
+}
+
+// *INDENT-ON*
+
+#endif
@@ -0,0 +1,153 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef VPID_ALLOCATOR_INTEL_X64_H
+#define VPID_ALLOCATOR_INTEL_X64_H
+
+#include <gsl/gsl>
+
+#include <array>
+#include <atomic>
+
+/// VPID Allocator
+///
+/// Hands out the 65,535 usable VPIDs (VPID 0 is reserved for the VMM)
+/// using a bitmap with one bit per VPID. Allocation and release are lock
+/// free (a compare-and-swap on a single 64bit word of the bitmap), so vCPUs
+/// can be created and destroyed concurrently.
+///
+/// Allocation starts searching where the previous allocation left off, so
+/// a released VPID is only handed out again once every other VPID has been
+/// tried, which gives the TLB as much time as possible to evict the stale
+/// entries of the previous owner. The allocator also keeps a high-water
+/// mark (one past the highest VPID ever handed out). A VPID below the mark
+/// might have been used before, and is reported as recycled, in which case
+/// the new owner must invalidate it (INVVPID) before it is used. VPIDs
+/// above the mark have never been used, and do not need to be invalidated.
+///
+class vpid_allocator_intel_x64
+{
+public:
+
+    using vpid_type = uint16_t;
+    using size_type = std::size_t;
+
+    static constexpr const size_type num_vpids = 0x10000UL;
+
+    /// Default Constructor
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    vpid_allocator_intel_x64() noexcept;
+
+    /// Destructor
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    virtual ~vpid_allocator_intel_x64() = default;
+
+    /// Allocate
+    ///
+    /// @expects none
+    /// @ensures vpid != 0
+    ///
+    /// @param recycled set to true if the VPID might have been used by a
+    ///     previous owner (i.e. its cached translations must be
+    ///     invalidated before it is used), false otherwise
+    /// @return a VPID that is not in use. Throws if every VPID is in use.
+    ///
+    vpid_type allocate(bool &recycled);
+
+    /// Release
+    ///
+    /// Returns a VPID to the allocator.
+    ///
+    /// @expects vpid != 0
+    /// @ensures none
+    ///
+    /// @param vpid the VPID to release
+    ///
+    void release(vpid_type vpid);
+
+    /// Is Allocated
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @param vpid the VPID to lookup
+    /// @return true if the VPID is in use, false otherwise
+    ///
+    bool is_allocated(vpid_type vpid) const noexcept;
+
+    /// Allocated
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return the number of VPIDs that are in use (not including VPID 0)
+    ///
+    size_type allocated() const noexcept
+    { return m_allocated.load(std::memory_order_relaxed); }
+
+    /// High Water Mark
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return one past the highest VPID that has ever been allocated
+    ///
+    size_type high_water_mark() const noexcept
+    { return m_high_water_mark.load(std::memory_order_relaxed); }
+
+    /// Instance
+    ///
+    /// @expects none
+    /// @ensures none
+    ///
+    /// @return the allocator shared by every vCPU
+    ///
+    static vpid_allocator_intel_x64 &instance() noexcept;
+
+private:
+
+    static constexpr const size_type bits_per_word = 64;
+    static constexpr const size_type num_words = num_vpids / bits_per_word;
+
+    std::array<std::atomic<uint64_t>, num_words> m_bitmap;
+
+    std::atomic<size_type> m_cursor;
+    std::atomic<size_type> m_allocated;
+    std::atomic<size_type> m_high_water_mark;
+
+public:
+
+    friend class eapis_ut;
+
+    vpid_allocator_intel_x64(vpid_allocator_intel_x64 &&) = delete;
+    vpid_allocator_intel_x64 &operator=(vpid_allocator_intel_x64 &&) = delete;
+
+    vpid_allocator_intel_x64(const vpid_allocator_intel_x64 &) = delete;
+    vpid_allocator_intel_x64 &operator=(const vpid_allocator_intel_x64 &) = delete;
+};
+
+#endif
@@ -70,7 +70,20 @@ SOURCES+=exit_handler_intel_x64_eapis_verifiers_vmcall.cpp
 SOURCES+=exit_handler_intel_x64_eapis_io_instruction_emulation.cpp
 SOURCES+=exit_handler_intel_x64_eapis_io_instruction_vmcall.cpp
 SOURCES+=exit_handler_intel_x64_eapis_monitor_trap_emulation.cpp
+SOURCES+=exit_handler_intel_x64_eapis_stepping.cpp
+SOURCES+=exit_handler_intel_x64_eapis_ept_violation_emulation.cpp
 SOURCES+=exit_handler_intel_x64_eapis_vpid_vmcall.cpp
+SOURCES+=exit_handler_intel_x64_eapis_page_age_vmcall.cpp
+SOURCES+=exit_handler_intel_x64_eapis_msr_emulation.cpp
+SOURCES+=exit_handler_intel_x64_eapis_msr_vmcall.cpp
+SOURCES+=exit_handler_intel_x64_eapis_broadcast.cpp
+SOURCES+=exit_handler_intel_x64_eapis_io_storm.cpp
+SOURCES+=exit_handler_intel_x64_eapis_exit_stats_vmcall.cpp
+SOURCES+=exit_handler_intel_x64_eapis_exit_trace.cpp
+SOURCES+=io_access_log_intel_x64.cpp
+SOURCES+=msr_access_log_intel_x64.cpp
+SOURCES+=exit_stats_intel_x64.cpp
+SOURCES+=uart_16550_intel_x64.cpp
 
 INCLUDE_PATHS+=../../../include
 INCLUDE_PATHS+=%HYPER_ABS%/include/
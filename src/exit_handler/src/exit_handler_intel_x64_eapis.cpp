@@ -19,6 +19,8 @@
 // License along with this library; if not, write to the Free Software
 // Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 
+#include <algorithm>
+
 #include <exit_handler/exit_handler_intel_x64_eapis.h>
 
 #include <vmcs/vmcs_intel_x64_32bit_read_only_data_fields.h>
@@ -28,20 +30,68 @@ using namespace x64;
 using namespace intel_x64;
 using namespace vmcs;
 
+constexpr const std::size_t exit_handler_intel_x64_eapis::max_exit_reasons;
+
 exit_handler_intel_x64_eapis::exit_handler_intel_x64_eapis() :
-    m_monitor_trap_callback(&exit_handler_intel_x64_eapis::unhandled_monitor_trap_callback),
-    m_io_access_log_enabled(false),
+    m_exit_handlers{},
+    m_exit_tsc(0),
+    m_exit_reason(0),
+    m_exit_trace_pending(false),
+    m_exit_trace_record{},
+    m_exit_trace_gpa(0),
+    m_broadcast(false),
+    m_vmcs_updates_pending(false),
+    m_monitor_trap_callback_count(0),
+    m_monitor_trap_callbacks{},
+    m_stepping(false),
+    m_step_budget(0),
+    m_step_count(0),
+    m_io_storm_policy{},
+    m_io_access_emulation_enabled(false),
+    m_io_trace_pending(false),
+    m_io_trace_record{},
+    m_io_trace_gpa(0),
+    m_page_merger(nullptr),
+    m_page_age_sampler(nullptr),
     m_vmcs_eapis(nullptr)
 {
     init_policy();
+
+    set_exit_handler(exit_reason::basic_exit_reason::monitor_trap_flag, &exit_handler_intel_x64_eapis::handle_exit__monitor_trap_flag);
+    set_exit_handler(exit_reason::basic_exit_reason::io_instruction, &exit_handler_intel_x64_eapis::handle_exit__io_instruction);
+    set_exit_handler(exit_reason::basic_exit_reason::ept_violation, &exit_handler_intel_x64_eapis::handle_exit__ept_violation);
+    set_exit_handler(exit_reason::basic_exit_reason::rdmsr, &exit_handler_intel_x64_eapis::handle_exit__rdmsr);
+    set_exit_handler(exit_reason::basic_exit_reason::wrmsr, &exit_handler_intel_x64_eapis::handle_exit__wrmsr);
+
+    std::lock_guard<std::mutex> guard(registry_mutex());
+    registry().push_back(this);
 }
 
-void
-exit_handler_intel_x64_eapis::resume()
+exit_handler_intel_x64_eapis::~exit_handler_intel_x64_eapis()
 {
-    eapis_vmcs()->resume();
+    if (m_vmcs_eapis != nullptr)
+        m_vmcs_eapis->set_entry_delegate(nullptr);
+
+    std::lock_guard<std::mutex> guard(registry_mutex());
+
+    auto &&ehlrs = registry();
+    ehlrs.erase(std::remove(ehlrs.begin(), ehlrs.end(), this), ehlrs.end());
+
+    // This vCPU will never enter the guest again, so the flush tickets
+    // that are still queued on it are released here. Otherwise they could
+    // never reach 0, and the page merger would wait on them forever.
+
+    std::lock_guard<std::mutex> updates_guard(m_vmcs_updates_mutex);
+    this->release_invept_tickets(m_invept_tickets);
+
+    this->unpin_guest_page(m_exit_trace_gpa);
+    this->unpin_guest_page(m_io_trace_gpa);
 }
 
+void
+exit_handler_intel_x64_eapis::resume()
+{ eapis_vmcs()->resume(); }
+
 void
 exit_handler_intel_x64_eapis::advance_and_resume()
 {
@@ -49,23 +99,38 @@ exit_handler_intel_x64_eapis::advance_and_resume()
     eapis_vmcs()->resume();
 }
 
+void
+exit_handler_intel_x64_eapis::vm_entry()
+{
+    this->apply_pending_vmcs_updates();
+    this->end_exit();
+}
+
 void
 exit_handler_intel_x64_eapis::handle_exit(vmcs::value_type reason)
 {
-    switch (reason)
-    {
-        case exit_reason::basic_exit_reason::monitor_trap_flag:
-            handle_exit__monitor_trap_flag();
-            break;
+    // The VMCS has to be resolved before the base exit handler gets a
+    // chance to resume the guest, as this is what installs vm_entry().
+    eapis_vmcs();
 
-        case exit_reason::basic_exit_reason::io_instruction:
-            handle_exit__io_instruction();
-            break;
+    this->begin_exit(reason);
+    this->rearm_io_storms();
 
-        default:
-            exit_handler_intel_x64::handle_exit(reason);
-            break;
-    }
+    auto &&handler = reason < m_exit_handlers.size() ? m_exit_handlers[reason] : nullptr;
+
+    if (handler != nullptr)
+        (this->*handler)();
+    else
+        exit_handler_intel_x64::handle_exit(reason);
+
+    this->end_exit();
+}
+
+void
+exit_handler_intel_x64_eapis::set_exit_handler(vmcs::value_type reason, exit_handler_delegate handler)
+{
+    expects(reason < m_exit_handlers.size());
+    m_exit_handlers[reason] = handler;
 }
 
 void
@@ -81,6 +146,10 @@ exit_handler_intel_x64_eapis::handle_vmcall_registers(vmcall_registers_t &regs)
             handle_vmcall_registers__vpid(regs);
             break;
 
+        case eapis_cat__msr:
+            handle_vmcall_registers__msr(regs);
+            break;
+
         default:
             throw std::runtime_error("unknown vmcall category");
     }
@@ -90,6 +159,9 @@ void
 exit_handler_intel_x64_eapis::handle_vmcall_data_string_json(
     const json &ijson, json &ojson)
 {
+    m_broadcast = ijson.value("broadcast", false);
+    auto &&reset = gsl::finally([&] { m_broadcast = false; });
+
     if (handle_vmcall_json__verifiers(ijson, ojson))
         return;
 
@@ -99,5 +171,86 @@ exit_handler_intel_x64_eapis::handle_vmcall_data_string_json(
     if (handle_vmcall_json__vpid(ijson, ojson))
         return;
 
+    if (handle_vmcall_json__page_age(ijson, ojson))
+        return;
+
+    if (handle_vmcall_json__msr(ijson, ojson))
+        return;
+
+    if (handle_vmcall_json__exit_stats(ijson, ojson))
+        return;
+
     throw std::runtime_error("unknown JSON command");
 }
+
+exit_handler_intel_x64_eapis::integer_pointer
+exit_handler_intel_x64_eapis::gpa_to_hpa(integer_pointer gpa, bool write)
+{
+    auto found = false;
+    auto allowed = false;
+    integer_pointer hpa = 0;
+
+    eapis_vmcs()->visit_epte_range(gpa, gpa + 1, [&](auto base, auto size, auto epte)
+    {
+        (void) size;
+
+        found = true;
+        hpa = epte->phys_addr() + (gpa - base);
+
+        // A page with sub-page write permissions is only partially
+        // writable, so the VMM does not write to it at all.
+
+        if (write)
+            allowed = epte->write_access() && !epte->sub_page_write_permissions();
+        else
+            allowed = epte->read_access();
+
+        // The VMM accesses the page on the guest's behalf, so the page is
+        // flagged the same way the CPU would have (see the page merger and
+        // the page age sampler, which rely on these flags).
+
+        if (allowed)
+        {
+            epte->set_accessed(true);
+
+            if (write)
+                epte->set_dirty(true);
+        }
+
+        return false;
+    });
+
+    if (!found)
+        throw std::runtime_error("gpa_to_hpa: gpa is not mapped");
+
+    if (!allowed)
+        throw std::runtime_error("gpa_to_hpa: access denied by the EPT");
+
+    return hpa;
+}
+
+bfn::unique_map_ptr_x64<uint8_t>
+exit_handler_intel_x64_eapis::map_guest_page(integer_pointer gpa)
+{
+    if (m_page_merger != nullptr && !m_page_merger->pin(gpa))
+        throw std::runtime_error("map_guest_page: gpa is merged");
+
+    try
+    {
+        return bfn::make_unique_map_x64<uint8_t>(this->gpa_to_hpa(gpa, true));
+    }
+    catch (...)
+    {
+        if (m_page_merger != nullptr)
+            m_page_merger->unpin(gpa);
+
+        throw;
+    }
+}
+
+void
+exit_handler_intel_x64_eapis::unpin_guest_page(integer_pointer gpa)
+{
+    if (gpa != 0 && m_page_merger != nullptr)
+        m_page_merger->unpin(gpa);
+}
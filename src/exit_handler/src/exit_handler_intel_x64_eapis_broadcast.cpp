@@ -0,0 +1,169 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <exit_handler/exit_handler_intel_x64_eapis.h>
+
+#include <intrinsics/vmx_intel_x64.h>
+
+std::size_t
+exit_handler_intel_x64_eapis::broadcast(const vmcs_update_type &update)
+{
+    auto &&vcpus = queue_vmcs_update(update, this);
+
+    update(eapis_vmcs());
+    return vcpus + 1;
+}
+
+page_merger_intel_x64::flush_ticket_type
+exit_handler_intel_x64_eapis::broadcast_invept()
+{
+    auto &&ticket = std::make_shared<std::atomic<std::size_t>>(0);
+
+    // The ticket is decremented by each vCPU as it performs its INVEPT,
+    // which can happen before the number of vCPUs is added to the ticket.
+    // The ticket wraps around in the meantime, but it only reaches 0 once
+    // both have happened.
+
+    auto vcpus = 0UL;
+
+    {
+        std::lock_guard<std::mutex> guard(registry_mutex());
+
+        for (const auto &ehlr : registry())
+        {
+            ehlr->push_invept(ticket);
+            vcpus++;
+        }
+    }
+
+    ticket->fetch_add(vcpus, std::memory_order_release);
+    return ticket;
+}
+
+void
+exit_handler_intel_x64_eapis::apply_pending_vmcs_updates()
+{
+    // This is called on every VM entry, so the lock is only taken if
+    // another vCPU has actually queued an update.
+
+    if (!m_vmcs_updates_pending.load(std::memory_order_acquire))
+        return;
+
+    std::vector<vmcs_update_type> updates;
+    std::vector<page_merger_intel_x64::flush_ticket_type> tickets;
+
+    {
+        std::lock_guard<std::mutex> guard(m_vmcs_updates_mutex);
+
+        updates.swap(m_vmcs_updates);
+        tickets.swap(m_invept_tickets);
+        m_vmcs_updates_pending.store(false, std::memory_order_relaxed);
+    }
+
+    for (const auto &update : updates)
+        update(eapis_vmcs());
+
+    // A single INVEPT covers every flush that was requested since the
+    // last VM entry.
+
+    if (!tickets.empty())
+    {
+        intel_x64::vmx::invept_global();
+        this->release_invept_tickets(tickets);
+    }
+}
+
+std::size_t
+exit_handler_intel_x64_eapis::queue_vmcs_update(
+    const vmcs_update_type &update, exit_handler_intel_x64_eapis *skip)
+{
+    std::lock_guard<std::mutex> guard(registry_mutex());
+
+    auto vcpus = 0UL;
+    for (const auto &ehlr : registry())
+    {
+        if (ehlr == skip)
+            continue;
+
+        ehlr->push_vmcs_update(update);
+        vcpus++;
+    }
+
+    return vcpus;
+}
+
+void
+exit_handler_intel_x64_eapis::push_vmcs_update(const vmcs_update_type &update)
+{
+    std::lock_guard<std::mutex> guard(m_vmcs_updates_mutex);
+
+    m_vmcs_updates.push_back(update);
+    m_vmcs_updates_pending.store(true, std::memory_order_release);
+}
+
+void
+exit_handler_intel_x64_eapis::push_invept(const page_merger_intel_x64::flush_ticket_type &ticket)
+{
+    std::lock_guard<std::mutex> guard(m_vmcs_updates_mutex);
+
+    m_invept_tickets.push_back(ticket);
+    m_vmcs_updates_pending.store(true, std::memory_order_release);
+}
+
+void
+exit_handler_intel_x64_eapis::release_invept_tickets(
+    std::vector<page_merger_intel_x64::flush_ticket_type> &tickets) noexcept
+{
+    for (const auto &ticket : tickets)
+        ticket->fetch_sub(1, std::memory_order_release);
+
+    tickets.clear();
+}
+
+void
+exit_handler_intel_x64_eapis::broadcast_exit_handler_update(const exit_handler_update_type &update)
+{
+    {
+        std::lock_guard<std::mutex> guard(registry_mutex());
+
+        for (const auto &ehlr : registry())
+        {
+            if (ehlr != this)
+                ehlr->push_vmcs_update([ehlr, update](auto) { update(ehlr); });
+        }
+    }
+
+    update(this);
+}
+
+std::mutex &
+exit_handler_intel_x64_eapis::registry_mutex()
+{
+    static std::mutex g_mutex;
+    return g_mutex;
+}
+
+std::vector<exit_handler_intel_x64_eapis *> &
+exit_handler_intel_x64_eapis::registry()
+{
+    static std::vector<exit_handler_intel_x64_eapis *> g_registry;
+    return g_registry;
+}
@@ -0,0 +1,43 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <exit_handler/exit_handler_intel_x64_eapis.h>
+
+#include <vmcs/vmcs_intel_x64_64bit_read_only_data_fields.h>
+#include <vmcs/vmcs_intel_x64_natural_width_read_only_data_fields.h>
+
+using namespace intel_x64;
+using namespace vmcs;
+
+void
+exit_handler_intel_x64_eapis::handle_exit__ept_violation()
+{
+    if (m_page_merger != nullptr)
+    {
+        if (m_page_merger->handle_write_violation(guest_physical_address::get(), exit_qualification::get()))
+        {
+            this->resume();
+            return;
+        }
+    }
+
+    exit_handler_intel_x64::handle_exit(exit_reason::basic_exit_reason::ept_violation);
+}
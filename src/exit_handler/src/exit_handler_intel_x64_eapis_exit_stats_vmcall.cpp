@@ -0,0 +1,141 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <to_string.h>
+
+#include <exit_handler/exit_handler_intel_x64_eapis.h>
+#include <exit_handler/exit_handler_intel_x64_eapis_vmcall_interface.h>
+
+#include <exit_handler/exit_handler_intel_x64_eapis_verifiers.h>
+#include <exit_handler/exit_handler_intel_x64_eapis_exit_stats_verifiers.h>
+
+using namespace x64;
+using namespace intel_x64;
+using namespace vmcs;
+
+bool
+exit_handler_intel_x64_eapis::handle_vmcall_json__exit_stats(
+    const json &ijson, json &ojson)
+{
+    auto set = ijson.value("set", std::string());
+
+    if (!set.empty())
+    {
+        if (set == "trace_exits")
+        {
+            handle_vmcall__trace_exits(json_hex_or_dec<integer_pointer>(ijson, "gpa"), ijson.value("overwrite", false));
+            ojson = {"success"};
+            return true;
+        }
+    }
+
+#if ENABLE_EXIT_STATS
+
+    auto run = ijson.value("run", std::string());
+
+    if (!run.empty())
+    {
+        if (run == "clear_exit_stats")
+        {
+            handle_vmcall__clear_exit_stats();
+            ojson = {"success"};
+            return true;
+        }
+    }
+
+    auto get = ijson.value("get", std::string());
+
+    if (!get.empty())
+    {
+        if (get == "exit_stats")
+        {
+            handle_vmcall__exit_stats(ojson);
+            return true;
+        }
+    }
+
+#endif
+
+    return false;
+}
+
+#if ENABLE_EXIT_STATS
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__exit_stats(json &ojson)
+{
+    if (policy(exit_stats)->verify() != vmcall_verifier::allow)
+        policy(exit_stats)->deny_vmcall();
+
+    for (const auto &pair : exit_stats_intel_x64::aggregate())
+    {
+        ojson[bfn::to_string(pair.first, 16)] = {
+            {"count", pair.second.count},
+            {"ticks", pair.second.ticks},
+            {"histogram", pair.second.histogram}
+        };
+    }
+
+    bfdebug << "dump exit_stats: success" << bfendl;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__clear_exit_stats()
+{
+    if (policy(clear_exit_stats)->verify() != vmcall_verifier::allow)
+        policy(clear_exit_stats)->deny_vmcall();
+
+    exit_stats_intel_x64::clear_all();
+    bfdebug << "clear_exit_stats: success" << bfendl;
+}
+
+#endif
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__trace_exits(
+    integer_pointer gpa, bool overwrite)
+{
+    if (policy(trace_exits)->verify(gpa, overwrite) != vmcall_verifier::allow)
+        policy(trace_exits)->deny_vmcall();
+
+    if ((gpa & (x64::page_size - 1)) != 0)
+        throw std::runtime_error("trace_exits: gpa must be page aligned");
+
+    // Like the IO trace, the trace ring is stored in a single guest page,
+    // which is resolved through the EPT and pinned (see
+    // handle_vmcall__trace_io_access()).
+
+    trace_exits({});
+    m_exit_trace_map.reset();
+
+    this->unpin_guest_page(m_exit_trace_gpa);
+    m_exit_trace_gpa = 0;
+
+    if (gpa != 0)
+    {
+        m_exit_trace_map = this->map_guest_page(gpa);
+        m_exit_trace_gpa = gpa;
+
+        trace_exits(gsl::span<uint8_t>(m_exit_trace_map.get(), x64::page_size), overwrite);
+    }
+
+    bfdebug << "trace_exits: " << std::hex << std::uppercase << "0x" << gpa << bfendl;
+}
@@ -0,0 +1,64 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <exit_handler/exit_handler_intel_x64_eapis.h>
+
+#include <vmcs/vmcs_intel_x64_natural_width_read_only_data_fields.h>
+
+using namespace intel_x64;
+using namespace vmcs;
+
+void
+exit_handler_intel_x64_eapis::trace_exits(gsl::span<uint8_t> buffer, bool overwrite)
+{
+    m_exit_trace_pending = false;
+
+    if (buffer.empty())
+    {
+        m_exit_trace.reset();
+        return;
+    }
+
+    m_exit_trace = std::make_unique<exit_trace_intel_x64>(buffer, overwrite);
+}
+
+void
+exit_handler_intel_x64_eapis::begin_exit_trace()
+{
+    // The guest's RIP is recorded before the VM exit is handled, as it is
+    // advanced by most of the handlers.
+
+    m_exit_trace_record.tsc = m_exit_tsc;
+    m_exit_trace_record.rip = m_state_save->rip;
+    m_exit_trace_record.qualification = vmcs::exit_qualification::get();
+    m_exit_trace_record.reason = gsl::narrow_cast<uint32_t>(m_exit_reason);
+
+    m_exit_trace_pending = true;
+}
+
+void
+exit_handler_intel_x64_eapis::end_exit_trace(uint64_t ticks) noexcept
+{
+    m_exit_trace_record.ticks = ticks;
+    m_exit_trace->push(m_exit_trace_record);
+
+    m_exit_trace_pending = false;
+}
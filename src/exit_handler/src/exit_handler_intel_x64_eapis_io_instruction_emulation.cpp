@@ -19,36 +19,561 @@
 // License along with this library; if not, write to the Free Software
 // Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 
+#include <algorithm>
+
 #include <exit_handler/exit_handler_intel_x64_eapis.h>
 
+#include <vmcs/vmcs_intel_x64_16bit_guest_state_fields.h>
 #include <vmcs/vmcs_intel_x64_32bit_control_fields.h>
+#include <vmcs/vmcs_intel_x64_32bit_read_only_data_fields.h>
+#include <vmcs/vmcs_intel_x64_64bit_guest_state_fields.h>
+#include <vmcs/vmcs_intel_x64_natural_width_guest_state_fields.h>
 #include <vmcs/vmcs_intel_x64_natural_width_read_only_data_fields.h>
 
+#include <intrinsics/rflags_x64.h>
+#include <intrinsics/portio_x64.h>
+
+using namespace x64;
 using namespace intel_x64;
 using namespace vmcs;
 
+// The guest's buffer of a string instruction spans at most this many pages
+constexpr const auto max_io_string_pages = (IO_STRING_EMULATION_MAX_BYTES / x64::page_size) + 2;
+
+// Guest control register bits that decide how the guest's page tables are
+// walked (see gla_to_gpa())
+constexpr const auto guest_cr0_pg = 0x0000000080000000UL;
+constexpr const auto guest_cr4_pae = 0x0000000000000020UL;
+constexpr const auto guest_cr4_la57 = 0x0000000000001000UL;
+constexpr const auto guest_cr4_smap = 0x0000000000200000UL;
+constexpr const auto guest_cr4_pke = 0x0000000000400000UL;
+constexpr const auto guest_efer_lma = 0x0000000000000400UL;
+
+// Guest page table entry bits
+constexpr const auto guest_pte_present = 0x0000000000000001UL;
+constexpr const auto guest_pte_read_write = 0x0000000000000002UL;
+constexpr const auto guest_pte_user = 0x0000000000000004UL;
+constexpr const auto guest_pte_accessed = 0x0000000000000020UL;
+constexpr const auto guest_pte_dirty = 0x0000000000000040UL;
+constexpr const auto guest_pte_large_page = 0x0000000000000080UL;
+constexpr const auto guest_pte_phys_addr = 0x000FFFFFFFFFF000UL;
+
 void
 exit_handler_intel_x64_eapis::log_io_access(bool enable)
-{ m_io_access_log_enabled = enable; }
+{ m_io_access_log.enable(enable); }
 
 void
 exit_handler_intel_x64_eapis::clear_io_access_log()
 { m_io_access_log.clear(); }
 
+void
+exit_handler_intel_x64_eapis::emulate_io_access(bool enable)
+{ m_io_access_emulation_enabled = enable; }
+
+void
+exit_handler_intel_x64_eapis::emulate_uart(bool enable)
+{ broadcast_exit_handler_update([=](auto ehlr) { ehlr->emulate_uart_on_this_vcpu(enable); }); }
+
+void
+exit_handler_intel_x64_eapis::emulate_uart_on_this_vcpu(bool enable)
+{
+    auto &&first = uart().base();
+    auto &&last = gsl::narrow_cast<port_type>(first + uart_16550_intel_x64::num_ports - 1);
+
+    if (enable)
+    {
+        register_io_port_handler(first, last, &uart());
+        return;
+    }
+
+    unregister_io_port_handler(first, last);
+    forget_io_storms(first, last);
+    eapis_vmcs()->pass_through_io_range(first, last);
+}
+
+uart_16550_intel_x64 &
+exit_handler_intel_x64_eapis::uart()
+{
+    static uart_16550_intel_x64 g_uart;
+    return g_uart;
+}
+
+void
+exit_handler_intel_x64_eapis::trace_io_access(gsl::span<uint8_t> buffer)
+{
+    m_io_trace_pending = false;
+
+    if (buffer.empty())
+    {
+        m_io_trace.reset();
+        return;
+    }
+
+    m_io_trace = std::make_unique<io_trace_intel_x64>(buffer);
+}
+
 void
 exit_handler_intel_x64_eapis::trap_on_io_access_callback()
 {
+    // An IN that was executed by the guest is only traced once it has
+    // completed, as this is the first time the value is known.
+
+    if (m_io_trace_pending)
+        this->record_io_trace(true);
+
     primary_processor_based_vm_execution_controls::use_io_bitmaps::enable();
-    this->resume();
+}
+
+void
+exit_handler_intel_x64_eapis::register_io_port_handler(
+    port_type first, port_type last, gsl::not_null<io_port_handler_intel_x64 *> handler)
+{
+    expects(first <= last);
+
+    for (auto port = static_cast<uint32_t>(first); port <= last; port++)
+    {
+        auto &&table = m_io_port_handlers.at(port >> 8);
+        if (!table)
+        {
+            table = std::make_unique<io_port_handler_table_type>();
+            table->fill(nullptr);
+        }
+
+        table->at(port & 0xFF) = handler;
+        eapis_vmcs()->trap_on_io_access(gsl::narrow_cast<port_type>(port));
+    }
+}
+
+void
+exit_handler_intel_x64_eapis::unregister_io_port_handler(
+    port_type first, port_type last)
+{
+    expects(first <= last);
+
+    for (auto port = static_cast<uint32_t>(first); port <= last; port++)
+    {
+        auto &&table = m_io_port_handlers.at(port >> 8);
+        if (table)
+            table->at(port & 0xFF) = nullptr;
+    }
+}
+
+io_port_handler_intel_x64 *
+exit_handler_intel_x64_eapis::io_port_handler(port_type port) const noexcept
+{
+    auto &&table = m_io_port_handlers[port >> 8];
+    return table ? (*table)[port & 0xFF] : nullptr;
+}
+
+void
+exit_handler_intel_x64_eapis::emulate_io_instruction()
+{
+    using namespace exit_qualification::io_instruction;
+
+    auto &&port = gsl::narrow_cast<port_type>(port_number::get());
+    auto &&handler = this->io_port_handler(port);
+
+    // Note that a 32bit IN zero extends into RAX, while 8bit and 16bit INs
+    // leave the rest of RAX untouched (same as a MOV to AL / AX)
+
+    if (direction_of_access::get() == direction_of_access::in)
+    {
+        switch (size_of_access::get())
+        {
+            case size_of_access::one_byte:
+            {
+                auto &&val = handler ? (handler->read(port, 1) & 0xFFU) : portio::inb(port);
+                m_state_save->rax = (m_state_save->rax & ~0xFFUL) | val;
+                break;
+            }
+
+            case size_of_access::two_byte:
+            {
+                auto &&val = handler ? (handler->read(port, 2) & 0xFFFFU) : portio::inw(port);
+                m_state_save->rax = (m_state_save->rax & ~0xFFFFUL) | val;
+                break;
+            }
+
+            default:
+                m_state_save->rax = handler ? handler->read(port, 4) : portio::ind(port);
+                break;
+        }
+    }
+    else
+    {
+        switch (size_of_access::get())
+        {
+            case size_of_access::one_byte:
+            {
+                auto &&val = gsl::narrow_cast<uint8_t>(m_state_save->rax);
+
+                if (handler != nullptr)
+                    handler->write(port, 1, val);
+                else
+                    portio::outb(port, val);
+
+                break;
+            }
+
+            case size_of_access::two_byte:
+            {
+                auto &&val = gsl::narrow_cast<uint16_t>(m_state_save->rax);
+
+                if (handler != nullptr)
+                    handler->write(port, 2, val);
+                else
+                    portio::outw(port, val);
+
+                break;
+            }
+
+            default:
+            {
+                auto &&val = gsl::narrow_cast<uint32_t>(m_state_save->rax);
+
+                if (handler != nullptr)
+                    handler->write(port, 4, val);
+                else
+                    portio::outd(port, val);
+
+                break;
+            }
+        }
+    }
+}
+
+bool
+exit_handler_intel_x64_eapis::emulate_io_string_instruction(bool &done)
+{
+    using namespace exit_qualification::io_instruction;
+
+    if ((guest_rflags::get() & rflags::direction_flag::mask) != 0)
+        return false;
+
+    auto &&port = gsl::narrow_cast<port_type>(port_number::get());
+    auto &&size = size_of_access::get() + 1;
+    auto &&in = direction_of_access::get() == direction_of_access::in;
+    auto &&rep = rep_prefixed::get() == rep_prefixed::rep;
+
+    // The address size of INS / OUTS is stored in bits 9:7 of the VM-exit
+    // instruction information (0 = 16bit, 1 = 32bit, 2 = 64bit), and
+    // determines which part of RCX, RSI and RDI is used / updated.
+
+    auto &&address_size = (vm_exit_instruction_information::get() >> 7) & 0x7;
+    auto &&address_mask = address_size == 0 ? 0xFFFFUL : address_size == 1 ? 0xFFFFFFFFUL : ~0UL;
+
+    auto &&update = [&](uint64_t & reg, uint64_t value)
+    {
+        if (address_size == 1)
+            reg = value & address_mask;
+        else
+            reg = (reg & ~address_mask) | (value & address_mask);
+    };
+
+    auto &&remaining = rep ? (m_state_save->rcx & address_mask) : 1UL;
+    auto count = std::min(remaining, IO_STRING_EMULATION_MAX_BYTES / size);
+
+    if (count != 0)
+    {
+        // The guest's buffer is located by walking the guest's page tables,
+        // which is only done for 4-level and PAE paging. In any other mode,
+        // the instruction is executed by the guest.
+
+        auto &&cr4 = guest_cr4::get();
+
+        if ((guest_cr0::get() & guest_cr0_pg) == 0 || (cr4 & guest_cr4_pae) == 0 || (cr4 & guest_cr4_la57) != 0)
+            return false;
+
+        // Each page of the buffer is translated before any port is
+        // accessed, so that a page the guest (or the EPT) does not allow
+        // the access to is left to the guest, which faults on it as it
+        // would without emulation. Only the elements in front of such a
+        // page are transferred.
+
+        auto &&gla = guest_linear_address::get();
+        auto &&first = gla & ~(x64::page_size - 1);
+        auto &&last = (gla + (count * size) - 1) & ~(x64::page_size - 1);
+
+        std::array<integer_pointer, max_io_string_pages> frames;
+        auto pages = 0UL;
+
+        for (auto page = first; pages < frames.size(); page += x64::page_size)
+        {
+            try
+            {
+                frames[pages] = this->io_string_gla_to_hpa(page, in);
+            }
+            catch (std::exception &)
+            {
+                break;
+            }
+
+            pages++;
+
+            if (page == last)
+                break;
+        }
+
+        if (pages == 0)
+            return false;
+
+        count = std::min(count, ((first + (pages * x64::page_size)) - gla) / size);
+
+        if (count == 0)
+            return false;
+
+        // Pages that are contiguous in the guest are not contiguous in
+        // host physical memory, so the transfer goes through a buffer
+        // that is copied to / from the guest one page at a time.
+
+        auto &&bytes = count * size;
+
+        if (m_io_string_buffer.size() < bytes)
+            m_io_string_buffer.resize(IO_STRING_EMULATION_MAX_BYTES);
+
+        auto &&buffer = gsl::span<uint8_t>(m_io_string_buffer.data(), gsl::narrow_cast<std::ptrdiff_t>(bytes));
+
+        auto &&copy = [&](bool to_guest)
+        {
+            for (auto offset = 0UL; offset < bytes;)
+            {
+                auto &&addr = gla + offset;
+                auto &&page_offset = addr & (x64::page_size - 1);
+                auto &&chunk = std::min<std::size_t>(bytes - offset, x64::page_size - page_offset);
+                auto &&frame = frames[(addr - first) / x64::page_size];
+                auto &&guest = this->map_io_string_buffer(frame + page_offset, chunk);
+
+                if (to_guest)
+                    __builtin_memcpy(guest.data(), &m_io_string_buffer[offset], chunk);
+                else
+                    __builtin_memcpy(&m_io_string_buffer[offset], guest.data(), chunk);
+
+                m_io_string_map.reset();
+                offset += chunk;
+            }
+        };
+
+        if (!in)
+            copy(false);
+
+        this->transfer_io_string(port, size, in, buffer);
+
+        if (in)
+            copy(true);
+
+        auto &&index = in ? &m_state_save->rdi : &m_state_save->rsi;
+        update(*index, *index + (count * size));
+
+        if (rep)
+            update(m_state_save->rcx, m_state_save->rcx - count);
+    }
+
+    // If the transfer was split, RIP is left as is so that the guest
+    // re-executes the REP instruction with the remaining count.
+
+    done = count == remaining;
+    return true;
+}
+
+void
+exit_handler_intel_x64_eapis::transfer_io_string(
+    port_type port, std::size_t size, bool in, gsl::span<uint8_t> buffer)
+{
+    auto &&handler = this->io_port_handler(port);
+
+    for (auto offset = 0UL; offset + size <= static_cast<std::size_t>(buffer.size()); offset += size)
+    {
+        auto &&data = &buffer[gsl::narrow_cast<std::ptrdiff_t>(offset)];
+        io_port_handler_intel_x64::value_type val = 0;
+
+        if (in)
+        {
+            if (handler != nullptr)
+                val = handler->read(port, size);
+            else
+                val = size == 1 ? portio::inb(port) : size == 2 ? portio::inw(port) : portio::ind(port);
+
+            __builtin_memcpy(data, &val, size);
+        }
+        else
+        {
+            __builtin_memcpy(&val, data, size);
+
+            if (handler != nullptr)
+                handler->write(port, size, val);
+            else if (size == 1)
+                portio::outb(port, gsl::narrow_cast<uint8_t>(val));
+            else if (size == 2)
+                portio::outw(port, gsl::narrow_cast<uint16_t>(val));
+            else
+                portio::outd(port, val);
+        }
+    }
+}
+
+exit_handler_intel_x64_eapis::integer_pointer
+exit_handler_intel_x64_eapis::io_string_gla_to_hpa(integer_pointer gla, bool write)
+{ return this->gpa_to_hpa(this->gla_to_gpa(gla, write), write); }
+
+gsl::span<uint8_t>
+exit_handler_intel_x64_eapis::map_io_string_buffer(integer_pointer hpa, std::size_t size)
+{
+    auto &&offset = hpa & (x64::page_size - 1);
+
+    m_io_string_map = bfn::make_unique_map_x64<uint8_t>(hpa - offset);
+    return gsl::span<uint8_t>(m_io_string_map.get() + offset, gsl::narrow_cast<std::ptrdiff_t>(size));
+}
+
+exit_handler_intel_x64_eapis::integer_pointer
+exit_handler_intel_x64_eapis::gla_to_gpa(integer_pointer gla, bool write)
+{
+    // Walks the guest's page tables (4-level or PAE paging), reading each
+    // table through the EPT. The walk fails if the guest could not perform
+    // the access itself without faulting, or without the CPU having to set
+    // an accessed / dirty flag, in which case the access is left to the
+    // guest.
+
+    auto &&long_mode = (guest_ia32_efer::get() & guest_efer_lma) != 0;
+    auto &&user = (guest_cs_selector::get() & 0x3) == 3;
+
+    // With PAE paging, the 4 PDPTEs are located at CR3 (32 byte aligned),
+    // and have no access rights or accessed flag.
+
+    auto &&cr3 = guest_cr3::get();
+    auto table = long_mode ? (cr3 & guest_pte_phys_addr) : (cr3 & 0xFFFFFFE0UL);
+    auto rights = guest_pte_read_write | guest_pte_user;
+
+    for (auto level = long_mode ? 4UL : 3UL; level > 0; level--)
+    {
+        auto &&shift = 12 + ((level - 1) * 9);
+        auto &&pdpte = !long_mode && level == 3;
+        auto &&index = (gla >> shift) & (pdpte ? 0x3UL : 0x1FFUL);
+        auto &&entry = this->read_guest_qword(table + (index * sizeof(uint64_t)));
+
+        if ((entry & guest_pte_present) == 0)
+            throw std::runtime_error("gla_to_gpa: page not present");
+
+        if (pdpte)
+        {
+            table = entry & guest_pte_phys_addr;
+            continue;
+        }
+
+        if ((entry & guest_pte_accessed) == 0)
+            throw std::runtime_error("gla_to_gpa: accessed flag not set");
+
+        rights &= entry;
+
+        if (level != 1 && (level > 3 || (entry & guest_pte_large_page) == 0))
+        {
+            table = entry & guest_pte_phys_addr;
+            continue;
+        }
+
+        if (write && (entry & guest_pte_dirty) == 0)
+            throw std::runtime_error("gla_to_gpa: dirty flag not set");
+
+        if (write && (rights & guest_pte_read_write) == 0)
+            throw std::runtime_error("gla_to_gpa: page is read-only");
+
+        if (user && (rights & guest_pte_user) == 0)
+            throw std::runtime_error("gla_to_gpa: page is a supervisor page");
+
+        // SMAP and protection keys further restrict the access to user
+        // pages, which is left to the guest instead of being emulated.
+
+        if ((rights & guest_pte_user) != 0 && (guest_cr4::get() & (guest_cr4_smap | guest_cr4_pke)) != 0)
+            throw std::runtime_error("gla_to_gpa: user page with SMAP / PKE");
+
+        auto &&page_mask = (1UL << shift) - 1;
+        return (entry & guest_pte_phys_addr & ~page_mask) | (gla & page_mask);
+    }
+
+    throw std::runtime_error("gla_to_gpa: invalid page walk");
+}
+
+uint64_t
+exit_handler_intel_x64_eapis::read_guest_qword(integer_pointer gpa)
+{
+    auto &&hpa = this->gpa_to_hpa(gpa, false);
+    auto &&offset = hpa & (x64::page_size - 1);
+
+    auto &&map = bfn::make_unique_map_x64<uint64_t>(hpa - offset);
+    return map.get()[offset / sizeof(uint64_t)];
+}
+
+void
+exit_handler_intel_x64_eapis::record_io_trace(bool has_value)
+{
+    if (has_value)
+    {
+        auto &&mask = (1UL << (m_io_trace_record.size * 8U)) - 1U;
+        m_io_trace_record.value = gsl::narrow_cast<uint32_t>(m_state_save->rax & mask);
+    }
+
+    m_io_trace->push(m_io_trace_record);
+    m_io_trace_pending = false;
 }
 
 void
 exit_handler_intel_x64_eapis::handle_exit__io_instruction()
 {
-    register_monitor_trap(&exit_handler_intel_x64_eapis::trap_on_io_access_callback);
+    using namespace exit_qualification::io_instruction;
+
+    auto &&port = gsl::narrow_cast<port_type>(port_number::get());
+    auto &&string = string_instruction::get() == string_instruction::string;
+    auto &&in = direction_of_access::get() == direction_of_access::in;
+
+    m_io_access_log.log(port);
+    this->check_io_storm(port);
 
-    if (m_io_access_log_enabled)
-        m_io_access_log[exit_qualification::io_instruction::port_number::get()]++;
+    if (m_io_trace)
+    {
+        m_io_trace_record.tsc = trace_ring_timestamp();
+        m_io_trace_record.rip = m_state_save->rip;
+        m_io_trace_record.value = 0;
+        m_io_trace_record.port = port;
+        m_io_trace_record.size = gsl::narrow_cast<uint8_t>(size_of_access::get() + 1);
+        m_io_trace_record.direction = in ? 1 : 0;
+    }
+
+    if (m_io_access_emulation_enabled || this->io_port_handler(port) != nullptr)
+    {
+        if (!string)
+        {
+            this->emulate_io_instruction();
+
+            if (m_io_trace)
+                this->record_io_trace(true);
+
+            this->advance_and_resume();
+            return;
+        }
+
+        auto done = false;
+        if (this->emulate_io_string_instruction(done))
+        {
+            if (m_io_trace)
+                this->record_io_trace(false);
+
+            if (done)
+                this->advance_and_resume();
+            else
+                this->resume();
+
+            return;
+        }
+    }
+
+    if (m_io_trace)
+    {
+        if (in && !string)
+            m_io_trace_pending = true;
+        else
+            this->record_io_trace(!string);
+    }
+
+    register_monitor_trap(&exit_handler_intel_x64_eapis::trap_on_io_access_callback);
 
     primary_processor_based_vm_execution_controls::use_io_bitmaps::disable();
     this->resume();
@@ -21,6 +21,8 @@
 
 #include <to_string.h>
 
+#include <memory_manager/map_ptr_x64.h>
+
 #include <exit_handler/exit_handler_intel_x64_eapis.h>
 #include <exit_handler/exit_handler_intel_x64_eapis_vmcall_interface.h>
 
@@ -80,6 +82,22 @@ exit_handler_intel_x64_eapis::handle_vmcall_json__io_instruction(
             return true;
         }
 
+        if (set == "trap_on_io_range")
+        {
+            handle_vmcall__trap_on_io_range(json_hex_or_dec<port_type>(ijson, "first"),
+                                            json_hex_or_dec<port_type>(ijson, "last"));
+            ojson = {"success"};
+            return true;
+        }
+
+        if (set == "pass_through_io_range")
+        {
+            handle_vmcall__pass_through_io_range(json_hex_or_dec<port_type>(ijson, "first"),
+                                                 json_hex_or_dec<port_type>(ijson, "last"));
+            ojson = {"success"};
+            return true;
+        }
+
         if (set == "whitelist_io_access")
         {
             handle_vmcall__whitelist_io_access(json_hex_or_dec_array<port_type>(ijson, "ports"));
@@ -94,12 +112,46 @@ exit_handler_intel_x64_eapis::handle_vmcall_json__io_instruction(
             return true;
         }
 
+        if (set == "share_io_bitmaps")
+        {
+            handle_vmcall__share_io_bitmaps(ijson.at("enabled"));
+            ojson = {"success"};
+            return true;
+        }
+
         if (set == "log_io_access")
         {
             handle_vmcall__log_io_access(ijson.at("enabled"));
             ojson = {"success"};
             return true;
         }
+
+        if (set == "trace_io_access")
+        {
+            handle_vmcall__trace_io_access(json_hex_or_dec<integer_pointer>(ijson, "gpa"));
+            ojson = {"success"};
+            return true;
+        }
+
+        if (set == "emulate_uart")
+        {
+            handle_vmcall__emulate_uart(ijson.at("enabled"));
+            ojson = {"success"};
+            return true;
+        }
+
+        if (set == "io_storm_policy")
+        {
+            io_storm_policy_type storm;
+
+            storm.threshold = json_hex_or_dec<uint64_t>(ijson, "threshold");
+            storm.window = json_hex_or_dec<uint64_t>(ijson, "window");
+            storm.rearm = json_hex_or_dec<uint64_t>(ijson, "rearm");
+
+            handle_vmcall__io_storm_policy(storm);
+            ojson = {"success"};
+            return true;
+        }
     }
 
     auto run = ijson.value("run", std::string());
@@ -123,6 +175,18 @@ exit_handler_intel_x64_eapis::handle_vmcall_json__io_instruction(
             handle_vmcall__io_access_log(ojson);
             return true;
         }
+
+        if (get == "uart_output")
+        {
+            handle_vmcall__uart_output(ojson);
+            return true;
+        }
+
+        if (get == "io_storms")
+        {
+            handle_vmcall__io_storms(ojson);
+            return true;
+        }
     }
 
     return false;
@@ -135,7 +199,8 @@ exit_handler_intel_x64_eapis::handle_vmcall__trap_on_io_access(
     if (policy(trap_on_io_access)->verify(port) != vmcall_verifier::allow)
         policy(trap_on_io_access)->deny_vmcall();
 
-    eapis_vmcs()->trap_on_io_access(port);
+    this->forget_io_storms(port, port);
+    update_vmcs([=](auto vmcs) { vmcs->trap_on_io_access(port); });
     bfdebug << "trap_on_io_access: " << std::hex << std::uppercase << "0x" << port << bfendl;
 }
 
@@ -145,7 +210,8 @@ exit_handler_intel_x64_eapis::handle_vmcall__trap_on_all_io_accesses()
     if (policy(trap_on_all_io_accesses)->verify() != vmcall_verifier::allow)
         policy(trap_on_all_io_accesses)->deny_vmcall();
 
-    eapis_vmcs()->trap_on_all_io_accesses();
+    this->forget_io_storms();
+    update_vmcs([](auto vmcs) { vmcs->trap_on_all_io_accesses(); });
     bfdebug << "trap_on_all_io_accesses: success" << bfendl;
 }
 
@@ -156,7 +222,8 @@ exit_handler_intel_x64_eapis::handle_vmcall__pass_through_io_access(
     if (policy(pass_through_io_access)->verify(port) != vmcall_verifier::allow)
         policy(pass_through_io_access)->deny_vmcall();
 
-    eapis_vmcs()->pass_through_io_access(port);
+    this->forget_io_storms(port, port);
+    update_vmcs([=](auto vmcs) { vmcs->pass_through_io_access(port); });
     bfdebug << "pass_through_io_access: " << std::hex << std::uppercase << "0x" << port << bfendl;
 }
 
@@ -166,10 +233,41 @@ exit_handler_intel_x64_eapis::handle_vmcall__pass_through_all_io_accesses()
     if (policy(pass_through_all_io_accesses)->verify() != vmcall_verifier::allow)
         policy(pass_through_all_io_accesses)->deny_vmcall();
 
-    eapis_vmcs()->pass_through_all_io_accesses();
+    this->forget_io_storms();
+    update_vmcs([](auto vmcs) { vmcs->pass_through_all_io_accesses(); });
     bfdebug << "trap_on_all_io_accesses: success" << bfendl;
 }
 
+void
+exit_handler_intel_x64_eapis::handle_vmcall__trap_on_io_range(
+    port_type first, port_type last)
+{
+    if (policy(trap_on_io_range)->verify(first, last) != vmcall_verifier::allow)
+        policy(trap_on_io_range)->deny_vmcall();
+
+    if (first > last)
+        throw std::runtime_error("trap_on_io_range: first must be <= last");
+
+    this->forget_io_storms(first, last);
+    update_vmcs([=](auto vmcs) { vmcs->trap_on_io_range(first, last); });
+    bfdebug << "trap_on_io_range: " << std::hex << std::uppercase << "0x" << first << " - 0x" << last << bfendl;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__pass_through_io_range(
+    port_type first, port_type last)
+{
+    if (policy(pass_through_io_range)->verify(first, last) != vmcall_verifier::allow)
+        policy(pass_through_io_range)->deny_vmcall();
+
+    if (first > last)
+        throw std::runtime_error("pass_through_io_range: first must be <= last");
+
+    this->forget_io_storms(first, last);
+    update_vmcs([=](auto vmcs) { vmcs->pass_through_io_range(first, last); });
+    bfdebug << "pass_through_io_range: " << std::hex << std::uppercase << "0x" << first << " - 0x" << last << bfendl;
+}
+
 void
 exit_handler_intel_x64_eapis::handle_vmcall__whitelist_io_access(
     const port_list_type &ports)
@@ -177,7 +275,8 @@ exit_handler_intel_x64_eapis::handle_vmcall__whitelist_io_access(
     if (policy(whitelist_io_access)->verify(ports) != vmcall_verifier::allow)
         policy(whitelist_io_access)->deny_vmcall();
 
-    eapis_vmcs()->whitelist_io_access(ports);
+    this->forget_io_storms();
+    update_vmcs([=](auto vmcs) { vmcs->whitelist_io_access(ports); });
 
     bfdebug << "whitelist_io_access: " << bfendl;
     for (auto port : ports)
@@ -191,13 +290,26 @@ exit_handler_intel_x64_eapis::handle_vmcall__blacklist_io_access(
     if (policy(blacklist_io_access)->verify(ports) != vmcall_verifier::allow)
         policy(blacklist_io_access)->deny_vmcall();
 
-    eapis_vmcs()->blacklist_io_access(ports);
+    this->forget_io_storms();
+    update_vmcs([=](auto vmcs) { vmcs->blacklist_io_access(ports); });
 
     bfdebug << "blacklist_io_access: " << bfendl;
     for (auto port : ports)
         bfdebug << "  - " << std::hex << std::uppercase << "0x" << port << bfendl;
 }
 
+void
+exit_handler_intel_x64_eapis::handle_vmcall__share_io_bitmaps(
+    bool enabled)
+{
+    if (policy(share_io_bitmaps)->verify(enabled) != vmcall_verifier::allow)
+        policy(share_io_bitmaps)->deny_vmcall();
+
+    this->forget_io_storms();
+    update_vmcs([=](auto vmcs) { vmcs->share_io_bitmaps(enabled); });
+    bfdebug << "share_io_bitmaps: " << std::boolalpha << enabled << bfendl;
+}
+
 void
 exit_handler_intel_x64_eapis::handle_vmcall__log_io_access(
     bool enabled)
@@ -215,7 +327,7 @@ exit_handler_intel_x64_eapis::handle_vmcall__clear_io_access_log()
     if (policy(clear_io_access_log)->verify() != vmcall_verifier::allow)
         policy(clear_io_access_log)->deny_vmcall();
 
-    clear_io_access_log();
+    io_access_log_intel_x64::clear_all();
     bfdebug << "clear_io_access_log: success" << bfendl;
 }
 
@@ -225,8 +337,88 @@ exit_handler_intel_x64_eapis::handle_vmcall__io_access_log(json &ojson)
     if (policy(io_access_log)->verify() != vmcall_verifier::allow)
         policy(io_access_log)->deny_vmcall();
 
-    for (auto pair : m_io_access_log)
+    for (const auto &pair : io_access_log_intel_x64::aggregate())
         ojson[bfn::to_string(pair.first, 16)] = pair.second;
 
     bfdebug << "dump io_access_log: success" << bfendl;
 }
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__trace_io_access(
+    integer_pointer gpa)
+{
+    if (policy(trace_io_access)->verify(gpa) != vmcall_verifier::allow)
+        policy(trace_io_access)->deny_vmcall();
+
+    if ((gpa & (x64::page_size - 1)) != 0)
+        throw std::runtime_error("trace_io_access: gpa must be page aligned");
+
+    // The trace ring is stored in a single page that is provided by the
+    // guest. The page is resolved through the EPT (so the guest can only
+    // provide a page that it can write to itself), and is pinned so that
+    // the page merger does not share it while the VMM writes to it.
+
+    trace_io_access({});
+    m_io_trace_map.reset();
+
+    this->unpin_guest_page(m_io_trace_gpa);
+    m_io_trace_gpa = 0;
+
+    if (gpa != 0)
+    {
+        m_io_trace_map = this->map_guest_page(gpa);
+        m_io_trace_gpa = gpa;
+
+        trace_io_access(gsl::span<uint8_t>(m_io_trace_map.get(), x64::page_size));
+    }
+
+    bfdebug << "trace_io_access: " << std::hex << std::uppercase << "0x" << gpa << bfendl;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__io_storm_policy(
+    const io_storm_policy_type &storm)
+{
+    if (policy(io_storm_policy)->verify(storm) != vmcall_verifier::allow)
+        policy(io_storm_policy)->deny_vmcall();
+
+    set_io_storm_policy(storm);
+
+    bfdebug << "io_storm_policy: " << std::hex << std::uppercase
+            << "threshold 0x" << storm.threshold << ", window 0x" << storm.window
+            << ", rearm 0x" << storm.rearm << bfendl;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__io_storms(json &ojson)
+{
+    if (policy(io_storms)->verify() != vmcall_verifier::allow)
+        policy(io_storms)->deny_vmcall();
+
+    ojson = json::array();
+    for (auto port : io_storm_ports())
+        ojson.push_back(bfn::to_string(port, 16));
+
+    bfdebug << "dump io_storms: success" << bfendl;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__emulate_uart(
+    bool enabled)
+{
+    if (policy(emulate_uart)->verify(enabled) != vmcall_verifier::allow)
+        policy(emulate_uart)->deny_vmcall();
+
+    emulate_uart(enabled);
+    bfdebug << "emulate_uart: " << std::boolalpha << enabled << bfendl;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__uart_output(json &ojson)
+{
+    if (policy(uart_output)->verify() != vmcall_verifier::allow)
+        policy(uart_output)->deny_vmcall();
+
+    ojson.push_back(uart().drain());
+    bfdebug << "dump uart_output: success" << bfendl;
+}
@@ -0,0 +1,130 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <exit_handler/exit_handler_intel_x64_eapis.h>
+
+void
+exit_handler_intel_x64_eapis::set_io_storm_policy(const io_storm_policy_type &policy)
+{
+    // Ports that were passed through by the previous policy are trapped
+    // again, so that the new policy starts from a clean slate.
+
+    for (const auto &pair : m_io_storm_ports)
+    {
+        auto port = pair.first;
+        update_vmcs([=](auto vmcs) { vmcs->trap_on_io_access(port); });
+    }
+
+    m_io_storm_ports.clear();
+    m_io_storm_windows.clear();
+    m_io_storm_policy = policy;
+
+    if (m_io_storm_policy.threshold != 0)
+        m_io_access_log.enable(true);
+}
+
+exit_handler_intel_x64_eapis::port_list_type
+exit_handler_intel_x64_eapis::io_storm_ports() const
+{
+    port_list_type ports;
+
+    for (const auto &pair : m_io_storm_ports)
+        ports.push_back(pair.first);
+
+    return ports;
+}
+
+void
+exit_handler_intel_x64_eapis::check_io_storm(port_type port)
+{
+    if (m_io_storm_policy.threshold == 0 || !m_io_access_log.is_enabled())
+        return;
+
+    if (m_io_storm_ports.count(port) != 0 || this->io_port_handler(port) != nullptr)
+        return;
+
+    auto &&now = trace_ring_timestamp();
+    auto &&count = m_io_access_log.count(port);
+
+    // The window restarts once it expires, or if the log was cleared out
+    // from under it. The base is the count prior to this access, so the
+    // access that opens the window is counted as part of it. A window is
+    // only allocated the first time a port is seen while a policy is set.
+
+    auto &&iter = m_io_storm_windows.find(port);
+    if (iter == m_io_storm_windows.end())
+        iter = m_io_storm_windows.emplace(port, io_storm_window_type{now, count - 1}).first;
+
+    auto &&window = iter->second;
+
+    if (count <= window.base || now - window.start > m_io_storm_policy.window)
+    {
+        window.start = now;
+        window.base = count - 1;
+    }
+
+    if (count - window.base < m_io_storm_policy.threshold)
+        return;
+
+    m_io_storm_windows.erase(iter);
+    m_io_storm_ports[port] = now;
+
+    update_vmcs([=](auto vmcs) { vmcs->pass_through_io_access(port); });
+    bfdebug << "io storm: passing through port " << bfn::to_string(port, 16) << bfendl;
+}
+
+void
+exit_handler_intel_x64_eapis::rearm_io_storms()
+{
+    // This is called on every VM exit, so there is nothing to do unless
+    // ports are actually re-armed by the policy.
+
+    if (m_io_storm_policy.rearm == 0 || m_io_storm_ports.empty())
+        return;
+
+    auto &&now = trace_ring_timestamp();
+
+    for (auto iter = m_io_storm_ports.begin(); iter != m_io_storm_ports.end();)
+    {
+        if (now - iter->second < m_io_storm_policy.rearm)
+        {
+            ++iter;
+            continue;
+        }
+
+        auto port = iter->first;
+        update_vmcs([=](auto vmcs) { vmcs->trap_on_io_access(port); });
+
+        bfdebug << "io storm: trapping port " << bfn::to_string(port, 16) << bfendl;
+        iter = m_io_storm_ports.erase(iter);
+    }
+}
+
+void
+exit_handler_intel_x64_eapis::forget_io_storms(port_type first, port_type last)
+{
+    // Only the ports that the storm logic passed through itself are
+    // re-armed, so once the user sets the policy of a port, the storm logic
+    // lets go of it.
+
+    m_io_storm_ports.erase(m_io_storm_ports.lower_bound(first), m_io_storm_ports.upper_bound(last));
+    m_io_storm_windows.erase(m_io_storm_windows.lower_bound(first), m_io_storm_windows.upper_bound(last));
+}
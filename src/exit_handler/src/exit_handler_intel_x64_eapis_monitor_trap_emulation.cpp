@@ -19,6 +19,8 @@
 // License along with this library; if not, write to the Free Software
 // Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 
+#include <algorithm>
+
 #include <exit_handler/exit_handler_intel_x64_eapis.h>
 
 #include <vmcs/vmcs_intel_x64_32bit_control_fields.h>
@@ -31,19 +33,72 @@ using namespace vmcs;
 void
 exit_handler_intel_x64_eapis::clear_monitor_trap()
 {
-    primary_processor_based_vm_execution_controls::monitor_trap_flag::disable();
-    m_monitor_trap_callback = &exit_handler_intel_x64_eapis::unhandled_monitor_trap_callback;
+    if (!m_stepping)
+        primary_processor_based_vm_execution_controls::monitor_trap_flag::disable();
+
+    m_monitor_trap_callback_count = 0;
 }
 
 void
 exit_handler_intel_x64_eapis::unhandled_monitor_trap_callback()
 { throw std::logic_error("unhandled_monitor_trap_callback called!!!"); }
 
+void
+exit_handler_intel_x64_eapis::queue_monitor_trap_callback(monitor_trap_callback callback)
+{
+    auto &&begin = m_monitor_trap_callbacks.begin();
+    auto &&end = begin + gsl::narrow_cast<std::ptrdiff_t>(m_monitor_trap_callback_count);
+
+    if (std::find(begin, end, callback) != end)
+        return;
+
+    if (m_monitor_trap_callback_count == m_monitor_trap_callbacks.size())
+        throw std::runtime_error("register_monitor_trap failed: too many monitor trap callbacks");
+
+    m_monitor_trap_callbacks[m_monitor_trap_callback_count++] = callback;
+    primary_processor_based_vm_execution_controls::monitor_trap_flag::enable();
+}
+
+exit_handler_intel_x64_eapis::monitor_trap_callback
+exit_handler_intel_x64_eapis::dequeue_monitor_trap_callback()
+{
+    auto callback = m_monitor_trap_callbacks[0];
+    auto &&begin = m_monitor_trap_callbacks.begin();
+    auto &&end = begin + gsl::narrow_cast<std::ptrdiff_t>(m_monitor_trap_callback_count);
+
+    std::rotate(begin, begin + 1, end);
+
+    if (--m_monitor_trap_callback_count == 0 && !m_stepping)
+        primary_processor_based_vm_execution_controls::monitor_trap_flag::disable();
+
+    return callback;
+}
+
 void
 exit_handler_intel_x64_eapis::handle_exit__monitor_trap_flag()
 {
-    auto callback = m_monitor_trap_callback;
+    if (m_monitor_trap_callback_count == 0 && !m_stepping)
+    {
+        clear_monitor_trap();
+        unhandled_monitor_trap_callback();
+    }
+
+    if (m_stepping)
+        this->step();
+
+    // Only the callbacks that were queued prior to this VM exit are called.
+    // Callbacks that register themselves again stay queued for the next
+    // monitor trap VM exit. Each callback is removed from the queue before
+    // it is called, so that if it resumes the guest itself, the remaining
+    // callbacks are still called on the next VM exit.
+
+    auto count = m_monitor_trap_callback_count;
+
+    for (auto i = 0UL; i < count; i++)
+    {
+        auto &&callback = dequeue_monitor_trap_callback();
+        (this->*callback)();
+    }
 
-    clear_monitor_trap();
-    (this->*callback)();
+    this->resume();
 }
@@ -0,0 +1,231 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <exit_handler/exit_handler_intel_x64_eapis.h>
+
+#include <vmcs/vmcs_intel_x64_32bit_read_only_data_fields.h>
+
+using namespace x64;
+using namespace intel_x64;
+using namespace vmcs;
+
+constexpr const auto msrs_per_range = msr_access_log_intel_x64::msrs_per_range;
+constexpr const auto high_msrs = msr_access_log_intel_x64::high_msrs;
+
+// Returns the index of the second level table of m_msr_handlers that
+// covers the provided MSR, or false if the MSR is not covered by the MSR
+// bitmaps (in which case it is stored in m_msr_handlers_other).
+static bool
+msr_handler_table(exit_handler_intel_x64_eapis::msr_type msr, std::size_t &table)
+{
+    if (msr < msrs_per_range)
+    {
+        table = msr >> 8;
+        return true;
+    }
+
+    if (msr - high_msrs < msrs_per_range)
+    {
+        table = (msrs_per_range >> 8) + ((msr - high_msrs) >> 8);
+        return true;
+    }
+
+    return false;
+}
+
+// Returns the region of the MSR space the provided MSR belongs to: the
+// low MSRs, the MSRs between the low and the high MSRs, the high MSRs, or
+// the MSRs above them. A handler's range must stay within one region.
+static int
+msr_region(exit_handler_intel_x64_eapis::msr_type msr)
+{
+    if (msr < msrs_per_range)
+        return 0;
+
+    if (msr < high_msrs)
+        return 1;
+
+    if (msr - high_msrs < msrs_per_range)
+        return 2;
+
+    return 3;
+}
+
+void
+exit_handler_intel_x64_eapis::log_msr_access(bool enable)
+{ m_msr_access_log.enable(enable); }
+
+void
+exit_handler_intel_x64_eapis::clear_msr_access_log()
+{ m_msr_access_log.clear(); }
+
+void
+exit_handler_intel_x64_eapis::register_msr_handler(
+    msr_type first, msr_type last, gsl::not_null<msr_handler_intel_x64 *> handler)
+{
+    expects(first <= last);
+    expects(msr_region(first) == msr_region(last));
+
+    auto table_index = 0UL;
+
+    if (!msr_handler_table(first, table_index))
+    {
+        this->erase_msr_handler_ranges(first, last);
+        m_msr_handlers_other[first] = {last, handler};
+
+        return;
+    }
+
+    for (auto i = static_cast<uint64_t>(first); i <= last; i++)
+    {
+        auto &&msr = gsl::narrow_cast<msr_type>(i);
+        msr_handler_table(msr, table_index);
+
+        auto &&table = m_msr_handlers.at(table_index);
+        if (!table)
+        {
+            table = std::make_unique<msr_handler_table_type>();
+            table->fill(nullptr);
+        }
+
+        table->at(msr & 0xFF) = handler;
+
+        eapis_vmcs()->trap_on_rdmsr_access(msr);
+        eapis_vmcs()->trap_on_wrmsr_access(msr);
+    }
+}
+
+void
+exit_handler_intel_x64_eapis::unregister_msr_handler(
+    msr_type first, msr_type last)
+{
+    expects(first <= last);
+    expects(msr_region(first) == msr_region(last));
+
+    auto table_index = 0UL;
+
+    if (!msr_handler_table(first, table_index))
+    {
+        this->erase_msr_handler_ranges(first, last);
+        return;
+    }
+
+    for (auto i = static_cast<uint64_t>(first); i <= last; i++)
+    {
+        auto &&msr = gsl::narrow_cast<msr_type>(i);
+        msr_handler_table(msr, table_index);
+
+        auto &&table = m_msr_handlers.at(table_index);
+        if (table)
+            table->at(msr & 0xFF) = nullptr;
+    }
+}
+
+void
+exit_handler_intel_x64_eapis::erase_msr_handler_ranges(
+    msr_type first, msr_type last)
+{
+    // Ranges that only partially overlap [first, last] are split, keeping
+    // the MSRs that are outside of [first, last].
+
+    auto &&iter = m_msr_handlers_other.upper_bound(first);
+
+    if (iter != m_msr_handlers_other.begin() && std::prev(iter)->second.last >= first)
+        --iter;
+
+    while (iter != m_msr_handlers_other.end() && iter->first <= last)
+    {
+        auto range_first = iter->first;
+        auto range = iter->second;
+
+        iter = m_msr_handlers_other.erase(iter);
+
+        if (range_first < first)
+            m_msr_handlers_other[range_first] = {first - 1, range.handler};
+
+        if (range.last > last)
+            m_msr_handlers_other[last + 1] = {range.last, range.handler};
+    }
+}
+
+msr_handler_intel_x64 *
+exit_handler_intel_x64_eapis::msr_handler(msr_type msr) const
+{
+    auto table_index = 0UL;
+
+    if (msr_handler_table(msr, table_index))
+    {
+        auto &&table = m_msr_handlers[table_index];
+        return table ? (*table)[msr & 0xFF] : nullptr;
+    }
+
+    if (m_msr_handlers_other.empty())
+        return nullptr;
+
+    auto &&iter = m_msr_handlers_other.upper_bound(msr);
+    if (iter == m_msr_handlers_other.begin())
+        return nullptr;
+
+    --iter;
+    return msr <= iter->second.last ? iter->second.handler : nullptr;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_exit__rdmsr()
+{
+    auto &&msr = gsl::narrow_cast<msr_type>(m_state_save->rcx);
+    m_msr_access_log.log(msr);
+
+    auto &&handler = this->msr_handler(msr);
+    if (handler == nullptr)
+    {
+        exit_handler_intel_x64::handle_exit(exit_reason::basic_exit_reason::rdmsr);
+        return;
+    }
+
+    auto &&value = handler->read(msr);
+
+    m_state_save->rax = value & 0x00000000FFFFFFFFUL;
+    m_state_save->rdx = value >> 32;
+
+    this->advance_and_resume();
+}
+
+void
+exit_handler_intel_x64_eapis::handle_exit__wrmsr()
+{
+    auto &&msr = gsl::narrow_cast<msr_type>(m_state_save->rcx);
+    m_msr_access_log.log(msr);
+
+    auto &&handler = this->msr_handler(msr);
+    if (handler == nullptr)
+    {
+        exit_handler_intel_x64::handle_exit(exit_reason::basic_exit_reason::wrmsr);
+        return;
+    }
+
+    auto &&value =
+        ((m_state_save->rdx & 0x00000000FFFFFFFFUL) << 32) |
+        ((m_state_save->rax & 0x00000000FFFFFFFFUL) << 0);
+
+    handler->write(msr, value);
+    this->advance_and_resume();
+}
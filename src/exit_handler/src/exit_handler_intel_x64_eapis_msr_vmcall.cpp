@@ -0,0 +1,346 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <to_string.h>
+
+#include <exit_handler/exit_handler_intel_x64_eapis.h>
+#include <exit_handler/exit_handler_intel_x64_eapis_vmcall_interface.h>
+
+#include <exit_handler/exit_handler_intel_x64_eapis_verifiers.h>
+#include <exit_handler/exit_handler_intel_x64_eapis_msr_verifiers.h>
+
+using namespace x64;
+using namespace intel_x64;
+using namespace vmcs;
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall_registers__msr(
+    vmcall_registers_t &regs)
+{
+    switch (regs.r03)
+    {
+        case eapis_fun__trap_on_rdmsr_access:
+            handle_vmcall__trap_on_rdmsr_access(gsl::narrow_cast<msr_type>(regs.r04));
+            break;
+
+        case eapis_fun__trap_on_wrmsr_access:
+            handle_vmcall__trap_on_wrmsr_access(gsl::narrow_cast<msr_type>(regs.r04));
+            break;
+
+        case eapis_fun__trap_on_all_rdmsr_accesses:
+            handle_vmcall__trap_on_all_rdmsr_accesses();
+            break;
+
+        case eapis_fun__trap_on_all_wrmsr_accesses:
+            handle_vmcall__trap_on_all_wrmsr_accesses();
+            break;
+
+        case eapis_fun__pass_through_rdmsr_access:
+            handle_vmcall__pass_through_rdmsr_access(gsl::narrow_cast<msr_type>(regs.r04));
+            break;
+
+        case eapis_fun__pass_through_wrmsr_access:
+            handle_vmcall__pass_through_wrmsr_access(gsl::narrow_cast<msr_type>(regs.r04));
+            break;
+
+        case eapis_fun__pass_through_all_rdmsr_accesses:
+            handle_vmcall__pass_through_all_rdmsr_accesses();
+            break;
+
+        case eapis_fun__pass_through_all_wrmsr_accesses:
+            handle_vmcall__pass_through_all_wrmsr_accesses();
+            break;
+
+        default:
+            throw std::runtime_error("unknown vmcall function");
+    }
+}
+
+bool
+exit_handler_intel_x64_eapis::handle_vmcall_json__msr(
+    const json &ijson, json &ojson)
+{
+    auto set = ijson.value("set", std::string());
+
+    if (!set.empty())
+    {
+        if (set == "trap_on_rdmsr_access")
+        {
+            handle_vmcall__trap_on_rdmsr_access(json_hex_or_dec<msr_type>(ijson, "msr"));
+            ojson = {"success"};
+            return true;
+        }
+
+        if (set == "trap_on_wrmsr_access")
+        {
+            handle_vmcall__trap_on_wrmsr_access(json_hex_or_dec<msr_type>(ijson, "msr"));
+            ojson = {"success"};
+            return true;
+        }
+
+        if (set == "pass_through_rdmsr_access")
+        {
+            handle_vmcall__pass_through_rdmsr_access(json_hex_or_dec<msr_type>(ijson, "msr"));
+            ojson = {"success"};
+            return true;
+        }
+
+        if (set == "pass_through_wrmsr_access")
+        {
+            handle_vmcall__pass_through_wrmsr_access(json_hex_or_dec<msr_type>(ijson, "msr"));
+            ojson = {"success"};
+            return true;
+        }
+
+        if (set == "whitelist_rdmsr_access")
+        {
+            handle_vmcall__whitelist_rdmsr_access(json_hex_or_dec_array<msr_type>(ijson, "msrs"));
+            ojson = {"success"};
+            return true;
+        }
+
+        if (set == "whitelist_wrmsr_access")
+        {
+            handle_vmcall__whitelist_wrmsr_access(json_hex_or_dec_array<msr_type>(ijson, "msrs"));
+            ojson = {"success"};
+            return true;
+        }
+
+        if (set == "blacklist_rdmsr_access")
+        {
+            handle_vmcall__blacklist_rdmsr_access(json_hex_or_dec_array<msr_type>(ijson, "msrs"));
+            ojson = {"success"};
+            return true;
+        }
+
+        if (set == "blacklist_wrmsr_access")
+        {
+            handle_vmcall__blacklist_wrmsr_access(json_hex_or_dec_array<msr_type>(ijson, "msrs"));
+            ojson = {"success"};
+            return true;
+        }
+
+        if (set == "log_msr_access")
+        {
+            handle_vmcall__log_msr_access(ijson.at("enabled"));
+            ojson = {"success"};
+            return true;
+        }
+    }
+
+    auto run = ijson.value("run", std::string());
+
+    if (!run.empty())
+    {
+        if (run == "clear_msr_access_log")
+        {
+            handle_vmcall__clear_msr_access_log();
+            ojson = {"success"};
+            return true;
+        }
+    }
+
+    auto get = ijson.value("get", std::string());
+
+    if (!get.empty())
+    {
+        if (get == "msr_access_log")
+        {
+            handle_vmcall__msr_access_log(ojson);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__trap_on_rdmsr_access(
+    msr_type msr)
+{
+    if (policy(trap_on_rdmsr_access)->verify(msr) != vmcall_verifier::allow)
+        policy(trap_on_rdmsr_access)->deny_vmcall();
+
+    update_vmcs([=](auto vmcs) { vmcs->trap_on_rdmsr_access(msr); });
+    bfdebug << "trap_on_rdmsr_access: " << std::hex << std::uppercase << "0x" << msr << bfendl;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__trap_on_wrmsr_access(
+    msr_type msr)
+{
+    if (policy(trap_on_wrmsr_access)->verify(msr) != vmcall_verifier::allow)
+        policy(trap_on_wrmsr_access)->deny_vmcall();
+
+    update_vmcs([=](auto vmcs) { vmcs->trap_on_wrmsr_access(msr); });
+    bfdebug << "trap_on_wrmsr_access: " << std::hex << std::uppercase << "0x" << msr << bfendl;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__trap_on_all_rdmsr_accesses()
+{
+    if (policy(trap_on_all_rdmsr_accesses)->verify() != vmcall_verifier::allow)
+        policy(trap_on_all_rdmsr_accesses)->deny_vmcall();
+
+    update_vmcs([](auto vmcs) { vmcs->trap_on_all_rdmsr_accesses(); });
+    bfdebug << "trap_on_all_rdmsr_accesses: success" << bfendl;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__trap_on_all_wrmsr_accesses()
+{
+    if (policy(trap_on_all_wrmsr_accesses)->verify() != vmcall_verifier::allow)
+        policy(trap_on_all_wrmsr_accesses)->deny_vmcall();
+
+    update_vmcs([](auto vmcs) { vmcs->trap_on_all_wrmsr_accesses(); });
+    bfdebug << "trap_on_all_wrmsr_accesses: success" << bfendl;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__pass_through_rdmsr_access(
+    msr_type msr)
+{
+    if (policy(pass_through_rdmsr_access)->verify(msr) != vmcall_verifier::allow)
+        policy(pass_through_rdmsr_access)->deny_vmcall();
+
+    update_vmcs([=](auto vmcs) { vmcs->pass_through_rdmsr_access(msr); });
+    bfdebug << "pass_through_rdmsr_access: " << std::hex << std::uppercase << "0x" << msr << bfendl;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__pass_through_wrmsr_access(
+    msr_type msr)
+{
+    if (policy(pass_through_wrmsr_access)->verify(msr) != vmcall_verifier::allow)
+        policy(pass_through_wrmsr_access)->deny_vmcall();
+
+    update_vmcs([=](auto vmcs) { vmcs->pass_through_wrmsr_access(msr); });
+    bfdebug << "pass_through_wrmsr_access: " << std::hex << std::uppercase << "0x" << msr << bfendl;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__pass_through_all_rdmsr_accesses()
+{
+    if (policy(pass_through_all_rdmsr_accesses)->verify() != vmcall_verifier::allow)
+        policy(pass_through_all_rdmsr_accesses)->deny_vmcall();
+
+    update_vmcs([](auto vmcs) { vmcs->pass_through_all_rdmsr_accesses(); });
+    bfdebug << "pass_through_all_rdmsr_accesses: success" << bfendl;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__pass_through_all_wrmsr_accesses()
+{
+    if (policy(pass_through_all_wrmsr_accesses)->verify() != vmcall_verifier::allow)
+        policy(pass_through_all_wrmsr_accesses)->deny_vmcall();
+
+    update_vmcs([](auto vmcs) { vmcs->pass_through_all_wrmsr_accesses(); });
+    bfdebug << "pass_through_all_wrmsr_accesses: success" << bfendl;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__whitelist_rdmsr_access(
+    const msr_list_type &msrs)
+{
+    if (policy(whitelist_rdmsr_access)->verify(msrs) != vmcall_verifier::allow)
+        policy(whitelist_rdmsr_access)->deny_vmcall();
+
+    update_vmcs([=](auto vmcs) { vmcs->whitelist_rdmsr_access(msrs); });
+
+    bfdebug << "whitelist_rdmsr_access: " << bfendl;
+    for (auto msr : msrs)
+        bfdebug << "  - " << std::hex << std::uppercase << "0x" << msr << bfendl;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__whitelist_wrmsr_access(
+    const msr_list_type &msrs)
+{
+    if (policy(whitelist_wrmsr_access)->verify(msrs) != vmcall_verifier::allow)
+        policy(whitelist_wrmsr_access)->deny_vmcall();
+
+    update_vmcs([=](auto vmcs) { vmcs->whitelist_wrmsr_access(msrs); });
+
+    bfdebug << "whitelist_wrmsr_access: " << bfendl;
+    for (auto msr : msrs)
+        bfdebug << "  - " << std::hex << std::uppercase << "0x" << msr << bfendl;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__blacklist_rdmsr_access(
+    const msr_list_type &msrs)
+{
+    if (policy(blacklist_rdmsr_access)->verify(msrs) != vmcall_verifier::allow)
+        policy(blacklist_rdmsr_access)->deny_vmcall();
+
+    update_vmcs([=](auto vmcs) { vmcs->blacklist_rdmsr_access(msrs); });
+
+    bfdebug << "blacklist_rdmsr_access: " << bfendl;
+    for (auto msr : msrs)
+        bfdebug << "  - " << std::hex << std::uppercase << "0x" << msr << bfendl;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__blacklist_wrmsr_access(
+    const msr_list_type &msrs)
+{
+    if (policy(blacklist_wrmsr_access)->verify(msrs) != vmcall_verifier::allow)
+        policy(blacklist_wrmsr_access)->deny_vmcall();
+
+    update_vmcs([=](auto vmcs) { vmcs->blacklist_wrmsr_access(msrs); });
+
+    bfdebug << "blacklist_wrmsr_access: " << bfendl;
+    for (auto msr : msrs)
+        bfdebug << "  - " << std::hex << std::uppercase << "0x" << msr << bfendl;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__log_msr_access(
+    bool enabled)
+{
+    if (policy(log_msr_access)->verify(enabled) != vmcall_verifier::allow)
+        policy(log_msr_access)->deny_vmcall();
+
+    log_msr_access(enabled);
+    bfdebug << "log_msr_access: " << std::boolalpha << enabled << bfendl;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__clear_msr_access_log()
+{
+    if (policy(clear_msr_access_log)->verify() != vmcall_verifier::allow)
+        policy(clear_msr_access_log)->deny_vmcall();
+
+    msr_access_log_intel_x64::clear_all();
+    bfdebug << "clear_msr_access_log: success" << bfendl;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__msr_access_log(json &ojson)
+{
+    if (policy(msr_access_log)->verify() != vmcall_verifier::allow)
+        policy(msr_access_log)->deny_vmcall();
+
+    for (const auto &pair : msr_access_log_intel_x64::aggregate())
+        ojson[bfn::to_string(pair.first, 16)] = pair.second;
+
+    bfdebug << "dump msr_access_log: success" << bfendl;
+}
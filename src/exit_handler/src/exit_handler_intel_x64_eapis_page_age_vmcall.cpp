@@ -0,0 +1,118 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <to_string.h>
+
+#include <exit_handler/exit_handler_intel_x64_eapis.h>
+#include <exit_handler/exit_handler_intel_x64_eapis_vmcall_interface.h>
+
+#include <exit_handler/exit_handler_intel_x64_eapis_verifiers.h>
+#include <exit_handler/exit_handler_intel_x64_eapis_page_age_verifiers.h>
+
+using namespace x64;
+using namespace intel_x64;
+using namespace vmcs;
+
+bool
+exit_handler_intel_x64_eapis::handle_vmcall_json__page_age(
+    const json &ijson, json &ojson)
+{
+    auto run = ijson.value("run", std::string());
+
+    if (!run.empty())
+    {
+        if (run == "sample_page_ages")
+        {
+            handle_vmcall__sample_page_ages();
+            ojson = {"success"};
+            return true;
+        }
+    }
+
+    auto get = ijson.value("get", std::string());
+
+    if (!get.empty())
+    {
+        if (get == "page_age_histogram")
+        {
+            handle_vmcall__page_age_histogram(ojson);
+            return true;
+        }
+
+        if (get == "cold_ranges")
+        {
+            handle_vmcall__cold_ranges(json_hex_or_dec<page_age_sampler_intel_x64::size_type>(ijson, "count"), ojson);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__sample_page_ages()
+{
+    if (policy(sample_page_ages)->verify() != vmcall_verifier::allow)
+        policy(sample_page_ages)->deny_vmcall();
+
+    page_age_sampler()->tick();
+    bfdebug << "sample_page_ages: success" << bfendl;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__page_age_histogram(json &ojson)
+{
+    if (policy(page_age_histogram)->verify() != vmcall_verifier::allow)
+        policy(page_age_histogram)->deny_vmcall();
+
+    for (auto count : page_age_sampler()->histogram())
+        ojson.push_back(count);
+
+    bfdebug << "dump page_age_histogram: success" << bfendl;
+}
+
+void
+exit_handler_intel_x64_eapis::handle_vmcall__cold_ranges(
+    page_age_sampler_intel_x64::size_type count, json &ojson)
+{
+    if (policy(cold_ranges)->verify(count) != vmcall_verifier::allow)
+        policy(cold_ranges)->deny_vmcall();
+
+    for (const auto &range : page_age_sampler()->cold_ranges(count))
+    {
+        ojson.push_back({
+            {"gpa", bfn::to_string(range.gpa, 16)},
+            {"size", bfn::to_string(range.size, 16)},
+            {"age", range.age}
+        });
+    }
+
+    bfdebug << "dump cold_ranges: success" << bfendl;
+}
+
+page_age_sampler_intel_x64 *
+exit_handler_intel_x64_eapis::page_age_sampler()
+{
+    if (m_page_age_sampler == nullptr)
+        throw std::runtime_error("page age sampler not set");
+
+    return m_page_age_sampler;
+}
@@ -0,0 +1,76 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <exit_handler/exit_handler_intel_x64_eapis.h>
+
+#include <vmcs/vmcs_intel_x64_32bit_control_fields.h>
+
+using namespace intel_x64;
+using namespace vmcs;
+
+void
+exit_handler_intel_x64_eapis::start_stepping(
+    gsl::span<uint8_t> buffer, uint64_t budget, step_predicate_type predicate)
+{
+    expects(budget != 0);
+
+    m_step_trace = std::make_unique<step_trace_intel_x64>(buffer);
+    m_step_predicate = std::move(predicate);
+    m_step_budget = budget;
+    m_step_count = 0;
+    m_stepping = true;
+
+    primary_processor_based_vm_execution_controls::monitor_trap_flag::enable();
+}
+
+void
+exit_handler_intel_x64_eapis::stop_stepping()
+{
+    m_stepping = false;
+
+    if (m_monitor_trap_callback_count == 0)
+        primary_processor_based_vm_execution_controls::monitor_trap_flag::disable();
+}
+
+void
+exit_handler_intel_x64_eapis::step()
+{
+    auto &&rip = m_state_save->rip;
+
+    step_trace_record_intel_x64 record =
+    {
+        trace_ring_timestamp(),
+        ++m_step_count,
+        rip,
+        m_state_save->rsp,
+        m_state_save->rax,
+        m_state_save->rbx,
+        m_state_save->rcx,
+        m_state_save->rdx,
+        m_state_save->rsi,
+        m_state_save->rdi
+    };
+
+    m_step_trace->push(record);
+
+    if (m_step_count == m_step_budget || (m_step_predicate && m_step_predicate(rip)))
+        this->stop_stepping();
+}
@@ -75,12 +75,12 @@ exit_handler_intel_x64_eapis::handle_vmcall__enable_vpid(bool enabled)
 
     if (enabled)
     {
-        eapis_vmcs()->enable_vpid();
+        update_vmcs([](auto vmcs) { vmcs->enable_vpid(); });
         bfdebug << "enable_vpid: success" << bfendl;
     }
     else
     {
-        eapis_vmcs()->disable_vpid();
+        update_vmcs([](auto vmcs) { vmcs->disable_vpid(); });
         bfdebug << "disable_vpid: success" << bfendl;
     }
 }
@@ -0,0 +1,144 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <algorithm>
+
+#include <exit_handler/exit_stats_intel_x64.h>
+
+#if ENABLE_EXIT_STATS
+
+constexpr const exit_stats_intel_x64::reason_type exit_stats_intel_x64::max_exit_reasons;
+constexpr const std::size_t exit_stats_intel_x64::num_buckets;
+
+exit_stats_intel_x64::exit_stats_intel_x64()
+{
+    this->clear();
+
+    std::lock_guard<std::mutex> guard(registry_mutex());
+    registry().push_back(this);
+}
+
+exit_stats_intel_x64::~exit_stats_intel_x64()
+{
+    std::lock_guard<std::mutex> guard(registry_mutex());
+
+    auto &&stats = registry();
+    stats.erase(std::remove(stats.begin(), stats.end(), this), stats.end());
+}
+
+exit_stats_intel_x64::stats_type
+exit_stats_intel_x64::stats(reason_type reason) const noexcept
+{
+    stats_type stats = {};
+
+    if (reason >= max_exit_reasons)
+        return stats;
+
+    auto &&counters = m_counters[reason];
+
+    stats.count = counters.count.load(std::memory_order_relaxed);
+    stats.ticks = counters.ticks.load(std::memory_order_relaxed);
+
+    for (auto i = 0UL; i < num_buckets; i++)
+        stats.histogram[i] = counters.histogram[i].load(std::memory_order_relaxed);
+
+    return stats;
+}
+
+void
+exit_stats_intel_x64::clear() noexcept
+{
+    for (auto &counters : m_counters)
+    {
+        counters.count.store(0, std::memory_order_relaxed);
+        counters.ticks.store(0, std::memory_order_relaxed);
+
+        for (auto &counter : counters.histogram)
+            counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+exit_stats_intel_x64::snapshot_type
+exit_stats_intel_x64::snapshot() const
+{
+    snapshot_type snapshot;
+    this->snapshot(snapshot);
+
+    return snapshot;
+}
+
+exit_stats_intel_x64::snapshot_type
+exit_stats_intel_x64::aggregate()
+{
+    snapshot_type snapshot;
+
+    std::lock_guard<std::mutex> guard(registry_mutex());
+
+    for (const auto &stats : registry())
+        stats->snapshot(snapshot);
+
+    return snapshot;
+}
+
+void
+exit_stats_intel_x64::clear_all()
+{
+    std::lock_guard<std::mutex> guard(registry_mutex());
+
+    for (const auto &stats : registry())
+        stats->clear();
+}
+
+void
+exit_stats_intel_x64::snapshot(snapshot_type &snapshot) const
+{
+    for (auto reason = 0UL; reason < max_exit_reasons; reason++)
+    {
+        auto &&stats = this->stats(reason);
+
+        if (stats.count == 0)
+            continue;
+
+        auto &&total = snapshot[reason];
+
+        total.count += stats.count;
+        total.ticks += stats.ticks;
+
+        for (auto i = 0UL; i < num_buckets; i++)
+            total.histogram[i] += stats.histogram[i];
+    }
+}
+
+std::mutex &
+exit_stats_intel_x64::registry_mutex()
+{
+    static std::mutex g_mutex;
+    return g_mutex;
+}
+
+std::vector<exit_stats_intel_x64 *> &
+exit_stats_intel_x64::registry()
+{
+    static std::vector<exit_stats_intel_x64 *> g_registry;
+    return g_registry;
+}
+
+#endif
@@ -0,0 +1,139 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <algorithm>
+
+#include <exit_handler/io_access_log_intel_x64.h>
+
+constexpr const decltype(io_access_log_intel_x64::num_ports) io_access_log_intel_x64::num_ports;
+
+io_access_log_intel_x64::io_access_log_intel_x64() :
+    m_enabled(false)
+{
+    std::lock_guard<std::mutex> guard(registry_mutex());
+    registry().push_back(this);
+}
+
+io_access_log_intel_x64::~io_access_log_intel_x64()
+{
+    std::lock_guard<std::mutex> guard(registry_mutex());
+
+    auto &&logs = registry();
+    logs.erase(std::remove(logs.begin(), logs.end(), this), logs.end());
+}
+
+void
+io_access_log_intel_x64::enable(bool enable)
+{
+    if (enable && !m_counters)
+    {
+        auto &&counters = std::make_unique<std::atomic<count_type>[]>(num_ports);
+
+        // Another vCPU could be taking a snapshot, so the counters are
+        // published while holding the registry lock.
+
+        std::lock_guard<std::mutex> guard(registry_mutex());
+        m_counters = std::move(counters);
+    }
+
+    m_enabled = enable;
+}
+
+io_access_log_intel_x64::count_type
+io_access_log_intel_x64::count(port_type port) const noexcept
+{
+    if (!m_counters)
+        return 0;
+
+    return m_counters[port].load(std::memory_order_relaxed);
+}
+
+void
+io_access_log_intel_x64::clear() noexcept
+{
+    if (!m_counters)
+        return;
+
+    for (auto port = 0UL; port < num_ports; port++)
+        m_counters[port].store(0, std::memory_order_relaxed);
+}
+
+io_access_log_intel_x64::snapshot_type
+io_access_log_intel_x64::snapshot() const
+{
+    snapshot_type snapshot;
+
+    std::lock_guard<std::mutex> guard(registry_mutex());
+    this->snapshot(snapshot);
+
+    return snapshot;
+}
+
+io_access_log_intel_x64::snapshot_type
+io_access_log_intel_x64::aggregate()
+{
+    snapshot_type snapshot;
+
+    std::lock_guard<std::mutex> guard(registry_mutex());
+
+    for (const auto &log : registry())
+        log->snapshot(snapshot);
+
+    return snapshot;
+}
+
+void
+io_access_log_intel_x64::clear_all()
+{
+    std::lock_guard<std::mutex> guard(registry_mutex());
+
+    for (const auto &log : registry())
+        log->clear();
+}
+
+void
+io_access_log_intel_x64::snapshot(snapshot_type &snapshot) const
+{
+    if (!m_counters)
+        return;
+
+    for (auto port = 0UL; port < num_ports; port++)
+    {
+        auto &&count = m_counters[port].load(std::memory_order_relaxed);
+
+        if (count != 0)
+            snapshot[gsl::narrow_cast<port_type>(port)] += count;
+    }
+}
+
+std::mutex &
+io_access_log_intel_x64::registry_mutex()
+{
+    static std::mutex g_mutex;
+    return g_mutex;
+}
+
+std::vector<io_access_log_intel_x64 *> &
+io_access_log_intel_x64::registry()
+{
+    static std::vector<io_access_log_intel_x64 *> g_registry;
+    return g_registry;
+}
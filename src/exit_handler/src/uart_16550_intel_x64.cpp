@@ -0,0 +1,196 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <exit_handler/uart_16550_intel_x64.h>
+
+constexpr const uart_16550_intel_x64::port_type uart_16550_intel_x64::com1;
+constexpr const uart_16550_intel_x64::port_type uart_16550_intel_x64::num_ports;
+
+// Register offsets (from the base port)
+constexpr const auto uart_data = 0U;
+constexpr const auto uart_ier = 1U;
+constexpr const auto uart_iir_fcr = 2U;
+constexpr const auto uart_lcr = 3U;
+constexpr const auto uart_mcr = 4U;
+constexpr const auto uart_lsr = 5U;
+constexpr const auto uart_msr = 6U;
+constexpr const auto uart_scr = 7U;
+
+constexpr const auto lcr_dlab = 0x80U;
+constexpr const auto ier_thri = 0x02U;
+constexpr const auto fcr_enable = 0x01U;
+constexpr const auto mcr_loop = 0x10U;
+
+constexpr const auto iir_no_int = 0x01U;
+constexpr const auto iir_thri = 0x02U;
+constexpr const auto iir_fifo_enabled = 0xC0U;
+
+// The transmit holding register and the transmitter are always empty
+constexpr const auto lsr_thre_temt = 0x60U;
+
+// DCD, DSR and CTS are always asserted
+constexpr const auto msr_asserted = 0xB0U;
+
+uart_16550_intel_x64::uart_16550_intel_x64(port_type base, size_type capacity) :
+    m_base(base),
+    m_ier(0),
+    m_fcr(0),
+    m_lcr(0),
+    m_mcr(0),
+    m_scr(0),
+    m_dll(0),
+    m_dlm(0),
+    m_buffer(capacity),
+    m_head(0),
+    m_size(0),
+    m_dropped(0)
+{
+    expects(capacity != 0);
+}
+
+uart_16550_intel_x64::value_type
+uart_16550_intel_x64::read(port_type port, size_type size)
+{
+    (void) size;
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    switch (static_cast<uint32_t>(port - m_base))
+    {
+        case uart_data:
+            return (m_lcr & lcr_dlab) != 0 ? m_dll : 0U;
+
+        case uart_ier:
+            return (m_lcr & lcr_dlab) != 0 ? m_dlm : m_ier;
+
+        case uart_iir_fcr:
+        {
+            auto &&fifo = (m_fcr & fcr_enable) != 0 ? iir_fifo_enabled : 0U;
+            return fifo | ((m_ier & ier_thri) != 0 ? iir_thri : iir_no_int);
+        }
+
+        case uart_lcr:
+            return m_lcr;
+
+        case uart_mcr:
+            return m_mcr;
+
+        case uart_lsr:
+            return lsr_thre_temt;
+
+        case uart_msr:
+        {
+            // In loopback mode, the modem control outputs (DTR, RTS, OUT1
+            // and OUT2) are looped back to DSR, CTS, RI and DCD, which is
+            // how drivers probe for the presence of a UART.
+
+            if ((m_mcr & mcr_loop) != 0)
+                return ((m_mcr & 0x01U) << 5) | ((m_mcr & 0x02U) << 3) | ((m_mcr & 0x0CU) << 4);
+
+            return msr_asserted;
+        }
+
+        case uart_scr:
+            return m_scr;
+
+        default:
+            return 0xFFU;
+    }
+}
+
+void
+uart_16550_intel_x64::write(port_type port, size_type size, value_type value)
+{
+    (void) size;
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    auto &&byte = gsl::narrow_cast<uint8_t>(value);
+
+    switch (static_cast<uint32_t>(port - m_base))
+    {
+        case uart_data:
+            if ((m_lcr & lcr_dlab) != 0)
+                m_dll = byte;
+            else if ((m_mcr & mcr_loop) == 0)
+                this->transmit(static_cast<char>(byte));
+            break;
+
+        case uart_ier:
+            if ((m_lcr & lcr_dlab) != 0)
+                m_dlm = byte;
+            else
+                m_ier = byte & 0x0FU;
+            break;
+
+        case uart_iir_fcr:
+            m_fcr = byte;
+            break;
+
+        case uart_lcr:
+            m_lcr = byte;
+            break;
+
+        case uart_mcr:
+            m_mcr = byte & 0x1FU;
+            break;
+
+        case uart_scr:
+            m_scr = byte;
+            break;
+
+        default:
+            break;
+    }
+}
+
+uart_16550_intel_x64::output_type
+uart_16550_intel_x64::drain()
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    output_type output;
+    output.reserve(m_size);
+
+    auto &&tail = (m_head + m_buffer.size() - m_size) % m_buffer.size();
+    for (auto i = 0UL; i < m_size; i++)
+        output.push_back(m_buffer[(tail + i) % m_buffer.size()]);
+
+    m_size = 0;
+    return output;
+}
+
+uart_16550_intel_x64::size_type
+uart_16550_intel_x64::dropped() const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_dropped;
+}
+
+void
+uart_16550_intel_x64::transmit(char c)
+{
+    m_buffer[m_head] = c;
+    m_head = (m_head + 1) % m_buffer.size();
+
+    if (m_size == m_buffer.size())
+        m_dropped++;
+    else
+        m_size++;
+}
@@ -45,11 +45,51 @@ eapis_ut::list()
     this->test_handle_exit_invalid();
     this->test_handle_exit_monitor_trap_flag();
     this->test_handle_exit_io_instruction();
+    this->test_handle_exit_io_instruction_emulate_in();
+    this->test_handle_exit_io_instruction_emulate_out();
+    this->test_handle_exit_io_instruction_emulate_string();
+    this->test_handle_exit_io_instruction_emulate_rep_string();
+    this->test_handle_exit_io_instruction_emulate_rep_string_partial();
+    this->test_handle_exit_io_instruction_emulate_rep_string_no_paging();
+    this->test_handle_exit_io_instruction_io_port_handler();
+    this->test_handle_exit_io_instruction_io_port_handler_unregistered();
+    this->test_handle_exit_io_instruction_uart();
+    this->test_handle_exit_io_instruction_uart_broadcast();
+    this->test_register_io_port_handler();
+    this->test_handle_exit_ept_violation();
+    this->test_handle_exit_ept_violation_not_merged();
     this->test_register_monitor_trap();
+    this->test_register_monitor_trap_multiple();
+    this->test_register_monitor_trap_rearm();
+    this->test_register_monitor_trap_full();
+    this->test_stepping_budget();
+    this->test_stepping_predicate();
+    this->test_stepping_with_monitor_trap_callbacks();
     this->test_clear_monitor_trap_by_default();
     this->test_log_io_access_enabled();
     this->test_log_io_access_disabled();
     this->test_clear_io_access_log();
+    this->test_io_access_log();
+    this->test_handle_exit_msr_handler();
+    this->test_handle_exit_msr_handler_unregistered();
+    this->test_register_exit_handler();
+    this->test_register_msr_handler();
+    this->test_register_msr_handler_range();
+    this->test_msr_access_log();
+#if ENABLE_EXIT_STATS
+    this->test_exit_stats();
+    this->test_handle_exit_exit_stats();
+#endif
+    this->test_trace_ring();
+    this->test_trace_ring_overwrite();
+    this->test_uart_16550();
+    this->test_handle_exit_io_instruction_trace();
+    this->test_handle_exit_trace();
+    this->test_handle_exit_io_instruction_storm();
+    this->test_broadcast();
+    this->test_broadcast_base_exit();
+    this->test_broadcast_invept();
+    this->test_handle_vmcall_json_broadcast();
     this->test_handle_vmcall_overrun_denials_buffer();
     this->test_handle_vmcall_registers_unknown();
     this->test_handle_vmcall_registers_io_instruction_unknown();
@@ -76,6 +116,14 @@ eapis_ut::list()
     this->test_handle_vmcall_json_io_instruction_pass_through_io_access_allowed();
     this->test_handle_vmcall_json_io_instruction_pass_through_io_access_logged();
     this->test_handle_vmcall_json_io_instruction_pass_through_io_access_denied();
+    this->test_handle_vmcall_json_io_instruction_trap_on_io_range_invalid_range();
+    this->test_handle_vmcall_json_io_instruction_trap_on_io_range_allowed();
+    this->test_handle_vmcall_json_io_instruction_trap_on_io_range_logged();
+    this->test_handle_vmcall_json_io_instruction_trap_on_io_range_denied();
+    this->test_handle_vmcall_json_io_instruction_pass_through_io_range_invalid_range();
+    this->test_handle_vmcall_json_io_instruction_pass_through_io_range_allowed();
+    this->test_handle_vmcall_json_io_instruction_pass_through_io_range_logged();
+    this->test_handle_vmcall_json_io_instruction_pass_through_io_range_denied();
     this->test_handle_vmcall_json_io_instruction_whitelist_io_access_missing_ports();
     this->test_handle_vmcall_json_io_instruction_whitelist_io_access_invalid_ports();
     this->test_handle_vmcall_json_io_instruction_whitelist_io_access_allowed();
@@ -88,6 +136,9 @@ eapis_ut::list()
     this->test_handle_vmcall_json_io_instruction_blacklist_io_access_denied();
     this->test_handle_vmcall_json_io_instruction_log_io_access_missing_enabled();
     this->test_handle_vmcall_json_io_instruction_log_io_access_invalid_enabled();
+    this->test_handle_vmcall_json_io_instruction_share_io_bitmaps_allowed();
+    this->test_handle_vmcall_json_io_instruction_share_io_bitmaps_logged();
+    this->test_handle_vmcall_json_io_instruction_share_io_bitmaps_denied();
     this->test_handle_vmcall_json_io_instruction_log_io_access_allowed();
     this->test_handle_vmcall_json_io_instruction_log_io_access_logged();
     this->test_handle_vmcall_json_io_instruction_log_io_access_denied();
@@ -97,6 +148,26 @@ eapis_ut::list()
     this->test_handle_vmcall_json_io_instruction_io_access_log_allowed();
     this->test_handle_vmcall_json_io_instruction_io_access_log_logged();
     this->test_handle_vmcall_json_io_instruction_io_access_log_denied();
+    this->test_handle_vmcall_json_io_instruction_trace_io_access_unaligned();
+    this->test_handle_vmcall_json_io_instruction_trace_io_access_allowed();
+    this->test_handle_vmcall_json_io_instruction_trace_io_access_logged();
+    this->test_handle_vmcall_json_io_instruction_trace_io_access_denied();
+    this->test_handle_vmcall_json_io_instruction_trace_io_access_unmapped();
+    this->test_handle_vmcall_json_io_instruction_trace_io_access_read_only();
+    this->test_handle_vmcall_json_io_instruction_trace_io_access_spp();
+    this->test_handle_vmcall_json_io_instruction_trace_io_access_merged();
+    this->test_handle_vmcall_json_io_instruction_io_storm_policy_allowed();
+    this->test_handle_vmcall_json_io_instruction_io_storm_policy_logged();
+    this->test_handle_vmcall_json_io_instruction_io_storm_policy_denied();
+    this->test_handle_vmcall_json_io_instruction_io_storms_allowed();
+    this->test_handle_vmcall_json_io_instruction_io_storms_logged();
+    this->test_handle_vmcall_json_io_instruction_io_storms_denied();
+    this->test_handle_vmcall_json_io_instruction_emulate_uart_allowed();
+    this->test_handle_vmcall_json_io_instruction_emulate_uart_logged();
+    this->test_handle_vmcall_json_io_instruction_emulate_uart_denied();
+    this->test_handle_vmcall_json_io_instruction_uart_output_allowed();
+    this->test_handle_vmcall_json_io_instruction_uart_output_logged();
+    this->test_handle_vmcall_json_io_instruction_uart_output_denied();
     this->test_handle_vmcall_registers_vpid_unknown();
     this->test_handle_vmcall_registers_vpid_enable_vpid_allowed();
     this->test_handle_vmcall_registers_vpid_enable_vpid_logged();
@@ -109,6 +180,64 @@ eapis_ut::list()
     this->test_handle_vmcall_json_vpid_enable_vpid_allowed();
     this->test_handle_vmcall_json_vpid_enable_vpid_logged();
     this->test_handle_vmcall_json_vpid_enable_vpid_denied();
+    this->test_handle_vmcall_registers_msr_unknown();
+    this->test_handle_vmcall_registers_msr_trap_on_rdmsr_access_allowed();
+    this->test_handle_vmcall_registers_msr_trap_on_rdmsr_access_logged();
+    this->test_handle_vmcall_registers_msr_trap_on_rdmsr_access_denied();
+    this->test_handle_vmcall_registers_msr_trap_on_wrmsr_access_allowed();
+    this->test_handle_vmcall_registers_msr_trap_on_wrmsr_access_logged();
+    this->test_handle_vmcall_registers_msr_trap_on_wrmsr_access_denied();
+    this->test_handle_vmcall_registers_msr_trap_on_all_rdmsr_accesses_allowed();
+    this->test_handle_vmcall_registers_msr_trap_on_all_rdmsr_accesses_logged();
+    this->test_handle_vmcall_registers_msr_trap_on_all_rdmsr_accesses_denied();
+    this->test_handle_vmcall_registers_msr_trap_on_all_wrmsr_accesses_allowed();
+    this->test_handle_vmcall_registers_msr_trap_on_all_wrmsr_accesses_logged();
+    this->test_handle_vmcall_registers_msr_trap_on_all_wrmsr_accesses_denied();
+    this->test_handle_vmcall_registers_msr_pass_through_rdmsr_access_allowed();
+    this->test_handle_vmcall_registers_msr_pass_through_rdmsr_access_logged();
+    this->test_handle_vmcall_registers_msr_pass_through_rdmsr_access_denied();
+    this->test_handle_vmcall_registers_msr_pass_through_wrmsr_access_allowed();
+    this->test_handle_vmcall_registers_msr_pass_through_wrmsr_access_logged();
+    this->test_handle_vmcall_registers_msr_pass_through_wrmsr_access_denied();
+    this->test_handle_vmcall_registers_msr_pass_through_all_rdmsr_accesses_allowed();
+    this->test_handle_vmcall_registers_msr_pass_through_all_rdmsr_accesses_logged();
+    this->test_handle_vmcall_registers_msr_pass_through_all_rdmsr_accesses_denied();
+    this->test_handle_vmcall_registers_msr_pass_through_all_wrmsr_accesses_allowed();
+    this->test_handle_vmcall_registers_msr_pass_through_all_wrmsr_accesses_logged();
+    this->test_handle_vmcall_registers_msr_pass_through_all_wrmsr_accesses_denied();
+    this->test_handle_vmcall_json_msr_trap_on_rdmsr_access_allowed();
+    this->test_handle_vmcall_json_msr_trap_on_rdmsr_access_logged();
+    this->test_handle_vmcall_json_msr_trap_on_rdmsr_access_denied();
+    this->test_handle_vmcall_json_msr_trap_on_wrmsr_access_allowed();
+    this->test_handle_vmcall_json_msr_trap_on_wrmsr_access_logged();
+    this->test_handle_vmcall_json_msr_trap_on_wrmsr_access_denied();
+    this->test_handle_vmcall_json_msr_pass_through_rdmsr_access_allowed();
+    this->test_handle_vmcall_json_msr_pass_through_rdmsr_access_logged();
+    this->test_handle_vmcall_json_msr_pass_through_rdmsr_access_denied();
+    this->test_handle_vmcall_json_msr_pass_through_wrmsr_access_allowed();
+    this->test_handle_vmcall_json_msr_pass_through_wrmsr_access_logged();
+    this->test_handle_vmcall_json_msr_pass_through_wrmsr_access_denied();
+    this->test_handle_vmcall_json_msr_whitelist_rdmsr_access_allowed();
+    this->test_handle_vmcall_json_msr_whitelist_rdmsr_access_logged();
+    this->test_handle_vmcall_json_msr_whitelist_rdmsr_access_denied();
+    this->test_handle_vmcall_json_msr_whitelist_wrmsr_access_allowed();
+    this->test_handle_vmcall_json_msr_whitelist_wrmsr_access_logged();
+    this->test_handle_vmcall_json_msr_whitelist_wrmsr_access_denied();
+    this->test_handle_vmcall_json_msr_blacklist_rdmsr_access_allowed();
+    this->test_handle_vmcall_json_msr_blacklist_rdmsr_access_logged();
+    this->test_handle_vmcall_json_msr_blacklist_rdmsr_access_denied();
+    this->test_handle_vmcall_json_msr_blacklist_wrmsr_access_allowed();
+    this->test_handle_vmcall_json_msr_blacklist_wrmsr_access_logged();
+    this->test_handle_vmcall_json_msr_blacklist_wrmsr_access_denied();
+    this->test_handle_vmcall_json_msr_log_msr_access_allowed();
+    this->test_handle_vmcall_json_msr_log_msr_access_logged();
+    this->test_handle_vmcall_json_msr_log_msr_access_denied();
+    this->test_handle_vmcall_json_msr_clear_msr_access_log_allowed();
+    this->test_handle_vmcall_json_msr_clear_msr_access_log_logged();
+    this->test_handle_vmcall_json_msr_clear_msr_access_log_denied();
+    this->test_handle_vmcall_json_msr_msr_access_log_allowed();
+    this->test_handle_vmcall_json_msr_msr_access_log_logged();
+    this->test_handle_vmcall_json_msr_msr_access_log_denied();
     this->test_handle_vmcall_json_verifiers_clear_denials_allowed();
     this->test_handle_vmcall_json_verifiers_clear_denials_logged();
     this->test_handle_vmcall_json_verifiers_clear_denials_denied();
@@ -118,6 +247,31 @@ eapis_ut::list()
     this->test_handle_vmcall_json_verifiers_dump_denials_allowed();
     this->test_handle_vmcall_json_verifiers_dump_denials_logged();
     this->test_handle_vmcall_json_verifiers_dump_denials_denied();
+    this->test_handle_vmcall_json_page_age_sample_page_ages_no_sampler();
+    this->test_handle_vmcall_json_page_age_sample_page_ages_allowed();
+    this->test_handle_vmcall_json_page_age_sample_page_ages_logged();
+    this->test_handle_vmcall_json_page_age_sample_page_ages_denied();
+    this->test_handle_vmcall_json_page_age_page_age_histogram_allowed();
+    this->test_handle_vmcall_json_page_age_page_age_histogram_logged();
+    this->test_handle_vmcall_json_page_age_page_age_histogram_denied();
+    this->test_handle_vmcall_json_page_age_cold_ranges_missing_count();
+    this->test_handle_vmcall_json_page_age_cold_ranges_allowed();
+    this->test_handle_vmcall_json_page_age_cold_ranges_logged();
+    this->test_handle_vmcall_json_page_age_cold_ranges_denied();
+#if ENABLE_EXIT_STATS
+    this->test_handle_vmcall_json_exit_stats_exit_stats_allowed();
+    this->test_handle_vmcall_json_exit_stats_exit_stats_logged();
+    this->test_handle_vmcall_json_exit_stats_exit_stats_denied();
+    this->test_handle_vmcall_json_exit_stats_clear_exit_stats_allowed();
+    this->test_handle_vmcall_json_exit_stats_clear_exit_stats_logged();
+    this->test_handle_vmcall_json_exit_stats_clear_exit_stats_denied();
+#endif
+    this->test_handle_vmcall_json_exit_stats_trace_exits_unaligned();
+    this->test_handle_vmcall_json_exit_stats_trace_exits_allowed();
+    this->test_handle_vmcall_json_exit_stats_trace_exits_logged();
+    this->test_handle_vmcall_json_exit_stats_trace_exits_denied();
+    this->test_handle_vmcall_json_exit_stats_trace_exits_read_only();
+    this->test_handle_vmcall_json_exit_stats_trace_exits_merged();
 
     return true;
 }
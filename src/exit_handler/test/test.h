@@ -23,6 +23,7 @@
 #define TEST_H
 
 #include <unittest.h>
+#include <exit_handler/exit_stats_intel_x64.h>
 
 class eapis_ut : public unittest
 {
@@ -44,11 +45,51 @@ private:
     void test_handle_exit_invalid();
     void test_handle_exit_monitor_trap_flag();
     void test_handle_exit_io_instruction();
+    void test_handle_exit_io_instruction_emulate_in();
+    void test_handle_exit_io_instruction_emulate_out();
+    void test_handle_exit_io_instruction_emulate_string();
+    void test_handle_exit_io_instruction_emulate_rep_string();
+    void test_handle_exit_io_instruction_emulate_rep_string_partial();
+    void test_handle_exit_io_instruction_emulate_rep_string_no_paging();
+    void test_handle_exit_io_instruction_io_port_handler();
+    void test_handle_exit_io_instruction_io_port_handler_unregistered();
+    void test_handle_exit_io_instruction_uart();
+    void test_handle_exit_io_instruction_uart_broadcast();
+    void test_register_io_port_handler();
+    void test_handle_exit_ept_violation();
+    void test_handle_exit_ept_violation_not_merged();
     void test_register_monitor_trap();
+    void test_register_monitor_trap_multiple();
+    void test_register_monitor_trap_rearm();
+    void test_register_monitor_trap_full();
+    void test_stepping_budget();
+    void test_stepping_predicate();
+    void test_stepping_with_monitor_trap_callbacks();
     void test_clear_monitor_trap_by_default();
     void test_log_io_access_enabled();
     void test_log_io_access_disabled();
     void test_clear_io_access_log();
+    void test_io_access_log();
+    void test_handle_exit_msr_handler();
+    void test_handle_exit_msr_handler_unregistered();
+    void test_register_exit_handler();
+    void test_register_msr_handler();
+    void test_register_msr_handler_range();
+    void test_msr_access_log();
+#if ENABLE_EXIT_STATS
+    void test_exit_stats();
+    void test_handle_exit_exit_stats();
+#endif
+    void test_trace_ring();
+    void test_trace_ring_overwrite();
+    void test_uart_16550();
+    void test_handle_exit_io_instruction_trace();
+    void test_handle_exit_trace();
+    void test_handle_exit_io_instruction_storm();
+    void test_broadcast();
+    void test_broadcast_base_exit();
+    void test_broadcast_invept();
+    void test_handle_vmcall_json_broadcast();
     void test_handle_vmcall_overrun_denials_buffer();
     void test_handle_vmcall_registers_unknown();
     void test_handle_vmcall_registers_io_instruction_unknown();
@@ -75,6 +116,14 @@ private:
     void test_handle_vmcall_json_io_instruction_pass_through_io_access_allowed();
     void test_handle_vmcall_json_io_instruction_pass_through_io_access_logged();
     void test_handle_vmcall_json_io_instruction_pass_through_io_access_denied();
+    void test_handle_vmcall_json_io_instruction_trap_on_io_range_invalid_range();
+    void test_handle_vmcall_json_io_instruction_trap_on_io_range_allowed();
+    void test_handle_vmcall_json_io_instruction_trap_on_io_range_logged();
+    void test_handle_vmcall_json_io_instruction_trap_on_io_range_denied();
+    void test_handle_vmcall_json_io_instruction_pass_through_io_range_invalid_range();
+    void test_handle_vmcall_json_io_instruction_pass_through_io_range_allowed();
+    void test_handle_vmcall_json_io_instruction_pass_through_io_range_logged();
+    void test_handle_vmcall_json_io_instruction_pass_through_io_range_denied();
     void test_handle_vmcall_json_io_instruction_whitelist_io_access_missing_ports();
     void test_handle_vmcall_json_io_instruction_whitelist_io_access_invalid_ports();
     void test_handle_vmcall_json_io_instruction_whitelist_io_access_allowed();
@@ -87,6 +136,9 @@ private:
     void test_handle_vmcall_json_io_instruction_blacklist_io_access_denied();
     void test_handle_vmcall_json_io_instruction_log_io_access_missing_enabled();
     void test_handle_vmcall_json_io_instruction_log_io_access_invalid_enabled();
+    void test_handle_vmcall_json_io_instruction_share_io_bitmaps_allowed();
+    void test_handle_vmcall_json_io_instruction_share_io_bitmaps_logged();
+    void test_handle_vmcall_json_io_instruction_share_io_bitmaps_denied();
     void test_handle_vmcall_json_io_instruction_log_io_access_allowed();
     void test_handle_vmcall_json_io_instruction_log_io_access_logged();
     void test_handle_vmcall_json_io_instruction_log_io_access_denied();
@@ -96,6 +148,26 @@ private:
     void test_handle_vmcall_json_io_instruction_io_access_log_allowed();
     void test_handle_vmcall_json_io_instruction_io_access_log_logged();
     void test_handle_vmcall_json_io_instruction_io_access_log_denied();
+    void test_handle_vmcall_json_io_instruction_trace_io_access_unaligned();
+    void test_handle_vmcall_json_io_instruction_trace_io_access_allowed();
+    void test_handle_vmcall_json_io_instruction_trace_io_access_logged();
+    void test_handle_vmcall_json_io_instruction_trace_io_access_denied();
+    void test_handle_vmcall_json_io_instruction_trace_io_access_unmapped();
+    void test_handle_vmcall_json_io_instruction_trace_io_access_read_only();
+    void test_handle_vmcall_json_io_instruction_trace_io_access_spp();
+    void test_handle_vmcall_json_io_instruction_trace_io_access_merged();
+    void test_handle_vmcall_json_io_instruction_io_storm_policy_allowed();
+    void test_handle_vmcall_json_io_instruction_io_storm_policy_logged();
+    void test_handle_vmcall_json_io_instruction_io_storm_policy_denied();
+    void test_handle_vmcall_json_io_instruction_io_storms_allowed();
+    void test_handle_vmcall_json_io_instruction_io_storms_logged();
+    void test_handle_vmcall_json_io_instruction_io_storms_denied();
+    void test_handle_vmcall_json_io_instruction_emulate_uart_allowed();
+    void test_handle_vmcall_json_io_instruction_emulate_uart_logged();
+    void test_handle_vmcall_json_io_instruction_emulate_uart_denied();
+    void test_handle_vmcall_json_io_instruction_uart_output_allowed();
+    void test_handle_vmcall_json_io_instruction_uart_output_logged();
+    void test_handle_vmcall_json_io_instruction_uart_output_denied();
     void test_handle_vmcall_registers_vpid_unknown();
     void test_handle_vmcall_registers_vpid_enable_vpid_allowed();
     void test_handle_vmcall_registers_vpid_enable_vpid_logged();
@@ -108,6 +180,64 @@ private:
     void test_handle_vmcall_json_vpid_enable_vpid_allowed();
     void test_handle_vmcall_json_vpid_enable_vpid_logged();
     void test_handle_vmcall_json_vpid_enable_vpid_denied();
+    void test_handle_vmcall_registers_msr_unknown();
+    void test_handle_vmcall_registers_msr_trap_on_rdmsr_access_allowed();
+    void test_handle_vmcall_registers_msr_trap_on_rdmsr_access_logged();
+    void test_handle_vmcall_registers_msr_trap_on_rdmsr_access_denied();
+    void test_handle_vmcall_registers_msr_trap_on_wrmsr_access_allowed();
+    void test_handle_vmcall_registers_msr_trap_on_wrmsr_access_logged();
+    void test_handle_vmcall_registers_msr_trap_on_wrmsr_access_denied();
+    void test_handle_vmcall_registers_msr_trap_on_all_rdmsr_accesses_allowed();
+    void test_handle_vmcall_registers_msr_trap_on_all_rdmsr_accesses_logged();
+    void test_handle_vmcall_registers_msr_trap_on_all_rdmsr_accesses_denied();
+    void test_handle_vmcall_registers_msr_trap_on_all_wrmsr_accesses_allowed();
+    void test_handle_vmcall_registers_msr_trap_on_all_wrmsr_accesses_logged();
+    void test_handle_vmcall_registers_msr_trap_on_all_wrmsr_accesses_denied();
+    void test_handle_vmcall_registers_msr_pass_through_rdmsr_access_allowed();
+    void test_handle_vmcall_registers_msr_pass_through_rdmsr_access_logged();
+    void test_handle_vmcall_registers_msr_pass_through_rdmsr_access_denied();
+    void test_handle_vmcall_registers_msr_pass_through_wrmsr_access_allowed();
+    void test_handle_vmcall_registers_msr_pass_through_wrmsr_access_logged();
+    void test_handle_vmcall_registers_msr_pass_through_wrmsr_access_denied();
+    void test_handle_vmcall_registers_msr_pass_through_all_rdmsr_accesses_allowed();
+    void test_handle_vmcall_registers_msr_pass_through_all_rdmsr_accesses_logged();
+    void test_handle_vmcall_registers_msr_pass_through_all_rdmsr_accesses_denied();
+    void test_handle_vmcall_registers_msr_pass_through_all_wrmsr_accesses_allowed();
+    void test_handle_vmcall_registers_msr_pass_through_all_wrmsr_accesses_logged();
+    void test_handle_vmcall_registers_msr_pass_through_all_wrmsr_accesses_denied();
+    void test_handle_vmcall_json_msr_trap_on_rdmsr_access_allowed();
+    void test_handle_vmcall_json_msr_trap_on_rdmsr_access_logged();
+    void test_handle_vmcall_json_msr_trap_on_rdmsr_access_denied();
+    void test_handle_vmcall_json_msr_trap_on_wrmsr_access_allowed();
+    void test_handle_vmcall_json_msr_trap_on_wrmsr_access_logged();
+    void test_handle_vmcall_json_msr_trap_on_wrmsr_access_denied();
+    void test_handle_vmcall_json_msr_pass_through_rdmsr_access_allowed();
+    void test_handle_vmcall_json_msr_pass_through_rdmsr_access_logged();
+    void test_handle_vmcall_json_msr_pass_through_rdmsr_access_denied();
+    void test_handle_vmcall_json_msr_pass_through_wrmsr_access_allowed();
+    void test_handle_vmcall_json_msr_pass_through_wrmsr_access_logged();
+    void test_handle_vmcall_json_msr_pass_through_wrmsr_access_denied();
+    void test_handle_vmcall_json_msr_whitelist_rdmsr_access_allowed();
+    void test_handle_vmcall_json_msr_whitelist_rdmsr_access_logged();
+    void test_handle_vmcall_json_msr_whitelist_rdmsr_access_denied();
+    void test_handle_vmcall_json_msr_whitelist_wrmsr_access_allowed();
+    void test_handle_vmcall_json_msr_whitelist_wrmsr_access_logged();
+    void test_handle_vmcall_json_msr_whitelist_wrmsr_access_denied();
+    void test_handle_vmcall_json_msr_blacklist_rdmsr_access_allowed();
+    void test_handle_vmcall_json_msr_blacklist_rdmsr_access_logged();
+    void test_handle_vmcall_json_msr_blacklist_rdmsr_access_denied();
+    void test_handle_vmcall_json_msr_blacklist_wrmsr_access_allowed();
+    void test_handle_vmcall_json_msr_blacklist_wrmsr_access_logged();
+    void test_handle_vmcall_json_msr_blacklist_wrmsr_access_denied();
+    void test_handle_vmcall_json_msr_log_msr_access_allowed();
+    void test_handle_vmcall_json_msr_log_msr_access_logged();
+    void test_handle_vmcall_json_msr_log_msr_access_denied();
+    void test_handle_vmcall_json_msr_clear_msr_access_log_allowed();
+    void test_handle_vmcall_json_msr_clear_msr_access_log_logged();
+    void test_handle_vmcall_json_msr_clear_msr_access_log_denied();
+    void test_handle_vmcall_json_msr_msr_access_log_allowed();
+    void test_handle_vmcall_json_msr_msr_access_log_logged();
+    void test_handle_vmcall_json_msr_msr_access_log_denied();
     void test_handle_vmcall_json_verifiers_clear_denials_allowed();
     void test_handle_vmcall_json_verifiers_clear_denials_logged();
     void test_handle_vmcall_json_verifiers_clear_denials_denied();
@@ -117,6 +247,31 @@ private:
     void test_handle_vmcall_json_verifiers_dump_denials_allowed();
     void test_handle_vmcall_json_verifiers_dump_denials_logged();
     void test_handle_vmcall_json_verifiers_dump_denials_denied();
+    void test_handle_vmcall_json_page_age_sample_page_ages_no_sampler();
+    void test_handle_vmcall_json_page_age_sample_page_ages_allowed();
+    void test_handle_vmcall_json_page_age_sample_page_ages_logged();
+    void test_handle_vmcall_json_page_age_sample_page_ages_denied();
+    void test_handle_vmcall_json_page_age_page_age_histogram_allowed();
+    void test_handle_vmcall_json_page_age_page_age_histogram_logged();
+    void test_handle_vmcall_json_page_age_page_age_histogram_denied();
+    void test_handle_vmcall_json_page_age_cold_ranges_missing_count();
+    void test_handle_vmcall_json_page_age_cold_ranges_allowed();
+    void test_handle_vmcall_json_page_age_cold_ranges_logged();
+    void test_handle_vmcall_json_page_age_cold_ranges_denied();
+#if ENABLE_EXIT_STATS
+    void test_handle_vmcall_json_exit_stats_exit_stats_allowed();
+    void test_handle_vmcall_json_exit_stats_exit_stats_logged();
+    void test_handle_vmcall_json_exit_stats_exit_stats_denied();
+    void test_handle_vmcall_json_exit_stats_clear_exit_stats_allowed();
+    void test_handle_vmcall_json_exit_stats_clear_exit_stats_logged();
+    void test_handle_vmcall_json_exit_stats_clear_exit_stats_denied();
+#endif
+    void test_handle_vmcall_json_exit_stats_trace_exits_unaligned();
+    void test_handle_vmcall_json_exit_stats_trace_exits_allowed();
+    void test_handle_vmcall_json_exit_stats_trace_exits_logged();
+    void test_handle_vmcall_json_exit_stats_trace_exits_denied();
+    void test_handle_vmcall_json_exit_stats_trace_exits_read_only();
+    void test_handle_vmcall_json_exit_stats_trace_exits_merged();
 
 };
 
@@ -26,11 +26,18 @@
 
 #include <vmcs/vmcs_intel_x64_32bit_read_only_data_fields.h>
 #include <vmcs/vmcs_intel_x64_natural_width_read_only_data_fields.h>
+#include <vmcs/vmcs_intel_x64_64bit_read_only_data_fields.h>
+#include <vmcs/vmcs_intel_x64_64bit_guest_state_fields.h>
+#include <vmcs/vmcs_intel_x64_natural_width_guest_state_fields.h>
+
+#include <intrinsics/rflags_x64.h>
 
 #include <vmcs/vmcs_intel_x64_eapis.h>
 #include <exit_handler/exit_handler_intel_x64_eapis.h>
 #include <exit_handler/exit_handler_intel_x64_eapis_vmcall_interface.h>
 
+#include <memory_manager/memory_manager_x64.h>
+
 using namespace x64;
 using namespace intel_x64;
 using namespace vmcs;
@@ -41,9 +48,20 @@ static std::map<intel_x64::vmcs::field_type, intel_x64::vmcs::value_type> g_vmcs
 uintptr_t g_rip = 0;
 state_save_intel_x64 g_state_save{};
 auto g_monitor_trap_callback_called = false;
+auto g_monitor_trap_callback_count = 0UL;
+auto g_exit_handler_count = 0UL;
 
 bool g_enable_vpid = false;
+std::map<vmcs_intel_x64_eapis *, vmcs_intel_x64_eapis::entry_delegate_type> g_entry_delegates;
 exit_handler_intel_x64_eapis::port_type g_port = 0;
+exit_handler_intel_x64_eapis::msr_type g_msr = 0;
+
+uint16_t g_io_port = 0;
+uint32_t g_io_value = 0;
+std::vector<uint8_t> g_io_buffer;
+
+std::mutex g_ept_mutex;
+constexpr exit_handler_intel_x64_eapis::integer_pointer g_guest_page = 0x0000000000042000UL;
 
 extern bool g_deny_all;
 extern bool g_log_denials;
@@ -78,11 +96,90 @@ extern "C" void
 __invvipd(uint64_t type, void *ptr) noexcept
 { (void) type; (void) ptr; }
 
+extern "C" uint8_t
+__inb(uint16_t port) noexcept
+{ g_io_port = port; return 0x42; }
+
+extern "C" uint16_t
+__inw(uint16_t port) noexcept
+{ g_io_port = port; return 0x4242; }
+
+extern "C" uint32_t
+__ind(uint16_t port) noexcept
+{ g_io_port = port; return 0x42424242; }
+
+extern "C" void
+__outb(uint16_t port, uint8_t val) noexcept
+{ g_io_port = port; g_io_value = val; }
+
+extern "C" void
+__outw(uint16_t port, uint16_t val) noexcept
+{ g_io_port = port; g_io_value = val; }
+
+extern "C" void
+__outd(uint16_t port, uint32_t val) noexcept
+{ g_io_port = port; g_io_value = val; }
+
 class exit_handler_ut : public exit_handler_intel_x64_eapis
 {
 public:
     void monitor_trap_callback()
     { g_monitor_trap_callback_called = true; }
+
+    void counting_monitor_trap_callback()
+    { g_monitor_trap_callback_count++; }
+
+    void counting_exit_handler()
+    { g_exit_handler_count++; }
+
+    void rearming_monitor_trap_callback()
+    {
+        g_monitor_trap_callback_count++;
+        this->register_monitor_trap(&exit_handler_ut::rearming_monitor_trap_callback);
+    }
+
+    // The guest's buffer is identity mapped onto g_io_buffer, and any page
+    // past the end of g_io_buffer cannot be accessed.
+
+    integer_pointer io_string_gla_to_hpa(integer_pointer gla, bool write) override
+    {
+        (void) write;
+
+        if (gla >= g_io_buffer.size())
+            throw std::runtime_error("buffer not mapped");
+
+        return gla;
+    }
+
+    gsl::span<uint8_t> map_io_string_buffer(integer_pointer hpa, std::size_t size) override
+    { return gsl::span<uint8_t>(&g_io_buffer[hpa], gsl::narrow_cast<std::ptrdiff_t>(size)); }
+};
+
+class io_port_handler_ut : public io_port_handler_intel_x64
+{
+public:
+    value_type read(port_type port, size_type size) override
+    { m_port = port; m_size = size; return 0xABCDEF12; }
+
+    void write(port_type port, size_type size, value_type value) override
+    { m_port = port; m_size = size; m_value = value; }
+
+    port_type m_port = 0;
+    size_type m_size = 0;
+    value_type m_value = 0;
+};
+
+class msr_handler_ut : public msr_handler_intel_x64
+{
+public:
+    value_type read(msr_type msr) override
+    { m_msr = msr; return 0x1122334455667788UL; }
+
+    void write(msr_type msr, value_type value) override
+    { m_msr = msr; m_value = value; }
+
+    msr_type m_msr = 0;
+    value_type m_value = 0;
 };
 
 auto
@@ -91,7 +188,8 @@ setup_vmcs(MockRepository &mocks, vmcs::value_type reason)
     auto vmcs = mocks.Mock<vmcs_intel_x64_eapis>();
 
     mocks.OnCall(vmcs, vmcs_intel_x64_eapis::launch);
-    mocks.OnCall(vmcs, vmcs_intel_x64_eapis::resume);
+    mocks.OnCall(vmcs, vmcs_intel_x64_eapis::resume).Do([vmcs] { if (g_entry_delegates[vmcs]) g_entry_delegates[vmcs](); });
+    mocks.OnCall(vmcs, vmcs_intel_x64_eapis::set_entry_delegate).Do([vmcs](auto delegate) { g_entry_delegates[vmcs] = delegate; });
     mocks.OnCall(vmcs, vmcs_intel_x64_eapis::promote);
     mocks.OnCall(vmcs, vmcs_intel_x64_eapis::load);
     mocks.OnCall(vmcs, vmcs_intel_x64_eapis::clear);
@@ -102,8 +200,23 @@ setup_vmcs(MockRepository &mocks, vmcs::value_type reason)
     mocks.OnCall(vmcs, vmcs_intel_x64_eapis::trap_on_all_io_accesses).Do([&]() { g_port = 42; });
     mocks.OnCall(vmcs, vmcs_intel_x64_eapis::pass_through_io_access).Do([&](auto port) { g_port = port; });
     mocks.OnCall(vmcs, vmcs_intel_x64_eapis::pass_through_all_io_accesses).Do([&]() { g_port = 42; });
+    mocks.OnCall(vmcs, vmcs_intel_x64_eapis::trap_on_io_range).Do([&](auto first, auto last) { (void) first; g_port = last; });
+    mocks.OnCall(vmcs, vmcs_intel_x64_eapis::pass_through_io_range).Do([&](auto first, auto last) { (void) first; g_port = last; });
+    mocks.OnCall(vmcs, vmcs_intel_x64_eapis::share_io_bitmaps);
     mocks.OnCall(vmcs, vmcs_intel_x64_eapis::whitelist_io_access).Do([&](auto ports) { g_port = ports[0]; });
     mocks.OnCall(vmcs, vmcs_intel_x64_eapis::blacklist_io_access).Do([&](auto ports) { g_port = ports[0]; });
+    mocks.OnCall(vmcs, vmcs_intel_x64_eapis::trap_on_rdmsr_access).Do([&](auto msr) { g_msr = msr; });
+    mocks.OnCall(vmcs, vmcs_intel_x64_eapis::trap_on_wrmsr_access).Do([&](auto msr) { g_msr = msr; });
+    mocks.OnCall(vmcs, vmcs_intel_x64_eapis::trap_on_all_rdmsr_accesses).Do([&]() { g_msr = 42; });
+    mocks.OnCall(vmcs, vmcs_intel_x64_eapis::trap_on_all_wrmsr_accesses).Do([&]() { g_msr = 42; });
+    mocks.OnCall(vmcs, vmcs_intel_x64_eapis::pass_through_rdmsr_access).Do([&](auto msr) { g_msr = msr; });
+    mocks.OnCall(vmcs, vmcs_intel_x64_eapis::pass_through_wrmsr_access).Do([&](auto msr) { g_msr = msr; });
+    mocks.OnCall(vmcs, vmcs_intel_x64_eapis::pass_through_all_rdmsr_accesses).Do([&]() { g_msr = 42; });
+    mocks.OnCall(vmcs, vmcs_intel_x64_eapis::pass_through_all_wrmsr_accesses).Do([&]() { g_msr = 42; });
+    mocks.OnCall(vmcs, vmcs_intel_x64_eapis::whitelist_rdmsr_access).Do([&](auto msrs) { g_msr = msrs[0]; });
+    mocks.OnCall(vmcs, vmcs_intel_x64_eapis::whitelist_wrmsr_access).Do([&](auto msrs) { g_msr = msrs[0]; });
+    mocks.OnCall(vmcs, vmcs_intel_x64_eapis::blacklist_rdmsr_access).Do([&](auto msrs) { g_msr = msrs[0]; });
+    mocks.OnCall(vmcs, vmcs_intel_x64_eapis::blacklist_wrmsr_access).Do([&](auto msrs) { g_msr = msrs[0]; });
 
     g_msrs[intel_x64::msrs::ia32_vmx_procbased_ctls2::addr] = 0xFFFFFFFF00000000UL;
     g_msrs[intel_x64::msrs::ia32_vmx_true_pinbased_ctls::addr] = 0xFFFFFFFF00000000UL;
@@ -111,6 +224,8 @@ setup_vmcs(MockRepository &mocks, vmcs::value_type reason)
     g_msrs[intel_x64::msrs::ia32_vmx_true_exit_ctls::addr] = 0xFFFFFFFF00000000UL;
     g_msrs[intel_x64::msrs::ia32_vmx_true_entry_ctls::addr] = 0xFFFFFFFF00000000UL;
 
+    g_entry_delegates[vmcs] = nullptr;
+
     g_vmcs[vmcs::exit_reason::addr] = reason;
     g_vmcs[vmcs::exit_qualification::addr] = 0;
     g_vmcs[vmcs::vm_exit_instruction_length::addr] = 8;
@@ -130,6 +245,45 @@ setup_ehlr(gsl::not_null<vmcs_intel_x64_eapis *> vmcs)
     return std::move(ehlr);
 }
 
+// The EPT of the mocked VMCS is a real extended page table, so that the
+// guest pages handed to the VMM by the vmcalls can be resolved.
+
+static void
+setup_long_mode()
+{
+    g_vmcs[vmcs::guest_cr0::addr] = 0x0000000080000001UL;
+    g_vmcs[vmcs::guest_cr4::addr] = 0x0000000000000020UL;
+    g_vmcs[vmcs::guest_ia32_efer::addr] = 0x0000000000000500UL;
+}
+
+static auto
+setup_ept(MockRepository &mocks, gsl::not_null<vmcs_intel_x64_eapis *> vmcs)
+{
+    auto mm = mocks.Mock<memory_manager_x64>();
+    mocks.OnCallFunc(memory_manager_x64::instance).Return(mm);
+    mocks.OnCall(mm, memory_manager_x64::virtptr_to_physint).Return(0x0000000000042000UL);
+
+    auto &&ept = std::make_unique<ept_intel_x64>();
+    auto &&eptp = ept.get();
+
+    mocks.OnCall(vmcs.get(), vmcs_intel_x64_eapis::eptp_mutex).Do([]() -> std::mutex & { return g_ept_mutex; });
+    mocks.OnCall(vmcs.get(), vmcs_intel_x64_eapis::eptp).Do([eptp]() -> gsl::not_null<ept_intel_x64 *> { return eptp; });
+
+    return std::move(ept);
+}
+
+static auto
+setup_guest_page(gsl::not_null<ept_intel_x64 *> ept, bool write)
+{
+    auto &&epte = ept->add_page_4k(g_guest_page);
+
+    epte->set_phys_addr(0x00000000ABCDE000UL);
+    epte->set_read_access(true);
+    epte->set_write_access(write);
+
+    return epte;
+}
+
 void
 eapis_ut::test_resume()
 {
@@ -198,278 +352,4496 @@ eapis_ut::test_handle_exit_io_instruction()
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
         this->expect_no_exception([&] { ehlr->dispatch(); });
-        this->expect_true(ehlr->m_io_access_log[42] == 1);
+        this->expect_true(ehlr->m_io_access_log.count(42) == 1);
     });
 }
 
 void
-eapis_ut::test_register_monitor_trap()
+eapis_ut::test_handle_exit_io_instruction_emulate_in()
 {
     MockRepository mocks;
-    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::monitor_trap_flag);
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::io_instruction);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    ehlr->register_monitor_trap(&exit_handler_ut::monitor_trap_callback);
-    ehlr->dispatch();
-    ehlr->clear_monitor_trap();
+    using namespace exit_qualification::io_instruction;
+    auto &&in = direction_of_access::in << direction_of_access::from;
+    auto &&port = 0x3F8UL << port_number::from;
+
+    ehlr->emulate_io_access(true);
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_true(g_monitor_trap_callback_called);
-        this->expect_exception([&]{ ehlr->dispatch(); }, ""_ut_lee);
+        primary_processor_based_vm_execution_controls::monitor_trap_flag::disable();
+
+        g_state_save.rax = 0xFFFFFFFFFFFFFFFFUL;
+        g_vmcs[vmcs::exit_qualification::addr] = port | in | size_of_access::one_byte;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(g_io_port == 0x3F8);
+        this->expect_true(g_state_save.rax == 0xFFFFFFFFFFFFFF42UL);
+        this->expect_true(primary_processor_based_vm_execution_controls::monitor_trap_flag::is_disabled());
+
+        g_state_save.rax = 0xFFFFFFFFFFFFFFFFUL;
+        g_vmcs[vmcs::exit_qualification::addr] = port | in | size_of_access::two_byte;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(g_state_save.rax == 0xFFFFFFFFFFFF4242UL);
+
+        g_state_save.rax = 0xFFFFFFFFFFFFFFFFUL;
+        g_vmcs[vmcs::exit_qualification::addr] = port | in | size_of_access::four_byte;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(g_state_save.rax == 0x0000000042424242UL);
     });
 }
 
 void
-eapis_ut::test_clear_monitor_trap_by_default()
+eapis_ut::test_handle_exit_io_instruction_emulate_out()
 {
     MockRepository mocks;
-    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::monitor_trap_flag);
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::io_instruction);
     auto &&ehlr = setup_ehlr(vmcs);
 
+    using namespace exit_qualification::io_instruction;
+    auto &&out = direction_of_access::out << direction_of_access::from;
+    auto &&port = 0x3F8UL << port_number::from;
+
+    ehlr->emulate_io_access(true);
+    g_state_save.rax = 0x1122334455667788UL;
+
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_exception([&]{ ehlr->dispatch(); }, ""_ut_lee);
+        auto rip = g_state_save.rip;
+        g_vmcs[vmcs::exit_qualification::addr] = port | out | size_of_access::one_byte;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(g_io_port == 0x3F8);
+        this->expect_true(g_io_value == 0x88);
+        this->expect_true(g_state_save.rip == rip + 8);
+
+        g_vmcs[vmcs::exit_qualification::addr] = port | out | size_of_access::two_byte;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(g_io_value == 0x7788);
+
+        g_vmcs[vmcs::exit_qualification::addr] = port | out | size_of_access::four_byte;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(g_io_value == 0x55667788);
+        this->expect_true(g_state_save.rax == 0x1122334455667788UL);
     });
 }
 
 void
-eapis_ut::test_log_io_access_enabled()
+eapis_ut::test_handle_exit_io_instruction_emulate_string()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::io_instruction);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    ehlr->log_io_access(true);
-    g_vmcs[vmcs::exit_qualification::addr] = 42 << exit_qualification::io_instruction::port_number::from;
+    using namespace exit_qualification::io_instruction;
+    auto &&string = string_instruction::string << string_instruction::from;
+
+    ehlr->emulate_io_access(true);
+    g_vmcs[vmcs::exit_qualification::addr] = (0x3F8UL << port_number::from) | string;
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        g_vmcs[primary_processor_based_vm_execution_controls::addr] = 0xFFFFFFFFFFFFFFFF;
+        auto rip = g_state_save.rip;
 
-        ehlr->dispatch();
-        this->expect_true(ehlr->m_io_access_log[42] == 1);
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(g_state_save.rip == rip);
+        this->expect_true(primary_processor_based_vm_execution_controls::monitor_trap_flag::is_enabled());
         this->expect_true(primary_processor_based_vm_execution_controls::use_io_bitmaps::is_disabled());
-
-        g_vmcs[vmcs::exit_reason::addr] = exit_reason::basic_exit_reason::monitor_trap_flag;
-        ehlr->dispatch();
-        this->expect_true(primary_processor_based_vm_execution_controls::use_io_bitmaps::is_enabled());
     });
 }
 
 void
-eapis_ut::test_log_io_access_disabled()
+eapis_ut::test_handle_exit_io_instruction_emulate_rep_string()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::io_instruction);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    ehlr->log_io_access(false);
-    g_vmcs[vmcs::exit_qualification::addr] = 42 << exit_qualification::io_instruction::port_number::from;
+    using namespace exit_qualification::io_instruction;
+    auto &&in = direction_of_access::in << direction_of_access::from;
+    auto &&out = direction_of_access::out << direction_of_access::from;
+    auto &&string = string_instruction::string << string_instruction::from;
+    auto &&rep = rep_prefixed::rep << rep_prefixed::from;
+    auto &&port = 0x3F8UL << port_number::from;
+
+    ehlr->emulate_io_access(true);
+    setup_long_mode();
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        g_vmcs[primary_processor_based_vm_execution_controls::addr] = 0xFFFFFFFFFFFFFFFF;
+        primary_processor_based_vm_execution_controls::monitor_trap_flag::disable();
 
-        ehlr->dispatch();
-        this->expect_true(ehlr->m_io_access_log[42] == 0);
-        this->expect_true(primary_processor_based_vm_execution_controls::use_io_bitmaps::is_disabled());
+        // rep outsw (64bit address size)
 
-        g_vmcs[vmcs::exit_reason::addr] = exit_reason::basic_exit_reason::monitor_trap_flag;
-        ehlr->dispatch();
-        this->expect_true(primary_processor_based_vm_execution_controls::use_io_bitmaps::is_enabled());
+        auto rip = g_state_save.rip;
+        g_io_buffer = {1, 2, 3, 4, 5, 6, 7, 8};
+        g_state_save.rcx = 4;
+        g_state_save.rsi = 0x1000;
+        g_vmcs[vmcs::vm_exit_instruction_information::addr] = 2UL << 7;
+        g_vmcs[vmcs::exit_qualification::addr] = port | out | string | rep | size_of_access::two_byte;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(g_io_port == 0x3F8);
+        this->expect_true(g_io_value == 0x0807);
+        this->expect_true(g_state_save.rcx == 0);
+        this->expect_true(g_state_save.rsi == 0x1008);
+        this->expect_true(g_state_save.rip == rip + 8);
+        this->expect_true(primary_processor_based_vm_execution_controls::monitor_trap_flag::is_disabled());
+
+        // rep insw (32bit address size, which zero extends RCX / RDI)
+
+        g_state_save.rcx = 0xFFFFFFFF00000002UL;
+        g_state_save.rdi = 0xFFFFFFFF00000010UL;
+        g_vmcs[vmcs::vm_exit_instruction_information::addr] = 1UL << 7;
+        g_vmcs[vmcs::exit_qualification::addr] = port | in | string | rep | size_of_access::two_byte;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(g_io_buffer[0] == 0x42 && g_io_buffer[3] == 0x42 && g_io_buffer[4] == 5);
+        this->expect_true(g_state_save.rcx == 0);
+        this->expect_true(g_state_save.rdi == 0x14);
+
+        // rep outsb that does not fit in a single VM exit
+
+        rip = g_state_save.rip;
+        g_io_buffer.resize(IO_STRING_EMULATION_MAX_BYTES);
+        g_state_save.rcx = IO_STRING_EMULATION_MAX_BYTES + 1;
+        g_state_save.rsi = 0;
+        g_vmcs[vmcs::vm_exit_instruction_information::addr] = 2UL << 7;
+        g_vmcs[vmcs::exit_qualification::addr] = port | out | string | rep | size_of_access::one_byte;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(g_state_save.rcx == 1);
+        this->expect_true(g_state_save.rsi == IO_STRING_EMULATION_MAX_BYTES);
+        this->expect_true(g_state_save.rip == rip);
+
+        // the direction flag is not emulated
+
+        g_vmcs[vmcs::guest_rflags::addr] = rflags::direction_flag::mask;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(g_state_save.rcx == 1);
+        this->expect_true(primary_processor_based_vm_execution_controls::monitor_trap_flag::is_enabled());
+
+        g_io_buffer.clear();
+        g_vmcs[vmcs::guest_rflags::addr] = 0;
+        g_vmcs[vmcs::vm_exit_instruction_information::addr] = 0;
+        primary_processor_based_vm_execution_controls::monitor_trap_flag::disable();
     });
 }
 
 void
-eapis_ut::test_clear_io_access_log()
+eapis_ut::test_handle_exit_io_instruction_emulate_rep_string_partial()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::io_instruction);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    ehlr->log_io_access(true);
-    g_vmcs[vmcs::exit_qualification::addr] = 42 << exit_qualification::io_instruction::port_number::from;
+    using namespace exit_qualification::io_instruction;
+    auto &&in = direction_of_access::in << direction_of_access::from;
+    auto &&string = string_instruction::string << string_instruction::from;
+    auto &&rep = rep_prefixed::rep << rep_prefixed::from;
+    auto &&port = 0x3F8UL << port_number::from;
+
+    ehlr->emulate_io_access(true);
+    setup_long_mode();
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        ehlr->dispatch();
-        this->expect_true(ehlr->m_io_access_log[42] == 1);
-        ehlr->clear_io_access_log();
-        this->expect_true(ehlr->m_io_access_log[42] == 0);
+        primary_processor_based_vm_execution_controls::monitor_trap_flag::disable();
+
+        // rep insw into a buffer that runs into a page that cannot be
+        // accessed, which stops the transfer in front of that page
+
+        auto rip = g_state_save.rip;
+        g_io_buffer.assign(x64::page_size, 0);
+        g_state_save.rcx = 8;
+        g_state_save.rdi = x64::page_size - 4;
+        g_vmcs[vmcs::guest_linear_address::addr] = x64::page_size - 4;
+        g_vmcs[vmcs::vm_exit_instruction_information::addr] = 2UL << 7;
+        g_vmcs[vmcs::exit_qualification::addr] = port | in | string | rep | size_of_access::two_byte;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(g_io_buffer[x64::page_size - 4] == 0x42 && g_io_buffer[x64::page_size - 1] == 0x42);
+        this->expect_true(g_state_save.rcx == 6);
+        this->expect_true(g_state_save.rdi == x64::page_size);
+        this->expect_true(g_state_save.rip == rip);
+        this->expect_true(primary_processor_based_vm_execution_controls::monitor_trap_flag::is_disabled());
+
+        // the next element is in the page that cannot be accessed, which
+        // the guest has to access itself
+
+        g_vmcs[vmcs::guest_linear_address::addr] = x64::page_size;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(g_state_save.rcx == 6);
+        this->expect_true(primary_processor_based_vm_execution_controls::monitor_trap_flag::is_enabled());
+
+        g_io_buffer.clear();
+        g_vmcs[vmcs::guest_linear_address::addr] = 0;
+        g_vmcs[vmcs::vm_exit_instruction_information::addr] = 0;
+        primary_processor_based_vm_execution_controls::monitor_trap_flag::disable();
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_overrun_denials_buffer()
+eapis_ut::test_handle_exit_io_instruction_emulate_rep_string_no_paging()
 {
     MockRepository mocks;
-    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::io_instruction);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson = {{"set", "vpid"}, {"enabled", false}};
-    json ojson = {};
+    using namespace exit_qualification::io_instruction;
+    auto &&out = direction_of_access::out << direction_of_access::from;
+    auto &&string = string_instruction::string << string_instruction::from;
+    auto &&rep = rep_prefixed::rep << rep_prefixed::from;
+    auto &&port = 0x3F8UL << port_number::from;
 
-    g_deny_all = false;
-    g_log_denials = true;
+    ehlr->emulate_io_access(true);
+    setup_long_mode();
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        for (auto i = 0; i < DENIAL_LOG_SIZE + 10; i++)
-            this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        g_io_buffer = {1, 2, 3, 4};
+        g_state_save.rcx = 4;
+        g_vmcs[vmcs::exit_qualification::addr] = port | out | string | rep | size_of_access::one_byte;
 
-        this->expect_true(ehlr->m_denials.size() == DENIAL_LOG_SIZE);
+        // 32bit paging (without PAE) is left to the guest
+
+        primary_processor_based_vm_execution_controls::monitor_trap_flag::disable();
+        g_vmcs[vmcs::guest_cr4::addr] = 0;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(g_state_save.rcx == 4);
+        this->expect_true(primary_processor_based_vm_execution_controls::monitor_trap_flag::is_enabled());
+
+        // so is a guest that has paging disabled
+
+        primary_processor_based_vm_execution_controls::monitor_trap_flag::disable();
+        setup_long_mode();
+        g_vmcs[vmcs::guest_cr0::addr] = 0;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(g_state_save.rcx == 4);
+        this->expect_true(primary_processor_based_vm_execution_controls::monitor_trap_flag::is_enabled());
+
+        g_io_buffer.clear();
+        primary_processor_based_vm_execution_controls::monitor_trap_flag::disable();
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_registers_unknown()
+eapis_ut::test_register_io_port_handler()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
-
-    vmcall_registers_t regs = {};
-    regs.r02 = 0xDEADBEEF;
+    auto &&handler = std::make_unique<io_port_handler_ut>();
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
+        this->expect_exception([&] { ehlr->register_io_port_handler(0x3FF, 0x3F8, handler.get()); }, ""_ut_ffe);
+        this->expect_exception([&] { ehlr->unregister_io_port_handler(0x3FF, 0x3F8); }, ""_ut_ffe);
+
+        this->expect_no_exception([&] { ehlr->register_io_port_handler(0x3F8, 0x3FF, handler.get()); });
+        this->expect_true(g_port == 0x3FF);
+        this->expect_true(ehlr->io_port_handler(0x3F7) == nullptr);
+        this->expect_true(ehlr->io_port_handler(0x3F8) == handler.get());
+        this->expect_true(ehlr->io_port_handler(0x3FF) == handler.get());
+        this->expect_true(ehlr->io_port_handler(0x400) == nullptr);
+
+        this->expect_no_exception([&] { ehlr->register_io_port_handler(0xFFFF, 0xFFFF, handler.get()); });
+        this->expect_true(ehlr->io_port_handler(0xFFFF) == handler.get());
+
+        this->expect_no_exception([&] { ehlr->unregister_io_port_handler(0x3F8, 0x3FB); });
+        this->expect_true(ehlr->io_port_handler(0x3F8) == nullptr);
+        this->expect_true(ehlr->io_port_handler(0x3FB) == nullptr);
+        this->expect_true(ehlr->io_port_handler(0x3FC) == handler.get());
+
+        this->expect_no_exception([&] { ehlr->unregister_io_port_handler(0x1000, 0x1001); });
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_registers_io_instruction_unknown()
+eapis_ut::test_handle_exit_io_instruction_io_port_handler()
 {
     MockRepository mocks;
-    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::io_instruction);
     auto &&ehlr = setup_ehlr(vmcs);
+    auto &&handler = std::make_unique<io_port_handler_ut>();
 
-    vmcall_registers_t regs = {};
-    regs.r02 = eapis_cat__io_instruction;
-    regs.r03 = 0xDEADBEEF;
+    using namespace exit_qualification::io_instruction;
+    auto &&in = direction_of_access::in << direction_of_access::from;
+    auto &&out = direction_of_access::out << direction_of_access::from;
+    auto &&port = 0x3F8UL << port_number::from;
+
+    ehlr->register_io_port_handler(0x3F8, 0x3FF, handler.get());
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
+        auto rip = g_state_save.rip;
+
+        g_io_port = 0;
+        g_state_save.rax = 0xFFFFFFFFFFFFFFFFUL;
+        g_vmcs[vmcs::exit_qualification::addr] = port | in | size_of_access::one_byte;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(handler->m_port == 0x3F8);
+        this->expect_true(handler->m_size == 1);
+        this->expect_true(g_state_save.rax == 0xFFFFFFFFFFFFFF12UL);
+        this->expect_true(g_state_save.rip == rip + 8);
+        this->expect_true(g_io_port == 0);
+
+        g_vmcs[vmcs::exit_qualification::addr] = port | in | size_of_access::four_byte;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(handler->m_size == 4);
+        this->expect_true(g_state_save.rax == 0x00000000ABCDEF12UL);
+
+        g_state_save.rax = 0x1122334455667788UL;
+        g_vmcs[vmcs::exit_qualification::addr] = port | out | size_of_access::two_byte;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(handler->m_size == 2);
+        this->expect_true(handler->m_value == 0x7788);
+        this->expect_true(g_io_port == 0);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_registers_io_instruction_trap_on_io_access_allowed()
+eapis_ut::test_handle_exit_io_instruction_io_port_handler_unregistered()
 {
     MockRepository mocks;
-    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::io_instruction);
     auto &&ehlr = setup_ehlr(vmcs);
+    auto &&handler = std::make_unique<io_port_handler_ut>();
 
-    vmcall_registers_t regs = {};
-    regs.r02 = eapis_cat__io_instruction;
-    regs.r03 = eapis_fun__trap_on_io_access;
-    regs.r04 = 42;
+    using namespace exit_qualification::io_instruction;
+    auto &&out = direction_of_access::out << direction_of_access::from;
 
-    g_port = 0;
-    g_deny_all = false;
-    g_log_denials = false;
+    ehlr->register_io_port_handler(0x3F8, 0x3FF, handler.get());
+    ehlr->unregister_io_port_handler(0x3F8, 0x3FF);
 
-    ehlr->clear_denials();
+    g_vmcs[vmcs::exit_qualification::addr] = (0x3F8UL << port_number::from) | out;
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
-        this->expect_true(g_port == 42);
-        this->expect_true(ehlr->m_denials.empty());
+        auto rip = g_state_save.rip;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(handler->m_port == 0);
+        this->expect_true(g_state_save.rip == rip);
+        this->expect_true(primary_processor_based_vm_execution_controls::monitor_trap_flag::is_enabled());
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_registers_io_instruction_trap_on_io_access_logged()
+eapis_ut::test_handle_exit_io_instruction_uart()
 {
     MockRepository mocks;
-    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::io_instruction);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    vmcall_registers_t regs = {};
-    regs.r02 = eapis_cat__io_instruction;
-    regs.r03 = eapis_fun__trap_on_io_access;
-    regs.r04 = 42;
-
-    g_port = 0;
-    g_deny_all = false;
-    g_log_denials = true;
+    using namespace exit_qualification::io_instruction;
+    auto &&in = direction_of_access::in << direction_of_access::from;
+    auto &&out = direction_of_access::out << direction_of_access::from;
 
-    ehlr->clear_denials();
+    ehlr->emulate_uart(true);
+    exit_handler_intel_x64_eapis::uart().drain();
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
-        this->expect_true(g_port == 42);
-        this->expect_true(ehlr->m_denials.size() == 1);
+        auto rip = g_state_save.rip;
+
+        g_io_port = 0;
+        g_state_save.rax = 0;
+        g_vmcs[vmcs::exit_qualification::addr] = (0x3FDUL << port_number::from) | in | size_of_access::one_byte;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(g_state_save.rax == 0x60);
+        this->expect_true(g_state_save.rip == rip + 8);
+
+        g_state_save.rax = 'A';
+        g_vmcs[vmcs::exit_qualification::addr] = (0x3F8UL << port_number::from) | out | size_of_access::one_byte;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(g_io_port == 0);
+        this->expect_true(exit_handler_intel_x64_eapis::uart().drain() == "A");
+
+        ehlr->emulate_uart(false);
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(exit_handler_intel_x64_eapis::uart().drain().empty());
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_registers_io_instruction_trap_on_io_access_denied()
+eapis_ut::test_handle_exit_io_instruction_uart_broadcast()
 {
     MockRepository mocks;
-    auto &&vmcs = setup_vmcs(mocks, 0x0);
-    auto &&ehlr = setup_ehlr(vmcs);
+    auto &&vmcs1 = setup_vmcs(mocks, exit_reason::basic_exit_reason::io_instruction);
+    auto &&vmcs2 = setup_vmcs(mocks, exit_reason::basic_exit_reason::io_instruction);
+    auto &&ehlr1 = setup_ehlr(vmcs1);
+    auto &&ehlr2 = setup_ehlr(vmcs2);
 
-    vmcall_registers_t regs = {};
-    regs.r02 = eapis_cat__io_instruction;
-    regs.r03 = eapis_fun__trap_on_io_access;
-    regs.r04 = 42;
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        ehlr1->emulate_uart(true);
+        this->expect_true(ehlr1->io_port_handler(0x3F8) == &exit_handler_intel_x64_eapis::uart());
+        this->expect_true(ehlr2->io_port_handler(0x3F8) == nullptr);
 
-    g_port = 0;
-    g_deny_all = true;
-    g_log_denials = false;
+        ehlr2->resume();
+        this->expect_true(ehlr2->io_port_handler(0x3F8) == &exit_handler_intel_x64_eapis::uart());
 
-    ehlr->clear_denials();
+        // Disabling the emulation on one vCPU disables it on every vCPU,
+        // so that no vCPU is left with a handler for an untrapped port.
 
-    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
-    {
-        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
-        this->expect_true(g_port == 0);
-        this->expect_true(ehlr->m_denials.empty());
+        g_port = 0;
+        ehlr2->emulate_uart(false);
+        this->expect_true(g_port == 0x3FF);
+        this->expect_true(ehlr2->io_port_handler(0x3F8) == nullptr);
+        this->expect_true(ehlr1->io_port_handler(0x3F8) != nullptr);
+
+        ehlr1->resume();
+        this->expect_true(ehlr1->io_port_handler(0x3F8) == nullptr);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_registers_io_instruction_trap_on_all_io_accesses_allowed()
+eapis_ut::test_handle_exit_ept_violation()
 {
     MockRepository mocks;
-    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::ept_violation);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    vmcall_registers_t regs = {};
-    regs.r02 = eapis_cat__io_instruction;
-    regs.r03 = eapis_fun__trap_on_all_io_accesses;
-
-    g_port = 0;
-    g_deny_all = false;
-    g_log_denials = false;
-
-    ehlr->clear_denials();
+    g_vmcs[vmcs::guest_physical_address::addr] = 0x1000;
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
-        this->expect_true(g_port == 42);
-        this->expect_true(ehlr->m_denials.empty());
+        this->expect_no_exception([&] { ehlr->dispatch(); });
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_registers_io_instruction_trap_on_all_io_accesses_logged()
+eapis_ut::test_handle_exit_ept_violation_not_merged()
 {
     MockRepository mocks;
-    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::ept_violation);
     auto &&ehlr = setup_ehlr(vmcs);
+    auto &&merger = std::make_unique<page_merger_intel_x64>(vmcs);
 
-    vmcall_registers_t regs = {};
+    ehlr->set_page_merger(merger.get());
+    g_vmcs[vmcs::guest_physical_address::addr] = 0x1000;
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(merger->merged_pages() == 0);
+    });
+}
+
+void
+eapis_ut::test_register_monitor_trap()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::monitor_trap_flag);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    ehlr->register_monitor_trap(&exit_handler_ut::monitor_trap_callback);
+    ehlr->dispatch();
+    ehlr->clear_monitor_trap();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_true(g_monitor_trap_callback_called);
+        this->expect_exception([&]{ ehlr->dispatch(); }, ""_ut_lee);
+    });
+}
+
+void
+eapis_ut::test_register_monitor_trap_multiple()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::monitor_trap_flag);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    g_monitor_trap_callback_called = false;
+    g_monitor_trap_callback_count = 0;
+
+    ehlr->register_monitor_trap(&exit_handler_ut::monitor_trap_callback);
+    ehlr->register_monitor_trap(&exit_handler_ut::counting_monitor_trap_callback);
+    ehlr->register_monitor_trap(&exit_handler_ut::counting_monitor_trap_callback);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_true(ehlr->m_monitor_trap_callback_count == 2);
+        this->expect_true(primary_processor_based_vm_execution_controls::monitor_trap_flag::is_enabled());
+
+        ehlr->dispatch();
+        this->expect_true(g_monitor_trap_callback_called);
+        this->expect_true(g_monitor_trap_callback_count == 1);
+        this->expect_true(ehlr->m_monitor_trap_callback_count == 0);
+        this->expect_true(primary_processor_based_vm_execution_controls::monitor_trap_flag::is_disabled());
+    });
+}
+
+void
+eapis_ut::test_register_monitor_trap_rearm()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::monitor_trap_flag);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    g_monitor_trap_callback_count = 0;
+    ehlr->register_monitor_trap(&exit_handler_ut::rearming_monitor_trap_callback);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        ehlr->dispatch();
+        ehlr->dispatch();
+
+        this->expect_true(g_monitor_trap_callback_count == 2);
+        this->expect_true(ehlr->m_monitor_trap_callback_count == 1);
+        this->expect_true(primary_processor_based_vm_execution_controls::monitor_trap_flag::is_enabled());
+    });
+}
+
+void
+eapis_ut::test_register_monitor_trap_full()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::monitor_trap_flag);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    for (auto &callback : ehlr->m_monitor_trap_callbacks)
+        callback = static_cast<exit_handler_intel_x64_eapis::monitor_trap_callback>(&exit_handler_ut::counting_monitor_trap_callback);
+
+    ehlr->m_monitor_trap_callback_count = ehlr->m_monitor_trap_callbacks.size();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->register_monitor_trap(&exit_handler_ut::counting_monitor_trap_callback); });
+        this->expect_exception([&]{ ehlr->register_monitor_trap(&exit_handler_ut::monitor_trap_callback); }, ""_ut_ree);
+    });
+}
+
+void
+eapis_ut::test_stepping_budget()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::monitor_trap_flag);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    auto &&buffer = std::vector<uint8_t>(sizeof(step_trace_intel_x64::header_type) + (4 * sizeof(step_trace_record_intel_x64)));
+    auto &&ring = std::make_unique<step_trace_intel_x64>(gsl::span<uint8_t>(buffer));
+
+    ehlr->start_stepping(gsl::span<uint8_t>(buffer), 2);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_true(ehlr->is_stepping());
+        this->expect_true(primary_processor_based_vm_execution_controls::monitor_trap_flag::is_enabled());
+
+        g_state_save.rip = 0x1000;
+        ehlr->dispatch();
+        this->expect_true(ehlr->is_stepping());
+        this->expect_true(primary_processor_based_vm_execution_controls::monitor_trap_flag::is_enabled());
+
+        g_state_save.rip = 0x1004;
+        ehlr->dispatch();
+        this->expect_false(ehlr->is_stepping());
+        this->expect_true(ehlr->step_count() == 2);
+        this->expect_true(primary_processor_based_vm_execution_controls::monitor_trap_flag::is_disabled());
+
+        step_trace_record_intel_x64 record = {};
+
+        this->expect_true(ring->pop(record));
+        this->expect_true(record.step == 1);
+        this->expect_true(record.rip == 0x1000);
+        this->expect_true(ring->pop(record));
+        this->expect_true(record.step == 2);
+        this->expect_true(record.rip == 0x1004);
+        this->expect_false(ring->pop(record));
+    });
+}
+
+void
+eapis_ut::test_stepping_predicate()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::monitor_trap_flag);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    auto &&buffer = std::vector<uint8_t>(sizeof(step_trace_intel_x64::header_type) + sizeof(step_trace_record_intel_x64));
+    auto &&ring = std::make_unique<step_trace_intel_x64>(gsl::span<uint8_t>(buffer));
+
+    ehlr->start_stepping(gsl::span<uint8_t>(buffer), 100, [](auto rip) { return rip == 0x2000; });
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_state_save.rip = 0x1000;
+        ehlr->dispatch();
+        ehlr->dispatch();
+        this->expect_true(ehlr->is_stepping());
+        this->expect_true(ring->dropped() == 1);
+
+        g_state_save.rip = 0x2000;
+        ehlr->dispatch();
+        this->expect_false(ehlr->is_stepping());
+        this->expect_true(ehlr->step_count() == 3);
+    });
+}
+
+void
+eapis_ut::test_stepping_with_monitor_trap_callbacks()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::monitor_trap_flag);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    auto &&buffer = std::vector<uint8_t>(sizeof(step_trace_intel_x64::header_type) + sizeof(step_trace_record_intel_x64));
+
+    g_monitor_trap_callback_count = 0;
+
+    ehlr->start_stepping(gsl::span<uint8_t>(buffer), 2);
+    ehlr->register_monitor_trap(&exit_handler_ut::counting_monitor_trap_callback);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->start_stepping(gsl::span<uint8_t>(buffer), 0); }, ""_ut_ffe);
+
+        ehlr->clear_monitor_trap();
+        this->expect_true(primary_processor_based_vm_execution_controls::monitor_trap_flag::is_enabled());
+
+        ehlr->register_monitor_trap(&exit_handler_ut::counting_monitor_trap_callback);
+        ehlr->dispatch();
+        this->expect_true(g_monitor_trap_callback_count == 1);
+        this->expect_true(primary_processor_based_vm_execution_controls::monitor_trap_flag::is_enabled());
+
+        ehlr->stop_stepping();
+        this->expect_true(primary_processor_based_vm_execution_controls::monitor_trap_flag::is_disabled());
+        this->expect_exception([&]{ ehlr->dispatch(); }, ""_ut_lee);
+    });
+}
+
+void
+eapis_ut::test_clear_monitor_trap_by_default()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::monitor_trap_flag);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->dispatch(); }, ""_ut_lee);
+    });
+}
+
+void
+eapis_ut::test_log_io_access_enabled()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::io_instruction);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    ehlr->log_io_access(true);
+    g_vmcs[vmcs::exit_qualification::addr] = 42 << exit_qualification::io_instruction::port_number::from;
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_vmcs[primary_processor_based_vm_execution_controls::addr] = 0xFFFFFFFFFFFFFFFF;
+
+        ehlr->dispatch();
+        this->expect_true(ehlr->m_io_access_log.count(42) == 1);
+        this->expect_true(primary_processor_based_vm_execution_controls::use_io_bitmaps::is_disabled());
+
+        g_vmcs[vmcs::exit_reason::addr] = exit_reason::basic_exit_reason::monitor_trap_flag;
+        ehlr->dispatch();
+        this->expect_true(primary_processor_based_vm_execution_controls::use_io_bitmaps::is_enabled());
+    });
+}
+
+void
+eapis_ut::test_log_io_access_disabled()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::io_instruction);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    ehlr->log_io_access(false);
+    g_vmcs[vmcs::exit_qualification::addr] = 42 << exit_qualification::io_instruction::port_number::from;
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_vmcs[primary_processor_based_vm_execution_controls::addr] = 0xFFFFFFFFFFFFFFFF;
+
+        ehlr->dispatch();
+        this->expect_true(ehlr->m_io_access_log.count(42) == 0);
+        this->expect_true(primary_processor_based_vm_execution_controls::use_io_bitmaps::is_disabled());
+
+        g_vmcs[vmcs::exit_reason::addr] = exit_reason::basic_exit_reason::monitor_trap_flag;
+        ehlr->dispatch();
+        this->expect_true(primary_processor_based_vm_execution_controls::use_io_bitmaps::is_enabled());
+    });
+}
+
+void
+eapis_ut::test_clear_io_access_log()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::io_instruction);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    ehlr->log_io_access(true);
+    g_vmcs[vmcs::exit_qualification::addr] = 42 << exit_qualification::io_instruction::port_number::from;
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        ehlr->dispatch();
+        this->expect_true(ehlr->m_io_access_log.count(42) == 1);
+        ehlr->clear_io_access_log();
+        this->expect_true(ehlr->m_io_access_log.count(42) == 0);
+    });
+}
+
+void
+eapis_ut::test_io_access_log()
+{
+    auto &&log1 = std::make_unique<io_access_log_intel_x64>();
+    auto &&log2 = std::make_unique<io_access_log_intel_x64>();
+
+    this->expect_false(log1->is_enabled());
+    this->expect_true(log1->m_counters == nullptr);
+
+    log1->log(42);
+    this->expect_true(log1->count(42) == 0);
+    this->expect_true(log1->snapshot().empty());
+
+    log1->enable(true);
+    log2->enable(true);
+
+    log1->log(42);
+    log1->log(42);
+    log1->log(0xFFFF);
+    log2->log(42);
+    log2->log(7);
+
+    this->expect_true(log1->count(42) == 2);
+    this->expect_true(log1->count(0xFFFF) == 1);
+    this->expect_true(log1->snapshot().size() == 2);
+
+    auto &&aggregate = io_access_log_intel_x64::aggregate();
+    this->expect_true(aggregate.size() == 3);
+    this->expect_true(aggregate[7] == 1);
+    this->expect_true(aggregate[42] == 3);
+    this->expect_true(aggregate[0xFFFF] == 1);
+
+    log1->enable(false);
+    log1->log(42);
+    this->expect_true(log1->count(42) == 2);
+
+    log1->clear();
+    this->expect_true(log1->count(42) == 0);
+    this->expect_true(io_access_log_intel_x64::aggregate().size() == 2);
+
+    log2.reset();
+    this->expect_true(io_access_log_intel_x64::aggregate().empty());
+
+    log1->enable(true);
+    log1->log(42);
+    io_access_log_intel_x64::clear_all();
+    this->expect_true(io_access_log_intel_x64::aggregate().empty());
+}
+
+void
+eapis_ut::test_handle_exit_msr_handler()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::rdmsr);
+    auto &&ehlr = setup_ehlr(vmcs);
+    auto &&handler = std::make_unique<msr_handler_ut>();
+
+    ehlr->register_msr_handler(0x6E0, 0x6E0, handler.get());
+    ehlr->register_msr_handler(0x800, 0x8FF, handler.get());
+    ehlr->register_msr_handler(0x40000000, 0x40000001, handler.get());
+
+    this->expect_true(g_msr == 0x40000001);
+    this->expect_true(ehlr->msr_handler(0x6E0) == handler.get());
+    this->expect_true(ehlr->msr_handler(0x6E1) == nullptr);
+    this->expect_true(ehlr->msr_handler(0xC0000080) == nullptr);
+    this->expect_true(ehlr->msr_handler(0x40000002) == nullptr);
+
+    ehlr->log_msr_access(true);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        auto rip = g_state_save.rip;
+
+        g_state_save.rcx = 0x6E0;
+        g_state_save.rax = 0xFFFFFFFFFFFFFFFFUL;
+        g_state_save.rdx = 0xFFFFFFFFFFFFFFFFUL;
+        g_vmcs[vmcs::exit_reason::addr] = exit_reason::basic_exit_reason::rdmsr;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(handler->m_msr == 0x6E0);
+        this->expect_true(g_state_save.rax == 0x55667788UL);
+        this->expect_true(g_state_save.rdx == 0x11223344UL);
+        this->expect_true(g_state_save.rip == rip + 8);
+
+        g_state_save.rcx = 0x808;
+        g_state_save.rax = 0xFFFFFFFFAABBCCDDUL;
+        g_state_save.rdx = 0xFFFFFFFF00000001UL;
+        g_vmcs[vmcs::exit_reason::addr] = exit_reason::basic_exit_reason::wrmsr;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(handler->m_msr == 0x808);
+        this->expect_true(handler->m_value == 0x00000001AABBCCDDUL);
+
+        g_state_save.rcx = 0x40000001;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(handler->m_msr == 0x40000001);
+
+        this->expect_true(ehlr->m_msr_access_log.count(0x6E0) == 1);
+        this->expect_true(ehlr->m_msr_access_log.count(0x808) == 1);
+        this->expect_true(ehlr->m_msr_access_log.count(0x40000001) == 1);
+    });
+}
+
+void
+eapis_ut::test_handle_exit_msr_handler_unregistered()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::rdmsr);
+    auto &&ehlr = setup_ehlr(vmcs);
+    auto &&handler = std::make_unique<msr_handler_ut>();
+
+    ehlr->register_msr_handler(0x48, 0x48, handler.get());
+    ehlr->register_msr_handler(0x40000000, 0x40000000, handler.get());
+    ehlr->unregister_msr_handler(0x48, 0x48);
+    ehlr->unregister_msr_handler(0x40000000, 0x40000000);
+
+    this->expect_true(ehlr->msr_handler(0x48) == nullptr);
+    this->expect_true(ehlr->msr_handler(0x40000000) == nullptr);
+
+    g_msrs[0x48] = 0x0000000200000001UL;
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_state_save.rcx = 0x48;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(handler->m_msr == 0);
+        this->expect_true(g_state_save.rax == 0x1);
+        this->expect_true(g_state_save.rdx == 0x2);
+    });
+}
+
+void
+eapis_ut::test_register_exit_handler()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::rdmsr);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    g_exit_handler_count = 0;
+    g_msrs[0x48] = 0x0000000200000001UL;
+
+    ehlr->register_exit_handler(exit_reason::basic_exit_reason::rdmsr, &exit_handler_ut::counting_exit_handler);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_state_save.rax = 0;
+        g_state_save.rdx = 0;
+        g_state_save.rcx = 0x48;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(g_exit_handler_count == 1);
+        this->expect_true(g_state_save.rax == 0);
+
+        ehlr->unregister_exit_handler(exit_reason::basic_exit_reason::rdmsr);
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(g_exit_handler_count == 1);
+        this->expect_true(g_state_save.rax == 0x1);
+        this->expect_true(g_state_save.rdx == 0x2);
+
+        this->expect_exception([&] { ehlr->register_exit_handler(exit_handler_ut::max_exit_reasons, &exit_handler_ut::counting_exit_handler); }, ""_ut_ffe);
+        this->expect_exception([&] { ehlr->unregister_exit_handler(exit_handler_ut::max_exit_reasons); }, ""_ut_ffe);
+    });
+}
+
+void
+eapis_ut::test_register_msr_handler()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+    auto &&handler = std::make_unique<msr_handler_ut>();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&] { ehlr->register_msr_handler(0x1, 0x0, handler.get()); }, ""_ut_ffe);
+        this->expect_exception([&] { ehlr->unregister_msr_handler(0x1, 0x0); }, ""_ut_ffe);
+
+        this->expect_exception([&] { ehlr->register_msr_handler(0xC0001FFF, 0xC0002000, handler.get()); }, ""_ut_ffe);
+        this->expect_exception([&] { ehlr->register_msr_handler(0x1FFF, 0x2000, handler.get()); }, ""_ut_ffe);
+        this->expect_exception([&] { ehlr->register_msr_handler(0x0, 0xFFFFFFFF, handler.get()); }, ""_ut_ffe);
+        this->expect_exception([&] { ehlr->unregister_msr_handler(0x0, 0xFFFFFFFF); }, ""_ut_ffe);
+
+        this->expect_no_exception([&] { ehlr->register_msr_handler(0xC0001FFF, 0xC0001FFF, handler.get()); });
+        this->expect_no_exception([&] { ehlr->register_msr_handler(0xC0002000, 0xC0002000, handler.get()); });
+        this->expect_true(ehlr->msr_handler(0xC0001FFF) == handler.get());
+        this->expect_true(ehlr->msr_handler(0xC0002000) == handler.get());
+        this->expect_true(ehlr->msr_handler(0xC0001FFE) == nullptr);
+
+        this->expect_no_exception([&] { ehlr->register_msr_handler(0xFFFFFFFF, 0xFFFFFFFF, handler.get()); });
+        this->expect_true(ehlr->msr_handler(0xFFFFFFFF) == handler.get());
+    });
+}
+
+void
+eapis_ut::test_register_msr_handler_range()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+    auto &&handler1 = std::make_unique<msr_handler_ut>();
+    auto &&handler2 = std::make_unique<msr_handler_ut>();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&] { ehlr->register_msr_handler(0x40000000, 0x400000FF, handler1.get()); });
+        this->expect_true(ehlr->m_msr_handlers_other.size() == 1);
+        this->expect_true(ehlr->msr_handler(0x3FFFFFFF) == nullptr);
+        this->expect_true(ehlr->msr_handler(0x40000000) == handler1.get());
+        this->expect_true(ehlr->msr_handler(0x400000FF) == handler1.get());
+        this->expect_true(ehlr->msr_handler(0x40000100) == nullptr);
+
+        // Registering / unregistering part of a range splits it
+
+        this->expect_no_exception([&] { ehlr->register_msr_handler(0x40000010, 0x4000001F, handler2.get()); });
+        this->expect_true(ehlr->m_msr_handlers_other.size() == 3);
+        this->expect_true(ehlr->msr_handler(0x4000000F) == handler1.get());
+        this->expect_true(ehlr->msr_handler(0x40000010) == handler2.get());
+        this->expect_true(ehlr->msr_handler(0x4000001F) == handler2.get());
+        this->expect_true(ehlr->msr_handler(0x40000020) == handler1.get());
+
+        this->expect_no_exception([&] { ehlr->unregister_msr_handler(0x40000000, 0x40000017); });
+        this->expect_true(ehlr->m_msr_handlers_other.size() == 2);
+        this->expect_true(ehlr->msr_handler(0x40000000) == nullptr);
+        this->expect_true(ehlr->msr_handler(0x40000017) == nullptr);
+        this->expect_true(ehlr->msr_handler(0x40000018) == handler2.get());
+        this->expect_true(ehlr->msr_handler(0x40000020) == handler1.get());
+
+        this->expect_no_exception([&] { ehlr->unregister_msr_handler(0x40000000, 0x7FFFFFFF); });
+        this->expect_true(ehlr->m_msr_handlers_other.empty());
+    });
+}
+
+void
+eapis_ut::test_msr_access_log()
+{
+    auto &&log1 = std::make_unique<msr_access_log_intel_x64>();
+    auto &&log2 = std::make_unique<msr_access_log_intel_x64>();
+
+    this->expect_false(log1->is_enabled());
+    this->expect_true(log1->m_counters == nullptr);
+
+    log1->log(0x10);
+    this->expect_true(log1->count(0x10) == 0);
+    this->expect_true(log1->snapshot().empty());
+
+    log1->enable(true);
+    log2->enable(true);
+
+    log1->log(0x10);
+    log1->log(0x10);
+    log1->log(0xC0000080);
+    log1->log(0x40000000);
+    log2->log(0x10);
+    log2->log(0x40000001);
+
+    this->expect_true(log1->count(0x10) == 2);
+    this->expect_true(log1->count(0xC0000080) == 1);
+    this->expect_true(log1->count(0x40000000) == 1);
+    this->expect_true(log1->snapshot().size() == 3);
+
+    auto &&aggregate = msr_access_log_intel_x64::aggregate();
+    this->expect_true(aggregate.size() == 3);
+    this->expect_true(aggregate[0x10] == 3);
+    this->expect_true(aggregate[0xC0000080] == 1);
+    this->expect_true(aggregate[msr_access_log_intel_x64::other_msrs] == 2);
+
+    log1->enable(false);
+    log1->log(0x10);
+    this->expect_true(log1->count(0x10) == 2);
+
+    log1->clear();
+    this->expect_true(log1->count(0x10) == 0);
+    this->expect_true(msr_access_log_intel_x64::aggregate().size() == 2);
+
+    log2.reset();
+    this->expect_true(msr_access_log_intel_x64::aggregate().empty());
+
+    log1->enable(true);
+    log1->log(0x10);
+    msr_access_log_intel_x64::clear_all();
+    this->expect_true(msr_access_log_intel_x64::aggregate().empty());
+}
+
+#if ENABLE_EXIT_STATS
+
+void
+eapis_ut::test_exit_stats()
+{
+    auto &&stats1 = std::make_unique<exit_stats_intel_x64>();
+    auto &&stats2 = std::make_unique<exit_stats_intel_x64>();
+
+    this->expect_true(exit_stats_intel_x64::bucket(0) == 0);
+    this->expect_true(exit_stats_intel_x64::bucket(1) == 1);
+    this->expect_true(exit_stats_intel_x64::bucket(3) == 2);
+    this->expect_true(exit_stats_intel_x64::bucket(4) == 3);
+    this->expect_true(exit_stats_intel_x64::bucket(0xFFFFFFFFFFFFFFFF) == exit_stats_intel_x64::num_buckets - 1);
+
+    this->expect_true(stats1->snapshot().empty());
+
+    stats1->record(0x20, 100);
+    stats1->record(0x20, 120);
+    stats1->record(0x1C, 1000);
+    stats1->record(exit_stats_intel_x64::max_exit_reasons, 42);
+    stats2->record(0x20, 3);
+
+    this->expect_true(stats1->stats(0x20).count == 2);
+    this->expect_true(stats1->stats(0x20).ticks == 220);
+    this->expect_true(stats1->stats(0x20).histogram[7] == 2);
+    this->expect_true(stats1->stats(exit_stats_intel_x64::max_exit_reasons).count == 0);
+    this->expect_true(stats1->snapshot().size() == 2);
+
+    auto &&aggregate = exit_stats_intel_x64::aggregate();
+    this->expect_true(aggregate.size() == 2);
+    this->expect_true(aggregate[0x20].count == 3);
+    this->expect_true(aggregate[0x20].ticks == 223);
+    this->expect_true(aggregate[0x20].histogram[2] == 1);
+    this->expect_true(aggregate[0x1C].histogram[10] == 1);
+
+    stats1->clear();
+    this->expect_true(stats1->stats(0x20).count == 0);
+    this->expect_true(exit_stats_intel_x64::aggregate().size() == 1);
+
+    exit_stats_intel_x64::clear_all();
+    this->expect_true(exit_stats_intel_x64::aggregate().empty());
+}
+
+void
+eapis_ut::test_handle_exit_exit_stats()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::rdmsr);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    ehlr->m_exit_stats.clear();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_state_save.rcx = 0x48;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(ehlr->m_exit_tsc == 0);
+        this->expect_true(ehlr->m_exit_stats.stats(exit_reason::basic_exit_reason::rdmsr).count == 1);
+
+        // CPUID is handled (and the guest resumed) by the base exit
+        // handler, which never returns on real hardware, so the VM exit
+        // has to be recorded on VM entry.
+
+        g_vmcs[vmcs::exit_reason::addr] = exit_reason::basic_exit_reason::cpuid;
+        g_state_save.rax = 0;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(ehlr->m_exit_tsc == 0);
+        this->expect_true(ehlr->m_exit_stats.stats(exit_reason::basic_exit_reason::cpuid).count == 1);
+
+        ehlr->begin_exit(exit_reason::basic_exit_reason::cpuid);
+        vmcs->resume();
+
+        this->expect_true(ehlr->m_exit_tsc == 0);
+        this->expect_true(ehlr->m_exit_stats.stats(exit_reason::basic_exit_reason::cpuid).count == 2);
+    });
+}
+
+#endif
+
+void
+eapis_ut::test_trace_ring()
+{
+    auto &&buffer = std::vector<uint8_t>(sizeof(io_trace_intel_x64::header_type) + (2 * sizeof(io_trace_record_intel_x64)));
+    auto &&ring = std::make_unique<io_trace_intel_x64>(gsl::span<uint8_t>(buffer));
+
+    auto &&header = reinterpret_cast<io_trace_intel_x64::header_type *>(buffer.data());
+    this->expect_true(header->magic == io_trace_intel_x64::trace_ring_magic);
+    this->expect_true(header->record_size == sizeof(io_trace_record_intel_x64));
+    this->expect_true(header->capacity == 2);
+
+    io_trace_record_intel_x64 record = {};
+    this->expect_false(ring->pop(record));
+
+    record.port = 1;
+    this->expect_true(ring->push(record));
+    record.port = 2;
+    this->expect_true(ring->push(record));
+    record.port = 3;
+    this->expect_false(ring->push(record));
+
+    this->expect_true(ring->size() == 2);
+    this->expect_true(ring->dropped() == 1);
+
+    this->expect_true(ring->pop(record));
+    this->expect_true(record.port == 1);
+
+    record.port = 4;
+    this->expect_true(ring->push(record));
+
+    this->expect_true(ring->pop(record));
+    this->expect_true(record.port == 2);
+    this->expect_true(ring->pop(record));
+    this->expect_true(record.port == 4);
+    this->expect_false(ring->pop(record));
+
+    auto &&small = std::vector<uint8_t>(sizeof(io_trace_intel_x64::header_type));
+    this->expect_exception([&] { std::make_unique<io_trace_intel_x64>(gsl::span<uint8_t>(small)); }, ""_ut_ffe);
+}
+
+void
+eapis_ut::test_trace_ring_overwrite()
+{
+    auto &&buffer = std::vector<uint8_t>(sizeof(io_trace_intel_x64::header_type) + (3 * sizeof(io_trace_record_intel_x64)));
+    auto &&ring = std::make_unique<io_trace_intel_x64>(gsl::span<uint8_t>(buffer), true);
+
+    auto &&header = reinterpret_cast<io_trace_intel_x64::header_type *>(buffer.data());
+    this->expect_true(header->overwrite == 1);
+    this->expect_true(header->capacity == 3);
+
+    io_trace_record_intel_x64 record = {};
+
+    for (auto port = 1; port <= 5; port++)
+    {
+        record.port = gsl::narrow_cast<uint16_t>(port);
+        this->expect_true(ring->push(record));
+    }
+
+    this->expect_true(ring->size() == 2);
+    this->expect_true(ring->dropped() == 0);
+    this->expect_true(ring->overwritten() == 3);
+
+    this->expect_true(ring->pop(record));
+    this->expect_true(record.port == 4);
+    this->expect_true(ring->pop(record));
+    this->expect_true(record.port == 5);
+    this->expect_false(ring->pop(record));
+
+    auto &&small = std::vector<uint8_t>(sizeof(io_trace_intel_x64::header_type) + sizeof(io_trace_record_intel_x64));
+    this->expect_exception([&] { std::make_unique<io_trace_intel_x64>(gsl::span<uint8_t>(small), true); }, ""_ut_ffe);
+}
+
+void
+eapis_ut::test_uart_16550()
+{
+    auto &&uart = std::make_unique<uart_16550_intel_x64>(0x2F8, 4);
+
+    this->expect_exception([&] { std::make_unique<uart_16550_intel_x64>(0x2F8, 0); }, ""_ut_ffe);
+
+    // The transmit holding register is always empty, and the receiver is
+    // never ready.
+
+    this->expect_true(uart->read(0x2FD, 1) == 0x60);
+    this->expect_true(uart->read(0x2FA, 1) == 0x01);
+
+    for (auto c : std::string("hello"))
+        uart->write(0x2F8, 1, static_cast<uint8_t>(c));
+
+    this->expect_true(uart->dropped() == 1);
+    this->expect_true(uart->drain() == "ello");
+    this->expect_true(uart->drain().empty());
+
+    // Divisor latch
+
+    uart->write(0x2FB, 1, 0x80);
+    uart->write(0x2F8, 1, 0x01);
+    uart->write(0x2F9, 1, 0x02);
+    this->expect_true(uart->read(0x2F8, 1) == 0x01);
+    this->expect_true(uart->read(0x2F9, 1) == 0x02);
+    this->expect_true(uart->drain().empty());
+
+    uart->write(0x2FB, 1, 0x03);
+    uart->write(0x2F9, 1, 0x02);
+    this->expect_true(uart->read(0x2F9, 1) == 0x02);
+    this->expect_true(uart->read(0x2FA, 1) == 0x02);
+
+    uart->write(0x2FA, 1, 0x01);
+    this->expect_true(uart->read(0x2FA, 1) == 0xC2);
+
+    // Loopback (used by drivers to detect the UART)
+
+    this->expect_true(uart->read(0x2FE, 1) == 0xB0);
+    uart->write(0x2FC, 1, 0x1F);
+    this->expect_true(uart->read(0x2FE, 1) == 0xF0);
+
+    uart->write(0x2F8, 1, 'x');
+    this->expect_true(uart->drain().empty());
+
+    uart->write(0x2FF, 1, 0x42);
+    this->expect_true(uart->read(0x2FF, 1) == 0x42);
+}
+
+void
+eapis_ut::test_handle_exit_trace()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::rdmsr);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    auto &&buffer = std::vector<uint8_t>(sizeof(exit_trace_intel_x64::header_type) + (3 * sizeof(exit_trace_record_intel_x64)));
+    auto &&ring = std::make_unique<exit_trace_intel_x64>(gsl::span<uint8_t>(buffer), true);
+
+    ehlr->trace_exits(gsl::span<uint8_t>(buffer), true);
+    g_msrs[0x48] = 0x0000000200000001UL;
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        exit_trace_record_intel_x64 record = {};
+
+        auto rip = g_state_save.rip;
+        g_state_save.rcx = 0x48;
+        g_vmcs[vmcs::exit_qualification::addr] = 0x42;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(ring->pop(record));
+        this->expect_true(record.reason == exit_reason::basic_exit_reason::rdmsr);
+        this->expect_true(record.qualification == 0x42);
+        this->expect_true(record.rip == rip);
+        this->expect_true(record.tsc != 0);
+        this->expect_false(ring->pop(record));
+
+        // CPUID is handled (and the guest resumed) by the base exit
+        // handler, so its record is pushed on VM entry.
+
+        g_vmcs[vmcs::exit_reason::addr] = exit_reason::basic_exit_reason::cpuid;
+        g_state_save.rax = 0;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(ring->pop(record));
+        this->expect_true(record.reason == exit_reason::basic_exit_reason::cpuid);
+        this->expect_false(ring->pop(record));
+
+        ehlr->begin_exit(exit_reason::basic_exit_reason::cpuid);
+        vmcs->resume();
+
+        this->expect_true(ring->pop(record));
+        this->expect_true(record.reason == exit_reason::basic_exit_reason::cpuid);
+        this->expect_false(ring->pop(record));
+
+        g_vmcs[vmcs::exit_reason::addr] = exit_reason::basic_exit_reason::rdmsr;
+        g_state_save.rcx = 0x48;
+
+        for (auto i = 0; i < 5; i++)
+            ehlr->dispatch();
+
+        this->expect_true(ring->overwritten() == 3);
+        this->expect_true(ring->pop(record));
+        this->expect_true(ring->pop(record));
+        this->expect_false(ring->pop(record));
+
+        ehlr->trace_exits({});
+        ehlr->dispatch();
+
+        this->expect_false(ring->pop(record));
+    });
+}
+
+void
+eapis_ut::test_handle_exit_io_instruction_trace()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::io_instruction);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    using namespace exit_qualification::io_instruction;
+    auto &&in = direction_of_access::in << direction_of_access::from;
+    auto &&out = direction_of_access::out << direction_of_access::from;
+    auto &&port = 0x3F8UL << port_number::from;
+
+    auto &&buffer = std::vector<uint8_t>(x64::page_size);
+    auto &&ring = std::make_unique<io_trace_intel_x64>(gsl::span<uint8_t>(buffer));
+
+    ehlr->trace_io_access(gsl::span<uint8_t>(buffer));
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        io_trace_record_intel_x64 record = {};
+        primary_processor_based_vm_execution_controls::monitor_trap_flag::disable();
+
+        ehlr->emulate_io_access(true);
+
+        auto rip = g_state_save.rip;
+        g_state_save.rax = 0xFFFFFFFFFFFFFFFFUL;
+        g_vmcs[vmcs::exit_qualification::addr] = port | in | size_of_access::two_byte;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(ring->pop(record));
+        this->expect_true(record.rip == rip);
+        this->expect_true(record.port == 0x3F8);
+        this->expect_true(record.size == 2);
+        this->expect_true(record.direction == 1);
+        this->expect_true(record.value == 0x4242);
+
+        g_state_save.rax = 0x1122334455667788UL;
+        g_vmcs[vmcs::exit_qualification::addr] = port | out | size_of_access::one_byte;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(ring->pop(record));
+        this->expect_true(record.direction == 0);
+        this->expect_true(record.value == 0x88);
+
+        // Without emulation, an IN is only traced once the guest has
+        // executed it (i.e. on the monitor trap flag exit).
+
+        ehlr->emulate_io_access(false);
+
+        g_state_save.rax = 0;
+        g_vmcs[vmcs::exit_qualification::addr] = port | in | size_of_access::four_byte;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_false(ring->pop(record));
+
+        g_state_save.rax = 0x12345678;
+        g_vmcs[vmcs::exit_reason::addr] = exit_reason::basic_exit_reason::monitor_trap_flag;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(ring->pop(record));
+        this->expect_true(record.size == 4);
+        this->expect_true(record.value == 0x12345678);
+
+        ehlr->trace_io_access({});
+        g_vmcs[vmcs::exit_reason::addr] = exit_reason::basic_exit_reason::io_instruction;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(ring->size() == 0);
+    });
+}
+
+void
+eapis_ut::test_handle_exit_io_instruction_storm()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::io_instruction);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    using namespace exit_qualification::io_instruction;
+    auto &&out = direction_of_access::out << direction_of_access::from;
+    auto &&port = 0x3F8UL << port_number::from;
+
+    io_storm_policy_intel_x64 policy;
+    policy.threshold = 3;
+    policy.window = ~0UL;
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        ehlr->set_io_storm_policy(policy);
+        g_vmcs[vmcs::exit_qualification::addr] = port | out | size_of_access::one_byte;
+
+        g_port = 0;
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(g_port == 0);
+        this->expect_true(ehlr->io_storm_ports().empty());
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(g_port == 0x3F8);
+        this->expect_true(ehlr->io_storm_ports() == exit_handler_intel_x64_eapis::port_list_type({0x3F8}));
+
+        // Once the rearm period has elapsed, the next VM exit traps the
+        // port again.
+
+        policy.threshold = 1;
+        policy.rearm = 1;
+        ehlr->set_io_storm_policy(policy);
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(ehlr->io_storm_ports().size() == 1);
+
+        g_port = 0;
+        g_vmcs[vmcs::exit_reason::addr] = exit_reason::basic_exit_reason::monitor_trap_flag;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(g_port == 0x3F8);
+        this->expect_true(ehlr->io_storm_ports().empty());
+
+        // A port whose policy is changed by the user is no longer owned by
+        // the storm logic, and is therefore never trapped again by it.
+
+        g_vmcs[vmcs::exit_reason::addr] = exit_reason::basic_exit_reason::io_instruction;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(ehlr->io_storm_ports().size() == 1);
+
+        this->expect_no_exception([&] { ehlr->handle_vmcall__pass_through_io_access(0x3F8); });
+        this->expect_true(ehlr->io_storm_ports().empty());
+
+        g_port = 0;
+        g_vmcs[vmcs::exit_reason::addr] = exit_reason::basic_exit_reason::monitor_trap_flag;
+
+        this->expect_no_exception([&] { ehlr->dispatch(); });
+        this->expect_true(g_port == 0);
+
+        g_vmcs[vmcs::exit_reason::addr] = exit_reason::basic_exit_reason::io_instruction;
+    });
+}
+
+void
+eapis_ut::test_broadcast()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr1 = setup_ehlr(vmcs);
+    auto &&ehlr2 = setup_ehlr(vmcs);
+
+    auto updates = 0;
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_true(ehlr1->broadcast([&](auto) { updates++; }) == 2);
+        this->expect_true(updates == 1);
+        this->expect_true(ehlr2->m_vmcs_updates.size() == 1);
+        this->expect_true(ehlr1->m_vmcs_updates.empty());
+
+        ehlr2->resume();
+        this->expect_true(updates == 2);
+        this->expect_true(ehlr2->m_vmcs_updates.empty());
+
+        ehlr2->advance_and_resume();
+        this->expect_true(updates == 2);
+
+        ehlr2.reset();
+        this->expect_no_exception([&] { ehlr1->broadcast([&](auto) { updates++; }); });
+        this->expect_true(updates == 3);
+    });
+}
+
+void
+eapis_ut::test_broadcast_base_exit()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, exit_reason::basic_exit_reason::cpuid);
+    auto &&ehlr1 = setup_ehlr(vmcs);
+    auto &&ehlr2 = setup_ehlr(vmcs);
+
+    auto updates = 0;
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        ehlr1->broadcast([&](auto) { updates++; });
+        this->expect_true(ehlr2->m_vmcs_updates.size() == 1);
+
+        // CPUID is handled (and the guest resumed) by the base exit
+        // handler, which never calls the EAPIs version of resume().
+
+        g_state_save.rax = 0;
+
+        this->expect_no_exception([&] { ehlr2->dispatch(); });
+        this->expect_true(updates == 2);
+        this->expect_true(ehlr2->m_vmcs_updates.empty());
+    });
+}
+
+void
+eapis_ut::test_broadcast_invept()
+{
+    MockRepository mocks;
+    auto &&vmcs1 = setup_vmcs(mocks, 0x0);
+    auto &&vmcs2 = setup_vmcs(mocks, 0x0);
+    auto &&ehlr1 = setup_ehlr(vmcs1);
+    auto &&ehlr2 = setup_ehlr(vmcs2);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        auto &&ticket = exit_handler_intel_x64_eapis::broadcast_invept();
+        this->expect_true(ticket->load() == 2);
+        this->expect_true(ehlr1->m_invept_tickets.size() == 1);
+        this->expect_true(ehlr2->m_invept_tickets.size() == 1);
+
+        ehlr1->resume();
+        this->expect_true(ticket->load() == 1);
+        this->expect_true(ehlr1->m_invept_tickets.empty());
+
+        ehlr2->resume();
+        this->expect_true(ticket->load() == 0);
+
+        // A vCPU that goes away before its next VM entry releases its
+        // share of the ticket.
+
+        ticket = exit_handler_intel_x64_eapis::broadcast_invept();
+        this->expect_true(ticket->load() == 2);
+
+        ehlr1->resume();
+        this->expect_true(ticket->load() == 1);
+
+        ehlr2.reset();
+        this->expect_true(ticket->load() == 0);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_broadcast()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr1 = setup_ehlr(vmcs);
+    auto &&ehlr2 = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "trap_on_io_access"}, {"port", 42}, {"broadcast", true}};
+    json ijson2 = {{"set", "trap_on_io_access"}, {"port", 42}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr1->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr1->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+        this->expect_true(ehlr2->m_vmcs_updates.size() == 1);
+        this->expect_false(ehlr1->m_broadcast);
+
+        g_port = 0;
+        ehlr2->resume();
+        this->expect_true(g_port == 42);
+
+        this->expect_no_exception([&]{ ehlr1->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ehlr2->m_vmcs_updates.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_overrun_denials_buffer()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "vpid"}, {"enabled", false}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = true;
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        for (auto i = 0; i < DENIAL_LOG_SIZE + 10; i++)
+            this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+
+        this->expect_true(ehlr->m_denials.size() == DENIAL_LOG_SIZE);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_unknown()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = 0xDEADBEEF;
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_io_instruction_unknown()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__io_instruction;
+    regs.r03 = 0xDEADBEEF;
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_io_instruction_trap_on_io_access_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__io_instruction;
+    regs.r03 = eapis_fun__trap_on_io_access;
+    regs.r04 = 42;
+
+    g_port = 0;
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_port == 42);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_io_instruction_trap_on_io_access_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__io_instruction;
+    regs.r03 = eapis_fun__trap_on_io_access;
+    regs.r04 = 42;
+
+    g_port = 0;
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_port == 42);
+        this->expect_true(ehlr->m_denials.size() == 1);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_io_instruction_trap_on_io_access_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__io_instruction;
+    regs.r03 = eapis_fun__trap_on_io_access;
+    regs.r04 = 42;
+
+    g_port = 0;
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
+        this->expect_true(g_port == 0);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_io_instruction_trap_on_all_io_accesses_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__io_instruction;
+    regs.r03 = eapis_fun__trap_on_all_io_accesses;
+
+    g_port = 0;
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_port == 42);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_io_instruction_trap_on_all_io_accesses_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__io_instruction;
+    regs.r03 = eapis_fun__trap_on_all_io_accesses;
+
+    g_port = 0;
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_port == 42);
+        this->expect_true(ehlr->m_denials.size() == 1);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_io_instruction_trap_on_all_io_accesses_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__io_instruction;
+    regs.r03 = eapis_fun__trap_on_all_io_accesses;
+
+    g_port = 0;
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
+        this->expect_true(g_port == 0);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_io_instruction_pass_through_io_access_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__io_instruction;
+    regs.r03 = eapis_fun__pass_through_io_access;
+    regs.r04 = 42;
+
+    g_port = 0;
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_port == 42);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_io_instruction_pass_through_io_access_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__io_instruction;
+    regs.r03 = eapis_fun__pass_through_io_access;
+    regs.r04 = 42;
+
+    g_port = 0;
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_port == 42);
+        this->expect_true(ehlr->m_denials.size() == 1);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_io_instruction_pass_through_io_access_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__io_instruction;
+    regs.r03 = eapis_fun__pass_through_io_access;
+    regs.r04 = 42;
+
+    g_port = 0;
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
+        this->expect_true(g_port == 0);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_io_instruction_pass_through_all_io_accesses_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__io_instruction;
+    regs.r03 = eapis_fun__pass_through_all_io_accesses;
+
+    g_port = 0;
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_port == 42);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_io_instruction_pass_through_all_io_accesses_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__io_instruction;
+    regs.r03 = eapis_fun__pass_through_all_io_accesses;
+
+    g_port = 0;
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_port == 42);
+        this->expect_true(ehlr->m_denials.size() == 1);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_io_instruction_pass_through_all_io_accesses_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
     regs.r02 = eapis_cat__io_instruction;
-    regs.r03 = eapis_fun__trap_on_all_io_accesses;
+    regs.r03 = eapis_fun__pass_through_all_io_accesses;
+
+    g_port = 0;
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
+        this->expect_true(g_port == 0);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_unknown()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "unknown_api"}};
+    json ojson = {};
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_ree);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_trap_on_io_access_missing_port()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "trap_on_io_access"}};
+    json ojson = {};
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_ore);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_trap_on_io_access_invalid_port()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "trap_on_io_access"}, {"port", "bad port"}};
+    json ijson2 = {{"set", "trap_on_io_access"}, {"port_hex", 10}};
+    json ojson = {};
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); }, ""_ut_ree);
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); }, ""_ut_ore);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_trap_on_io_access_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "trap_on_io_access"}, {"port", 42}};
+    json ijson2 = {{"set", "trap_on_io_access"}, {"port_hex", "0x2A"}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_trap_on_io_access_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "trap_on_io_access"}, {"port", 42}};
+    json ijson2 = {{"set", "trap_on_io_access"}, {"port_hex", "0x2A"}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+        this->expect_true(ehlr->m_denials.size() == 1);
+
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+        this->expect_true(ehlr->m_denials.size() == 2);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_trap_on_io_access_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "trap_on_io_access"}, {"port", 42}};
+    json ijson2 = {{"set", "trap_on_io_access"}, {"port_hex", "0x2A"}};
+    json ojson = {};
+
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_port = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_port == 0);
+
+        g_port = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_port == 0);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_pass_through_io_access_missing_port()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "pass_through_io_access"}};
+    json ojson = {};
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_ore);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_pass_through_io_access_invalid_port()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "pass_through_io_access"}, {"port", "bad port"}};
+    json ijson2 = {{"set", "pass_through_io_access"}, {"port_hex", 10}};
+    json ojson = {};
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); }, ""_ut_ree);
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); }, ""_ut_ore);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_pass_through_io_access_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "pass_through_io_access"}, {"port", 42}};
+    json ijson2 = {{"set", "pass_through_io_access"}, {"port_hex", "0x2A"}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_pass_through_io_access_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "pass_through_io_access"}, {"port", 42}};
+    json ijson2 = {{"set", "pass_through_io_access"}, {"port_hex", "0x2A"}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+        this->expect_true(ehlr->m_denials.size() == 1);
+
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+        this->expect_true(ehlr->m_denials.size() == 2);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_pass_through_io_access_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "pass_through_io_access"}, {"port", 42}};
+    json ijson2 = {{"set", "pass_through_io_access"}, {"port_hex", "0x2A"}};
+    json ojson = {};
+
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_port = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_port == 0);
+
+        g_port = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_port == 0);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_trap_on_io_range_invalid_range()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "trap_on_io_range"}, {"first", 43}, {"last", 42}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_port = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_ree);
+        this->expect_true(g_port == 0);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_trap_on_io_range_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "trap_on_io_range"}, {"first", 40}, {"last", 42}};
+    json ijson2 = {{"set", "trap_on_io_range"}, {"first_hex", "0x28"}, {"last_hex", "0x2A"}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_trap_on_io_range_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "trap_on_io_range"}, {"first", 40}, {"last", 42}};
+    json ijson2 = {{"set", "trap_on_io_range"}, {"first_hex", "0x28"}, {"last_hex", "0x2A"}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+        this->expect_true(ehlr->m_denials.size() == 2);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_trap_on_io_range_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "trap_on_io_range"}, {"first", 40}, {"last", 42}};
+    json ijson2 = {{"set", "trap_on_io_range"}, {"first_hex", "0x28"}, {"last_hex", "0x2A"}};
+    json ojson = {};
+
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_port = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_port == 0);
+
+        g_port = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_port == 0);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_pass_through_io_range_invalid_range()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "pass_through_io_range"}, {"first", 43}, {"last", 42}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_port = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_ree);
+        this->expect_true(g_port == 0);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_pass_through_io_range_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "pass_through_io_range"}, {"first", 40}, {"last", 42}};
+    json ijson2 = {{"set", "pass_through_io_range"}, {"first_hex", "0x28"}, {"last_hex", "0x2A"}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_pass_through_io_range_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "pass_through_io_range"}, {"first", 40}, {"last", 42}};
+    json ijson2 = {{"set", "pass_through_io_range"}, {"first_hex", "0x28"}, {"last_hex", "0x2A"}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+        this->expect_true(ehlr->m_denials.size() == 2);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_pass_through_io_range_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "pass_through_io_range"}, {"first", 40}, {"last", 42}};
+    json ijson2 = {{"set", "pass_through_io_range"}, {"first_hex", "0x28"}, {"last_hex", "0x2A"}};
+    json ojson = {};
+
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_port = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_port == 0);
+
+        g_port = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_port == 0);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_whitelist_io_access_missing_ports()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "whitelist_io_access"}};
+    json ojson = {};
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_ore);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_whitelist_io_access_invalid_ports()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "whitelist_io_access"}, {"ports", "bad port"}};
+    json ijson2 = {{"set", "whitelist_io_access"}, {"ports_hex", 10}};
+    json ojson = {};
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); }, ""_ut_ree);
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); }, ""_ut_ore);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_whitelist_io_access_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "whitelist_io_access"}, {"ports", {42}}};
+    json ijson2 = {{"set", "whitelist_io_access"}, {"ports_hex", {"0x2A"}}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_whitelist_io_access_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "whitelist_io_access"}, {"ports", {42}}};
+    json ijson2 = {{"set", "whitelist_io_access"}, {"ports_hex", {"0x2A"}}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+        this->expect_true(ehlr->m_denials.size() == 1);
+
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+        this->expect_true(ehlr->m_denials.size() == 2);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_whitelist_io_access_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "whitelist_io_access"}, {"ports", {42}}};
+    json ijson2 = {{"set", "whitelist_io_access"}, {"ports_hex", {"0x2A"}}};
+    json ojson = {};
+
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_port = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_port == 0);
+
+        g_port = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_port == 0);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_blacklist_io_access_missing_ports()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "blacklist_io_access"}};
+    json ojson = {};
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_ore);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_blacklist_io_access_invalid_ports()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "blacklist_io_access"}, {"ports", "bad port"}};
+    json ijson2 = {{"set", "blacklist_io_access"}, {"ports_hex", 10}};
+    json ojson = {};
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); }, ""_ut_ree);
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); }, ""_ut_ore);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_blacklist_io_access_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "blacklist_io_access"}, {"ports", {42}}};
+    json ijson2 = {{"set", "blacklist_io_access"}, {"ports_hex", {"0x2A"}}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_blacklist_io_access_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "blacklist_io_access"}, {"ports", {42}}};
+    json ijson2 = {{"set", "blacklist_io_access"}, {"ports_hex", {"0x2A"}}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+        this->expect_true(ehlr->m_denials.size() == 1);
+
+        g_port = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_port == 42);
+        this->expect_true(ehlr->m_denials.size() == 2);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_blacklist_io_access_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "blacklist_io_access"}, {"ports", {42}}};
+    json ijson2 = {{"set", "blacklist_io_access"}, {"ports_hex", {"0x2A"}}};
+    json ojson = {};
+
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_port = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_port == 0);
+
+        g_port = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_port == 0);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_log_io_access_missing_enabled()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "log_io_access"}};
+    json ojson = {};
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_ore);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_log_io_access_invalid_enabled()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "log_io_access"}, {"enabled", "not a bool"}};
+    json ojson = {};
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_dme);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_share_io_bitmaps_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "share_io_bitmaps"}, {"enabled", false}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_share_io_bitmaps_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "share_io_bitmaps"}, {"enabled", false}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(ehlr->m_denials.size() == 1);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_share_io_bitmaps_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "share_io_bitmaps"}, {"enabled", false}};
+    json ojson = {};
+
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_log_io_access_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "log_io_access"}, {"enabled", false}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_log_io_access_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "log_io_access"}, {"enabled", false}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(ehlr->m_denials.size() == 1);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_log_io_access_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "log_io_access"}, {"enabled", false}};
+    json ojson = {};
+
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_clear_io_access_log_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"run", "clear_io_access_log"}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_clear_io_access_log_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"run", "clear_io_access_log"}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(ehlr->m_denials.size() == 1);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_clear_io_access_log_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"run", "clear_io_access_log"}};
+    json ojson = {};
+
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_io_access_log_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"get", "io_access_log"}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+    ehlr->log_io_access(true);
+    ehlr->m_io_access_log.m_counters[42] = 42;
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "{\"0x2A\":42}");
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_io_access_log_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"get", "io_access_log"}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+    ehlr->log_io_access(true);
+    ehlr->m_io_access_log.m_counters[42] = 42;
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "{\"0x2A\":42}");
+        this->expect_true(ehlr->m_denials.size() == 1);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_io_access_log_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"get", "io_access_log"}};
+    json ojson = {};
+
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+    ehlr->log_io_access(true);
+    ehlr->m_io_access_log.m_counters[42] = 42;
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "{\"0x2A\":42}");
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_trace_io_access_unaligned()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "trace_io_access"}, {"gpa", 42}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_ree);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_trace_io_access_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "trace_io_access"}, {"gpa", 0}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_trace_io_access_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "trace_io_access"}, {"gpa", 0}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(ehlr->m_denials.size() == 1);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_trace_io_access_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "trace_io_access"}, {"gpa", 0}};
+    json ojson = {};
+
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_trace_io_access_unmapped()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+    auto &&ept = setup_ept(mocks, vmcs);
+
+    json ijson = {{"set", "trace_io_access"}, {"gpa", g_guest_page}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_ree);
+        this->expect_true(ehlr->m_io_trace_gpa == 0);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_trace_io_access_read_only()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+    auto &&ept = setup_ept(mocks, vmcs);
+    auto &&merger = std::make_unique<page_merger_intel_x64>(vmcs);
+
+    setup_guest_page(ept.get(), false);
+    ehlr->set_page_merger(merger.get());
+
+    json ijson = {{"set", "trace_io_access"}, {"gpa", g_guest_page}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_ree);
+        this->expect_true(ehlr->m_io_trace_gpa == 0);
+        this->expect_true(merger->m_pinned.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_trace_io_access_spp()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+    auto &&ept = setup_ept(mocks, vmcs);
+
+    setup_guest_page(ept.get(), true)->set_sub_page_write_permissions(true);
+
+    json ijson = {{"set", "trace_io_access"}, {"gpa", g_guest_page}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_ree);
+        this->expect_true(ehlr->m_io_trace_gpa == 0);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_trace_io_access_merged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+    auto &&ept = setup_ept(mocks, vmcs);
+    auto &&merger = std::make_unique<page_merger_intel_x64>(vmcs);
+
+    setup_guest_page(ept.get(), false);
+    ehlr->set_page_merger(merger.get());
+    merger->m_merged[g_guest_page] = 0x00000000ABCDE000UL;
+
+    json ijson = {{"set", "trace_io_access"}, {"gpa", g_guest_page}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_ree);
+        this->expect_true(ehlr->m_io_trace_gpa == 0);
+        this->expect_true(merger->m_pinned.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_io_storm_policy_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "io_storm_policy"}, {"threshold", 0}, {"window", 0}, {"rearm", 0}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_io_storm_policy_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "io_storm_policy"}, {"threshold", 0}, {"window", 0}, {"rearm", 0}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(ehlr->m_denials.size() == 1);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_io_storm_policy_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "io_storm_policy"}, {"threshold", 0}, {"window", 0}, {"rearm", 0}};
+    json ojson = {};
+
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_io_storms_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"get", "io_storms"}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "[]");
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_io_storms_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"get", "io_storms"}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "[]");
+        this->expect_true(ehlr->m_denials.size() == 1);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_io_storms_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"get", "io_storms"}};
+    json ojson = {};
+
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_emulate_uart_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "emulate_uart"}, {"enabled", false}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_emulate_uart_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "emulate_uart"}, {"enabled", false}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(ehlr->m_denials.size() == 1);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_emulate_uart_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "emulate_uart"}, {"enabled", false}};
+    json ojson = {};
+
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_uart_output_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"get", "uart_output"}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "[\"\"]");
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_uart_output_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"get", "uart_output"}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "[\"\"]");
+        this->expect_true(ehlr->m_denials.size() == 1);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_io_instruction_uart_output_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"get", "uart_output"}};
+    json ojson = {};
+
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_vpid_unknown()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__vpid;
+    regs.r03 = 0xDEADBEEF;
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_vpid_enable_vpid_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__vpid;
+    regs.r03 = eapis_fun__enable_vpid;
+
+    g_enable_vpid = false;
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_enable_vpid);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_vpid_enable_vpid_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__vpid;
+    regs.r03 = eapis_fun__enable_vpid;
+
+    g_enable_vpid = false;
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_enable_vpid);
+        this->expect_true(ehlr->m_denials.size() == 1);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_vpid_enable_vpid_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__vpid;
+    regs.r03 = eapis_fun__enable_vpid;
+
+    g_enable_vpid = false;
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
+        this->expect_false(g_enable_vpid);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_vpid_disable_vpid_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__vpid;
+    regs.r03 = eapis_fun__disable_vpid;
+
+    g_enable_vpid = true;
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_false(g_enable_vpid);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_vpid_disable_vpid_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__vpid;
+    regs.r03 = eapis_fun__disable_vpid;
+
+    g_enable_vpid = true;
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_false(g_enable_vpid);
+        this->expect_true(ehlr->m_denials.size() == 1);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_vpid_disable_vpid_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__vpid;
+    regs.r03 = eapis_fun__disable_vpid;
+
+    g_enable_vpid = true;
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
+        this->expect_true(g_enable_vpid);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_vpid_enable_vpid_missing_enabled()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "vpid"}};
+    json ojson = {};
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_ore);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_vpid_enable_vpid_invalid_enabled()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "vpid"}, {"enabled", "not a bool"}};
+    json ojson = {};
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_dme);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_vpid_enable_vpid_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "vpid"}, {"enabled", false}};
+    json ojson = {};
+
+    g_enable_vpid = true;
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_false(g_enable_vpid);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_vpid_enable_vpid_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "vpid"}, {"enabled", false}};
+    json ojson = {};
+
+    g_enable_vpid = true;
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(ehlr->m_denials.size() == 1);
+        this->expect_false(g_enable_vpid);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_vpid_enable_vpid_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"set", "vpid"}, {"enabled", false}};
+    json ojson = {};
+
+    g_enable_vpid = true;
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_enable_vpid);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_unknown()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = 0xDEADBEEF;
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_trap_on_rdmsr_access_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = eapis_fun__trap_on_rdmsr_access;
+    regs.r04 = 42;
+
+    g_msr = 0;
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_msr == 42);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_trap_on_rdmsr_access_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = eapis_fun__trap_on_rdmsr_access;
+    regs.r04 = 42;
+
+    g_msr = 0;
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_msr == 42);
+        this->expect_true(ehlr->m_denials.size() == 1);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_trap_on_rdmsr_access_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = eapis_fun__trap_on_rdmsr_access;
+    regs.r04 = 42;
+
+    g_msr = 0;
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
+        this->expect_true(g_msr == 0);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_trap_on_wrmsr_access_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = eapis_fun__trap_on_wrmsr_access;
+    regs.r04 = 42;
+
+    g_msr = 0;
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_msr == 42);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_trap_on_wrmsr_access_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = eapis_fun__trap_on_wrmsr_access;
+    regs.r04 = 42;
+
+    g_msr = 0;
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_msr == 42);
+        this->expect_true(ehlr->m_denials.size() == 1);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_trap_on_wrmsr_access_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = eapis_fun__trap_on_wrmsr_access;
+    regs.r04 = 42;
+
+    g_msr = 0;
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
+        this->expect_true(g_msr == 0);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_trap_on_all_rdmsr_accesses_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = eapis_fun__trap_on_all_rdmsr_accesses;
+
+    g_msr = 0;
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_msr == 42);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_trap_on_all_rdmsr_accesses_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = eapis_fun__trap_on_all_rdmsr_accesses;
+
+    g_msr = 0;
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_msr == 42);
+        this->expect_true(ehlr->m_denials.size() == 1);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_trap_on_all_rdmsr_accesses_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = eapis_fun__trap_on_all_rdmsr_accesses;
+
+    g_msr = 0;
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
+        this->expect_true(g_msr == 0);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_trap_on_all_wrmsr_accesses_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = eapis_fun__trap_on_all_wrmsr_accesses;
+
+    g_msr = 0;
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_msr == 42);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_trap_on_all_wrmsr_accesses_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = eapis_fun__trap_on_all_wrmsr_accesses;
+
+    g_msr = 0;
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_msr == 42);
+        this->expect_true(ehlr->m_denials.size() == 1);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_trap_on_all_wrmsr_accesses_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = eapis_fun__trap_on_all_wrmsr_accesses;
+
+    g_msr = 0;
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
+        this->expect_true(g_msr == 0);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_pass_through_rdmsr_access_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = eapis_fun__pass_through_rdmsr_access;
+    regs.r04 = 42;
+
+    g_msr = 0;
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_msr == 42);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_pass_through_rdmsr_access_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = eapis_fun__pass_through_rdmsr_access;
+    regs.r04 = 42;
+
+    g_msr = 0;
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_msr == 42);
+        this->expect_true(ehlr->m_denials.size() == 1);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_pass_through_rdmsr_access_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = eapis_fun__pass_through_rdmsr_access;
+    regs.r04 = 42;
+
+    g_msr = 0;
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
+        this->expect_true(g_msr == 0);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_pass_through_wrmsr_access_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = eapis_fun__pass_through_wrmsr_access;
+    regs.r04 = 42;
+
+    g_msr = 0;
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_msr == 42);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_pass_through_wrmsr_access_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = eapis_fun__pass_through_wrmsr_access;
+    regs.r04 = 42;
+
+    g_msr = 0;
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_msr == 42);
+        this->expect_true(ehlr->m_denials.size() == 1);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_pass_through_wrmsr_access_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = eapis_fun__pass_through_wrmsr_access;
+    regs.r04 = 42;
+
+    g_msr = 0;
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
+        this->expect_true(g_msr == 0);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_pass_through_all_rdmsr_accesses_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = eapis_fun__pass_through_all_rdmsr_accesses;
+
+    g_msr = 0;
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_msr == 42);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_pass_through_all_rdmsr_accesses_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = eapis_fun__pass_through_all_rdmsr_accesses;
+
+    g_msr = 0;
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_msr == 42);
+        this->expect_true(ehlr->m_denials.size() == 1);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_pass_through_all_rdmsr_accesses_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = eapis_fun__pass_through_all_rdmsr_accesses;
+
+    g_msr = 0;
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
+        this->expect_true(g_msr == 0);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_pass_through_all_wrmsr_accesses_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = eapis_fun__pass_through_all_wrmsr_accesses;
+
+    g_msr = 0;
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_msr == 42);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_pass_through_all_wrmsr_accesses_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = eapis_fun__pass_through_all_wrmsr_accesses;
+
+    g_msr = 0;
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
+        this->expect_true(g_msr == 42);
+        this->expect_true(ehlr->m_denials.size() == 1);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_registers_msr_pass_through_all_wrmsr_accesses_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    vmcall_registers_t regs = {};
+    regs.r02 = eapis_cat__msr;
+    regs.r03 = eapis_fun__pass_through_all_wrmsr_accesses;
+
+    g_msr = 0;
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
+        this->expect_true(g_msr == 0);
+        this->expect_true(ehlr->m_denials.empty());
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_msr_trap_on_rdmsr_access_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "trap_on_rdmsr_access"}, {"msr", 42}};
+    json ijson2 = {{"set", "trap_on_rdmsr_access"}, {"msr_hex", "0x2A"}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_msr = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_msr == 42);
+
+        g_msr = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_msr == 42);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_msr_trap_on_rdmsr_access_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "trap_on_rdmsr_access"}, {"msr", 42}};
+    json ijson2 = {{"set", "trap_on_rdmsr_access"}, {"msr_hex", "0x2A"}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_msr = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_msr == 42);
+
+        g_msr = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_msr == 42);
+        this->expect_true(ehlr->m_denials.size() == 2);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_msr_trap_on_rdmsr_access_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "trap_on_rdmsr_access"}, {"msr", 42}};
+    json ijson2 = {{"set", "trap_on_rdmsr_access"}, {"msr_hex", "0x2A"}};
+    json ojson = {};
+
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_msr = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_msr == 0);
+
+        g_msr = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_msr == 0);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_msr_trap_on_wrmsr_access_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "trap_on_wrmsr_access"}, {"msr", 42}};
+    json ijson2 = {{"set", "trap_on_wrmsr_access"}, {"msr_hex", "0x2A"}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_msr = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_msr == 42);
+
+        g_msr = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_msr == 42);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_msr_trap_on_wrmsr_access_logged()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "trap_on_wrmsr_access"}, {"msr", 42}};
+    json ijson2 = {{"set", "trap_on_wrmsr_access"}, {"msr_hex", "0x2A"}};
+    json ojson = {};
 
-    g_port = 0;
     g_deny_all = false;
     g_log_denials = true;
 
@@ -477,24 +4849,30 @@ eapis_ut::test_handle_vmcall_registers_io_instruction_trap_on_all_io_accesses_lo
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
-        this->expect_true(g_port == 42);
-        this->expect_true(ehlr->m_denials.size() == 1);
+        g_msr = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_msr == 42);
+
+        g_msr = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_msr == 42);
+        this->expect_true(ehlr->m_denials.size() == 2);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_registers_io_instruction_trap_on_all_io_accesses_denied()
+eapis_ut::test_handle_vmcall_json_msr_trap_on_wrmsr_access_denied()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    vmcall_registers_t regs = {};
-    regs.r02 = eapis_cat__io_instruction;
-    regs.r03 = eapis_fun__trap_on_all_io_accesses;
+    json ijson1 = {{"set", "trap_on_wrmsr_access"}, {"msr", 42}};
+    json ijson2 = {{"set", "trap_on_wrmsr_access"}, {"msr_hex", "0x2A"}};
+    json ojson = {};
 
-    g_port = 0;
     g_deny_all = true;
     g_log_denials = false;
 
@@ -502,25 +4880,29 @@ eapis_ut::test_handle_vmcall_registers_io_instruction_trap_on_all_io_accesses_de
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
-        this->expect_true(g_port == 0);
-        this->expect_true(ehlr->m_denials.empty());
+        g_msr = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_msr == 0);
+
+        g_msr = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_msr == 0);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_registers_io_instruction_pass_through_io_access_allowed()
+eapis_ut::test_handle_vmcall_json_msr_pass_through_rdmsr_access_allowed()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    vmcall_registers_t regs = {};
-    regs.r02 = eapis_cat__io_instruction;
-    regs.r03 = eapis_fun__pass_through_io_access;
-    regs.r04 = 42;
+    json ijson1 = {{"set", "pass_through_rdmsr_access"}, {"msr", 42}};
+    json ijson2 = {{"set", "pass_through_rdmsr_access"}, {"msr_hex", "0x2A"}};
+    json ojson = {};
 
-    g_port = 0;
     g_deny_all = false;
     g_log_denials = false;
 
@@ -528,25 +4910,29 @@ eapis_ut::test_handle_vmcall_registers_io_instruction_pass_through_io_access_all
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
-        this->expect_true(g_port == 42);
-        this->expect_true(ehlr->m_denials.empty());
+        g_msr = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_msr == 42);
+
+        g_msr = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_msr == 42);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_registers_io_instruction_pass_through_io_access_logged()
+eapis_ut::test_handle_vmcall_json_msr_pass_through_rdmsr_access_logged()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    vmcall_registers_t regs = {};
-    regs.r02 = eapis_cat__io_instruction;
-    regs.r03 = eapis_fun__pass_through_io_access;
-    regs.r04 = 42;
+    json ijson1 = {{"set", "pass_through_rdmsr_access"}, {"msr", 42}};
+    json ijson2 = {{"set", "pass_through_rdmsr_access"}, {"msr_hex", "0x2A"}};
+    json ojson = {};
 
-    g_port = 0;
     g_deny_all = false;
     g_log_denials = true;
 
@@ -554,25 +4940,30 @@ eapis_ut::test_handle_vmcall_registers_io_instruction_pass_through_io_access_log
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
-        this->expect_true(g_port == 42);
-        this->expect_true(ehlr->m_denials.size() == 1);
+        g_msr = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_msr == 42);
+
+        g_msr = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_msr == 42);
+        this->expect_true(ehlr->m_denials.size() == 2);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_registers_io_instruction_pass_through_io_access_denied()
+eapis_ut::test_handle_vmcall_json_msr_pass_through_rdmsr_access_denied()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    vmcall_registers_t regs = {};
-    regs.r02 = eapis_cat__io_instruction;
-    regs.r03 = eapis_fun__pass_through_io_access;
-    regs.r04 = 42;
+    json ijson1 = {{"set", "pass_through_rdmsr_access"}, {"msr", 42}};
+    json ijson2 = {{"set", "pass_through_rdmsr_access"}, {"msr_hex", "0x2A"}};
+    json ojson = {};
 
-    g_port = 0;
     g_deny_all = true;
     g_log_denials = false;
 
@@ -580,24 +4971,29 @@ eapis_ut::test_handle_vmcall_registers_io_instruction_pass_through_io_access_den
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
-        this->expect_true(g_port == 0);
-        this->expect_true(ehlr->m_denials.empty());
+        g_msr = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_msr == 0);
+
+        g_msr = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_msr == 0);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_registers_io_instruction_pass_through_all_io_accesses_allowed()
+eapis_ut::test_handle_vmcall_json_msr_pass_through_wrmsr_access_allowed()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    vmcall_registers_t regs = {};
-    regs.r02 = eapis_cat__io_instruction;
-    regs.r03 = eapis_fun__pass_through_all_io_accesses;
+    json ijson1 = {{"set", "pass_through_wrmsr_access"}, {"msr", 42}};
+    json ijson2 = {{"set", "pass_through_wrmsr_access"}, {"msr_hex", "0x2A"}};
+    json ojson = {};
 
-    g_port = 0;
     g_deny_all = false;
     g_log_denials = false;
 
@@ -605,24 +5001,29 @@ eapis_ut::test_handle_vmcall_registers_io_instruction_pass_through_all_io_access
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
-        this->expect_true(g_port == 42);
-        this->expect_true(ehlr->m_denials.empty());
+        g_msr = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_msr == 42);
+
+        g_msr = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_msr == 42);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_registers_io_instruction_pass_through_all_io_accesses_logged()
+eapis_ut::test_handle_vmcall_json_msr_pass_through_wrmsr_access_logged()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    vmcall_registers_t regs = {};
-    regs.r02 = eapis_cat__io_instruction;
-    regs.r03 = eapis_fun__pass_through_all_io_accesses;
+    json ijson1 = {{"set", "pass_through_wrmsr_access"}, {"msr", 42}};
+    json ijson2 = {{"set", "pass_through_wrmsr_access"}, {"msr_hex", "0x2A"}};
+    json ojson = {};
 
-    g_port = 0;
     g_deny_all = false;
     g_log_denials = true;
 
@@ -630,24 +5031,30 @@ eapis_ut::test_handle_vmcall_registers_io_instruction_pass_through_all_io_access
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
-        this->expect_true(g_port == 42);
-        this->expect_true(ehlr->m_denials.size() == 1);
+        g_msr = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_msr == 42);
+
+        g_msr = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_msr == 42);
+        this->expect_true(ehlr->m_denials.size() == 2);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_registers_io_instruction_pass_through_all_io_accesses_denied()
+eapis_ut::test_handle_vmcall_json_msr_pass_through_wrmsr_access_denied()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    vmcall_registers_t regs = {};
-    regs.r02 = eapis_cat__io_instruction;
-    regs.r03 = eapis_fun__pass_through_all_io_accesses;
+    json ijson1 = {{"set", "pass_through_wrmsr_access"}, {"msr", 42}};
+    json ijson2 = {{"set", "pass_through_wrmsr_access"}, {"msr_hex", "0x2A"}};
+    json ojson = {};
 
-    g_port = 0;
     g_deny_all = true;
     g_log_denials = false;
 
@@ -655,71 +5062,118 @@ eapis_ut::test_handle_vmcall_registers_io_instruction_pass_through_all_io_access
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
-        this->expect_true(g_port == 0);
-        this->expect_true(ehlr->m_denials.empty());
+        g_msr = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_msr == 0);
+
+        g_msr = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_msr == 0);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_unknown()
+eapis_ut::test_handle_vmcall_json_msr_whitelist_rdmsr_access_allowed()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson = {{"set", "unknown_api"}};
+    json ijson1 = {{"set", "whitelist_rdmsr_access"}, {"msrs", {42}}};
+    json ijson2 = {{"set", "whitelist_rdmsr_access"}, {"msrs_hex", {"0x2A"}}};
     json ojson = {};
 
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_ree);
+        g_msr = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_msr == 42);
+
+        g_msr = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_msr == 42);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_trap_on_io_access_missing_port()
+eapis_ut::test_handle_vmcall_json_msr_whitelist_rdmsr_access_logged()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson = {{"set", "trap_on_io_access"}};
+    json ijson1 = {{"set", "whitelist_rdmsr_access"}, {"msrs", {42}}};
+    json ijson2 = {{"set", "whitelist_rdmsr_access"}, {"msrs_hex", {"0x2A"}}};
     json ojson = {};
 
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_ore);
+        g_msr = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_msr == 42);
+
+        g_msr = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_msr == 42);
+        this->expect_true(ehlr->m_denials.size() == 2);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_trap_on_io_access_invalid_port()
+eapis_ut::test_handle_vmcall_json_msr_whitelist_rdmsr_access_denied()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson1 = {{"set", "trap_on_io_access"}, {"port", "bad port"}};
-    json ijson2 = {{"set", "trap_on_io_access"}, {"port_hex", 10}};
+    json ijson1 = {{"set", "whitelist_rdmsr_access"}, {"msrs", {42}}};
+    json ijson2 = {{"set", "whitelist_rdmsr_access"}, {"msrs_hex", {"0x2A"}}};
     json ojson = {};
 
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); }, ""_ut_ree);
-        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); }, ""_ut_ore);
+        g_msr = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_msr == 0);
+
+        g_msr = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_msr == 0);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_trap_on_io_access_allowed()
+eapis_ut::test_handle_vmcall_json_msr_whitelist_wrmsr_access_allowed()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson1 = {{"set", "trap_on_io_access"}, {"port", 42}};
-    json ijson2 = {{"set", "trap_on_io_access"}, {"port_hex", "0x2A"}};
+    json ijson1 = {{"set", "whitelist_wrmsr_access"}, {"msrs", {42}}};
+    json ijson2 = {{"set", "whitelist_wrmsr_access"}, {"msrs_hex", {"0x2A"}}};
     json ojson = {};
 
     g_deny_all = false;
@@ -729,27 +5183,27 @@ eapis_ut::test_handle_vmcall_json_io_instruction_trap_on_io_access_allowed()
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        g_port = 0;
+        g_msr = 0;
         this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
         this->expect_true(ojson.dump() == "[\"success\"]");
-        this->expect_true(g_port == 42);
+        this->expect_true(g_msr == 42);
 
-        g_port = 0;
+        g_msr = 0;
         this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
         this->expect_true(ojson.dump() == "[\"success\"]");
-        this->expect_true(g_port == 42);
+        this->expect_true(g_msr == 42);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_trap_on_io_access_logged()
+eapis_ut::test_handle_vmcall_json_msr_whitelist_wrmsr_access_logged()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson1 = {{"set", "trap_on_io_access"}, {"port", 42}};
-    json ijson2 = {{"set", "trap_on_io_access"}, {"port_hex", "0x2A"}};
+    json ijson1 = {{"set", "whitelist_wrmsr_access"}, {"msrs", {42}}};
+    json ijson2 = {{"set", "whitelist_wrmsr_access"}, {"msrs_hex", {"0x2A"}}};
     json ojson = {};
 
     g_deny_all = false;
@@ -759,29 +5213,28 @@ eapis_ut::test_handle_vmcall_json_io_instruction_trap_on_io_access_logged()
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        g_port = 0;
+        g_msr = 0;
         this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
         this->expect_true(ojson.dump() == "[\"success\"]");
-        this->expect_true(g_port == 42);
-        this->expect_true(ehlr->m_denials.size() == 1);
+        this->expect_true(g_msr == 42);
 
-        g_port = 0;
+        g_msr = 0;
         this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
         this->expect_true(ojson.dump() == "[\"success\"]");
-        this->expect_true(g_port == 42);
+        this->expect_true(g_msr == 42);
         this->expect_true(ehlr->m_denials.size() == 2);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_trap_on_io_access_denied()
+eapis_ut::test_handle_vmcall_json_msr_whitelist_wrmsr_access_denied()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson1 = {{"set", "trap_on_io_access"}, {"port", 42}};
-    json ijson2 = {{"set", "trap_on_io_access"}, {"port_hex", "0x2A"}};
+    json ijson1 = {{"set", "whitelist_wrmsr_access"}, {"msrs", {42}}};
+    json ijson2 = {{"set", "whitelist_wrmsr_access"}, {"msrs_hex", {"0x2A"}}};
     json ojson = {};
 
     g_deny_all = true;
@@ -791,61 +5244,118 @@ eapis_ut::test_handle_vmcall_json_io_instruction_trap_on_io_access_denied()
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        g_port = 0;
+        g_msr = 0;
         this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); },  ""_ut_ree);
         this->expect_true(ojson.dump() != "[\"success\"]");
-        this->expect_true(g_port == 0);
+        this->expect_true(g_msr == 0);
 
-        g_port = 0;
+        g_msr = 0;
         this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); },  ""_ut_ree);
         this->expect_true(ojson.dump() != "[\"success\"]");
-        this->expect_true(g_port == 0);
+        this->expect_true(g_msr == 0);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_pass_through_io_access_missing_port()
+eapis_ut::test_handle_vmcall_json_msr_blacklist_rdmsr_access_allowed()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson = {{"set", "pass_through_io_access"}};
+    json ijson1 = {{"set", "blacklist_rdmsr_access"}, {"msrs", {42}}};
+    json ijson2 = {{"set", "blacklist_rdmsr_access"}, {"msrs_hex", {"0x2A"}}};
     json ojson = {};
 
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_ore);
+        g_msr = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_msr == 42);
+
+        g_msr = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_msr == 42);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_pass_through_io_access_invalid_port()
+eapis_ut::test_handle_vmcall_json_msr_blacklist_rdmsr_access_logged()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson1 = {{"set", "pass_through_io_access"}, {"port", "bad port"}};
-    json ijson2 = {{"set", "pass_through_io_access"}, {"port_hex", 10}};
+    json ijson1 = {{"set", "blacklist_rdmsr_access"}, {"msrs", {42}}};
+    json ijson2 = {{"set", "blacklist_rdmsr_access"}, {"msrs_hex", {"0x2A"}}};
     json ojson = {};
 
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); }, ""_ut_ree);
-        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); }, ""_ut_ore);
+        g_msr = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_msr == 42);
+
+        g_msr = 0;
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(g_msr == 42);
+        this->expect_true(ehlr->m_denials.size() == 2);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_pass_through_io_access_allowed()
+eapis_ut::test_handle_vmcall_json_msr_blacklist_rdmsr_access_denied()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson1 = {{"set", "pass_through_io_access"}, {"port", 42}};
-    json ijson2 = {{"set", "pass_through_io_access"}, {"port_hex", "0x2A"}};
+    json ijson1 = {{"set", "blacklist_rdmsr_access"}, {"msrs", {42}}};
+    json ijson2 = {{"set", "blacklist_rdmsr_access"}, {"msrs_hex", {"0x2A"}}};
+    json ojson = {};
+
+    g_deny_all = true;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        g_msr = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_msr == 0);
+
+        g_msr = 0;
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+        this->expect_true(g_msr == 0);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_msr_blacklist_wrmsr_access_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson1 = {{"set", "blacklist_wrmsr_access"}, {"msrs", {42}}};
+    json ijson2 = {{"set", "blacklist_wrmsr_access"}, {"msrs_hex", {"0x2A"}}};
     json ojson = {};
 
     g_deny_all = false;
@@ -855,27 +5365,27 @@ eapis_ut::test_handle_vmcall_json_io_instruction_pass_through_io_access_allowed(
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        g_port = 0;
+        g_msr = 0;
         this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
         this->expect_true(ojson.dump() == "[\"success\"]");
-        this->expect_true(g_port == 42);
+        this->expect_true(g_msr == 42);
 
-        g_port = 0;
+        g_msr = 0;
         this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
         this->expect_true(ojson.dump() == "[\"success\"]");
-        this->expect_true(g_port == 42);
+        this->expect_true(g_msr == 42);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_pass_through_io_access_logged()
+eapis_ut::test_handle_vmcall_json_msr_blacklist_wrmsr_access_logged()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson1 = {{"set", "pass_through_io_access"}, {"port", 42}};
-    json ijson2 = {{"set", "pass_through_io_access"}, {"port_hex", "0x2A"}};
+    json ijson1 = {{"set", "blacklist_wrmsr_access"}, {"msrs", {42}}};
+    json ijson2 = {{"set", "blacklist_wrmsr_access"}, {"msrs_hex", {"0x2A"}}};
     json ojson = {};
 
     g_deny_all = false;
@@ -885,29 +5395,28 @@ eapis_ut::test_handle_vmcall_json_io_instruction_pass_through_io_access_logged()
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        g_port = 0;
+        g_msr = 0;
         this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
         this->expect_true(ojson.dump() == "[\"success\"]");
-        this->expect_true(g_port == 42);
-        this->expect_true(ehlr->m_denials.size() == 1);
+        this->expect_true(g_msr == 42);
 
-        g_port = 0;
+        g_msr = 0;
         this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
         this->expect_true(ojson.dump() == "[\"success\"]");
-        this->expect_true(g_port == 42);
+        this->expect_true(g_msr == 42);
         this->expect_true(ehlr->m_denials.size() == 2);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_pass_through_io_access_denied()
+eapis_ut::test_handle_vmcall_json_msr_blacklist_wrmsr_access_denied()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson1 = {{"set", "pass_through_io_access"}, {"port", 42}};
-    json ijson2 = {{"set", "pass_through_io_access"}, {"port_hex", "0x2A"}};
+    json ijson1 = {{"set", "blacklist_wrmsr_access"}, {"msrs", {42}}};
+    json ijson2 = {{"set", "blacklist_wrmsr_access"}, {"msrs_hex", {"0x2A"}}};
     json ojson = {};
 
     g_deny_all = true;
@@ -917,91 +5426,115 @@ eapis_ut::test_handle_vmcall_json_io_instruction_pass_through_io_access_denied()
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        g_port = 0;
+        g_msr = 0;
         this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); },  ""_ut_ree);
         this->expect_true(ojson.dump() != "[\"success\"]");
-        this->expect_true(g_port == 0);
+        this->expect_true(g_msr == 0);
 
-        g_port = 0;
+        g_msr = 0;
         this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); },  ""_ut_ree);
         this->expect_true(ojson.dump() != "[\"success\"]");
-        this->expect_true(g_port == 0);
+        this->expect_true(g_msr == 0);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_whitelist_io_access_missing_ports()
+eapis_ut::test_handle_vmcall_json_msr_log_msr_access_allowed()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson = {{"set", "whitelist_io_access"}};
+    json ijson = {{"set", "log_msr_access"}, {"enabled", false}};
     json ojson = {};
 
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_ore);
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_whitelist_io_access_invalid_ports()
+eapis_ut::test_handle_vmcall_json_msr_log_msr_access_logged()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson1 = {{"set", "whitelist_io_access"}, {"ports", "bad port"}};
-    json ijson2 = {{"set", "whitelist_io_access"}, {"ports_hex", 10}};
+    json ijson = {{"set", "log_msr_access"}, {"enabled", false}};
     json ojson = {};
 
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); }, ""_ut_ree);
-        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); }, ""_ut_ore);
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(ehlr->m_denials.size() == 1);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_whitelist_io_access_allowed()
+eapis_ut::test_handle_vmcall_json_msr_log_msr_access_denied()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson1 = {{"set", "whitelist_io_access"}, {"ports", {42}}};
-    json ijson2 = {{"set", "whitelist_io_access"}, {"ports_hex", {"0x2A"}}};
+    json ijson = {{"set", "log_msr_access"}, {"enabled", false}};
     json ojson = {};
 
-    g_deny_all = false;
+    g_deny_all = true;
     g_log_denials = false;
 
     ehlr->clear_denials();
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        g_port = 0;
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
-        this->expect_true(ojson.dump() == "[\"success\"]");
-        this->expect_true(g_port == 42);
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
+    });
+}
 
-        g_port = 0;
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+void
+eapis_ut::test_handle_vmcall_json_msr_clear_msr_access_log_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"run", "clear_msr_access_log"}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
         this->expect_true(ojson.dump() == "[\"success\"]");
-        this->expect_true(g_port == 42);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_whitelist_io_access_logged()
+eapis_ut::test_handle_vmcall_json_msr_clear_msr_access_log_logged()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson1 = {{"set", "whitelist_io_access"}, {"ports", {42}}};
-    json ijson2 = {{"set", "whitelist_io_access"}, {"ports_hex", {"0x2A"}}};
+    json ijson = {{"run", "clear_msr_access_log"}};
     json ojson = {};
 
     g_deny_all = false;
@@ -1011,29 +5544,20 @@ eapis_ut::test_handle_vmcall_json_io_instruction_whitelist_io_access_logged()
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        g_port = 0;
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
         this->expect_true(ojson.dump() == "[\"success\"]");
-        this->expect_true(g_port == 42);
         this->expect_true(ehlr->m_denials.size() == 1);
-
-        g_port = 0;
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
-        this->expect_true(ojson.dump() == "[\"success\"]");
-        this->expect_true(g_port == 42);
-        this->expect_true(ehlr->m_denials.size() == 2);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_whitelist_io_access_denied()
+eapis_ut::test_handle_vmcall_json_msr_clear_msr_access_log_denied()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson1 = {{"set", "whitelist_io_access"}, {"ports", {42}}};
-    json ijson2 = {{"set", "whitelist_io_access"}, {"ports_hex", {"0x2A"}}};
+    json ijson = {{"run", "clear_msr_access_log"}};
     json ojson = {};
 
     g_deny_all = true;
@@ -1043,232 +5567,299 @@ eapis_ut::test_handle_vmcall_json_io_instruction_whitelist_io_access_denied()
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        g_port = 0;
-        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); },  ""_ut_ree);
-        this->expect_true(ojson.dump() != "[\"success\"]");
-        this->expect_true(g_port == 0);
-
-        g_port = 0;
-        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); },  ""_ut_ree);
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ree);
         this->expect_true(ojson.dump() != "[\"success\"]");
-        this->expect_true(g_port == 0);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_blacklist_io_access_missing_ports()
+eapis_ut::test_handle_vmcall_json_msr_msr_access_log_allowed()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson = {{"set", "blacklist_io_access"}};
+    json ijson = {{"get", "msr_access_log"}};
     json ojson = {};
 
+    g_deny_all = false;
+    g_log_denials = false;
+
+    ehlr->clear_denials();
+    ehlr->log_msr_access(true);
+    ehlr->m_msr_access_log.m_counters[0x10] = 42;
+
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_ore);
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "{\"0x10\":42}");
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_blacklist_io_access_invalid_ports()
+eapis_ut::test_handle_vmcall_json_msr_msr_access_log_logged()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson1 = {{"set", "blacklist_io_access"}, {"ports", "bad port"}};
-    json ijson2 = {{"set", "blacklist_io_access"}, {"ports_hex", 10}};
+    json ijson = {{"get", "msr_access_log"}};
     json ojson = {};
 
+    g_deny_all = false;
+    g_log_denials = true;
+
+    ehlr->clear_denials();
+    ehlr->log_msr_access(true);
+    ehlr->m_msr_access_log.m_counters[0x10] = 42;
+
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); }, ""_ut_ree);
-        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); }, ""_ut_ore);
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "{\"0x10\":42}");
+        this->expect_true(ehlr->m_denials.size() == 1);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_blacklist_io_access_allowed()
+eapis_ut::test_handle_vmcall_json_msr_msr_access_log_denied()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson1 = {{"set", "blacklist_io_access"}, {"ports", {42}}};
-    json ijson2 = {{"set", "blacklist_io_access"}, {"ports_hex", {"0x2A"}}};
+    json ijson = {{"get", "msr_access_log"}};
     json ojson = {};
 
-    g_deny_all = false;
+    g_deny_all = true;
     g_log_denials = false;
 
     ehlr->clear_denials();
+    ehlr->log_msr_access(true);
+    ehlr->m_msr_access_log.m_counters[0x10] = 42;
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        g_port = 0;
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
-        this->expect_true(ojson.dump() == "[\"success\"]");
-        this->expect_true(g_port == 42);
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "{\"0x10\":42}");
+    });
+}
 
-        g_port = 0;
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+void
+eapis_ut::test_handle_vmcall_json_verifiers_clear_denials_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"run", "clear_denials"}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+    ehlr->m_denials.push_back("fake denial");
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
         this->expect_true(ojson.dump() == "[\"success\"]");
-        this->expect_true(g_port == 42);
+        this->expect_true(ehlr->m_denials.empty());
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_blacklist_io_access_logged()
+eapis_ut::test_handle_vmcall_json_verifiers_clear_denials_logged()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson1 = {{"set", "blacklist_io_access"}, {"ports", {42}}};
-    json ijson2 = {{"set", "blacklist_io_access"}, {"ports_hex", {"0x2A"}}};
+    json ijson = {{"run", "clear_denials"}};
     json ojson = {};
 
     g_deny_all = false;
     g_log_denials = true;
-
-    ehlr->clear_denials();
+    ehlr->m_denials.push_back("fake denial");
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        g_port = 0;
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); });
-        this->expect_true(ojson.dump() == "[\"success\"]");
-        this->expect_true(g_port == 42);
-        this->expect_true(ehlr->m_denials.size() == 1);
-
-        g_port = 0;
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); });
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
         this->expect_true(ojson.dump() == "[\"success\"]");
-        this->expect_true(g_port == 42);
-        this->expect_true(ehlr->m_denials.size() == 2);
+        this->expect_true(ehlr->m_denials.empty());
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_blacklist_io_access_denied()
+eapis_ut::test_handle_vmcall_json_verifiers_clear_denials_denied()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson1 = {{"set", "blacklist_io_access"}, {"ports", {42}}};
-    json ijson2 = {{"set", "blacklist_io_access"}, {"ports_hex", {"0x2A"}}};
+    json ijson = {{"run", "clear_denials"}};
     json ojson = {};
 
     g_deny_all = true;
     g_log_denials = false;
-
-    ehlr->clear_denials();
+    ehlr->m_denials.push_back("fake denial");
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        g_port = 0;
-        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson1, ojson); },  ""_ut_ree);
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ree);
         this->expect_true(ojson.dump() != "[\"success\"]");
-        this->expect_true(g_port == 0);
+        this->expect_true(ehlr->m_denials.size() == 1);
+    });
+}
 
-        g_port = 0;
-        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson2, ojson); },  ""_ut_ree);
-        this->expect_true(ojson.dump() != "[\"success\"]");
-        this->expect_true(g_port == 0);
+void
+eapis_ut::test_handle_vmcall_json_verifiers_dump_policy_allowed()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"dump", "policy"}};
+    json ojson = {};
+
+    g_deny_all = false;
+    g_log_denials = false;
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_log_io_access_missing_enabled()
+eapis_ut::test_handle_vmcall_json_verifiers_dump_policy_logged()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson = {{"set", "log_io_access"}};
+    json ijson = {{"dump", "policy"}};
     json ojson = {};
 
+    g_deny_all = false;
+    g_log_denials = true;
+
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_ore);
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_log_io_access_invalid_enabled()
+eapis_ut::test_handle_vmcall_json_verifiers_dump_policy_denied()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson = {{"set", "log_io_access"}, {"enabled", "not a bool"}};
+    json ijson = {{"dump", "policy"}};
     json ojson = {};
 
+    g_deny_all = true;
+    g_log_denials = false;
+
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_dme);
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ree);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_log_io_access_allowed()
+eapis_ut::test_handle_vmcall_json_verifiers_dump_denials_allowed()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson = {{"set", "log_io_access"}, {"enabled", false}};
+    json ijson = {{"dump", "denials"}};
     json ojson = {};
 
     g_deny_all = false;
     g_log_denials = false;
-
-    ehlr->clear_denials();
+    ehlr->m_denials.push_back("fake denial");
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
         this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
-        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(ojson.dump() == "[\"fake denial\"]");
+        this->expect_true(ehlr->m_denials.size() == 1);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_log_io_access_logged()
+eapis_ut::test_handle_vmcall_json_verifiers_dump_denials_logged()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson = {{"set", "log_io_access"}, {"enabled", false}};
+    json ijson = {{"dump", "denials"}};
     json ojson = {};
 
     g_deny_all = false;
     g_log_denials = true;
+    ehlr->m_denials.push_back("fake denial");
 
-    ehlr->clear_denials();
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ehlr->m_denials.size() == 2);
+    });
+}
+
+void
+eapis_ut::test_handle_vmcall_json_verifiers_dump_denials_denied()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs(mocks, 0x0);
+    auto &&ehlr = setup_ehlr(vmcs);
+
+    json ijson = {{"dump", "denials"}};
+    json ojson = {};
+
+    g_deny_all = true;
+    g_log_denials = false;
+    ehlr->m_denials.push_back("fake denial");
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
-        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"fake denial\"]");
         this->expect_true(ehlr->m_denials.size() == 1);
     });
 }
 
+auto
+setup_sampler(MockRepository &mocks)
+{
+    auto sampler = mocks.Mock<page_age_sampler_intel_x64>();
+
+    page_age_sampler_intel_x64::histogram_type histogram{{42, 1, 0, 0, 0, 0, 0, 0, 2}};
+    page_age_sampler_intel_x64::range_list_type ranges{{0x1000, 0x2000, 42}};
+
+    mocks.OnCall(sampler, page_age_sampler_intel_x64::set_flush_delegate);
+    mocks.OnCall(sampler, page_age_sampler_intel_x64::tick).Return(true);
+    mocks.OnCall(sampler, page_age_sampler_intel_x64::histogram).Return(histogram);
+    mocks.OnCall(sampler, page_age_sampler_intel_x64::cold_ranges).Return(ranges);
+
+    return sampler;
+}
+
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_log_io_access_denied()
+eapis_ut::test_handle_vmcall_json_page_age_sample_page_ages_no_sampler()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson = {{"set", "log_io_access"}, {"enabled", false}};
+    json ijson = {{"run", "sample_page_ages"}};
     json ojson = {};
 
-    g_deny_all = true;
+    g_deny_all = false;
     g_log_denials = false;
 
     ehlr->clear_denials();
@@ -1276,24 +5867,25 @@ eapis_ut::test_handle_vmcall_json_io_instruction_log_io_access_denied()
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
         this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ree);
-        this->expect_true(ojson.dump() != "[\"success\"]");
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_clear_io_access_log_allowed()
+eapis_ut::test_handle_vmcall_json_page_age_sample_page_ages_allowed()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
+    auto &&sampler = setup_sampler(mocks);
 
-    json ijson = {{"run", "clear_io_access_log"}};
+    json ijson = {{"run", "sample_page_ages"}};
     json ojson = {};
 
     g_deny_all = false;
     g_log_denials = false;
 
     ehlr->clear_denials();
+    ehlr->set_page_age_sampler(sampler);
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
@@ -1303,19 +5895,21 @@ eapis_ut::test_handle_vmcall_json_io_instruction_clear_io_access_log_allowed()
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_clear_io_access_log_logged()
+eapis_ut::test_handle_vmcall_json_page_age_sample_page_ages_logged()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
+    auto &&sampler = setup_sampler(mocks);
 
-    json ijson = {{"run", "clear_io_access_log"}};
+    json ijson = {{"run", "sample_page_ages"}};
     json ojson = {};
 
     g_deny_all = false;
     g_log_denials = true;
 
     ehlr->clear_denials();
+    ehlr->set_page_age_sampler(sampler);
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
@@ -1326,19 +5920,21 @@ eapis_ut::test_handle_vmcall_json_io_instruction_clear_io_access_log_logged()
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_clear_io_access_log_denied()
+eapis_ut::test_handle_vmcall_json_page_age_sample_page_ages_denied()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
+    auto &&sampler = setup_sampler(mocks);
 
-    json ijson = {{"run", "clear_io_access_log"}};
+    json ijson = {{"run", "sample_page_ages"}};
     json ojson = {};
 
     g_deny_all = true;
     g_log_denials = false;
 
     ehlr->clear_denials();
+    ehlr->set_page_age_sampler(sampler);
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
@@ -1348,531 +5944,465 @@ eapis_ut::test_handle_vmcall_json_io_instruction_clear_io_access_log_denied()
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_io_access_log_allowed()
+eapis_ut::test_handle_vmcall_json_page_age_page_age_histogram_allowed()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
+    auto &&sampler = setup_sampler(mocks);
 
-    json ijson = {{"get", "io_access_log"}};
+    json ijson = {{"get", "page_age_histogram"}};
     json ojson = {};
 
     g_deny_all = false;
     g_log_denials = false;
 
     ehlr->clear_denials();
-    ehlr->m_io_access_log[42] = 42;
+    ehlr->set_page_age_sampler(sampler);
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
         this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
-        this->expect_true(ojson.dump() == "{\"0x2A\":42}");
+        this->expect_true(ojson.dump() == "[42,1,0,0,0,0,0,0,2]");
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_io_access_log_logged()
+eapis_ut::test_handle_vmcall_json_page_age_page_age_histogram_logged()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
+    auto &&sampler = setup_sampler(mocks);
 
-    json ijson = {{"get", "io_access_log"}};
+    json ijson = {{"get", "page_age_histogram"}};
     json ojson = {};
 
     g_deny_all = false;
     g_log_denials = true;
 
     ehlr->clear_denials();
-    ehlr->m_io_access_log[42] = 42;
+    ehlr->set_page_age_sampler(sampler);
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
         this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
-        this->expect_true(ojson.dump() == "{\"0x2A\":42}");
+        this->expect_true(ojson.dump() == "[42,1,0,0,0,0,0,0,2]");
         this->expect_true(ehlr->m_denials.size() == 1);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_io_instruction_io_access_log_denied()
+eapis_ut::test_handle_vmcall_json_page_age_page_age_histogram_denied()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
+    auto &&sampler = setup_sampler(mocks);
 
-    json ijson = {{"get", "io_access_log"}};
+    json ijson = {{"get", "page_age_histogram"}};
     json ojson = {};
 
     g_deny_all = true;
     g_log_denials = false;
 
     ehlr->clear_denials();
-    ehlr->m_io_access_log[42] = 42;
+    ehlr->set_page_age_sampler(sampler);
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
         this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ree);
-        this->expect_true(ojson.dump() != "{\"0x2A\":42}");
+        this->expect_true(ojson.dump() != "[42,1,0,0,0,0,0,0,2]");
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_registers_vpid_unknown()
+eapis_ut::test_handle_vmcall_json_page_age_cold_ranges_missing_count()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
+    auto &&sampler = setup_sampler(mocks);
 
-    vmcall_registers_t regs = {};
-    regs.r02 = eapis_cat__vpid;
-    regs.r03 = 0xDEADBEEF;
+    json ijson = {{"get", "cold_ranges"}};
+    json ojson = {};
+
+    ehlr->set_page_age_sampler(sampler);
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ore);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_registers_vpid_enable_vpid_allowed()
+eapis_ut::test_handle_vmcall_json_page_age_cold_ranges_allowed()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
+    auto &&sampler = setup_sampler(mocks);
 
-    vmcall_registers_t regs = {};
-    regs.r02 = eapis_cat__vpid;
-    regs.r03 = eapis_fun__enable_vpid;
+    json ijson = {{"get", "cold_ranges"}, {"count", 1}};
+    json ojson = {};
 
-    g_enable_vpid = false;
     g_deny_all = false;
     g_log_denials = false;
 
     ehlr->clear_denials();
+    ehlr->set_page_age_sampler(sampler);
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
-        this->expect_true(g_enable_vpid);
-        this->expect_true(ehlr->m_denials.empty());
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "[{\"age\":42,\"gpa\":\"0x1000\",\"size\":\"0x2000\"}]");
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_registers_vpid_enable_vpid_logged()
+eapis_ut::test_handle_vmcall_json_page_age_cold_ranges_logged()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
+    auto &&sampler = setup_sampler(mocks);
 
-    vmcall_registers_t regs = {};
-    regs.r02 = eapis_cat__vpid;
-    regs.r03 = eapis_fun__enable_vpid;
+    json ijson = {{"get", "cold_ranges"}, {"count", 1}};
+    json ojson = {};
 
-    g_enable_vpid = false;
     g_deny_all = false;
     g_log_denials = true;
 
     ehlr->clear_denials();
+    ehlr->set_page_age_sampler(sampler);
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
-        this->expect_true(g_enable_vpid);
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "[{\"age\":42,\"gpa\":\"0x1000\",\"size\":\"0x2000\"}]");
         this->expect_true(ehlr->m_denials.size() == 1);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_registers_vpid_enable_vpid_denied()
+eapis_ut::test_handle_vmcall_json_page_age_cold_ranges_denied()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
+    auto &&sampler = setup_sampler(mocks);
 
-    vmcall_registers_t regs = {};
-    regs.r02 = eapis_cat__vpid;
-    regs.r03 = eapis_fun__enable_vpid;
+    json ijson = {{"get", "cold_ranges"}, {"count", 1}};
+    json ojson = {};
 
-    g_enable_vpid = false;
     g_deny_all = true;
     g_log_denials = false;
 
     ehlr->clear_denials();
+    ehlr->set_page_age_sampler(sampler);
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
-        this->expect_false(g_enable_vpid);
-        this->expect_true(ehlr->m_denials.empty());
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[{\"age\":42,\"gpa\":\"0x1000\",\"size\":\"0x2000\"}]");
     });
 }
 
+#if ENABLE_EXIT_STATS
+
 void
-eapis_ut::test_handle_vmcall_registers_vpid_disable_vpid_allowed()
+eapis_ut::test_handle_vmcall_json_exit_stats_exit_stats_allowed()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    vmcall_registers_t regs = {};
-    regs.r02 = eapis_cat__vpid;
-    regs.r03 = eapis_fun__disable_vpid;
+    json ijson = {{"get", "exit_stats"}};
+    json ojson = {};
 
-    g_enable_vpid = true;
     g_deny_all = false;
     g_log_denials = false;
 
     ehlr->clear_denials();
 
+    exit_stats_intel_x64::clear_all();
+    ehlr->m_exit_stats.record(0x20, 100);
+
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
-        this->expect_false(g_enable_vpid);
-        this->expect_true(ehlr->m_denials.empty());
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson["0x20"]["count"] == 1);
+        this->expect_true(ojson["0x20"]["ticks"] == 100);
+        this->expect_true(ojson["0x20"]["histogram"][7] == 1);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_registers_vpid_disable_vpid_logged()
+eapis_ut::test_handle_vmcall_json_exit_stats_exit_stats_logged()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    vmcall_registers_t regs = {};
-    regs.r02 = eapis_cat__vpid;
-    regs.r03 = eapis_fun__disable_vpid;
+    json ijson = {{"get", "exit_stats"}};
+    json ojson = {};
 
-    g_enable_vpid = true;
     g_deny_all = false;
     g_log_denials = true;
 
     ehlr->clear_denials();
 
+    exit_stats_intel_x64::clear_all();
+    ehlr->m_exit_stats.record(0x20, 100);
+
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_registers(regs); });
-        this->expect_false(g_enable_vpid);
+        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson["0x20"]["count"] == 1);
+        this->expect_true(ojson["0x20"]["ticks"] == 100);
+        this->expect_true(ojson["0x20"]["histogram"][7] == 1);
         this->expect_true(ehlr->m_denials.size() == 1);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_registers_vpid_disable_vpid_denied()
+eapis_ut::test_handle_vmcall_json_exit_stats_exit_stats_denied()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    vmcall_registers_t regs = {};
-    regs.r02 = eapis_cat__vpid;
-    regs.r03 = eapis_fun__disable_vpid;
+    json ijson = {{"get", "exit_stats"}};
+    json ojson = {};
 
-    g_enable_vpid = true;
     g_deny_all = true;
     g_log_denials = false;
 
     ehlr->clear_denials();
 
-    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
-    {
-        this->expect_exception([&]{ ehlr->handle_vmcall_registers(regs); }, ""_ut_ree);
-        this->expect_true(g_enable_vpid);
-        this->expect_true(ehlr->m_denials.empty());
-    });
-}
-
-void
-eapis_ut::test_handle_vmcall_json_vpid_enable_vpid_missing_enabled()
-{
-    MockRepository mocks;
-    auto &&vmcs = setup_vmcs(mocks, 0x0);
-    auto &&ehlr = setup_ehlr(vmcs);
-
-    json ijson = {{"set", "vpid"}};
-    json ojson = {};
-
-    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
-    {
-        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_ore);
-    });
-}
-
-void
-eapis_ut::test_handle_vmcall_json_vpid_enable_vpid_invalid_enabled()
-{
-    MockRepository mocks;
-    auto &&vmcs = setup_vmcs(mocks, 0x0);
-    auto &&ehlr = setup_ehlr(vmcs);
-
-    json ijson = {{"set", "vpid"}, {"enabled", "not a bool"}};
-    json ojson = {};
+    exit_stats_intel_x64::clear_all();
+    ehlr->m_exit_stats.record(0x20, 100);
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_dme);
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.count("0x20") == 0);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_vpid_enable_vpid_allowed()
+eapis_ut::test_handle_vmcall_json_exit_stats_clear_exit_stats_allowed()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson = {{"set", "vpid"}, {"enabled", false}};
+    json ijson = {{"run", "clear_exit_stats"}};
     json ojson = {};
 
-    g_enable_vpid = true;
     g_deny_all = false;
     g_log_denials = false;
 
     ehlr->clear_denials();
+    ehlr->m_exit_stats.record(0x20, 100);
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
         this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
-        this->expect_true(ojson.dump() == "[\"success\"]");
-        this->expect_false(g_enable_vpid);
+        this->expect_true(ehlr->m_exit_stats.stats(0x20).count == 0);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_vpid_enable_vpid_logged()
+eapis_ut::test_handle_vmcall_json_exit_stats_clear_exit_stats_logged()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson = {{"set", "vpid"}, {"enabled", false}};
+    json ijson = {{"run", "clear_exit_stats"}};
     json ojson = {};
 
-    g_enable_vpid = true;
     g_deny_all = false;
     g_log_denials = true;
 
     ehlr->clear_denials();
+    ehlr->m_exit_stats.record(0x20, 100);
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
         this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
-        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(ehlr->m_exit_stats.stats(0x20).count == 0);
         this->expect_true(ehlr->m_denials.size() == 1);
-        this->expect_false(g_enable_vpid);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_vpid_enable_vpid_denied()
+eapis_ut::test_handle_vmcall_json_exit_stats_clear_exit_stats_denied()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson = {{"set", "vpid"}, {"enabled", false}};
+    json ijson = {{"run", "clear_exit_stats"}};
     json ojson = {};
 
-    g_enable_vpid = true;
     g_deny_all = true;
     g_log_denials = false;
 
     ehlr->clear_denials();
+    ehlr->m_exit_stats.record(0x20, 100);
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
         this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ree);
-        this->expect_true(ojson.dump() != "[\"success\"]");
-        this->expect_true(g_enable_vpid);
+        this->expect_true(ehlr->m_exit_stats.stats(0x20).count == 1);
     });
 }
 
-void
-eapis_ut::test_handle_vmcall_json_verifiers_clear_denials_allowed()
-{
-    MockRepository mocks;
-    auto &&vmcs = setup_vmcs(mocks, 0x0);
-    auto &&ehlr = setup_ehlr(vmcs);
-
-    json ijson = {{"run", "clear_denials"}};
-    json ojson = {};
-
-    g_deny_all = false;
-    g_log_denials = false;
-    ehlr->m_denials.push_back("fake denial");
-
-    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
-    {
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
-        this->expect_true(ojson.dump() == "[\"success\"]");
-        this->expect_true(ehlr->m_denials.empty());
-    });
-}
+#endif
 
 void
-eapis_ut::test_handle_vmcall_json_verifiers_clear_denials_logged()
+eapis_ut::test_handle_vmcall_json_exit_stats_trace_exits_unaligned()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson = {{"run", "clear_denials"}};
+    json ijson = {{"set", "trace_exits"}, {"gpa", 0x1001}};
     json ojson = {};
 
     g_deny_all = false;
-    g_log_denials = true;
-    ehlr->m_denials.push_back("fake denial");
-
-    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
-    {
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
-        this->expect_true(ojson.dump() == "[\"success\"]");
-        this->expect_true(ehlr->m_denials.empty());
-    });
-}
-
-void
-eapis_ut::test_handle_vmcall_json_verifiers_clear_denials_denied()
-{
-    MockRepository mocks;
-    auto &&vmcs = setup_vmcs(mocks, 0x0);
-    auto &&ehlr = setup_ehlr(vmcs);
-
-    json ijson = {{"run", "clear_denials"}};
-    json ojson = {};
-
-    g_deny_all = true;
     g_log_denials = false;
-    ehlr->m_denials.push_back("fake denial");
+
+    ehlr->clear_denials();
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ree);
-        this->expect_true(ojson.dump() != "[\"success\"]");
-        this->expect_true(ehlr->m_denials.size() == 1);
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_ree);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_verifiers_dump_policy_allowed()
+eapis_ut::test_handle_vmcall_json_exit_stats_trace_exits_allowed()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson = {{"dump", "policy"}};
+    json ijson = {{"set", "trace_exits"}, {"gpa", 0}, {"overwrite", true}};
     json ojson = {};
 
     g_deny_all = false;
     g_log_denials = false;
 
+    ehlr->clear_denials();
+
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
         this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_verifiers_dump_policy_logged()
+eapis_ut::test_handle_vmcall_json_exit_stats_trace_exits_logged()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson = {{"dump", "policy"}};
+    json ijson = {{"set", "trace_exits"}, {"gpa", 0}, {"overwrite", true}};
     json ojson = {};
 
     g_deny_all = false;
     g_log_denials = true;
 
+    ehlr->clear_denials();
+
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
         this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
+        this->expect_true(ojson.dump() == "[\"success\"]");
+        this->expect_true(ehlr->m_denials.size() == 1);
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_verifiers_dump_policy_denied()
+eapis_ut::test_handle_vmcall_json_exit_stats_trace_exits_denied()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
 
-    json ijson = {{"dump", "policy"}};
+    json ijson = {{"set", "trace_exits"}, {"gpa", 0}, {"overwrite", true}};
     json ojson = {};
 
     g_deny_all = true;
     g_log_denials = false;
 
+    ehlr->clear_denials();
+
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
         this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ree);
+        this->expect_true(ojson.dump() != "[\"success\"]");
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_verifiers_dump_denials_allowed()
+eapis_ut::test_handle_vmcall_json_exit_stats_trace_exits_read_only()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
+    auto &&ept = setup_ept(mocks, vmcs);
+    auto &&merger = std::make_unique<page_merger_intel_x64>(vmcs);
 
-    json ijson = {{"dump", "denials"}};
+    setup_guest_page(ept.get(), false);
+    ehlr->set_page_merger(merger.get());
+
+    json ijson = {{"set", "trace_exits"}, {"gpa", g_guest_page}, {"overwrite", true}};
     json ojson = {};
 
     g_deny_all = false;
     g_log_denials = false;
-    ehlr->m_denials.push_back("fake denial");
-
-    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
-    {
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
-        this->expect_true(ojson.dump() == "[\"fake denial\"]");
-        this->expect_true(ehlr->m_denials.size() == 1);
-    });
-}
-
-void
-eapis_ut::test_handle_vmcall_json_verifiers_dump_denials_logged()
-{
-    MockRepository mocks;
-    auto &&vmcs = setup_vmcs(mocks, 0x0);
-    auto &&ehlr = setup_ehlr(vmcs);
-
-    json ijson = {{"dump", "denials"}};
-    json ojson = {};
 
-    g_deny_all = false;
-    g_log_denials = true;
-    ehlr->m_denials.push_back("fake denial");
+    ehlr->clear_denials();
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_no_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); });
-        this->expect_true(ehlr->m_denials.size() == 2);
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_ree);
+        this->expect_true(ehlr->m_exit_trace_gpa == 0);
+        this->expect_true(merger->m_pinned.empty());
     });
 }
 
 void
-eapis_ut::test_handle_vmcall_json_verifiers_dump_denials_denied()
+eapis_ut::test_handle_vmcall_json_exit_stats_trace_exits_merged()
 {
     MockRepository mocks;
     auto &&vmcs = setup_vmcs(mocks, 0x0);
     auto &&ehlr = setup_ehlr(vmcs);
+    auto &&ept = setup_ept(mocks, vmcs);
+    auto &&merger = std::make_unique<page_merger_intel_x64>(vmcs);
 
-    json ijson = {{"dump", "denials"}};
+    setup_guest_page(ept.get(), false);
+    ehlr->set_page_merger(merger.get());
+    merger->m_merged[g_guest_page] = 0x00000000ABCDE000UL;
+
+    json ijson = {{"set", "trace_exits"}, {"gpa", g_guest_page}, {"overwrite", true}};
     json ojson = {};
 
-    g_deny_all = true;
+    g_deny_all = false;
     g_log_denials = false;
-    ehlr->m_denials.push_back("fake denial");
+
+    ehlr->clear_denials();
 
     RUN_UNITTEST_WITH_MOCKS(mocks, [&]
     {
-        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); },  ""_ut_ree);
-        this->expect_true(ojson.dump() != "[\"fake denial\"]");
-        this->expect_true(ehlr->m_denials.size() == 1);
+        this->expect_exception([&]{ ehlr->handle_vmcall_data_string_json(ijson, ojson); }, ""_ut_ree);
+        this->expect_true(ehlr->m_exit_trace_gpa == 0);
+        this->expect_true(merger->m_pinned.empty());
     });
 }
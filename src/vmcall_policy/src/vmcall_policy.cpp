@@ -23,6 +23,9 @@
 #include <exit_handler/exit_handler_intel_x64_eapis_verifiers.h>
 #include <exit_handler/exit_handler_intel_x64_eapis_io_instruction_verifiers.h>
 #include <exit_handler/exit_handler_intel_x64_eapis_vpid_verifiers.h>
+#include <exit_handler/exit_handler_intel_x64_eapis_page_age_verifiers.h>
+#include <exit_handler/exit_handler_intel_x64_eapis_msr_verifiers.h>
+#include <exit_handler/exit_handler_intel_x64_eapis_exit_stats_verifiers.h>
 
 void
 exit_handler_intel_x64_eapis::init_policy()
@@ -40,6 +43,41 @@ exit_handler_intel_x64_eapis::init_policy()
     m_verifiers[vp::index_log_io_access] = std::make_unique<default_verifier__log_io_access>();
     m_verifiers[vp::index_clear_io_access_log] = std::make_unique<default_verifier__clear_io_access_log>();
     m_verifiers[vp::index_io_access_log] = std::make_unique<default_verifier__io_access_log>();
+    m_verifiers[vp::index_trace_io_access] = std::make_unique<default_verifier__trace_io_access>();
+    m_verifiers[vp::index_trap_on_io_range] = std::make_unique<default_verifier__trap_on_io_range>();
+    m_verifiers[vp::index_pass_through_io_range] = std::make_unique<default_verifier__pass_through_io_range>();
+    m_verifiers[vp::index_share_io_bitmaps] = std::make_unique<default_verifier__share_io_bitmaps>();
+    m_verifiers[vp::index_io_storm_policy] = std::make_unique<default_verifier__io_storm_policy>();
+    m_verifiers[vp::index_io_storms] = std::make_unique<default_verifier__io_storms>();
+    m_verifiers[vp::index_emulate_uart] = std::make_unique<default_verifier__emulate_uart>();
+    m_verifiers[vp::index_uart_output] = std::make_unique<default_verifier__uart_output>();
 
     m_verifiers[vp::index_enable_vpid] = std::make_unique<default_verifier__enable_vpid>();
+
+    m_verifiers[vp::index_sample_page_ages] = std::make_unique<default_verifier__sample_page_ages>();
+    m_verifiers[vp::index_page_age_histogram] = std::make_unique<default_verifier__page_age_histogram>();
+    m_verifiers[vp::index_cold_ranges] = std::make_unique<default_verifier__cold_ranges>();
+
+    m_verifiers[vp::index_trap_on_rdmsr_access] = std::make_unique<default_verifier__trap_on_rdmsr_access>();
+    m_verifiers[vp::index_trap_on_wrmsr_access] = std::make_unique<default_verifier__trap_on_wrmsr_access>();
+    m_verifiers[vp::index_trap_on_all_rdmsr_accesses] = std::make_unique<default_verifier__trap_on_all_rdmsr_accesses>();
+    m_verifiers[vp::index_trap_on_all_wrmsr_accesses] = std::make_unique<default_verifier__trap_on_all_wrmsr_accesses>();
+    m_verifiers[vp::index_pass_through_rdmsr_access] = std::make_unique<default_verifier__pass_through_rdmsr_access>();
+    m_verifiers[vp::index_pass_through_wrmsr_access] = std::make_unique<default_verifier__pass_through_wrmsr_access>();
+    m_verifiers[vp::index_pass_through_all_rdmsr_accesses] = std::make_unique<default_verifier__pass_through_all_rdmsr_accesses>();
+    m_verifiers[vp::index_pass_through_all_wrmsr_accesses] = std::make_unique<default_verifier__pass_through_all_wrmsr_accesses>();
+    m_verifiers[vp::index_whitelist_rdmsr_access] = std::make_unique<default_verifier__whitelist_rdmsr_access>();
+    m_verifiers[vp::index_whitelist_wrmsr_access] = std::make_unique<default_verifier__whitelist_wrmsr_access>();
+    m_verifiers[vp::index_blacklist_rdmsr_access] = std::make_unique<default_verifier__blacklist_rdmsr_access>();
+    m_verifiers[vp::index_blacklist_wrmsr_access] = std::make_unique<default_verifier__blacklist_wrmsr_access>();
+    m_verifiers[vp::index_log_msr_access] = std::make_unique<default_verifier__log_msr_access>();
+    m_verifiers[vp::index_clear_msr_access_log] = std::make_unique<default_verifier__clear_msr_access_log>();
+    m_verifiers[vp::index_msr_access_log] = std::make_unique<default_verifier__msr_access_log>();
+
+#if ENABLE_EXIT_STATS
+    m_verifiers[vp::index_exit_stats] = std::make_unique<default_verifier__exit_stats>();
+    m_verifiers[vp::index_clear_exit_stats] = std::make_unique<default_verifier__clear_exit_stats>();
+#endif
+
+    m_verifiers[vp::index_trace_exits] = std::make_unique<default_verifier__trace_exits>();
 }
@@ -67,9 +67,17 @@ NATIVE_OUTDIR+=%BUILD_REL%/../bin
 SOURCES+=vmcs_intel_x64_eapis.cpp
 SOURCES+=vmcs_intel_x64_eapis_ept.cpp
 SOURCES+=vmcs_intel_x64_eapis_io.cpp
+SOURCES+=vmcs_intel_x64_eapis_msr.cpp
+SOURCES+=vmcs_intel_x64_eapis_auto_msr.cpp
 SOURCES+=vmcs_intel_x64_eapis_vpid.cpp
+SOURCES+=vmcs_intel_x64_eapis_spp.cpp
 SOURCES+=ept_intel_x64.cpp
 SOURCES+=ept_entry_intel_x64.cpp
+SOURCES+=spp_intel_x64.cpp
+SOURCES+=page_merger_intel_x64.cpp
+SOURCES+=page_age_sampler_intel_x64.cpp
+SOURCES+=io_bitmaps_intel_x64.cpp
+SOURCES+=vpid_allocator_intel_x64.cpp
 
 INCLUDE_PATHS+=../../../include
 INCLUDE_PATHS+=%HYPER_ABS%/include/
@@ -123,6 +123,14 @@ void
 ept_entry_intel_x64::set_suppress_ve(bool enabled) noexcept
 { *m_epte = enabled ? set_bit(*m_epte, 63) : clear_bit(*m_epte, 63); }
 
+bool
+ept_entry_intel_x64::sub_page_write_permissions() const noexcept
+{ return is_bit_set(*m_epte, 61); }
+
+void
+ept_entry_intel_x64::set_sub_page_write_permissions(bool enabled) noexcept
+{ *m_epte = enabled ? set_bit(*m_epte, 61) : clear_bit(*m_epte, 61); }
+
 void
 ept_entry_intel_x64::trap_on_access() noexcept
 {
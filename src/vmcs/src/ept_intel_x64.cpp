@@ -26,9 +26,10 @@
 using namespace x64;
 using namespace intel_x64;
 
-ept_intel_x64::ept_intel_x64(pointer epte) :
+ept_intel_x64::ept_intel_x64(pointer epte, integer_pointer bits) :
     ept_entry_intel_x64(epte != nullptr ? epte : (&m_bitbucket)),
     m_size(0),
+    m_bits(bits),
     m_bitbucket(0),
     m_eptes(ept::num_entries)
 {
@@ -56,11 +57,20 @@ ept_intel_x64::global_size() const noexcept
     return size;
 }
 
-template<class T> std::unique_ptr<T>
-ept_intel_x64::add_epte(pointer p)
+ept_intel_x64::integer_pointer
+ept_intel_x64::check_gpa(integer_pointer addr) const
+{
+    if (addr >= this->max_gpa())
+        throw std::runtime_error("invalid address: exceeds the page walk length");
+
+    return addr;
+}
+
+template<class T, class... Args> std::unique_ptr<T>
+ept_intel_x64::add_epte(pointer p, Args &&... args)
 {
     m_size++;
-    return std::make_unique<T>(p);
+    return std::make_unique<T>(p, std::forward<Args>(args)...);
 }
 
 template<class T> std::unique_ptr<T>
@@ -80,7 +90,7 @@ ept_intel_x64::add_page(
     {
         auto &&iter = bfn::find(m_eptes, index);
         if (!*iter)
-            *iter = add_epte<ept_intel_x64>(&m_ept.at(index));
+            *iter = add_epte<ept_intel_x64>(&m_ept.at(index), bits - ept::pt::size);
 
         if (auto epte = dynamic_cast<ept_intel_x64 *>(iter->get()))
             return epte->add_page(addr, bits - ept::pt::size, end_bits);
@@ -0,0 +1,126 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <algorithm>
+
+#include <bitmanip_ext.h>
+#include <vmcs/io_bitmaps_intel_x64.h>
+
+// Each IO bitmap covers 0x8000 ports, and port "n" is bit "n % 64" of the
+// 64bit word "n / 64". Ranges are applied one word at a time, with only
+// the first and last words needing a mask.
+constexpr const auto ports_per_bitmap = 0x8000U;
+
+static void
+fill_io_bitmap(uint8_t *bitmap, uint32_t first, uint32_t last, bool trap)
+{
+    auto &&words = reinterpret_cast<uint64_t *>(bitmap);
+
+    auto &&first_word = first >> 6;
+    auto &&last_word = last >> 6;
+    auto &&first_mask = ~0UL << (first & 63);
+    auto &&last_mask = ~0UL >> (63 - (last & 63));
+
+    auto &&apply = [&](uint64_t & word, uint64_t mask)
+    { word = trap ? (word | mask) : (word & ~mask); };
+
+    if (first_word == last_word)
+    {
+        apply(words[first_word], first_mask & last_mask);
+        return;
+    }
+
+    apply(words[first_word], first_mask);
+    apply(words[last_word], last_mask);
+
+    if (last_word - first_word > 1)
+    {
+        __builtin_memset(&words[first_word + 1], trap ? 0xFF : 0,
+                         (last_word - first_word - 1) * sizeof(uint64_t));
+    }
+}
+
+io_bitmaps_intel_x64::io_bitmaps_intel_x64() :
+    m_bitmapa{std::make_unique<uint8_t[]>(x64::page_size)},
+    m_bitmapb{std::make_unique<uint8_t[]>(x64::page_size)},
+    m_bitmapa_view{m_bitmapa, x64::page_size},
+    m_bitmapb_view{m_bitmapb, x64::page_size}
+{ }
+
+std::shared_ptr<io_bitmaps_intel_x64>
+io_bitmaps_intel_x64::clone() const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    auto &&bitmaps = std::make_shared<io_bitmaps_intel_x64>();
+
+    __builtin_memcpy(bitmaps->m_bitmapa.get(), m_bitmapa.get(), x64::page_size);
+    __builtin_memcpy(bitmaps->m_bitmapb.get(), m_bitmapb.get(), x64::page_size);
+
+    return bitmaps;
+}
+
+void
+io_bitmaps_intel_x64::trap_on_io_access(port_type port)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    if (port < ports_per_bitmap)
+        set_bit_from_span(m_bitmapa_view, port);
+    else
+        set_bit_from_span(m_bitmapb_view, port - ports_per_bitmap);
+}
+
+void
+io_bitmaps_intel_x64::pass_through_io_access(port_type port)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    if (port < ports_per_bitmap)
+        clear_bit_from_span(m_bitmapa_view, port);
+    else
+        clear_bit_from_span(m_bitmapb_view, port - ports_per_bitmap);
+}
+
+void
+io_bitmaps_intel_x64::trap_on_io_range(port_type first, port_type last)
+{
+    expects(first <= last);
+    this->fill(first, last, true);
+}
+
+void
+io_bitmaps_intel_x64::pass_through_io_range(port_type first, port_type last)
+{
+    expects(first <= last);
+    this->fill(first, last, false);
+}
+
+void
+io_bitmaps_intel_x64::fill(uint32_t first, uint32_t last, bool trap)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    if (first < ports_per_bitmap)
+        fill_io_bitmap(m_bitmapa.get(), first, std::min(last, ports_per_bitmap - 1), trap);
+
+    if (last >= ports_per_bitmap)
+        fill_io_bitmap(m_bitmapb.get(), std::max(first, ports_per_bitmap) - ports_per_bitmap, last - ports_per_bitmap, trap);
+}
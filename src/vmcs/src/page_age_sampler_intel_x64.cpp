@@ -0,0 +1,402 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <algorithm>
+
+#include <vmcs/page_age_sampler_intel_x64.h>
+#include <vmcs/vmcs_intel_x64_64bit_control_fields.h>
+
+#include <intrinsics/vmx_intel_x64.h>
+
+using namespace intel_x64;
+using namespace vmcs;
+
+constexpr const page_age_sampler_intel_x64::age_type page_age_sampler_intel_x64::max_age;
+constexpr const page_age_sampler_intel_x64::age_type page_age_sampler_intel_x64::not_present;
+
+page_age_sampler_intel_x64::page_age_sampler_intel_x64(
+    gsl::not_null<vmcs_intel_x64_eapis *> vmcs, size_type pages_per_tick) :
+    m_vmcs(vmcs),
+    m_pages_per_tick(pages_per_tick),
+    m_saddr(0),
+    m_eaddr(ept::page_walk::max_gpa),
+    m_cursor(0),
+    m_histogram{}
+{ }
+
+void
+page_age_sampler_intel_x64::set_range(integer_pointer saddr, integer_pointer eaddr)
+{
+    expects(saddr < eaddr);
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    this->forget(0, saddr);
+    this->forget(eaddr, ~0UL);
+
+    m_saddr = saddr;
+    m_eaddr = eaddr;
+    m_cursor = saddr;
+}
+
+void
+page_age_sampler_intel_x64::set_flush_delegate(flush_delegate_type delegate)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_flush_delegate = std::move(delegate);
+}
+
+bool
+page_age_sampler_intel_x64::tick()
+{
+    if (!ept_pointer::accessed_and_dirty_flags::is_enabled())
+        throw std::logic_error("tick failed: the EPT accessed / dirty flags are disabled");
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    // Until every vCPU has flushed the translations that were cached
+    // before the previous tick cleared the accessed bits, these vCPUs
+    // would not set them again, and the pages would be aged while in use.
+
+    if (!this->flushed())
+        return false;
+
+    auto flush = false;
+    auto pages = 0UL;
+    auto next = m_cursor;
+
+    auto &&finished = m_vmcs->visit_epte_range(m_cursor, m_eaddr, [&](auto gpa, auto size, auto epte)
+    {
+        if (pages++ == m_pages_per_tick)
+            return false;
+
+        // Anything between the previous page and this page is no longer
+        // mapped, and is therefore no longer tracked.
+
+        this->forget(next, gpa);
+
+        auto &&accessed = epte->accessed();
+        if (accessed)
+        {
+            epte->set_accessed(false);
+            flush = true;
+        }
+
+        this->update(gpa, size, accessed);
+
+        next = gpa + size;
+        return true;
+    });
+
+    if (flush)
+        this->flush();
+
+    if (!finished)
+    {
+        m_cursor = next;
+        return false;
+    }
+
+    this->forget(next, m_eaddr);
+    m_cursor = m_saddr;
+
+    return true;
+}
+
+page_age_sampler_intel_x64::age_type
+page_age_sampler_intel_x64::age(integer_pointer gpa) const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    auto &&iter = m_tables.find(gpa & ~(ept::pd::size_bytes - 1));
+    if (iter != m_tables.end())
+    {
+        auto &&age = iter->second->ages.at(ept::index(gpa, ept::pt::from));
+        if (age != not_present)
+            return age;
+    }
+
+    auto &&large = m_large.upper_bound(gpa);
+    if (large != m_large.begin())
+    {
+        --large;
+
+        if (gpa < large->first + large->second.size)
+            return large->second.age;
+    }
+
+    throw std::runtime_error("age: page has not been sampled");
+}
+
+page_age_sampler_intel_x64::histogram_type
+page_age_sampler_intel_x64::histogram() const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_histogram;
+}
+
+page_age_sampler_intel_x64::range_list_type
+page_age_sampler_intel_x64::cold_ranges(size_type count) const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    range_list_type ranges;
+    range_type range = {0, 0, 0};
+
+    auto &&add = [&](integer_pointer gpa, size_type size, age_type age)
+    {
+        // Hot pages (age 0) are never part of a cold range.
+
+        if (age == not_present || age == 0)
+            return;
+
+        if (range.size != 0 && range.gpa + range.size == gpa && bucket(range.age) == bucket(age))
+        {
+            range.size += size;
+            range.age = std::min(range.age, age);
+
+            return;
+        }
+
+        if (range.size != 0)
+            ranges.push_back(range);
+
+        range = {gpa, size, age};
+    };
+
+    // A 2M region is either covered by a table of 4k pages, or by a large
+    // page, so both can be walked in order of guest physical address.
+
+    auto &&large = m_large.begin();
+
+    for (const auto &pair : m_tables)
+    {
+        for (; large != m_large.end() && large->first < pair.first; ++large)
+            add(large->first, large->second.size, large->second.age);
+
+        for (auto index = 0UL; index < ept::num_entries; index++)
+            add(pair.first + (index << ept::pt::from), ept::pt::size_bytes, pair.second->ages[index]);
+    }
+
+    for (; large != m_large.end(); ++large)
+        add(large->first, large->second.size, large->second.age);
+
+    if (range.size != 0)
+        ranges.push_back(range);
+
+    auto &&colder = [](const range_type & lhs, const range_type & rhs)
+    {
+        if (lhs.age != rhs.age)
+            return lhs.age > rhs.age;
+
+        if (lhs.size != rhs.size)
+            return lhs.size > rhs.size;
+
+        return lhs.gpa < rhs.gpa;
+    };
+
+    count = std::min(count, ranges.size());
+
+    std::partial_sort(ranges.begin(), ranges.begin() + gsl::narrow_cast<std::ptrdiff_t>(count), ranges.end(), colder);
+    ranges.resize(count);
+
+    return ranges;
+}
+
+page_age_sampler_intel_x64::size_type
+page_age_sampler_intel_x64::bucket(age_type age) noexcept
+{
+    size_type bucket = 0;
+
+    while (age != 0)
+    {
+        bucket++;
+        age >>= 1;
+    }
+
+    return bucket;
+}
+
+page_age_sampler_intel_x64::age_type
+page_age_sampler_intel_x64::next_age(age_type age, bool accessed) noexcept
+{
+    // The accessed bit of a page that has not been seen before has not
+    // been cleared by a previous pass, so if it is clear, the page has at
+    // least not been touched since it was mapped.
+
+    if (age == not_present)
+        return accessed ? 0 : 1;
+
+    if (accessed)
+        return 0;
+
+    return age < max_age ? age + 1 : age;
+}
+
+void
+page_age_sampler_intel_x64::update(integer_pointer gpa, size_type size, bool accessed)
+{
+    auto &&saddr = std::max(gpa, m_saddr);
+    auto &&eaddr = std::min(gpa + size, m_eaddr);
+
+    if (saddr >= eaddr)
+        return;
+
+    // A range of guest physical memory that was remapped using a different
+    // page size is forgotten, and starts over.
+
+    if (size == ept::pt::size_bytes)
+    {
+        this->forget_large(saddr, eaddr);
+        this->update_page(saddr, accessed);
+    }
+    else
+    {
+        this->forget_pages(saddr, eaddr);
+        this->update_large(saddr, eaddr - saddr, accessed);
+    }
+}
+
+void
+page_age_sampler_intel_x64::update_page(integer_pointer gpa, bool accessed)
+{
+    auto &&table = m_tables[gpa & ~(ept::pd::size_bytes - 1)];
+    if (!table)
+    {
+        table = std::make_unique<table_type>();
+        table->ages.fill(not_present);
+        table->present = 0;
+    }
+
+    auto &&age = table->ages[ept::index(gpa, ept::pt::from)];
+
+    if (age == not_present)
+        table->present++;
+    else
+        m_histogram[bucket(age)]--;
+
+    age = next_age(age, accessed);
+    m_histogram[bucket(age)]++;
+}
+
+void
+page_age_sampler_intel_x64::update_large(integer_pointer gpa, size_type size, bool accessed)
+{
+    auto &&pages = size >> ept::pt::from;
+    auto &&iter = m_large.find(gpa);
+
+    if (iter == m_large.end() || iter->second.size != size)
+    {
+        this->forget_large(gpa, gpa + size);
+        iter = m_large.emplace(gpa, large_type{size, not_present}).first;
+    }
+    else
+    {
+        m_histogram[bucket(iter->second.age)] -= pages;
+    }
+
+    iter->second.age = next_age(iter->second.age, accessed);
+    m_histogram[bucket(iter->second.age)] += pages;
+}
+
+void
+page_age_sampler_intel_x64::forget(integer_pointer saddr, integer_pointer eaddr)
+{
+    this->forget_pages(saddr, eaddr);
+    this->forget_large(saddr, eaddr);
+}
+
+void
+page_age_sampler_intel_x64::forget_pages(integer_pointer saddr, integer_pointer eaddr)
+{
+    if (saddr >= eaddr)
+        return;
+
+    auto &&iter = m_tables.lower_bound(saddr & ~(ept::pd::size_bytes - 1));
+
+    while (iter != m_tables.end() && iter->first < eaddr)
+    {
+        auto &&table = iter->second;
+
+        for (auto index = 0UL; index < ept::num_entries; index++)
+        {
+            auto &&addr = iter->first + (index << ept::pt::from);
+            auto &&age = table->ages[index];
+
+            if (addr < saddr || addr >= eaddr || age == not_present)
+                continue;
+
+            m_histogram[bucket(age)]--;
+            table->present--;
+
+            age = not_present;
+        }
+
+        if (table->present == 0)
+            iter = m_tables.erase(iter);
+        else
+            ++iter;
+    }
+}
+
+void
+page_age_sampler_intel_x64::forget_large(integer_pointer saddr, integer_pointer eaddr)
+{
+    if (saddr >= eaddr)
+        return;
+
+    auto &&iter = m_large.upper_bound(saddr);
+
+    if (iter != m_large.begin())
+    {
+        auto &&prev = std::prev(iter);
+
+        if (prev->first + prev->second.size > saddr)
+            iter = prev;
+    }
+
+    while (iter != m_large.end() && iter->first < eaddr)
+    {
+        m_histogram[bucket(iter->second.age)] -= iter->second.size >> ept::pt::from;
+        iter = m_large.erase(iter);
+    }
+}
+
+void
+page_age_sampler_intel_x64::flush()
+{
+    if (!m_flush_delegate)
+    {
+        intel_x64::vmx::invept_global();
+        return;
+    }
+
+    m_flush = m_flush_delegate();
+}
+
+bool
+page_age_sampler_intel_x64::flushed()
+{
+    if (m_flush && m_flush->load(std::memory_order_acquire) != 0)
+        return false;
+
+    m_flush.reset();
+    return true;
+}
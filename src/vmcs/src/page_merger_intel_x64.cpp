@@ -0,0 +1,614 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <cstring>
+#include <algorithm>
+
+#include <vmcs/page_merger_intel_x64.h>
+#include <vmcs/vmcs_intel_x64_64bit_control_fields.h>
+
+#include <memory_manager/map_ptr_x64.h>
+#include <memory_manager/memory_manager_x64.h>
+
+#include <intrinsics/x64.h>
+#include <intrinsics/vmx_intel_x64.h>
+
+using namespace x64;
+using namespace intel_x64;
+using namespace vmcs;
+
+// FNV-1a (64bit), applied to the page one 64bit word at a time
+constexpr const auto fnv_offset_basis = 0xCBF29CE484222325UL;
+constexpr const auto fnv_prime = 0x00000100000001B3UL;
+constexpr const auto words_per_page = x64::page_size / sizeof(uint64_t);
+
+// Bit 1 of the exit qualification of an EPT violation is set if the
+// violation was caused by a data write (see the Intel SDM, Vol. 3,
+// Section 27.2.1, Table 27-7).
+constexpr const auto ept_violation_data_write = 0x0000000000000002UL;
+
+page_merger_intel_x64::page_merger_intel_x64(
+    gsl::not_null<vmcs_intel_x64_eapis *> vmcs, size_type pages_per_scan) :
+    m_vmcs(vmcs),
+    m_pages_per_scan(pages_per_scan),
+    m_cursor(0)
+{ }
+
+void
+page_merger_intel_x64::set_flush_delegate(flush_delegate_type delegate)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_flush_delegate = std::move(delegate);
+}
+
+page_merger_intel_x64::size_type
+page_merger_intel_x64::scan(integer_pointer saddr, integer_pointer eaddr)
+{
+    expects(saddr < eaddr);
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    if (!this->flushed())
+        return 0;
+
+    auto merged = this->merge_matches();
+
+    auto flush = false;
+    auto pages = 0UL;
+    auto &&track_dirty = ept_pointer::accessed_and_dirty_flags::is_enabled();
+
+    std::vector<candidate_type> candidates;
+
+    if (m_cursor < saddr || m_cursor >= eaddr)
+        m_cursor = saddr;
+
+    auto &&finished = m_vmcs->visit_epte_range(m_cursor, eaddr, [&](auto gpa, auto size, auto epte)
+    {
+        if (pages++ == m_pages_per_scan)
+        {
+            m_cursor = gpa;
+            return false;
+        }
+
+        if (size != ept::pt::size_bytes || m_merged.count(gpa) != 0 || m_pinned.count(gpa) != 0)
+            return true;
+
+        if (!epte->read_access() || !epte->write_access() || epte->sub_page_write_permissions())
+            return true;
+
+        // A page that has been written since the last scan is not a
+        // candidate. Its dirty bit is cleared so that the next scan can tell
+        // if the page has settled.
+
+        if (epte->dirty())
+        {
+            epte->set_dirty(false);
+            m_hashes.erase(gpa);
+
+            flush = true;
+            return true;
+        }
+
+        auto &&iter = m_hashes.find(gpa);
+
+        // If the page is clean and has already been hashed, its contents
+        // cannot have changed, so there is no need to hash it again.
+
+        if (track_dirty && iter != m_hashes.end())
+        {
+            candidates.push_back({gpa, epte->phys_addr(), iter->second});
+            return true;
+        }
+
+        auto &&phys = epte->phys_addr();
+        auto &&hash = this->hash_page(phys);
+
+        if (iter == m_hashes.end() || iter->second != hash)
+        {
+            m_hashes[gpa] = hash;
+            return true;
+        }
+
+        candidates.push_back({gpa, phys, hash});
+        return true;
+    });
+
+    if (finished)
+        m_cursor = saddr;
+
+    for (const auto &candidate : candidates)
+        this->match(candidate);
+
+    // The matches are write-protected, but until every vCPU has flushed its
+    // EPT translations, a vCPU could still write to them. If the flush
+    // completes right away, the matches are merged by this scan, otherwise
+    // they are merged by the first scan that sees the flush complete.
+
+    if (flush || !m_matches.empty() || !m_released.empty())
+    {
+        this->flush();
+        merged += this->merge_matches();
+    }
+
+    // If the flush above completed right away, the frames that were freed
+    // by merging the matches still need a flush of their own.
+
+    if (!m_released.empty() && !m_flush)
+    {
+        this->flush();
+        this->flushed();
+    }
+
+    return merged;
+}
+
+bool
+page_merger_intel_x64::handle_write_violation(integer_pointer gpa, qualification_type qualification)
+{
+    if ((qualification & ept_violation_data_write) == 0)
+        return false;
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    auto &&page = gpa & ~(ept::pt::size_bytes - 1);
+
+    if (m_protected.count(page) != 0)
+    {
+        this->unprotect(page);
+        return true;
+    }
+
+    auto &&breaking = m_breaking.find(page);
+    if (breaking != m_breaking.end())
+    {
+        // The page already has a private copy, which stays read-only until
+        // every vCPU has flushed its translations to the shared frame. The
+        // faulting instruction is retried until then.
+
+        auto &&ticket = breaking->second;
+        if (ticket && ticket->load(std::memory_order_acquire) != 0)
+            return true;
+
+        if (auto epte = this->lookup(page))
+            epte->set_write_access(true);
+
+        m_breaking.erase(breaking);
+
+        intel_x64::vmx::invept_global();
+        return true;
+    }
+
+    auto &&iter = m_merged.find(page);
+    if (iter == m_merged.end())
+    {
+        // The write access of a page is only ever removed once every vCPU
+        // has been told to flush its EPT translations. A write violation on
+        // a page that is writable can therefore only come from a stale
+        // translation that was cached before the write access was restored.
+
+        auto &&epte = this->lookup(page);
+        if (epte == nullptr || !epte->write_access())
+            return false;
+
+        intel_x64::vmx::invept_global();
+        return true;
+    }
+
+    auto &&epte = m_vmcs->gpa_to_epte(page);
+    auto shared = iter->second;
+    auto &&frame = m_frames.at(shared);
+
+    m_merged.erase(iter);
+
+    // The last user of a shared frame keeps the frame, there is nothing to
+    // copy. Everyone else gets a private copy.
+
+    if (--frame.refs == 0)
+    {
+        m_stable.erase(frame.hash);
+        m_frames.erase(shared);
+    }
+    else
+    {
+        auto &&phys = this->alloc_frame();
+
+        this->copy_page(phys, shared);
+        epte->set_phys_addr(phys);
+
+        // Other vCPUs could still have translations to the shared frame
+        // cached, and would keep reading it once the private copy is
+        // written. The private copy has the same contents as the shared
+        // frame, so it is mapped read-only until every vCPU has flushed.
+
+        if (m_flush_delegate)
+        {
+            m_breaking[page] = m_flush_delegate();
+            return true;
+        }
+    }
+
+    epte->set_write_access(true);
+
+    intel_x64::vmx::invept_global();
+    return true;
+}
+
+bool
+page_merger_intel_x64::pin(integer_pointer gpa)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    auto &&page = gpa & ~(ept::pt::size_bytes - 1);
+
+    if (m_merged.count(page) != 0 || m_breaking.count(page) != 0)
+        return false;
+
+    this->unprotect(page);
+
+    m_hashes.erase(page);
+    m_pinned[page]++;
+
+    return true;
+}
+
+void
+page_merger_intel_x64::unpin(integer_pointer gpa)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    auto &&iter = m_pinned.find(gpa & ~(ept::pt::size_bytes - 1));
+    if (iter == m_pinned.end())
+        return;
+
+    if (--iter->second == 0)
+        m_pinned.erase(iter);
+}
+
+page_merger_intel_x64::size_type
+page_merger_intel_x64::merged_pages() const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_merged.size();
+}
+
+page_merger_intel_x64::size_type
+page_merger_intel_x64::shared_frames() const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_frames.size();
+}
+
+page_merger_intel_x64::frame_list_type
+page_merger_intel_x64::reclaim_frames()
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    frame_list_type frames;
+    frames.swap(m_reclaimable);
+
+    return frames;
+}
+
+page_merger_intel_x64::hash_type
+page_merger_intel_x64::hash_page(integer_pointer phys)
+{
+    auto &&map = bfn::make_unique_map_x64<uint64_t>(phys);
+    auto &&page = gsl::span<uint64_t>(map.get(), words_per_page);
+
+    hash_type hash = fnv_offset_basis;
+    for (auto word : page)
+    {
+        hash ^= word;
+        hash *= fnv_prime;
+    }
+
+    return hash;
+}
+
+bool
+page_merger_intel_x64::compare_pages(integer_pointer phys1, integer_pointer phys2)
+{
+    auto &&map1 = bfn::make_unique_map_x64<uint8_t>(phys1);
+    auto &&map2 = bfn::make_unique_map_x64<uint8_t>(phys2);
+
+    return memcmp(map1.get(), map2.get(), x64::page_size) == 0;
+}
+
+void
+page_merger_intel_x64::copy_page(integer_pointer dst_phys, integer_pointer src_phys)
+{
+    auto &&dst = bfn::make_unique_map_x64<uint8_t>(dst_phys);
+    auto &&src = bfn::make_unique_map_x64<uint8_t>(src_phys);
+
+    memcpy(dst.get(), src.get(), x64::page_size);
+}
+
+page_merger_intel_x64::integer_pointer
+page_merger_intel_x64::alloc_frame()
+{
+    if (!m_reclaimable.empty())
+    {
+        auto phys = m_reclaimable.back();
+        m_reclaimable.pop_back();
+
+        return phys;
+    }
+
+    auto &&frame = std::make_unique<uint8_t[]>(x64::page_size);
+    auto &&phys = g_mm->virtptr_to_physint(frame.get());
+
+    m_owned_frames.push_back(std::move(frame));
+    return phys;
+}
+
+void
+page_merger_intel_x64::match(const candidate_type &candidate)
+{
+    auto &&epte = this->lookup(candidate.gpa);
+    if (!this->is_candidate(candidate.gpa, epte) || epte->phys_addr() != candidate.phys)
+        return;
+
+    // If the contents of this page are already backed by a shared frame (or
+    // will be, once a match found by this scan is merged), the page can
+    // join the frame.
+
+    auto &&pending = std::any_of(m_matches.begin(), m_matches.end(), [&](const auto & match)
+    { return match.hash == candidate.hash; });
+
+    if (pending || m_stable.count(candidate.hash) != 0)
+    {
+        this->protect(epte, candidate.gpa);
+        m_matches.push_back({candidate.gpa, 0, candidate.hash, true});
+
+        return;
+    }
+
+    // Otherwise, the first candidate seen with these contents is remembered
+    // (and stays writable), and once a second candidate shows up with the
+    // same contents, both candidates are write-protected so that they can
+    // be compared once the EPT has been flushed.
+
+    auto &&unstable = m_unstable.find(candidate.hash);
+    if (unstable == m_unstable.end() || unstable->second == candidate.gpa)
+    {
+        m_unstable[candidate.hash] = candidate.gpa;
+        return;
+    }
+
+    auto partner_gpa = unstable->second;
+    m_unstable.erase(unstable);
+
+    auto &&partner_hash = m_hashes.find(partner_gpa);
+    if (partner_hash == m_hashes.end() || partner_hash->second != candidate.hash)
+    {
+        m_unstable[candidate.hash] = candidate.gpa;
+        return;
+    }
+
+    auto &&partner = this->lookup(partner_gpa);
+    if (!this->is_candidate(partner_gpa, partner))
+    {
+        m_unstable[candidate.hash] = candidate.gpa;
+        return;
+    }
+
+    this->protect(partner, partner_gpa);
+    this->protect(epte, candidate.gpa);
+
+    m_matches.push_back({candidate.gpa, partner_gpa, candidate.hash, false});
+}
+
+page_merger_intel_x64::size_type
+page_merger_intel_x64::merge_matches()
+{
+    if (!this->flushed())
+        return 0;
+
+    std::vector<match_type> matches;
+    matches.swap(m_matches);
+
+    auto merged = 0UL;
+    for (const auto &match : matches)
+        merged += this->merge(match);
+
+    return merged;
+}
+
+page_merger_intel_x64::size_type
+page_merger_intel_x64::merge(const match_type &match)
+{
+    // Pages are compared only after they have been write-protected on
+    // every vCPU, so their contents cannot change while they are compared.
+    // Two matches with the same contents can be found by the same scan, in
+    // which case the first one creates the shared frame, and the second
+    // one joins it.
+
+    if (match.stable || m_stable.count(match.hash) != 0)
+    {
+        auto merged = this->join(match.gpa, match.hash);
+
+        if (!match.stable)
+            merged += this->join(match.partner, match.hash);
+
+        return merged;
+    }
+
+    auto &&epte = this->find_protected(match.gpa);
+    auto &&partner = this->find_protected(match.partner);
+
+    if (epte == nullptr || partner == nullptr || !this->compare_pages(partner->phys_addr(), epte->phys_addr()))
+    {
+        this->unprotect(match.gpa);
+        this->unprotect(match.partner);
+
+        return 0;
+    }
+
+    auto &&phys = epte->phys_addr();
+    auto &&shared = partner->phys_addr();
+
+    m_frames[shared] = {match.hash, 0};
+    m_stable[match.hash] = shared;
+
+    this->share(partner, match.partner, shared);
+    this->share(epte, match.gpa, shared);
+
+    return this->release(phys, shared) ? 1 : 0;
+}
+
+page_merger_intel_x64::size_type
+page_merger_intel_x64::join(integer_pointer gpa, hash_type hash)
+{
+    auto &&epte = this->find_protected(gpa);
+    if (epte == nullptr)
+        return 0;
+
+    auto &&stable = m_stable.find(hash);
+    if (stable == m_stable.end() || !this->compare_pages(stable->second, epte->phys_addr()))
+    {
+        this->unprotect(gpa);
+        return 0;
+    }
+
+    auto &&phys = epte->phys_addr();
+    auto &&shared = stable->second;
+
+    this->share(epte, gpa, shared);
+    return this->release(phys, shared) ? 1 : 0;
+}
+
+ept_entry_intel_x64 *
+page_merger_intel_x64::lookup(integer_pointer gpa)
+{
+    ept_entry_intel_x64 *epte = nullptr;
+
+    // Pages can be unmapped between the time that they are scanned and
+    // the time that they are merged, in which case the page is forgotten.
+
+    try
+    {
+        epte = m_vmcs->gpa_to_epte(gpa);
+    }
+    catch (std::runtime_error &)
+    {
+        m_hashes.erase(gpa);
+        m_protected.erase(gpa);
+
+        return nullptr;
+    }
+
+    return epte;
+}
+
+bool
+page_merger_intel_x64::is_candidate(integer_pointer gpa, ept_entry_intel_x64 *epte) const
+{
+    // Pages can also be written to between the time that they are scanned
+    // and the time that they are matched, in which case the page is no
+    // longer a candidate.
+
+    if (epte == nullptr || m_merged.count(gpa) != 0 || m_pinned.count(gpa) != 0)
+        return false;
+
+    return epte->write_access() && !epte->dirty();
+}
+
+ept_entry_intel_x64 *
+page_merger_intel_x64::find_protected(integer_pointer gpa)
+{
+    // A write-protected page that the guest tried to write to is no longer
+    // protected (see handle_write_violation()), and is not merged.
+
+    if (m_protected.count(gpa) == 0)
+        return nullptr;
+
+    return this->lookup(gpa);
+}
+
+void
+page_merger_intel_x64::protect(gsl::not_null<ept_entry_intel_x64 *> epte, integer_pointer gpa)
+{
+    epte->set_write_access(false);
+    m_protected.insert(gpa);
+}
+
+void
+page_merger_intel_x64::unprotect(integer_pointer gpa)
+{
+    if (m_protected.count(gpa) == 0)
+        return;
+
+    if (auto epte = this->lookup(gpa))
+        epte->set_write_access(true);
+
+    m_protected.erase(gpa);
+}
+
+void
+page_merger_intel_x64::share(
+    gsl::not_null<ept_entry_intel_x64 *> epte, integer_pointer gpa, integer_pointer phys)
+{
+    epte->set_phys_addr(phys);
+    epte->set_write_access(false);
+
+    m_frames.at(phys).refs++;
+    m_merged[gpa] = phys;
+    m_hashes.erase(gpa);
+    m_protected.erase(gpa);
+}
+
+bool
+page_merger_intel_x64::release(integer_pointer phys, integer_pointer shared)
+{
+    if (phys == shared)
+        return false;
+
+    // Other vCPUs could still have translations to the frame cached, so it
+    // is only reclaimable once the next flush completes (see flushed()).
+
+    m_released.push_back(phys);
+    return true;
+}
+
+void
+page_merger_intel_x64::flush()
+{
+    if (!m_flush_delegate)
+    {
+        intel_x64::vmx::invept_global();
+        return;
+    }
+
+    m_flush = m_flush_delegate();
+}
+
+bool
+page_merger_intel_x64::flushed()
+{
+    if (m_flush && m_flush->load(std::memory_order_acquire) != 0)
+        return false;
+
+    m_flush.reset();
+
+    m_reclaimable.insert(m_reclaimable.end(), m_released.begin(), m_released.end());
+    m_released.clear();
+
+    return true;
+}
@@ -0,0 +1,171 @@
+//
+// Bareflank Hypervisor
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <vmcs/spp_intel_x64.h>
+#include <memory_manager/memory_manager_x64.h>
+
+#include <intrinsics/x64.h>
+using namespace x64;
+using namespace intel_x64;
+
+spp_intel_x64::spp_intel_x64(integer_pointer bits) :
+    m_bits(bits),
+    m_size(0)
+{
+    m_sppt_owner = std::make_unique<integer_pointer[]>(ept::num_entries);
+    m_sppt = gsl::span<integer_pointer>(m_sppt_owner, ept::num_entries);
+    m_phys_addr = g_mm->virtptr_to_physint(m_sppt_owner.get());
+
+    if (leaf())
+        m_present.resize(ept::num_entries);
+    else
+        m_sppts.resize(ept::num_entries);
+}
+
+spp_intel_x64::size_type
+spp_intel_x64::global_size() const noexcept
+{
+    auto size = m_size;
+
+    for (const auto &sppt : m_sppts)
+    {
+        if (sppt)
+            size += sppt->global_size();
+    }
+
+    return size;
+}
+
+void
+spp_intel_x64::set_write_mask(integer_pointer gpa, mask_type mask)
+{
+    expects(gpa < spp::max_gpa);
+
+    auto &&index = ept::index(gpa, m_bits);
+
+    if (leaf())
+    {
+        // Note that a leaf entry of 0 is a valid vector (no sub-page is
+        // writable), so whether or not a leaf entry is in use has to be
+        // tracked separately from the table itself.
+
+        if (!m_present.at(index))
+        {
+            m_present.at(index) = true;
+            m_size++;
+        }
+
+        m_sppt.at(index) = mask_to_vector(mask);
+        return;
+    }
+
+    auto &&iter = bfn::find(m_sppts, index);
+    if (!*iter)
+    {
+        *iter = std::make_unique<spp_intel_x64>(m_bits - ept::pt::size);
+        m_sppt.at(index) = (*iter)->phys_addr() | spp::valid;
+        m_size++;
+    }
+
+    (*iter)->set_write_mask(gpa, mask);
+}
+
+spp_intel_x64::mask_type
+spp_intel_x64::write_mask(integer_pointer gpa) const
+{
+    expects(gpa < spp::max_gpa);
+
+    auto &&index = ept::index(gpa, m_bits);
+
+    if (leaf())
+    {
+        if (!m_present.at(index))
+            throw std::runtime_error("write_mask: invalid address");
+
+        return vector_to_mask(m_sppt.at(index));
+    }
+
+    const auto &sppt = m_sppts.at(index);
+    if (!sppt)
+        throw std::runtime_error("write_mask: invalid address");
+
+    return sppt->write_mask(gpa);
+}
+
+void
+spp_intel_x64::clear_write_mask(integer_pointer gpa)
+{
+    expects(gpa < spp::max_gpa);
+
+    auto &&index = ept::index(gpa, m_bits);
+
+    if (leaf())
+    {
+        if (!m_present.at(index))
+            throw std::runtime_error("clear_write_mask: invalid address");
+
+        m_sppt.at(index) = 0;
+        m_present.at(index) = false;
+        m_size--;
+        return;
+    }
+
+    auto &&iter = bfn::find(m_sppts, index);
+    if (!*iter)
+        throw std::runtime_error("clear_write_mask: invalid address");
+
+    (*iter)->clear_write_mask(gpa);
+
+    if ((*iter)->empty())
+    {
+        m_sppt.at(index) = 0;
+        *iter = nullptr;
+        m_size--;
+    }
+}
+
+spp_intel_x64::vector_type
+spp_intel_x64::mask_to_vector(mask_type mask) noexcept
+{
+    vector_type vector = 0;
+
+    for (auto i = 0UL; i < spp::num_sub_pages; i++)
+    {
+        if ((mask & (1U << i)) != 0)
+            vector |= (1UL << (i << 1));
+    }
+
+    return vector;
+}
+
+spp_intel_x64::mask_type
+spp_intel_x64::vector_to_mask(vector_type vector) noexcept
+{
+    mask_type mask = 0;
+
+    for (auto i = 0UL; i < spp::num_sub_pages; i++)
+    {
+        if ((vector & (1UL << (i << 1))) != 0)
+            mask |= (1U << i);
+    }
+
+    return mask;
+}
@@ -24,18 +24,40 @@
 #include <vmcs/vmcs_intel_x64_eapis.h>
 #include <vmcs/vmcs_intel_x64_32bit_control_fields.h>
 #include <vmcs/vmcs_intel_x64_64bit_control_fields.h>
+#include <vmcs/vmcs_intel_x64_eapis_control_fields.h>
 
 using namespace intel_x64;
 using namespace vmcs;
 
 vmcs_intel_x64_eapis::vmcs_intel_x64_eapis() :
-    m_io_bitmapa{std::make_unique<uint8_t[]>(x64::page_size)},
-    m_io_bitmapb{std::make_unique<uint8_t[]>(x64::page_size)},
-    m_io_bitmapa_view{m_io_bitmapa, x64::page_size},
-    m_io_bitmapb_view{m_io_bitmapb, x64::page_size}
+    m_vpid{0},
+    m_vpid_flush_pending{false},
+    m_vpid_invalidate_context{false},
+    m_vpid_invalidation_count{0},
+    m_vpid_invalidations{},
+    m_io_bitmaps_shared{true},
+    m_io_bitmaps_user{false},
+    m_io_bitmaps{shared_io_bitmaps()},
+    m_msr_bitmap{std::make_unique<uint8_t[]>(x64::page_size)},
+    m_msr_bitmap_view{m_msr_bitmap, x64::page_size},
+    m_auto_msr_count{0}
 {
-    static vmcs::value_type g_vpid = 1;
-    m_vpid = g_vpid++;
+    // Every MSR access traps until it is explicitly passed through, which
+    // is the same behavior as not using the MSR bitmaps at all.
+    __builtin_memset(m_msr_bitmap.get(), 0xFF, x64::page_size);
+
+    // The EPT capabilities do not change, so they are read once here instead
+    // of each time EPT is enabled.
+    m_ept_vpid_cap = x64::msrs::get(msrs::ia32_vmx_ept_vpid_cap::addr);
+}
+
+vmcs_intel_x64_eapis::~vmcs_intel_x64_eapis()
+{
+    if (m_vpid != 0)
+        vpid_allocator_intel_x64::instance().release(gsl::narrow_cast<vpid_allocator_intel_x64::vpid_type>(m_vpid));
+
+    if (m_io_bitmaps_user)
+        io_bitmaps_users()--;
 }
 
 void
@@ -44,11 +66,14 @@ vmcs_intel_x64_eapis::write_fields(gsl::not_null<vmcs_intel_x64_state *> host_st
 {
     vmcs_intel_x64::write_fields(host_state, guest_state);
 
-    address_of_io_bitmap_a::set(g_mm->virtptr_to_physint(m_io_bitmapa.get()));
-    address_of_io_bitmap_b::set(g_mm->virtptr_to_physint(m_io_bitmapb.get()));
+    this->setup_io_bitmaps();
     primary_processor_based_vm_execution_controls::use_io_bitmaps::enable();
 
+    address_of_msr_bitmaps::set(g_mm->virtptr_to_physint(m_msr_bitmap.get()));
+    primary_processor_based_vm_execution_controls::use_msr_bitmaps::enable();
+
+    this->write_auto_switched_msr_fields();
+
     this->disable_ept();
     this->disable_vpid();
-    this->pass_through_all_io_accesses();
 }
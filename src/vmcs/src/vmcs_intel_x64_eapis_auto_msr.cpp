@@ -0,0 +1,164 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <memory_manager/memory_manager_x64.h>
+
+#include <vmcs/vmcs_intel_x64_eapis.h>
+#include <vmcs/vmcs_intel_x64_32bit_control_fields.h>
+#include <vmcs/vmcs_intel_x64_64bit_control_fields.h>
+#include <vmcs/vmcs_intel_x64_64bit_guest_state_fields.h>
+
+using namespace intel_x64;
+using namespace vmcs;
+
+constexpr const vmcs_intel_x64_eapis::size_type vmcs_intel_x64_eapis::max_auto_switched_msrs;
+
+void
+vmcs_intel_x64_eapis::add_auto_switched_msr(
+    msr_type msr, msr_value_type guest_value, msr_value_type host_value)
+{
+    // The host IA32_EFER / IA32_PAT fields hold the VMM's own values, which
+    // are set up with the rest of the host state, so only the guest field
+    // is set. Once enabled, the controls are never disabled again (see
+    // remove_auto_switched_msr()).
+
+    if (msr == msrs::ia32_efer::addr)
+    {
+        guest_ia32_efer::set(guest_value);
+
+        vm_entry_controls::load_ia32_efer::enable();
+        vm_exit_controls::save_ia32_efer::enable();
+        vm_exit_controls::load_ia32_efer::enable();
+
+        return;
+    }
+
+    if (msr == msrs::ia32_pat::addr)
+    {
+        guest_ia32_pat::set(guest_value);
+
+        vm_entry_controls::load_ia32_pat::enable();
+        vm_exit_controls::save_ia32_pat::enable();
+        vm_exit_controls::load_ia32_pat::enable();
+
+        return;
+    }
+
+    if (!m_auto_msr_guest_area)
+    {
+        m_auto_msr_guest_area = std::make_unique<auto_msr_entry_type[]>(max_auto_switched_msrs);
+        m_auto_msr_host_area = std::make_unique<auto_msr_entry_type[]>(max_auto_switched_msrs);
+    }
+
+    auto &&index = this->find_auto_switched_msr(msr);
+    if (index == m_auto_msr_count)
+    {
+        if (m_auto_msr_count == max_auto_switched_msrs)
+            throw std::runtime_error("add_auto_switched_msr failed: the MSR load / store areas are full");
+
+        m_auto_msr_count++;
+    }
+
+    m_auto_msr_guest_area[index] = {msr, 0, guest_value};
+    m_auto_msr_host_area[index] = {msr, 0, host_value};
+
+    this->write_auto_switched_msr_fields();
+}
+
+void
+vmcs_intel_x64_eapis::remove_auto_switched_msr(msr_type msr)
+{
+    if (msr == msrs::ia32_efer::addr || msr == msrs::ia32_pat::addr)
+        throw std::logic_error("remove_auto_switched_msr failed: EFER / PAT are always switched by the VMCS");
+
+    auto &&index = this->find_auto_switched_msr(msr);
+    if (index == m_auto_msr_count)
+        return;
+
+    // The order of the entries does not matter, so the last entry is
+    // moved into the hole, keeping both areas contiguous.
+
+    m_auto_msr_count--;
+
+    m_auto_msr_guest_area[index] = m_auto_msr_guest_area[m_auto_msr_count];
+    m_auto_msr_host_area[index] = m_auto_msr_host_area[m_auto_msr_count];
+
+    this->write_auto_switched_msr_fields();
+}
+
+vmcs_intel_x64_eapis::msr_value_type
+vmcs_intel_x64_eapis::auto_switched_msr_guest_value(msr_type msr) const
+{
+    if (msr == msrs::ia32_efer::addr)
+        return guest_ia32_efer::get();
+
+    if (msr == msrs::ia32_pat::addr)
+        return guest_ia32_pat::get();
+
+    auto &&index = this->find_auto_switched_msr(msr);
+    if (index == m_auto_msr_count)
+        throw std::runtime_error("auto_switched_msr_guest_value failed: MSR is not auto switched");
+
+    return m_auto_msr_guest_area[index].value;
+}
+
+vmcs_intel_x64_eapis::msr_list_type
+vmcs_intel_x64_eapis::auto_switched_msrs() const
+{
+    msr_list_type list;
+
+    for (auto index = 0UL; index < m_auto_msr_count; index++)
+        list.push_back(m_auto_msr_guest_area[index].msr);
+
+    return list;
+}
+
+void
+vmcs_intel_x64_eapis::write_auto_switched_msr_fields()
+{
+    if (!m_auto_msr_guest_area)
+        return;
+
+    auto &&guest = g_mm->virtptr_to_physint(m_auto_msr_guest_area.get());
+    auto &&host = g_mm->virtptr_to_physint(m_auto_msr_host_area.get());
+
+    vm_entry_msr_load_address::set(guest);
+    vm_exit_msr_store_address::set(guest);
+    vm_exit_msr_load_address::set(host);
+
+    vm_entry_msr_load_count::set(m_auto_msr_count);
+    vm_exit_msr_store_count::set(m_auto_msr_count);
+    vm_exit_msr_load_count::set(m_auto_msr_count);
+}
+
+vmcs_intel_x64_eapis::size_type
+vmcs_intel_x64_eapis::find_auto_switched_msr(msr_type msr) const
+{
+    auto index = 0UL;
+
+    for (; index < m_auto_msr_count; index++)
+    {
+        if (m_auto_msr_guest_area[index].msr == msr)
+            break;
+    }
+
+    return index;
+}
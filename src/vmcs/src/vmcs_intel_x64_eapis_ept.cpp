@@ -22,17 +22,47 @@
 #include <vmcs/vmcs_intel_x64_eapis.h>
 #include <vmcs/vmcs_intel_x64_32bit_control_fields.h>
 #include <vmcs/vmcs_intel_x64_64bit_control_fields.h>
+#include <vmcs/vmcs_intel_x64_eapis_control_fields.h>
 
 using namespace intel_x64;
 using namespace vmcs;
 
 void
-vmcs_intel_x64_eapis::enable_ept()
+vmcs_intel_x64_eapis::enable_ept(const ept_config_type &config)
 {
-    ept_pointer::memory_type::set(ept_pointer::memory_type::write_back);
-    ept_pointer::page_walk_length_minus_one::set(3UL);
+    using namespace msrs::ia32_vmx_ept_vpid_cap;
+
+    switch (config.memory_type)
+    {
+        case ept::memory_type::uc:
+            if (!memory_type_uncacheable::is_supported(m_ept_vpid_cap))
+                throw std::logic_error("enable_ept failed: uncacheable paging structures are not supported");
+            break;
+
+        case ept::memory_type::wb:
+            if (!memory_type_write_back::is_supported(m_ept_vpid_cap))
+                throw std::logic_error("enable_ept failed: write back paging structures are not supported");
+            break;
+
+        default:
+            throw std::runtime_error("enable_ept failed: invalid EPTP memory type");
+    }
+
+    if (config.accessed_and_dirty_flags && !accessed_dirty_flags::is_supported(m_ept_vpid_cap))
+        throw std::logic_error("enable_ept failed: the EPT accessed / dirty flags are not supported");
+
+    if (ept::page_walk::page_walk_length == 5 && !page_walk_length_of_5::is_supported(m_ept_vpid_cap))
+        throw std::logic_error("enable_ept failed: a 5-level page walk is not supported");
+
+    ept_pointer::memory_type::set(config.memory_type);
+    ept_pointer::page_walk_length_minus_one::set(ept::page_walk::page_walk_length - 1UL);
     ept_pointer::phys_addr::set(eptp()->phys_addr());
 
+    if (config.accessed_and_dirty_flags)
+        ept_pointer::accessed_and_dirty_flags::enable();
+    else
+        ept_pointer::accessed_and_dirty_flags::disable();
+
     secondary_processor_based_vm_execution_controls::enable_ept::enable();
     intel_x64::vmx::invept_global();
 }
@@ -19,65 +19,135 @@
 // License along with this library; if not, write to the Free Software
 // Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 
-#include <bitmanip_ext.h>
+#include <memory_manager/memory_manager_x64.h>
+
 #include <vmcs/vmcs_intel_x64_eapis.h>
+#include <vmcs/vmcs_intel_x64_64bit_control_fields.h>
+
+using namespace intel_x64;
+using namespace vmcs;
 
 void
 vmcs_intel_x64_eapis::trap_on_io_access(port_type port)
+{ io_bitmaps()->trap_on_io_access(port); }
+
+void
+vmcs_intel_x64_eapis::trap_on_all_io_accesses()
+{ io_bitmaps()->trap_on_io_range(0x0000, 0xFFFF); }
+
+void
+vmcs_intel_x64_eapis::pass_through_io_access(port_type port)
+{ io_bitmaps()->pass_through_io_access(port); }
+
+void
+vmcs_intel_x64_eapis::pass_through_all_io_accesses()
+{ io_bitmaps()->pass_through_io_range(0x0000, 0xFFFF); }
+
+void
+vmcs_intel_x64_eapis::trap_on_io_range(port_type first, port_type last)
+{ io_bitmaps()->trap_on_io_range(first, last); }
+
+void
+vmcs_intel_x64_eapis::pass_through_io_range(port_type first, port_type last)
+{ io_bitmaps()->pass_through_io_range(first, last); }
+
+void
+vmcs_intel_x64_eapis::whitelist_io_access(const port_list_type &ports)
 {
-    if (port < 0x8000)
-    {
-        auto &&addr = port;
-        set_bit_from_span(m_io_bitmapa_view, addr);
-    }
-    else
+    auto &&bitmaps = io_bitmaps();
+    bitmaps->trap_on_io_range(0x0000, 0xFFFF);
+
+    for (auto iter = ports.begin(); iter != ports.end();)
     {
-        auto &&addr = port - 0x8000;
-        set_bit_from_span(m_io_bitmapb_view, addr);
+        auto run = std::next(iter);
+        while (run != ports.end() && *run == *(run - 1) + 1)
+            ++run;
+
+        bitmaps->pass_through_io_range(*iter, *(run - 1));
+        iter = run;
     }
 }
 
 void
-vmcs_intel_x64_eapis::trap_on_all_io_accesses()
+vmcs_intel_x64_eapis::blacklist_io_access(const port_list_type &ports)
 {
-    __builtin_memset(m_io_bitmapa.get(), 0xFF, x64::page_size);
-    __builtin_memset(m_io_bitmapb.get(), 0xFF, x64::page_size);
+    auto &&bitmaps = io_bitmaps();
+    bitmaps->pass_through_io_range(0x0000, 0xFFFF);
+
+    for (auto iter = ports.begin(); iter != ports.end();)
+    {
+        auto run = std::next(iter);
+        while (run != ports.end() && *run == *(run - 1) + 1)
+            ++run;
+
+        bitmaps->trap_on_io_range(*iter, *(run - 1));
+        iter = run;
+    }
 }
 
 void
-vmcs_intel_x64_eapis::pass_through_io_access(port_type port)
+vmcs_intel_x64_eapis::share_io_bitmaps(bool shared)
 {
-    if (port < 0x8000)
+    m_io_bitmaps_shared = shared;
+
+    // A vCPU that stops sharing keeps using the shared bitmaps until it
+    // actually changes its policy (copy-on-write), see io_bitmaps()
+
+    if (shared && m_io_bitmaps != shared_io_bitmaps())
     {
-        auto &&addr = port;
-        clear_bit_from_span(m_io_bitmapa_view, addr);
+        m_io_bitmaps = shared_io_bitmaps();
+        this->write_io_bitmap_addresses();
     }
-    else
+}
+
+std::shared_ptr<io_bitmaps_intel_x64>
+vmcs_intel_x64_eapis::shared_io_bitmaps()
+{
+    static auto g_io_bitmaps = std::make_shared<io_bitmaps_intel_x64>();
+    return g_io_bitmaps;
+}
+
+gsl::not_null<io_bitmaps_intel_x64 *>
+vmcs_intel_x64_eapis::io_bitmaps()
+{
+    if (!m_io_bitmaps_shared && m_io_bitmaps == shared_io_bitmaps())
     {
-        auto &&addr = port - 0x8000;
-        clear_bit_from_span(m_io_bitmapb_view, addr);
+        m_io_bitmaps = m_io_bitmaps->clone();
+        this->write_io_bitmap_addresses();
     }
+
+    return m_io_bitmaps.get();
 }
 
 void
-vmcs_intel_x64_eapis::pass_through_all_io_accesses()
+vmcs_intel_x64_eapis::setup_io_bitmaps()
 {
-    __builtin_memset(m_io_bitmapa.get(), 0, x64::page_size);
-    __builtin_memset(m_io_bitmapb.get(), 0, x64::page_size);
+    // The shared IO bitmaps outlive the VMCSs that use them. Once every
+    // VMCS is gone (e.g. the hypervisor was stopped), the policy they hold
+    // is stale, so the first VMCS that is set up afterwards resets it.
+    // VMCSs that are set up while others are running keep the policy.
+
+    if (!m_io_bitmaps_user)
+    {
+        m_io_bitmaps_user = true;
+
+        if (io_bitmaps_users()++ == 0)
+            shared_io_bitmaps()->pass_through_io_range(0x0000, 0xFFFF);
+    }
+
+    this->write_io_bitmap_addresses();
 }
 
-void
-vmcs_intel_x64_eapis::whitelist_io_access(const port_list_type &ports)
+std::atomic<vmcs_intel_x64_eapis::size_type> &
+vmcs_intel_x64_eapis::io_bitmaps_users()
 {
-    trap_on_all_io_accesses();
-    for (auto port : ports)
-        pass_through_io_access(port);
+    static std::atomic<size_type> g_users{0};
+    return g_users;
 }
 
 void
-vmcs_intel_x64_eapis::blacklist_io_access(const port_list_type &ports)
+vmcs_intel_x64_eapis::write_io_bitmap_addresses()
 {
-    pass_through_all_io_accesses();
-    for (auto port : ports)
-        trap_on_io_access(port);
+    address_of_io_bitmap_a::set(g_mm->virtptr_to_physint(m_io_bitmaps->bitmap_a().data()));
+    address_of_io_bitmap_b::set(g_mm->virtptr_to_physint(m_io_bitmaps->bitmap_b().data()));
 }
@@ -0,0 +1,129 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <to_string.h>
+
+#include <vmcs/vmcs_intel_x64_eapis.h>
+
+using namespace intel_x64;
+using namespace vmcs;
+
+// The MSR bitmaps are a single page made up of four 1k bitmaps: reads of
+// the low MSRs [0x0, 0x1FFF], reads of the high MSRs [0xC0000000,
+// 0xC0001FFF], and then the same two ranges for writes. Any other MSR
+// always traps.
+constexpr const auto msr_bitmap_read = 0x000UL;
+constexpr const auto msr_bitmap_write = 0x800UL;
+constexpr const auto msr_bitmap_high = 0x400UL;
+constexpr const auto msr_bitmap_size = 0x400UL;
+
+constexpr const auto msrs_per_bitmap = 0x2000U;
+constexpr const auto msr_high_base = 0xC0000000U;
+
+void
+vmcs_intel_x64_eapis::trap_on_rdmsr_access(msr_type msr)
+{ this->set_msr_bitmap_bit(msr, msr_bitmap_read, true); }
+
+void
+vmcs_intel_x64_eapis::trap_on_wrmsr_access(msr_type msr)
+{ this->set_msr_bitmap_bit(msr, msr_bitmap_write, true); }
+
+void
+vmcs_intel_x64_eapis::trap_on_all_rdmsr_accesses()
+{ __builtin_memset(&m_msr_bitmap[msr_bitmap_read], 0xFF, msr_bitmap_size * 2); }
+
+void
+vmcs_intel_x64_eapis::trap_on_all_wrmsr_accesses()
+{ __builtin_memset(&m_msr_bitmap[msr_bitmap_write], 0xFF, msr_bitmap_size * 2); }
+
+void
+vmcs_intel_x64_eapis::pass_through_rdmsr_access(msr_type msr)
+{ this->set_msr_bitmap_bit(msr, msr_bitmap_read, false); }
+
+void
+vmcs_intel_x64_eapis::pass_through_wrmsr_access(msr_type msr)
+{ this->set_msr_bitmap_bit(msr, msr_bitmap_write, false); }
+
+void
+vmcs_intel_x64_eapis::pass_through_all_rdmsr_accesses()
+{ __builtin_memset(&m_msr_bitmap[msr_bitmap_read], 0, msr_bitmap_size * 2); }
+
+void
+vmcs_intel_x64_eapis::pass_through_all_wrmsr_accesses()
+{ __builtin_memset(&m_msr_bitmap[msr_bitmap_write], 0, msr_bitmap_size * 2); }
+
+void
+vmcs_intel_x64_eapis::whitelist_rdmsr_access(const msr_list_type &msrs)
+{
+    this->trap_on_all_rdmsr_accesses();
+
+    for (auto msr : msrs)
+        this->pass_through_rdmsr_access(msr);
+}
+
+void
+vmcs_intel_x64_eapis::whitelist_wrmsr_access(const msr_list_type &msrs)
+{
+    this->trap_on_all_wrmsr_accesses();
+
+    for (auto msr : msrs)
+        this->pass_through_wrmsr_access(msr);
+}
+
+void
+vmcs_intel_x64_eapis::blacklist_rdmsr_access(const msr_list_type &msrs)
+{
+    this->pass_through_all_rdmsr_accesses();
+
+    for (auto msr : msrs)
+        this->trap_on_rdmsr_access(msr);
+}
+
+void
+vmcs_intel_x64_eapis::blacklist_wrmsr_access(const msr_list_type &msrs)
+{
+    this->pass_through_all_wrmsr_accesses();
+
+    for (auto msr : msrs)
+        this->trap_on_wrmsr_access(msr);
+}
+
+void
+vmcs_intel_x64_eapis::set_msr_bitmap_bit(msr_type msr, size_type offset, bool trap)
+{
+    if (msr >= msr_high_base && msr - msr_high_base < msrs_per_bitmap)
+    {
+        offset += msr_bitmap_high;
+        msr -= msr_high_base;
+    }
+    else if (msr >= msrs_per_bitmap)
+    {
+        if (trap)
+            return;
+
+        throw std::runtime_error("msr is not covered by the msr bitmaps: " + bfn::to_string(msr, 16));
+    }
+
+    auto &&byte = m_msr_bitmap[offset + (msr >> 3)];
+    auto &&mask = 1U << (msr & 7U);
+
+    byte = gsl::narrow_cast<uint8_t>(trap ? (byte | mask) : (byte & ~mask));
+}
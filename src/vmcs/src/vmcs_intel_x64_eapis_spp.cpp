@@ -0,0 +1,105 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <vmcs/vmcs_intel_x64_eapis.h>
+#include <vmcs/vmcs_intel_x64_eapis_control_fields.h>
+#include <vmcs/vmcs_intel_x64_32bit_control_fields.h>
+
+using namespace intel_x64;
+using namespace vmcs;
+
+void
+vmcs_intel_x64_eapis::enable_spp()
+{
+    if (secondary_processor_based_vm_execution_controls::enable_ept::is_disabled())
+        throw std::logic_error("enable_spp failed: EPT must be enabled first");
+
+    spp_table_pointer::set(sppt()->phys_addr());
+    secondary_processor_based_vm_execution_controls::sub_page_write_permissions::enable();
+
+    intel_x64::vmx::invept_global();
+}
+
+void
+vmcs_intel_x64_eapis::disable_spp()
+{
+    secondary_processor_based_vm_execution_controls::sub_page_write_permissions::disable();
+    spp_table_pointer::set(0UL);
+
+    intel_x64::vmx::invept_global();
+}
+
+void
+vmcs_intel_x64_eapis::set_spp_write_mask(integer_pointer gpa, spp_mask_type mask)
+{
+    std::lock_guard<std::mutex> guard(eptp_mutex());
+
+    auto &&entry = eptp()->find_epte(gpa);
+    if (entry->entry_type())
+        throw std::logic_error("set_spp_write_mask: gpa must be mapped using map_4k");
+
+    sppt()->set_write_mask(gpa, mask);
+
+    // The write access of the page is only known the first time the page
+    // is protected, as it is cleared while the SPP write mask is in use.
+
+    if (!entry->sub_page_write_permissions() && !entry->write_access())
+        spp_read_only_pages().insert(gpa & ~(ept::pt::size_bytes - 1));
+
+    entry->set_write_access(false);
+    entry->set_sub_page_write_permissions(true);
+
+    intel_x64::vmx::invept_global();
+}
+
+void
+vmcs_intel_x64_eapis::clear_spp_write_mask(integer_pointer gpa)
+{
+    std::lock_guard<std::mutex> guard(eptp_mutex());
+
+    auto &&entry = eptp()->find_epte(gpa);
+    sppt()->clear_write_mask(gpa);
+
+    auto &&read_only = spp_read_only_pages().erase(gpa & ~(ept::pt::size_bytes - 1)) != 0;
+
+    entry->set_sub_page_write_permissions(false);
+    entry->set_write_access(!read_only);
+
+    intel_x64::vmx::invept_global();
+}
+
+gsl::not_null<spp_intel_x64 *>
+vmcs_intel_x64_eapis::sppt() const
+{
+    static std::unique_ptr<spp_intel_x64> g_sppt;
+
+    if (!g_sppt)
+        g_sppt = std::make_unique<spp_intel_x64>();
+
+    return g_sppt.get();
+}
+
+std::set<vmcs_intel_x64_eapis::integer_pointer> &
+vmcs_intel_x64_eapis::spp_read_only_pages() const
+{
+    static std::set<integer_pointer> g_read_only_pages;
+    return g_read_only_pages;
+}
@@ -20,17 +20,38 @@
 // Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 
 #include <vmcs/vmcs_intel_x64_eapis.h>
+#include <vmcs/vmcs_intel_x64_eapis_control_fields.h>
 #include <vmcs/vmcs_intel_x64_16bit_control_fields.h>
 #include <vmcs/vmcs_intel_x64_32bit_control_fields.h>
 
+#include <intrinsics/vmx_intel_x64.h>
+
 using namespace intel_x64;
 using namespace vmcs;
 
 void
 vmcs_intel_x64_eapis::enable_vpid()
 {
+    if (m_vpid == 0)
+    {
+        auto recycled = false;
+
+        m_vpid = vpid_allocator_intel_x64::instance().allocate(recycled);
+        m_vpid_flush_pending = recycled;
+    }
+
     vmcs::virtual_processor_identifier::set(m_vpid);
     secondary_processor_based_vm_execution_controls::enable_vpid::enable();
+
+    // A recycled VPID could still have translations cached by its previous
+    // owner. The VMCS is loaded on the CPU that will run the guest, so
+    // this is also the CPU whose TLB needs to be invalidated.
+
+    if (m_vpid_flush_pending)
+    {
+        this->invalidate_vpid_context();
+        m_vpid_flush_pending = false;
+    }
 }
 
 void
@@ -38,4 +59,113 @@ vmcs_intel_x64_eapis::disable_vpid()
 {
     vmcs::virtual_processor_identifier::set(0UL);
     secondary_processor_based_vm_execution_controls::enable_vpid::disable();
+
+    m_vpid_invalidate_context = false;
+    m_vpid_invalidation_count = 0;
+}
+
+void
+vmcs_intel_x64_eapis::invalidate_vpid_address(integer_pointer addr)
+{
+    if (secondary_processor_based_vm_execution_controls::enable_vpid::is_disabled())
+        return;
+
+    if (!msrs::ia32_vmx_ept_vpid_cap::invvpid_individual_address::is_supported(m_ept_vpid_cap))
+    {
+        this->invalidate_vpid_context();
+        return;
+    }
+
+    intel_x64::vmx::invvpid_individual_address(m_vpid, addr);
+}
+
+void
+vmcs_intel_x64_eapis::invalidate_vpid_context()
+{
+    if (secondary_processor_based_vm_execution_controls::enable_vpid::is_disabled())
+        return;
+
+    if (!msrs::ia32_vmx_ept_vpid_cap::invvpid_single_context::is_supported(m_ept_vpid_cap))
+    {
+        this->invalidate_all_vpid_contexts();
+        return;
+    }
+
+    intel_x64::vmx::invvpid_single_context(m_vpid);
+}
+
+void
+vmcs_intel_x64_eapis::invalidate_all_vpid_contexts()
+{
+    if (msrs::ia32_vmx_ept_vpid_cap::invvpid_all_context::is_supported(m_ept_vpid_cap))
+    {
+        intel_x64::vmx::invvpid_all_contexts();
+        return;
+    }
+
+    // The best that can be done without the all-context type is to
+    // invalidate this VMCS's own VPID. This does not go through
+    // invalidate_vpid_context(), as it falls back to this function.
+
+    if (m_vpid == 0 || secondary_processor_based_vm_execution_controls::enable_vpid::is_disabled())
+        return;
+
+    if (msrs::ia32_vmx_ept_vpid_cap::invvpid_single_context::is_supported(m_ept_vpid_cap))
+        intel_x64::vmx::invvpid_single_context(m_vpid);
+}
+
+void
+vmcs_intel_x64_eapis::queue_vpid_invalidation(integer_pointer addr)
+{
+    if (m_vpid_invalidate_context)
+        return;
+
+    auto &&page = addr & ~(x64::page_size - 1);
+
+    for (auto i = 0UL; i < m_vpid_invalidation_count; i++)
+    {
+        if (m_vpid_invalidations[i] == page)
+            return;
+    }
+
+    // Once the queue is full, a single-context invalidation is cheaper
+    // than invalidating each page individually, so the queued pages are
+    // dropped.
+
+    if (m_vpid_invalidation_count == m_vpid_invalidations.size())
+    {
+        m_vpid_invalidate_context = true;
+        m_vpid_invalidation_count = 0;
+
+        return;
+    }
+
+    m_vpid_invalidations[m_vpid_invalidation_count++] = page;
+}
+
+void
+vmcs_intel_x64_eapis::flush_vpid_invalidations()
+{
+    if (m_vpid_invalidate_context)
+        this->invalidate_vpid_context();
+
+    for (auto i = 0UL; i < m_vpid_invalidation_count; i++)
+        this->invalidate_vpid_address(m_vpid_invalidations[i]);
+
+    m_vpid_invalidate_context = false;
+    m_vpid_invalidation_count = 0;
+}
+
+void
+vmcs_intel_x64_eapis::set_entry_delegate(const entry_delegate_type &delegate)
+{ m_entry_delegate = delegate; }
+
+void
+vmcs_intel_x64_eapis::resume()
+{
+    if (m_entry_delegate)
+        m_entry_delegate();
+
+    this->flush_vpid_invalidations();
+    vmcs_intel_x64::resume();
 }
@@ -0,0 +1,110 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <vmcs/vpid_allocator_intel_x64.h>
+
+constexpr const vpid_allocator_intel_x64::size_type vpid_allocator_intel_x64::num_vpids;
+constexpr const vpid_allocator_intel_x64::size_type vpid_allocator_intel_x64::bits_per_word;
+constexpr const vpid_allocator_intel_x64::size_type vpid_allocator_intel_x64::num_words;
+
+vpid_allocator_intel_x64::vpid_allocator_intel_x64() noexcept :
+    m_cursor(1),
+    m_allocated(0),
+    m_high_water_mark(1)
+{
+    for (auto &&word : m_bitmap)
+        word.store(0, std::memory_order_relaxed);
+
+    // VPID 0 is used by the VMM, and is never handed out.
+    m_bitmap[0].store(1, std::memory_order_relaxed);
+}
+
+vpid_allocator_intel_x64::vpid_type
+vpid_allocator_intel_x64::allocate(bool &recycled)
+{
+    auto cursor = m_cursor.load(std::memory_order_relaxed);
+
+    // The search visits the word containing the cursor twice. The first
+    // time, the VPIDs behind the cursor are skipped, so that they are
+    // only handed out once the search has wrapped all the way around.
+
+    for (auto i = 0UL; i <= num_words; i++)
+    {
+        auto index = ((cursor / bits_per_word) + i) % num_words;
+        auto skip = i == 0 ? (1UL << (cursor % bits_per_word)) - 1 : 0UL;
+
+        auto &&word = m_bitmap[index];
+        auto bits = word.load(std::memory_order_relaxed);
+
+        while ((bits | skip) != ~0UL)
+        {
+            auto bit = static_cast<size_type>(__builtin_ctzl(~(bits | skip)));
+
+            if (!word.compare_exchange_weak(bits, bits | (1UL << bit),
+                                            std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                continue;
+            }
+
+            auto vpid = (index * bits_per_word) + bit;
+
+            m_cursor.store((vpid + 1) % num_vpids, std::memory_order_relaxed);
+            m_allocated.fetch_add(1, std::memory_order_relaxed);
+
+            auto mark = m_high_water_mark.load(std::memory_order_relaxed);
+            while (mark <= vpid && !m_high_water_mark.compare_exchange_weak(mark, vpid + 1, std::memory_order_relaxed))
+            { }
+
+            recycled = vpid < mark;
+            return gsl::narrow_cast<vpid_type>(vpid);
+        }
+    }
+
+    throw std::runtime_error("allocate failed: out of VPIDs");
+}
+
+void
+vpid_allocator_intel_x64::release(vpid_type vpid)
+{
+    expects(vpid != 0);
+
+    auto &&mask = 1UL << (vpid % bits_per_word);
+    auto &&bits = m_bitmap[vpid / bits_per_word].fetch_and(~mask, std::memory_order_release);
+
+    if ((bits & mask) == 0)
+        throw std::logic_error("release failed: VPID is not allocated");
+
+    m_allocated.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool
+vpid_allocator_intel_x64::is_allocated(vpid_type vpid) const noexcept
+{
+    auto &&mask = 1UL << (vpid % bits_per_word);
+    return (m_bitmap[vpid / bits_per_word].load(std::memory_order_relaxed) & mask) != 0;
+}
+
+vpid_allocator_intel_x64 &
+vpid_allocator_intel_x64::instance() noexcept
+{
+    static vpid_allocator_intel_x64 g_vpid_allocator;
+    return g_vpid_allocator;
+}
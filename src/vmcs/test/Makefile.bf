@@ -53,6 +53,10 @@ SOURCES+=test.cpp
 SOURCES+=test_vmcs_intel_x64_eapis.cpp
 SOURCES+=test_ept_intel_x64.cpp
 SOURCES+=test_ept_entry_intel_x64.cpp
+SOURCES+=test_spp_intel_x64.cpp
+SOURCES+=test_vpid_allocator_intel_x64.cpp
+SOURCES+=test_page_merger_intel_x64.cpp
+SOURCES+=test_page_age_sampler_intel_x64.cpp
 
 INCLUDE_PATHS+=./
 INCLUDE_PATHS+=../../../include
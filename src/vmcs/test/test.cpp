@@ -42,15 +42,39 @@ eapis_ut::list()
 {
     this->test_construction();
     this->test_launch();
+    this->test_launch_reset_io_bitmaps();
     this->test_enable_vpid();
     this->test_disable_vpid();
+    this->test_enable_vpid_release();
+    this->test_queue_vpid_invalidation();
+    this->test_queue_vpid_invalidation_overflow();
+    this->test_flush_vpid_invalidations();
+    this->test_invalidate_all_vpid_contexts();
     this->test_trap_on_io_access();
     this->test_trap_on_all_io_accesses();
     this->test_pass_through_io_access();
     this->test_pass_through_all_io_accesses();
+    this->test_trap_on_io_range();
+    this->test_pass_through_io_range();
     this->test_whitelist_io_access();
     this->test_blacklist_io_access();
+    this->test_share_io_bitmaps();
+    this->test_trap_on_rdmsr_access();
+    this->test_trap_on_wrmsr_access();
+    this->test_trap_on_all_msr_accesses();
+    this->test_pass_through_rdmsr_access();
+    this->test_pass_through_wrmsr_access();
+    this->test_pass_through_all_msr_accesses();
+    this->test_whitelist_msr_access();
+    this->test_blacklist_msr_access();
+    this->test_add_auto_switched_msr();
+    this->test_add_auto_switched_msr_dedicated_fields();
+    this->test_remove_auto_switched_msr();
+    this->test_add_auto_switched_msr_full();
     this->test_enable_ept();
+    this->test_enable_ept_with_config();
+    this->test_enable_ept_invalid_config();
+    this->test_enable_ept_unsupported_config();
     this->test_disable_ept();
     this->test_map_1g();
     this->test_map_2m();
@@ -62,6 +86,13 @@ eapis_ut::list()
     this->test_setup_ept_identity_map_2m_valid();
     this->test_setup_ept_identity_map_4k_invalid();
     this->test_setup_ept_identity_map_4k_valid();
+    this->test_enable_spp();
+    this->test_enable_spp_without_ept();
+    this->test_disable_spp();
+    this->test_set_spp_write_mask();
+    this->test_set_spp_write_mask_2m();
+    this->test_clear_spp_write_mask();
+    this->test_clear_spp_write_mask_read_only();
 
     this->test_ept_entry_intel_x64_invalid();
     this->test_ept_entry_intel_x64_read_access();
@@ -75,6 +106,7 @@ eapis_ut::list()
     this->test_ept_entry_intel_x64_execute_access_user();
     this->test_ept_entry_intel_x64_phys_addr();
     this->test_ept_entry_intel_x64_suppress_ve();
+    this->test_ept_entry_intel_x64_sub_page_write_permissions();
     this->test_ept_entry_intel_x64_trap_on_access();
     this->test_ept_entry_intel_x64_pass_through_access();
     this->test_ept_entry_intel_x64_clear();
@@ -87,6 +119,38 @@ eapis_ut::list()
     this->test_ept_intel_x64_add_page_twice_failure();
     this->test_ept_intel_x64_remove_page_twice_failure();
     this->test_ept_intel_x64_remove_page_unknown_failure();
+    this->test_ept_intel_x64_visit_range();
+    this->test_ept_intel_x64_five_level();
+    this->test_ept_intel_x64_exceeds_page_walk_length();
+
+    this->test_spp_intel_x64_mask_to_vector();
+    this->test_spp_intel_x64_vector_to_mask();
+    this->test_vpid_allocator_intel_x64_allocate();
+    this->test_vpid_allocator_intel_x64_release();
+    this->test_vpid_allocator_intel_x64_recycle();
+    this->test_vpid_allocator_intel_x64_instance();
+    this->test_spp_intel_x64_set_write_mask();
+    this->test_spp_intel_x64_table_format();
+    this->test_spp_intel_x64_clear_write_mask();
+    this->test_spp_intel_x64_clear_write_mask_unknown_failure();
+
+    this->test_page_merger_intel_x64_scan_invalid();
+    this->test_page_merger_intel_x64_merge();
+    this->test_page_merger_intel_x64_pages_per_scan();
+    this->test_page_merger_intel_x64_dirty_pages();
+    this->test_page_merger_intel_x64_changed_pages();
+    this->test_page_merger_intel_x64_write_violation();
+    this->test_page_merger_intel_x64_deferred_flush();
+    this->test_page_merger_intel_x64_write_violation_deferred_flush();
+    this->test_page_merger_intel_x64_pin();
+    this->test_page_age_sampler_intel_x64_bucket();
+    this->test_page_age_sampler_intel_x64_tick_without_ad_flags();
+    this->test_page_age_sampler_intel_x64_tick();
+    this->test_page_age_sampler_intel_x64_pages_per_tick();
+    this->test_page_age_sampler_intel_x64_unmapped_pages();
+    this->test_page_age_sampler_intel_x64_set_range();
+    this->test_page_age_sampler_intel_x64_cold_ranges();
+    this->test_page_age_sampler_intel_x64_deferred_flush();
 
     return true;
 }
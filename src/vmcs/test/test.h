@@ -41,15 +41,39 @@ private:
 
     void test_construction();
     void test_launch();
+    void test_launch_reset_io_bitmaps();
     void test_enable_vpid();
     void test_disable_vpid();
+    void test_enable_vpid_release();
+    void test_queue_vpid_invalidation();
+    void test_queue_vpid_invalidation_overflow();
+    void test_flush_vpid_invalidations();
+    void test_invalidate_all_vpid_contexts();
     void test_trap_on_io_access();
     void test_trap_on_all_io_accesses();
     void test_pass_through_io_access();
     void test_pass_through_all_io_accesses();
+    void test_trap_on_io_range();
+    void test_pass_through_io_range();
     void test_whitelist_io_access();
     void test_blacklist_io_access();
+    void test_share_io_bitmaps();
+    void test_trap_on_rdmsr_access();
+    void test_trap_on_wrmsr_access();
+    void test_trap_on_all_msr_accesses();
+    void test_pass_through_rdmsr_access();
+    void test_pass_through_wrmsr_access();
+    void test_pass_through_all_msr_accesses();
+    void test_whitelist_msr_access();
+    void test_blacklist_msr_access();
+    void test_add_auto_switched_msr();
+    void test_add_auto_switched_msr_dedicated_fields();
+    void test_remove_auto_switched_msr();
+    void test_add_auto_switched_msr_full();
     void test_enable_ept();
+    void test_enable_ept_with_config();
+    void test_enable_ept_invalid_config();
+    void test_enable_ept_unsupported_config();
     void test_disable_ept();
     void test_map_1g();
     void test_map_2m();
@@ -61,6 +85,13 @@ private:
     void test_setup_ept_identity_map_2m_valid();
     void test_setup_ept_identity_map_4k_invalid();
     void test_setup_ept_identity_map_4k_valid();
+    void test_enable_spp();
+    void test_enable_spp_without_ept();
+    void test_disable_spp();
+    void test_set_spp_write_mask();
+    void test_set_spp_write_mask_2m();
+    void test_clear_spp_write_mask();
+    void test_clear_spp_write_mask_read_only();
 
     void test_ept_entry_intel_x64_invalid();
     void test_ept_entry_intel_x64_read_access();
@@ -74,6 +105,7 @@ private:
     void test_ept_entry_intel_x64_execute_access_user();
     void test_ept_entry_intel_x64_phys_addr();
     void test_ept_entry_intel_x64_suppress_ve();
+    void test_ept_entry_intel_x64_sub_page_write_permissions();
     void test_ept_entry_intel_x64_trap_on_access();
     void test_ept_entry_intel_x64_pass_through_access();
     void test_ept_entry_intel_x64_clear();
@@ -86,7 +118,38 @@ private:
     void test_ept_intel_x64_add_page_twice_failure();
     void test_ept_intel_x64_remove_page_twice_failure();
     void test_ept_intel_x64_remove_page_unknown_failure();
+    void test_ept_intel_x64_visit_range();
+    void test_ept_intel_x64_five_level();
+    void test_ept_intel_x64_exceeds_page_walk_length();
 
+    void test_spp_intel_x64_mask_to_vector();
+    void test_spp_intel_x64_vector_to_mask();
+    void test_vpid_allocator_intel_x64_allocate();
+    void test_vpid_allocator_intel_x64_release();
+    void test_vpid_allocator_intel_x64_recycle();
+    void test_vpid_allocator_intel_x64_instance();
+    void test_spp_intel_x64_set_write_mask();
+    void test_spp_intel_x64_table_format();
+    void test_spp_intel_x64_clear_write_mask();
+    void test_spp_intel_x64_clear_write_mask_unknown_failure();
+
+    void test_page_merger_intel_x64_scan_invalid();
+    void test_page_merger_intel_x64_merge();
+    void test_page_merger_intel_x64_pages_per_scan();
+    void test_page_merger_intel_x64_dirty_pages();
+    void test_page_merger_intel_x64_changed_pages();
+    void test_page_merger_intel_x64_write_violation();
+    void test_page_merger_intel_x64_deferred_flush();
+    void test_page_merger_intel_x64_write_violation_deferred_flush();
+    void test_page_merger_intel_x64_pin();
+    void test_page_age_sampler_intel_x64_bucket();
+    void test_page_age_sampler_intel_x64_tick_without_ad_flags();
+    void test_page_age_sampler_intel_x64_tick();
+    void test_page_age_sampler_intel_x64_pages_per_tick();
+    void test_page_age_sampler_intel_x64_unmapped_pages();
+    void test_page_age_sampler_intel_x64_set_range();
+    void test_page_age_sampler_intel_x64_cold_ranges();
+    void test_page_age_sampler_intel_x64_deferred_flush();
 
 };
 
@@ -224,6 +224,22 @@ eapis_ut::test_ept_entry_intel_x64_suppress_ve()
     this->expect_true(num_bits_set(entry) == 0);
 }
 
+void
+eapis_ut::test_ept_entry_intel_x64_sub_page_write_permissions()
+{
+    epte_type entry = 0;
+    auto &&epte = std::make_unique<ept_entry_intel_x64>(&entry);
+
+    epte->set_sub_page_write_permissions(true);
+    this->expect_true(epte->sub_page_write_permissions());
+    this->expect_true(num_bits_set(entry) == 1);
+    this->expect_true(is_bit_set(entry, 61));
+
+    epte->set_sub_page_write_permissions(false);
+    this->expect_false(epte->sub_page_write_permissions());
+    this->expect_true(num_bits_set(entry) == 0);
+}
+
 void
 eapis_ut::test_ept_entry_intel_x64_trap_on_access()
 {
@@ -242,3 +242,137 @@ eapis_ut::test_ept_intel_x64_remove_page_unknown_failure()
         this->expect_exception([&]{ eptp->remove_page(virt); }, ""_ut_ree);
     });
 }
+
+void
+eapis_ut::test_ept_intel_x64_visit_range()
+{
+    MockRepository mocks;
+    setup_mm(mocks);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        auto &&eptp = std::make_unique<ept_intel_x64>();
+        auto &&base = 0x0000123440000000UL;
+
+        std::vector<ept_intel_x64::integer_pointer> gpas;
+
+        auto &&visit = [&](auto gpa, auto size, auto epte)
+        {
+            (void) size;
+            (void) epte;
+
+            gpas.push_back(gpa);
+            return true;
+        };
+
+        eptp->add_page_4k(base);
+        eptp->add_page_4k(base + 0x1000);
+        eptp->add_page_2m(base + 0x200000);
+        eptp->add_page_4k(base + 0x40000000);
+
+        this->expect_true(eptp->visit_range(base, base + 0x80000000, visit));
+        this->expect_true(gpas.size() == 4);
+        this->expect_true(gpas[0] == base);
+        this->expect_true(gpas[1] == base + 0x1000);
+        this->expect_true(gpas[2] == base + 0x200000);
+        this->expect_true(gpas[3] == base + 0x40000000);
+
+        gpas.clear();
+        this->expect_true(eptp->visit_range(base + 0x1000, base + 0x200001, visit));
+        this->expect_true(gpas.size() == 2);
+        this->expect_true(gpas[0] == base + 0x1000);
+        this->expect_true(gpas[1] == base + 0x200000);
+
+        gpas.clear();
+        this->expect_true(eptp->visit_range(base + 0x2000, base + 0x200000, visit));
+        this->expect_true(gpas.empty());
+
+        gpas.clear();
+        this->expect_false(eptp->visit_range(0, 0xFFFFFFFFFFFFF000, [&](auto gpa, auto size, auto epte)
+        {
+            (void) size;
+            (void) epte;
+
+            gpas.push_back(gpa);
+            return gpas.size() < 2;
+        }));
+        this->expect_true(gpas.size() == 2);
+
+        eptp->remove_page(base);
+        eptp->remove_page(base + 0x1000);
+        eptp->remove_page(base + 0x200000);
+        eptp->remove_page(base + 0x40000000);
+    });
+}
+
+void
+eapis_ut::test_ept_intel_x64_five_level()
+{
+    MockRepository mocks;
+    setup_mm(mocks);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        auto &&eptp = std::make_unique<ept_intel_x64>(nullptr, intel_x64::ept::pml5::from);
+        auto &&high = 0x00FF000000000000UL + virt;
+
+        this->expect_true(eptp->max_gpa() == 0x0200000000000000UL);
+
+        eptp->add_page_4k(virt);
+        this->expect_true(eptp->global_size() == 5);
+
+        eptp->add_page_4k(high);
+        this->expect_true(eptp->global_size() == 10);
+
+        this->expect_no_exception([&]{ eptp->find_epte(virt); });
+        this->expect_no_exception([&]{ eptp->find_epte(high); });
+        this->expect_exception([&]{ eptp->find_epte(high + 0x1000); }, ""_ut_ree);
+
+        std::vector<ept_intel_x64::integer_pointer> gpas;
+        this->expect_true(eptp->visit_range(0, eptp->max_gpa(), [&](auto gpa, auto size, auto epte)
+        {
+            (void) epte;
+
+            this->expect_true(size == intel_x64::ept::pt::size_bytes);
+            gpas.push_back(gpa);
+            return true;
+        }));
+
+        this->expect_true(gpas.size() == 2);
+        this->expect_true(gpas[0] == virt);
+        this->expect_true(gpas[1] == high);
+
+        eptp->remove_page(high);
+        this->expect_true(eptp->global_size() == 5);
+
+        eptp->remove_page(virt);
+        this->expect_true(eptp->global_size() == 0);
+    });
+}
+
+void
+eapis_ut::test_ept_intel_x64_exceeds_page_walk_length()
+{
+    MockRepository mocks;
+    setup_mm(mocks);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        auto &&eptp = std::make_unique<ept_intel_x64>(nullptr, intel_x64::ept::pml4::from);
+        auto &&high = 0x0001000000000000UL + virt;
+
+        this->expect_true(eptp->max_gpa() == 0x0001000000000000UL);
+
+        this->expect_exception([&]{ eptp->add_page_4k(high); }, ""_ut_ree);
+        this->expect_exception([&]{ eptp->add_page_2m(high); }, ""_ut_ree);
+        this->expect_exception([&]{ eptp->add_page_1g(high); }, ""_ut_ree);
+
+        // Without the check, "high" would alias "virt"
+        eptp->add_page_4k(virt);
+        this->expect_exception([&]{ eptp->find_epte(high); }, ""_ut_ree);
+        this->expect_exception([&]{ eptp->remove_page(high); }, ""_ut_ree);
+
+        eptp->remove_page(virt);
+        this->expect_true(eptp->global_size() == 0);
+    });
+}
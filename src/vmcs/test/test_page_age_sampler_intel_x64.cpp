@@ -0,0 +1,330 @@
+//
+// Bareflank Hypervisor
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <test.h>
+#include <memory_manager/memory_manager_x64.h>
+
+#include <vmcs/page_age_sampler_intel_x64.h>
+#include <vmcs/vmcs_intel_x64_64bit_control_fields.h>
+
+using namespace intel_x64;
+using namespace vmcs;
+
+constexpr vmcs_intel_x64_eapis::integer_pointer sampler_gpa = 0x0000110000000000UL;
+constexpr vmcs_intel_x64_eapis::integer_pointer sampler_end = sampler_gpa + 0x400000UL;
+
+static auto
+setup_sampler_mm(MockRepository &mocks)
+{
+    auto mm = mocks.Mock<memory_manager_x64>();
+    mocks.OnCallFunc(memory_manager_x64::instance).Return(mm);
+    mocks.OnCall(mm, memory_manager_x64::virtptr_to_physint).Return(0x0000000000042000UL);
+
+    return mm;
+}
+
+static auto
+setup_sampler_vmcs()
+{
+    auto &&vmcs = std::make_unique<vmcs_intel_x64_eapis>();
+
+    ept_pointer::set(0UL);
+    ept_pointer::accessed_and_dirty_flags::enable();
+
+    vmcs->map_4k(sampler_gpa + 0x0000, sampler_gpa + 0x0000, ept::memory_attr::pt_wb);
+    vmcs->map_4k(sampler_gpa + 0x1000, sampler_gpa + 0x1000, ept::memory_attr::pt_wb);
+    vmcs->map_4k(sampler_gpa + 0x3000, sampler_gpa + 0x3000, ept::memory_attr::pt_wb);
+    vmcs->map_2m(sampler_gpa + 0x200000, sampler_gpa + 0x200000, ept::memory_attr::pt_wb);
+
+    return std::move(vmcs);
+}
+
+static void
+teardown_sampler_vmcs(gsl::not_null<vmcs_intel_x64_eapis *> vmcs)
+{
+    vmcs->unmap(sampler_gpa + 0x0000);
+    vmcs->unmap(sampler_gpa + 0x1000);
+    vmcs->unmap(sampler_gpa + 0x3000);
+    vmcs->unmap(sampler_gpa + 0x200000);
+
+    ept_pointer::set(0UL);
+}
+
+void
+eapis_ut::test_page_age_sampler_intel_x64_bucket()
+{
+    this->expect_true(page_age_sampler_intel_x64::bucket(0) == 0);
+    this->expect_true(page_age_sampler_intel_x64::bucket(1) == 1);
+    this->expect_true(page_age_sampler_intel_x64::bucket(2) == 2);
+    this->expect_true(page_age_sampler_intel_x64::bucket(3) == 2);
+    this->expect_true(page_age_sampler_intel_x64::bucket(4) == 3);
+    this->expect_true(page_age_sampler_intel_x64::bucket(127) == 7);
+    this->expect_true(page_age_sampler_intel_x64::bucket(128) == 8);
+    this->expect_true(page_age_sampler_intel_x64::bucket(page_age_sampler_intel_x64::max_age) == 8);
+}
+
+void
+eapis_ut::test_page_age_sampler_intel_x64_tick_without_ad_flags()
+{
+    MockRepository mocks;
+    setup_sampler_mm(mocks);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        auto &&vmcs = std::make_unique<vmcs_intel_x64_eapis>();
+        auto &&sampler = std::make_unique<page_age_sampler_intel_x64>(vmcs.get());
+
+        ept_pointer::set(0UL);
+        this->expect_exception([&] { sampler->tick(); }, ""_ut_lee);
+        this->expect_exception([&] { sampler->set_range(sampler_end, sampler_gpa); }, ""_ut_ffe);
+    });
+}
+
+void
+eapis_ut::test_page_age_sampler_intel_x64_tick()
+{
+    MockRepository mocks;
+    setup_sampler_mm(mocks);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        auto &&vmcs = setup_sampler_vmcs();
+        auto &&sampler = std::make_unique<page_age_sampler_intel_x64>(vmcs.get());
+
+        sampler->set_range(sampler_gpa, sampler_end);
+
+        vmcs->gpa_to_epte(sampler_gpa + 0x3000)->set_accessed(true);
+
+        this->expect_true(sampler->tick());
+        this->expect_true(sampler->age(sampler_gpa + 0x0000) == 1);
+        this->expect_true(sampler->age(sampler_gpa + 0x3000) == 0);
+        this->expect_true(sampler->age(sampler_gpa + 0x200000) == 1);
+        this->expect_true(sampler->histogram()[0] == 1);
+        this->expect_true(sampler->histogram()[1] == 514);
+        this->expect_exception([&] { sampler->age(sampler_gpa + 0x2000); }, ""_ut_ree);
+
+        // The large page is tracked using a single entry.
+
+        this->expect_true(sampler->m_tables.size() == 1);
+        this->expect_true(sampler->m_large.size() == 1);
+
+        vmcs->gpa_to_epte(sampler_gpa + 0x1000)->set_accessed(true);
+
+        this->expect_true(sampler->tick());
+        this->expect_true(sampler->age(sampler_gpa + 0x0000) == 2);
+        this->expect_true(sampler->age(sampler_gpa + 0x1000) == 0);
+        this->expect_true(sampler->age(sampler_gpa + 0x3000) == 1);
+        this->expect_true(sampler->age(sampler_gpa + 0x3FF000) == 2);
+        this->expect_false(vmcs->gpa_to_epte(sampler_gpa + 0x1000)->accessed());
+
+        auto &&histogram = sampler->histogram();
+        this->expect_true(histogram[0] == 1);
+        this->expect_true(histogram[1] == 1);
+        this->expect_true(histogram[2] == 513);
+        this->expect_true(histogram[3] == 0);
+
+        for (auto i = 0; i < 300; i++)
+            sampler->tick();
+
+        this->expect_true(sampler->age(sampler_gpa + 0x1000) == page_age_sampler_intel_x64::max_age);
+        this->expect_true(sampler->histogram()[8] == 515);
+
+        teardown_sampler_vmcs(vmcs.get());
+    });
+}
+
+void
+eapis_ut::test_page_age_sampler_intel_x64_pages_per_tick()
+{
+    MockRepository mocks;
+    setup_sampler_mm(mocks);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        auto &&vmcs = setup_sampler_vmcs();
+        auto &&sampler = std::make_unique<page_age_sampler_intel_x64>(vmcs.get(), 2);
+
+        sampler->set_range(sampler_gpa, sampler_end);
+
+        this->expect_false(sampler->tick());
+        this->expect_true(sampler->m_cursor == sampler_gpa + 0x2000);
+        this->expect_true(sampler->histogram()[1] == 2);
+
+        this->expect_true(sampler->tick());
+        this->expect_true(sampler->m_cursor == sampler_gpa);
+        this->expect_true(sampler->histogram()[1] == 515);
+
+        teardown_sampler_vmcs(vmcs.get());
+    });
+}
+
+void
+eapis_ut::test_page_age_sampler_intel_x64_unmapped_pages()
+{
+    MockRepository mocks;
+    setup_sampler_mm(mocks);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        auto &&vmcs = setup_sampler_vmcs();
+        auto &&sampler = std::make_unique<page_age_sampler_intel_x64>(vmcs.get());
+
+        sampler->set_range(sampler_gpa, sampler_end);
+        sampler->tick();
+
+        vmcs->unmap(sampler_gpa + 0x1000);
+        vmcs->unmap(sampler_gpa + 0x200000);
+
+        sampler->tick();
+        this->expect_exception([&] { sampler->age(sampler_gpa + 0x1000); }, ""_ut_ree);
+        this->expect_exception([&] { sampler->age(sampler_gpa + 0x200000); }, ""_ut_ree);
+        this->expect_true(sampler->histogram()[2] == 2);
+        this->expect_true(sampler->m_tables.size() == 1);
+        this->expect_true(sampler->m_large.empty());
+
+        vmcs->map_4k(sampler_gpa + 0x1000, sampler_gpa + 0x1000, ept::memory_attr::pt_wb);
+        vmcs->map_2m(sampler_gpa + 0x200000, sampler_gpa + 0x200000, ept::memory_attr::pt_wb);
+
+        teardown_sampler_vmcs(vmcs.get());
+    });
+}
+
+void
+eapis_ut::test_page_age_sampler_intel_x64_set_range()
+{
+    MockRepository mocks;
+    setup_sampler_mm(mocks);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        auto &&vmcs = setup_sampler_vmcs();
+        auto &&sampler = std::make_unique<page_age_sampler_intel_x64>(vmcs.get());
+
+        sampler->set_range(sampler_gpa, sampler_end);
+        sampler->tick();
+
+        sampler->set_range(sampler_gpa + 0x1000, sampler_gpa + 0x200000);
+        this->expect_exception([&] { sampler->age(sampler_gpa); }, ""_ut_ree);
+        this->expect_exception([&] { sampler->age(sampler_gpa + 0x200000); }, ""_ut_ree);
+        this->expect_true(sampler->histogram()[1] == 2);
+
+        sampler->tick();
+        this->expect_true(sampler->age(sampler_gpa + 0x1000) == 2);
+        this->expect_true(sampler->age(sampler_gpa + 0x3000) == 2);
+        this->expect_true(sampler->histogram()[2] == 2);
+
+        teardown_sampler_vmcs(vmcs.get());
+    });
+}
+
+void
+eapis_ut::test_page_age_sampler_intel_x64_cold_ranges()
+{
+    MockRepository mocks;
+    setup_sampler_mm(mocks);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        auto &&vmcs = setup_sampler_vmcs();
+        auto &&sampler = std::make_unique<page_age_sampler_intel_x64>(vmcs.get());
+
+        sampler->set_range(sampler_gpa, sampler_end);
+        this->expect_true(sampler->cold_ranges(10).empty());
+
+        for (auto i = 0; i < 4; i++)
+        {
+            vmcs->gpa_to_epte(sampler_gpa + 0x1000)->set_accessed(true);
+            sampler->tick();
+        }
+
+        vmcs->gpa_to_epte(sampler_gpa + 0x3000)->set_accessed(true);
+        sampler->tick();
+
+        auto &&ranges = sampler->cold_ranges(10);
+        this->expect_true(ranges.size() == 3);
+
+        this->expect_true(ranges[0].gpa == sampler_gpa + 0x200000);
+        this->expect_true(ranges[0].size == 0x200000);
+        this->expect_true(ranges[0].age == 5);
+
+        this->expect_true(ranges[1].gpa == sampler_gpa);
+        this->expect_true(ranges[1].size == 0x1000);
+        this->expect_true(ranges[1].age == 5);
+
+        this->expect_true(ranges[2].gpa == sampler_gpa + 0x1000);
+        this->expect_true(ranges[2].size == 0x1000);
+        this->expect_true(ranges[2].age == 1);
+
+        ranges = sampler->cold_ranges(1);
+        this->expect_true(ranges.size() == 1);
+        this->expect_true(ranges[0].gpa == sampler_gpa + 0x200000);
+
+        teardown_sampler_vmcs(vmcs.get());
+    });
+}
+
+void
+eapis_ut::test_page_age_sampler_intel_x64_deferred_flush()
+{
+    MockRepository mocks;
+    setup_sampler_mm(mocks);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        auto &&vmcs = setup_sampler_vmcs();
+        auto &&sampler = std::make_unique<page_age_sampler_intel_x64>(vmcs.get());
+
+        page_age_sampler_intel_x64::flush_ticket_type ticket;
+        auto flushes = 0;
+
+        sampler->set_flush_delegate([&]
+        {
+            flushes++;
+            ticket = std::make_shared<std::atomic<std::size_t>>(1);
+
+            return ticket;
+        });
+
+        sampler->set_range(sampler_gpa, sampler_end);
+        vmcs->gpa_to_epte(sampler_gpa + 0x3000)->set_accessed(true);
+
+        this->expect_true(sampler->tick());
+        this->expect_true(flushes == 1);
+        this->expect_true(sampler->age(sampler_gpa + 0x0000) == 1);
+
+        // The pages are not aged again until every vCPU has flushed the
+        // translations that were cached before the accessed bits were
+        // cleared.
+
+        this->expect_false(sampler->tick());
+        this->expect_true(sampler->age(sampler_gpa + 0x0000) == 1);
+        this->expect_true(sampler->age(sampler_gpa + 0x3000) == 0);
+
+        ticket->store(0);
+
+        this->expect_true(sampler->tick());
+        this->expect_true(flushes == 1);
+        this->expect_true(sampler->age(sampler_gpa + 0x0000) == 2);
+        this->expect_true(sampler->age(sampler_gpa + 0x3000) == 1);
+
+        teardown_sampler_vmcs(vmcs.get());
+    });
+}
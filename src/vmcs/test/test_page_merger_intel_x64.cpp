@@ -0,0 +1,430 @@
+//
+// Bareflank Hypervisor
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <test.h>
+#include <memory_manager/memory_manager_x64.h>
+
+#include <vmcs/page_merger_intel_x64.h>
+#include <vmcs/vmcs_intel_x64_64bit_control_fields.h>
+
+using namespace intel_x64;
+using namespace vmcs;
+
+constexpr vmcs_intel_x64_eapis::integer_pointer merger_gpa = 0x0000100000000000UL;
+
+constexpr vmcs_intel_x64_eapis::integer_pointer frame_a = 0x000000000A000000UL;
+constexpr vmcs_intel_x64_eapis::integer_pointer frame_b = 0x000000000B000000UL;
+constexpr vmcs_intel_x64_eapis::integer_pointer frame_c = 0x000000000C000000UL;
+constexpr vmcs_intel_x64_eapis::integer_pointer frame_d = 0x000000000D000000UL;
+
+// Bit 1 of the exit qualification of an EPT violation (data write)
+constexpr page_merger_intel_x64::qualification_type data_write = 0x2UL;
+
+// Each fake frame is filled with a single repeating value, which is all that
+// is needed to tell the frames apart.
+
+static std::map<page_merger_intel_x64::integer_pointer, uint64_t> g_frames;
+
+class page_merger_ut : public page_merger_intel_x64
+{
+public:
+
+    page_merger_ut(gsl::not_null<vmcs_intel_x64_eapis *> vmcs, size_type pages_per_scan) :
+        page_merger_intel_x64(vmcs, pages_per_scan)
+    { }
+
+protected:
+
+    hash_type hash_page(integer_pointer phys) override
+    { return g_frames[phys]; }
+
+    bool compare_pages(integer_pointer phys1, integer_pointer phys2) override
+    { return g_frames[phys1] == g_frames[phys2]; }
+
+    void copy_page(integer_pointer dst_phys, integer_pointer src_phys) override
+    { g_frames[dst_phys] = g_frames[src_phys]; }
+};
+
+static auto
+setup_merger_mm(MockRepository &mocks)
+{
+    auto mm = mocks.Mock<memory_manager_x64>();
+    mocks.OnCallFunc(memory_manager_x64::instance).Return(mm);
+    mocks.OnCall(mm, memory_manager_x64::virtptr_to_physint).Return(0x0000000000042000UL);
+
+    return mm;
+}
+
+static auto
+setup_merger_vmcs()
+{
+    auto &&vmcs = std::make_unique<vmcs_intel_x64_eapis>();
+    ept_pointer::set(0UL);
+
+    vmcs->map_4k(merger_gpa + 0x0000, frame_a, ept::memory_attr::pt_wb);
+    vmcs->map_4k(merger_gpa + 0x1000, frame_b, ept::memory_attr::pt_wb);
+    vmcs->map_4k(merger_gpa + 0x2000, frame_c, ept::memory_attr::pt_wb);
+    vmcs->map_4k(merger_gpa + 0x3000, frame_d, ept::memory_attr::pt_wb);
+
+    g_frames[frame_a] = 0;
+    g_frames[frame_b] = 0;
+    g_frames[frame_c] = 42;
+    g_frames[frame_d] = 0;
+
+    return std::move(vmcs);
+}
+
+static void
+teardown_merger_vmcs(gsl::not_null<vmcs_intel_x64_eapis *> vmcs)
+{
+    vmcs->unmap(merger_gpa + 0x0000);
+    vmcs->unmap(merger_gpa + 0x1000);
+    vmcs->unmap(merger_gpa + 0x2000);
+    vmcs->unmap(merger_gpa + 0x3000);
+}
+
+void
+eapis_ut::test_page_merger_intel_x64_scan_invalid()
+{
+    MockRepository mocks;
+    setup_merger_mm(mocks);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        auto &&vmcs = std::make_unique<vmcs_intel_x64_eapis>();
+        auto &&merger = std::make_unique<page_merger_ut>(vmcs.get(), 16);
+
+        this->expect_exception([&] { merger->scan(merger_gpa, merger_gpa); }, ""_ut_ffe);
+        this->expect_true(merger->scan(merger_gpa, merger_gpa + 0x4000) == 0);
+    });
+}
+
+void
+eapis_ut::test_page_merger_intel_x64_merge()
+{
+    MockRepository mocks;
+    setup_merger_mm(mocks);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        auto &&vmcs = setup_merger_vmcs();
+        auto &&merger = std::make_unique<page_merger_ut>(vmcs.get(), 16);
+
+        this->expect_true(merger->scan(merger_gpa, merger_gpa + 0x4000) == 0);
+        this->expect_true(merger->scan(merger_gpa, merger_gpa + 0x4000) == 2);
+
+        this->expect_true(merger->merged_pages() == 3);
+        this->expect_true(merger->shared_frames() == 1);
+
+        this->expect_true(vmcs->gpa_to_epte(merger_gpa + 0x0000)->phys_addr() == frame_a);
+        this->expect_true(vmcs->gpa_to_epte(merger_gpa + 0x1000)->phys_addr() == frame_a);
+        this->expect_true(vmcs->gpa_to_epte(merger_gpa + 0x2000)->phys_addr() == frame_c);
+        this->expect_true(vmcs->gpa_to_epte(merger_gpa + 0x3000)->phys_addr() == frame_a);
+
+        this->expect_false(vmcs->gpa_to_epte(merger_gpa + 0x0000)->write_access());
+        this->expect_false(vmcs->gpa_to_epte(merger_gpa + 0x1000)->write_access());
+        this->expect_true(vmcs->gpa_to_epte(merger_gpa + 0x2000)->write_access());
+        this->expect_false(vmcs->gpa_to_epte(merger_gpa + 0x3000)->write_access());
+
+        auto &&frames = merger->reclaim_frames();
+        this->expect_true(frames.size() == 2);
+        this->expect_true(frames[0] == frame_b);
+        this->expect_true(frames[1] == frame_d);
+        this->expect_true(merger->reclaim_frames().empty());
+
+        teardown_merger_vmcs(vmcs.get());
+    });
+}
+
+void
+eapis_ut::test_page_merger_intel_x64_pages_per_scan()
+{
+    MockRepository mocks;
+    setup_merger_mm(mocks);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        auto &&vmcs = setup_merger_vmcs();
+        auto &&merger = std::make_unique<page_merger_ut>(vmcs.get(), 2);
+
+        merger->scan(merger_gpa, merger_gpa + 0x4000);
+        this->expect_true(merger->m_hashes.size() == 2);
+        this->expect_true(merger->m_cursor == merger_gpa + 0x2000);
+
+        merger->scan(merger_gpa, merger_gpa + 0x4000);
+        this->expect_true(merger->m_hashes.size() == 4);
+        this->expect_true(merger->m_cursor == merger_gpa);
+
+        teardown_merger_vmcs(vmcs.get());
+    });
+}
+
+void
+eapis_ut::test_page_merger_intel_x64_dirty_pages()
+{
+    MockRepository mocks;
+    setup_merger_mm(mocks);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        auto &&vmcs = setup_merger_vmcs();
+        auto &&merger = std::make_unique<page_merger_ut>(vmcs.get(), 16);
+
+        merger->scan(merger_gpa, merger_gpa + 0x4000);
+
+        vmcs->gpa_to_epte(merger_gpa + 0x1000)->set_dirty(true);
+        vmcs->gpa_to_epte(merger_gpa + 0x3000)->set_dirty(true);
+
+        this->expect_true(merger->scan(merger_gpa, merger_gpa + 0x4000) == 0);
+        this->expect_false(vmcs->gpa_to_epte(merger_gpa + 0x1000)->dirty());
+        this->expect_false(vmcs->gpa_to_epte(merger_gpa + 0x3000)->dirty());
+        this->expect_true(merger->merged_pages() == 0);
+
+        teardown_merger_vmcs(vmcs.get());
+    });
+}
+
+void
+eapis_ut::test_page_merger_intel_x64_changed_pages()
+{
+    MockRepository mocks;
+    setup_merger_mm(mocks);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        auto &&vmcs = setup_merger_vmcs();
+        auto &&merger = std::make_unique<page_merger_ut>(vmcs.get(), 16);
+
+        merger->scan(merger_gpa, merger_gpa + 0x4000);
+        g_frames[frame_b] = 1;
+        g_frames[frame_d] = 2;
+
+        this->expect_true(merger->scan(merger_gpa, merger_gpa + 0x4000) == 0);
+        this->expect_true(merger->merged_pages() == 0);
+
+        teardown_merger_vmcs(vmcs.get());
+    });
+}
+
+void
+eapis_ut::test_page_merger_intel_x64_write_violation()
+{
+    MockRepository mocks;
+    setup_merger_mm(mocks);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        auto &&vmcs = setup_merger_vmcs();
+        auto &&merger = std::make_unique<page_merger_ut>(vmcs.get(), 16);
+
+        merger->scan(merger_gpa, merger_gpa + 0x4000);
+        merger->scan(merger_gpa, merger_gpa + 0x4000);
+
+        this->expect_false(merger->handle_write_violation(merger_gpa + 0x1010, 0));
+        this->expect_true(merger->merged_pages() == 3);
+
+        this->expect_false(merger->handle_write_violation(merger_gpa + 0x5000, data_write));
+        this->expect_true(merger->handle_write_violation(merger_gpa + 0x2000, data_write));
+        this->expect_true(vmcs->gpa_to_epte(merger_gpa + 0x2000)->write_access());
+
+        this->expect_true(merger->handle_write_violation(merger_gpa + 0x1010, data_write));
+        this->expect_true(vmcs->gpa_to_epte(merger_gpa + 0x1000)->phys_addr() == frame_d);
+        this->expect_true(vmcs->gpa_to_epte(merger_gpa + 0x1000)->write_access());
+        this->expect_true(merger->merged_pages() == 2);
+
+        this->expect_true(merger->handle_write_violation(merger_gpa + 0x3000, data_write));
+        this->expect_true(vmcs->gpa_to_epte(merger_gpa + 0x3000)->phys_addr() == frame_b);
+        this->expect_true(vmcs->gpa_to_epte(merger_gpa + 0x3000)->write_access());
+
+        this->expect_true(merger->handle_write_violation(merger_gpa + 0x0000, data_write));
+        this->expect_true(vmcs->gpa_to_epte(merger_gpa + 0x0000)->phys_addr() == frame_a);
+        this->expect_true(vmcs->gpa_to_epte(merger_gpa + 0x0000)->write_access());
+
+        this->expect_true(merger->merged_pages() == 0);
+        this->expect_true(merger->shared_frames() == 0);
+        this->expect_false(merger->handle_write_violation(merger_gpa + 0x0000, 0));
+
+        teardown_merger_vmcs(vmcs.get());
+    });
+}
+
+void
+eapis_ut::test_page_merger_intel_x64_deferred_flush()
+{
+    MockRepository mocks;
+    setup_merger_mm(mocks);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        auto &&vmcs = setup_merger_vmcs();
+        auto &&merger = std::make_unique<page_merger_ut>(vmcs.get(), 16);
+
+        page_merger_intel_x64::flush_ticket_type ticket;
+        auto flushes = 0;
+
+        merger->set_flush_delegate([&]
+        {
+            flushes++;
+            ticket = std::make_shared<std::atomic<std::size_t>>(1);
+
+            return ticket;
+        });
+
+        // The duplicates are write-protected, but are not compared until
+        // the flush completes.
+
+        this->expect_true(merger->scan(merger_gpa, merger_gpa + 0x4000) == 0);
+        this->expect_true(merger->scan(merger_gpa, merger_gpa + 0x4000) == 0);
+        this->expect_true(flushes == 1);
+        this->expect_true(merger->merged_pages() == 0);
+
+        this->expect_false(vmcs->gpa_to_epte(merger_gpa + 0x0000)->write_access());
+        this->expect_false(vmcs->gpa_to_epte(merger_gpa + 0x1000)->write_access());
+        this->expect_true(vmcs->gpa_to_epte(merger_gpa + 0x2000)->write_access());
+        this->expect_false(vmcs->gpa_to_epte(merger_gpa + 0x3000)->write_access());
+        this->expect_true(vmcs->gpa_to_epte(merger_gpa + 0x1000)->phys_addr() == frame_b);
+
+        this->expect_true(merger->scan(merger_gpa, merger_gpa + 0x4000) == 0);
+        this->expect_true(flushes == 1);
+
+        // A write to a protected page before the flush completes makes the
+        // page writable again, and it is no longer merged.
+
+        this->expect_true(merger->handle_write_violation(merger_gpa + 0x3000, data_write));
+        this->expect_true(vmcs->gpa_to_epte(merger_gpa + 0x3000)->write_access());
+
+        ticket->store(0);
+
+        this->expect_true(merger->scan(merger_gpa, merger_gpa + 0x4000) == 1);
+        this->expect_true(merger->merged_pages() == 2);
+        this->expect_true(vmcs->gpa_to_epte(merger_gpa + 0x1000)->phys_addr() == frame_a);
+        this->expect_true(vmcs->gpa_to_epte(merger_gpa + 0x3000)->phys_addr() == frame_d);
+
+        // The freed frame is only reclaimable once the flush that follows
+        // the merge completes.
+
+        this->expect_true(flushes == 2);
+        this->expect_true(merger->reclaim_frames().empty());
+
+        ticket->store(0);
+        merger->scan(merger_gpa, merger_gpa + 0x4000);
+
+        auto &&frames = merger->reclaim_frames();
+        this->expect_true(frames.size() == 1);
+        this->expect_true(frames[0] == frame_b);
+
+        teardown_merger_vmcs(vmcs.get());
+    });
+}
+
+void
+eapis_ut::test_page_merger_intel_x64_write_violation_deferred_flush()
+{
+    MockRepository mocks;
+    setup_merger_mm(mocks);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        auto &&vmcs = setup_merger_vmcs();
+        auto &&merger = std::make_unique<page_merger_ut>(vmcs.get(), 16);
+
+        page_merger_intel_x64::flush_ticket_type ticket;
+        auto flushes = 0;
+
+        merger->set_flush_delegate([&]
+        {
+            flushes++;
+            ticket = std::make_shared<std::atomic<std::size_t>>(1);
+
+            return ticket;
+        });
+
+        merger->scan(merger_gpa, merger_gpa + 0x4000);
+        merger->scan(merger_gpa, merger_gpa + 0x4000);
+
+        ticket->store(0);
+        merger->scan(merger_gpa, merger_gpa + 0x4000);
+
+        this->expect_true(merger->merged_pages() == 3);
+
+        // The private copy stays read-only until every vCPU has flushed
+        // its translations to the shared frame.
+
+        auto &&shared = vmcs->gpa_to_epte(merger_gpa + 0x1000)->phys_addr();
+        auto &&before = flushes;
+
+        this->expect_true(merger->handle_write_violation(merger_gpa + 0x1010, data_write));
+        this->expect_true(flushes == before + 1);
+        this->expect_true(merger->merged_pages() == 2);
+        this->expect_true(vmcs->gpa_to_epte(merger_gpa + 0x1000)->phys_addr() != shared);
+        this->expect_false(vmcs->gpa_to_epte(merger_gpa + 0x1000)->write_access());
+
+        this->expect_true(merger->handle_write_violation(merger_gpa + 0x1010, data_write));
+        this->expect_false(vmcs->gpa_to_epte(merger_gpa + 0x1000)->write_access());
+
+        ticket->store(0);
+
+        this->expect_true(merger->handle_write_violation(merger_gpa + 0x1010, data_write));
+        this->expect_true(vmcs->gpa_to_epte(merger_gpa + 0x1000)->write_access());
+        this->expect_true(flushes == before + 1);
+
+        teardown_merger_vmcs(vmcs.get());
+    });
+}
+
+void
+eapis_ut::test_page_merger_intel_x64_pin()
+{
+    MockRepository mocks;
+    setup_merger_mm(mocks);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        auto &&vmcs = setup_merger_vmcs();
+        auto &&merger = std::make_unique<page_merger_ut>(vmcs.get(), 16);
+
+        this->expect_true(merger->pin(merger_gpa + 0x1010));
+        this->expect_true(merger->pin(merger_gpa + 0x1000));
+
+        merger->scan(merger_gpa, merger_gpa + 0x4000);
+        merger->scan(merger_gpa, merger_gpa + 0x4000);
+
+        this->expect_true(merger->merged_pages() == 2);
+        this->expect_true(vmcs->gpa_to_epte(merger_gpa + 0x1000)->phys_addr() == frame_b);
+        this->expect_true(vmcs->gpa_to_epte(merger_gpa + 0x1000)->write_access());
+
+        this->expect_false(merger->pin(merger_gpa + 0x3000));
+
+        merger->unpin(merger_gpa + 0x1000);
+        merger->scan(merger_gpa, merger_gpa + 0x4000);
+        this->expect_true(vmcs->gpa_to_epte(merger_gpa + 0x1000)->phys_addr() == frame_b);
+
+        merger->unpin(merger_gpa + 0x1000);
+        merger->unpin(merger_gpa + 0x1000);
+        merger->scan(merger_gpa, merger_gpa + 0x4000);
+        merger->scan(merger_gpa, merger_gpa + 0x4000);
+
+        this->expect_true(merger->merged_pages() == 3);
+        this->expect_true(vmcs->gpa_to_epte(merger_gpa + 0x1000)->phys_addr() == frame_a);
+
+        teardown_merger_vmcs(vmcs.get());
+    });
+}
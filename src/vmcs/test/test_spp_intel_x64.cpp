@@ -0,0 +1,178 @@
+//
+// Bareflank Hypervisor
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <gsl/gsl>
+
+#include <test.h>
+#include <vmcs/spp_intel_x64.h>
+#include <memory_manager/memory_manager_x64.h>
+
+constexpr spp_intel_x64::integer_pointer spp_gpa = 0x0000123456780000UL;
+
+static auto
+setup_mm(MockRepository &mocks)
+{
+    auto mm = mocks.Mock<memory_manager_x64>();
+    mocks.OnCallFunc(memory_manager_x64::instance).Return(mm);
+    mocks.OnCall(mm, memory_manager_x64::virtptr_to_physint).Return(0x0000000ABCDEF0000);
+
+    return mm;
+}
+
+void
+eapis_ut::test_spp_intel_x64_mask_to_vector()
+{
+    this->expect_true(spp_intel_x64::mask_to_vector(0x00000000U) == 0x0000000000000000UL);
+    this->expect_true(spp_intel_x64::mask_to_vector(0x00000001U) == 0x0000000000000001UL);
+    this->expect_true(spp_intel_x64::mask_to_vector(0x00000002U) == 0x0000000000000004UL);
+    this->expect_true(spp_intel_x64::mask_to_vector(0x80000000U) == 0x4000000000000000UL);
+    this->expect_true(spp_intel_x64::mask_to_vector(0xFFFFFFFFU) == intel_x64::spp::write_bits_mask);
+}
+
+void
+eapis_ut::test_spp_intel_x64_vector_to_mask()
+{
+    this->expect_true(spp_intel_x64::vector_to_mask(0x0000000000000000UL) == 0x00000000U);
+    this->expect_true(spp_intel_x64::vector_to_mask(0x0000000000000001UL) == 0x00000001U);
+    this->expect_true(spp_intel_x64::vector_to_mask(0x0000000000000004UL) == 0x00000002U);
+    this->expect_true(spp_intel_x64::vector_to_mask(0x4000000000000000UL) == 0x80000000U);
+    this->expect_true(spp_intel_x64::vector_to_mask(0xFFFFFFFFFFFFFFFFUL) == 0xFFFFFFFFU);
+    this->expect_true(spp_intel_x64::vector_to_mask(0xAAAAAAAAAAAAAAAAUL) == 0x00000000U);
+}
+
+void
+eapis_ut::test_spp_intel_x64_set_write_mask()
+{
+    MockRepository mocks;
+    setup_mm(mocks);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        auto &&sppt = std::make_unique<spp_intel_x64>();
+
+        sppt->set_write_mask(spp_gpa, 0x0000FFFF);
+        this->expect_true(sppt->global_size() == 4);
+        this->expect_true(sppt->write_mask(spp_gpa) == 0x0000FFFF);
+        this->expect_true(sppt->write_mask(spp_gpa + 0xFFF) == 0x0000FFFF);
+
+        sppt->set_write_mask(spp_gpa, 0x00000000);
+        this->expect_true(sppt->global_size() == 4);
+        this->expect_true(sppt->write_mask(spp_gpa) == 0x00000000);
+
+        sppt->set_write_mask(spp_gpa + 0x1000, 0x80000001);
+        this->expect_true(sppt->global_size() == 5);
+        this->expect_true(sppt->write_mask(spp_gpa + 0x1000) == 0x80000001);
+
+        sppt->set_write_mask(spp_gpa + 0x40000000, 0x1);
+        this->expect_true(sppt->global_size() == 8);
+
+        this->expect_exception([&]{ sppt->write_mask(spp_gpa + 0x2000); }, ""_ut_ree);
+        this->expect_exception([&]{ sppt->write_mask(spp_gpa + 0x80000000000); }, ""_ut_ree);
+
+        this->expect_exception([&]{ sppt->set_write_mask(intel_x64::spp::max_gpa | spp_gpa, 0x1); }, ""_ut_ffe);
+        this->expect_exception([&]{ sppt->write_mask(intel_x64::spp::max_gpa | spp_gpa); }, ""_ut_ffe);
+        this->expect_true(sppt->global_size() == 8);
+    });
+}
+
+void
+eapis_ut::test_spp_intel_x64_table_format()
+{
+    MockRepository mocks;
+    setup_mm(mocks);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        using namespace intel_x64;
+        auto &&sppt = std::make_unique<spp_intel_x64>();
+
+        sppt->set_write_mask(spp_gpa, 0x00000003);
+
+        auto &&pml4_index = ept::index(spp_gpa, ept::pml4::from);
+        auto &&pdpt_index = ept::index(spp_gpa, ept::pdpt::from);
+        auto &&pd_index = ept::index(spp_gpa, ept::pd::from);
+        auto &&pt_index = ept::index(spp_gpa, ept::pt::from);
+
+        auto &&pml4e = sppt->m_sppt[pml4_index];
+        this->expect_true((pml4e & spp::valid) != 0);
+        this->expect_true((pml4e & spp::phys_addr_mask) == 0x0000000ABCDEF0000);
+        this->expect_true((pml4e & ~(spp::phys_addr_mask | spp::valid)) == 0);
+
+        auto &&sppdpt = sppt->m_sppts[pml4_index];
+        this->expect_true((sppdpt->m_sppt[pdpt_index] & spp::valid) != 0);
+
+        auto &&sppd = sppdpt->m_sppts[pdpt_index];
+        this->expect_true((sppd->m_sppt[pd_index] & spp::valid) != 0);
+
+        auto &&sppl1 = sppd->m_sppts[pd_index];
+        this->expect_true(sppl1->m_sppt[pt_index] == 0x0000000000000005UL);
+        this->expect_true((sppl1->m_sppt[pt_index] & ~spp::write_bits_mask) == 0);
+
+        for (auto i = 0UL; i < ept::num_entries; i++)
+        {
+            if (i != pml4_index)
+                this->expect_true(sppt->m_sppt[i] == 0);
+        }
+    });
+}
+
+void
+eapis_ut::test_spp_intel_x64_clear_write_mask()
+{
+    MockRepository mocks;
+    setup_mm(mocks);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        auto &&sppt = std::make_unique<spp_intel_x64>();
+
+        sppt->set_write_mask(spp_gpa, 0x1);
+        sppt->set_write_mask(spp_gpa + 0x1000, 0x1);
+        this->expect_true(sppt->global_size() == 5);
+
+        sppt->clear_write_mask(spp_gpa);
+        this->expect_true(sppt->global_size() == 4);
+        this->expect_exception([&]{ sppt->write_mask(spp_gpa); }, ""_ut_ree);
+
+        sppt->clear_write_mask(spp_gpa + 0x1000);
+        this->expect_true(sppt->global_size() == 0);
+
+        auto &&pml4_index = intel_x64::ept::index(spp_gpa, intel_x64::ept::pml4::from);
+        this->expect_true(sppt->m_sppt[pml4_index] == 0);
+    });
+}
+
+void
+eapis_ut::test_spp_intel_x64_clear_write_mask_unknown_failure()
+{
+    MockRepository mocks;
+    setup_mm(mocks);
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        auto &&sppt = std::make_unique<spp_intel_x64>();
+        this->expect_exception([&]{ sppt->clear_write_mask(spp_gpa); }, ""_ut_ree);
+
+        sppt->set_write_mask(spp_gpa, 0x1);
+        this->expect_exception([&]{ sppt->clear_write_mask(spp_gpa + 0x1000); }, ""_ut_ree);
+        this->expect_exception([&]{ sppt->clear_write_mask(intel_x64::spp::max_gpa | spp_gpa); }, ""_ut_ffe);
+    });
+}
@@ -26,12 +26,16 @@
 #include <vmcs/vmcs_intel_x64_16bit_control_fields.h>
 #include <vmcs/vmcs_intel_x64_32bit_control_fields.h>
 #include <vmcs/vmcs_intel_x64_64bit_control_fields.h>
+#include <vmcs/vmcs_intel_x64_64bit_guest_state_fields.h>
+#include <vmcs/vmcs_intel_x64_64bit_host_state_fields.h>
+#include <vmcs/vmcs_intel_x64_eapis_control_fields.h>
 
 using namespace intel_x64;
 using namespace vmcs;
 
 static std::map<intel_x64::msrs::field_type, intel_x64::msrs::value_type> g_msrs;
 static std::map<intel_x64::vmcs::field_type, intel_x64::vmcs::value_type> g_vmcs;
+static uint64_t g_invvpid_type = 0;
 
 extern "C" bool
 __vmread(uint64_t field, uint64_t *val) noexcept
@@ -69,7 +73,7 @@ __invept(uint64_t type, void *ptr) noexcept
 
 extern "C" void
 __invvipd(uint64_t type, void *ptr) noexcept
-{ (void) type; (void) ptr; }
+{ g_invvpid_type = type; (void) ptr; }
 
 uintptr_t
 virtptr_to_physint(void *ptr)
@@ -86,23 +90,27 @@ setup_mm(MockRepository &mocks)
 }
 
 auto
-setup_vmcs()
+setup_vmcs(intel_x64::msrs::value_type ept_vpid_cap = 0xFFFFFFFFFFFFFFFFUL)
 {
-    auto &&vmcs = std::make_unique<vmcs_intel_x64_eapis>();
-
     g_msrs[intel_x64::msrs::ia32_vmx_procbased_ctls2::addr] = 0xFFFFFFFF00000000UL;
     g_msrs[intel_x64::msrs::ia32_vmx_true_pinbased_ctls::addr] = 0xFFFFFFFF00000000UL;
     g_msrs[intel_x64::msrs::ia32_vmx_true_procbased_ctls::addr] = 0xFFFFFFFF00000000UL;
     g_msrs[intel_x64::msrs::ia32_vmx_true_exit_ctls::addr] = 0xFFFFFFFF00000000UL;
     g_msrs[intel_x64::msrs::ia32_vmx_true_entry_ctls::addr] = 0xFFFFFFFF00000000UL;
+    g_msrs[intel_x64::msrs::ia32_vmx_ept_vpid_cap::addr] = ept_vpid_cap;
 
+    // The shared IO bitmaps are global, so each test starts over with every
+    // port passed through.
+    vmcs_intel_x64_eapis::shared_io_bitmaps()->pass_through_io_range(0x0000, 0xFFFF);
+
+    auto &&vmcs = std::make_unique<vmcs_intel_x64_eapis>();
     return std::move(vmcs);
 }
 
 void
 eapis_ut::test_construction()
 {
-    this->expect_no_exception([&] { std::make_unique<vmcs_intel_x64_eapis>(); });
+    this->expect_no_exception([&]{ std::make_unique<vmcs_intel_x64_eapis>(); });
 }
 
 void
@@ -119,9 +127,39 @@ eapis_ut::test_launch()
     this->expect_true(address_of_io_bitmap_a::get() != 0);
     this->expect_true(address_of_io_bitmap_b::get() != 0);
 
+    this->expect_true(primary_processor_based_vm_execution_controls::use_msr_bitmaps::is_enabled());
+    this->expect_true(address_of_msr_bitmaps::get() != 0);
+
     this->expect_true(secondary_processor_based_vm_execution_controls::enable_vpid::is_disabled());
 }
 
+void
+eapis_ut::test_launch_reset_io_bitmaps()
+{
+    MockRepository mocks;
+    setup_mm(mocks);
+    auto &&vmss = std::make_unique<vmcs_intel_x64_state>();
+    auto &&bitmaps = vmcs_intel_x64_eapis::shared_io_bitmaps();
+
+    {
+        auto &&vmcs1 = setup_vmcs();
+        auto &&vmcs2 = setup_vmcs();
+
+        bitmaps->trap_on_io_access(0x42);
+        vmcs1->launch(vmss.get(), vmss.get());
+        this->expect_true(bitmaps->bitmap_a()[8] == 0x0);
+
+        bitmaps->trap_on_io_access(0x42);
+        vmcs2->launch(vmss.get(), vmss.get());
+        this->expect_true(bitmaps->bitmap_a()[8] == 0x4);
+    }
+
+    auto &&vmcs3 = std::make_unique<vmcs_intel_x64_eapis>();
+
+    vmcs3->launch(vmss.get(), vmss.get());
+    this->expect_true(bitmaps->bitmap_a()[8] == 0x0);
+}
+
 void
 eapis_ut::test_enable_vpid()
 {
@@ -134,6 +172,138 @@ eapis_ut::test_enable_vpid()
     this->expect_true(vmcs::virtual_processor_identifier::get() != 0);
 }
 
+void
+eapis_ut::test_enable_vpid_release()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs();
+
+    vmcs->enable_vpid();
+    auto &&vpid = gsl::narrow_cast<vpid_allocator_intel_x64::vpid_type>(vmcs::virtual_processor_identifier::get());
+
+    vmcs->disable_vpid();
+    vmcs->enable_vpid();
+
+    this->expect_true(vmcs::virtual_processor_identifier::get() == vpid);
+    this->expect_true(vpid_allocator_intel_x64::instance().is_allocated(vpid));
+    this->expect_false(vmcs->m_vpid_flush_pending);
+
+    vmcs.reset();
+    this->expect_false(vpid_allocator_intel_x64::instance().is_allocated(vpid));
+}
+
+void
+eapis_ut::test_queue_vpid_invalidation()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs();
+
+    vmcs->enable_vpid();
+
+    vmcs->queue_vpid_invalidation(0x1000);
+    vmcs->queue_vpid_invalidation(0x1FFF);
+    vmcs->queue_vpid_invalidation(0x2000);
+
+    this->expect_true(vmcs->m_vpid_invalidation_count == 2);
+    this->expect_true(vmcs->m_vpid_invalidations[0] == 0x1000);
+    this->expect_true(vmcs->m_vpid_invalidations[1] == 0x2000);
+    this->expect_false(vmcs->m_vpid_invalidate_context);
+}
+
+void
+eapis_ut::test_queue_vpid_invalidation_overflow()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs();
+
+    vmcs->enable_vpid();
+
+    for (auto i = 0UL; i <= VPID_INVALIDATION_QUEUE_SIZE; i++)
+        vmcs->queue_vpid_invalidation(i << 12);
+
+    this->expect_true(vmcs->m_vpid_invalidation_count == 0);
+    this->expect_true(vmcs->m_vpid_invalidate_context);
+
+    vmcs->queue_vpid_invalidation(0x1000);
+    this->expect_true(vmcs->m_vpid_invalidation_count == 0);
+}
+
+void
+eapis_ut::test_flush_vpid_invalidations()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs();
+
+    vmcs->enable_vpid();
+
+    vmcs->queue_vpid_invalidation(0x1000);
+    this->expect_no_exception([&]{ vmcs->flush_vpid_invalidations(); });
+    this->expect_true(vmcs->m_vpid_invalidation_count == 0);
+
+    for (auto i = 0UL; i <= VPID_INVALIDATION_QUEUE_SIZE; i++)
+        vmcs->queue_vpid_invalidation(i << 12);
+
+    this->expect_no_exception([&]{ vmcs->flush_vpid_invalidations(); });
+    this->expect_false(vmcs->m_vpid_invalidate_context);
+
+    vmcs->queue_vpid_invalidation(0x1000);
+    vmcs->disable_vpid();
+    this->expect_true(vmcs->m_vpid_invalidation_count == 0);
+}
+
+void
+eapis_ut::test_invalidate_all_vpid_contexts()
+{
+    using namespace msrs::ia32_vmx_ept_vpid_cap;
+
+    constexpr const auto none = ~0UL;
+    constexpr const auto single_context = 1UL;
+    constexpr const auto all_context = 2UL;
+
+    {
+        auto &&vmcs = setup_vmcs();
+        vmcs->enable_vpid();
+
+        g_invvpid_type = none;
+        vmcs->invalidate_all_vpid_contexts();
+        this->expect_true(g_invvpid_type == all_context);
+    }
+
+    {
+        auto &&vmcs = setup_vmcs(~invvpid_all_context::mask);
+        vmcs->enable_vpid();
+
+        g_invvpid_type = none;
+        vmcs->invalidate_all_vpid_contexts();
+        this->expect_true(g_invvpid_type == single_context);
+
+        vmcs->disable_vpid();
+
+        g_invvpid_type = none;
+        vmcs->invalidate_all_vpid_contexts();
+        this->expect_true(g_invvpid_type == none);
+    }
+
+    {
+        auto &&vmcs = setup_vmcs(~invvpid_single_context::mask);
+        vmcs->enable_vpid();
+
+        g_invvpid_type = none;
+        vmcs->invalidate_vpid_context();
+        this->expect_true(g_invvpid_type == all_context);
+    }
+
+    {
+        auto &&vmcs = setup_vmcs(~(invvpid_single_context::mask | invvpid_all_context::mask));
+        vmcs->enable_vpid();
+
+        g_invvpid_type = none;
+        this->expect_no_exception([&]{ vmcs->invalidate_vpid_context(); });
+        this->expect_no_exception([&]{ vmcs->invalidate_all_vpid_contexts(); });
+        this->expect_true(g_invvpid_type == none);
+    }
+}
+
 void
 eapis_ut::test_disable_vpid()
 {
@@ -155,8 +325,8 @@ eapis_ut::test_trap_on_io_access()
     vmcs->trap_on_io_access(0x42);
     vmcs->trap_on_io_access(0x8042);
 
-    this->expect_true(vmcs->m_io_bitmapa_view[8] == 0x4);
-    this->expect_true(vmcs->m_io_bitmapb_view[8] == 0x4);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_a()[8] == 0x4);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_b()[8] == 0x4);
 }
 
 void
@@ -168,13 +338,13 @@ eapis_ut::test_trap_on_all_io_accesses()
     vmcs->trap_on_all_io_accesses();
 
     auto all_seta = 0xFF;
-    for (auto val : vmcs->m_io_bitmapa_view)
+    for (auto val : vmcs->m_io_bitmaps->bitmap_a())
         all_seta &= val;
 
     this->expect_true(all_seta == 0xFF);
 
     auto all_setb = 0xFF;
-    for (auto val : vmcs->m_io_bitmapa_view)
+    for (auto val : vmcs->m_io_bitmaps->bitmap_a())
         all_setb &= val;
 
     this->expect_true(all_setb == 0xFF);
@@ -190,8 +360,8 @@ eapis_ut::test_pass_through_io_access()
     vmcs->pass_through_io_access(0x42);
     vmcs->pass_through_io_access(0x8042);
 
-    this->expect_true(vmcs->m_io_bitmapa_view[8] == 0xFB);
-    this->expect_true(vmcs->m_io_bitmapb_view[8] == 0xFB);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_a()[8] == 0xFB);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_b()[8] == 0xFB);
 }
 
 void
@@ -203,18 +373,70 @@ eapis_ut::test_pass_through_all_io_accesses()
     vmcs->pass_through_all_io_accesses();
 
     auto all_seta = 0x0;
-    for (auto val : vmcs->m_io_bitmapa_view)
+    for (auto val : vmcs->m_io_bitmaps->bitmap_a())
         all_seta |= val;
 
     this->expect_true(all_seta == 0x0);
 
     auto all_setb = 0x0;
-    for (auto val : vmcs->m_io_bitmapa_view)
+    for (auto val : vmcs->m_io_bitmaps->bitmap_a())
         all_setb |= val;
 
     this->expect_true(all_setb == 0x0);
 }
 
+void
+eapis_ut::test_trap_on_io_range()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs();
+
+    vmcs->pass_through_all_io_accesses();
+
+    vmcs->trap_on_io_range(0x42, 0x42);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_a()[8] == 0x4);
+
+    vmcs->trap_on_io_range(0x7FFC, 0x8103);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_a()[0xFFE] == 0x00);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_a()[0xFFF] == 0xF0);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_b()[0x00] == 0xFF);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_b()[0x1F] == 0xFF);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_b()[0x20] == 0x0F);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_b()[0x21] == 0x00);
+
+    vmcs->trap_on_io_range(0x0, 0xFFFF);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_a()[0x000] == 0xFF);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_b()[0xFFF] == 0xFF);
+
+    this->expect_exception([&] { vmcs->trap_on_io_range(0x43, 0x42); }, ""_ut_ffe);
+}
+
+void
+eapis_ut::test_pass_through_io_range()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs();
+
+    vmcs->trap_on_all_io_accesses();
+
+    vmcs->pass_through_io_range(0x42, 0x42);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_a()[8] == 0xFB);
+
+    vmcs->pass_through_io_range(0x7FFC, 0x8103);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_a()[0xFFE] == 0xFF);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_a()[0xFFF] == 0x0F);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_b()[0x00] == 0x00);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_b()[0x1F] == 0x00);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_b()[0x20] == 0xF0);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_b()[0x21] == 0xFF);
+
+    vmcs->pass_through_io_range(0x0, 0xFFFF);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_a()[0x000] == 0x00);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_b()[0xFFF] == 0x00);
+
+    this->expect_exception([&] { vmcs->pass_through_io_range(0x43, 0x42); }, ""_ut_ffe);
+}
+
 void
 eapis_ut::test_whitelist_io_access()
 {
@@ -222,8 +444,13 @@ eapis_ut::test_whitelist_io_access()
     auto &&vmcs = setup_vmcs();
 
     vmcs->whitelist_io_access({0x42, 0x8042});
-    this->expect_true(vmcs->m_io_bitmapa_view[8] == 0xFB);
-    this->expect_true(vmcs->m_io_bitmapb_view[8] == 0xFB);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_a()[8] == 0xFB);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_b()[8] == 0xFB);
+
+    vmcs->whitelist_io_access({0x40, 0x41, 0x42, 0x43, 0x47, 0x7FFF, 0x8000});
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_a()[8] == 0x70);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_a()[0xFFF] == 0x7F);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_b()[0] == 0xFE);
 }
 
 void
@@ -233,8 +460,321 @@ eapis_ut::test_blacklist_io_access()
     auto &&vmcs = setup_vmcs();
 
     vmcs->blacklist_io_access({0x42, 0x8042});
-    this->expect_true(vmcs->m_io_bitmapa_view[8] == 0x4);
-    this->expect_true(vmcs->m_io_bitmapb_view[8] == 0x4);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_a()[8] == 0x4);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_b()[8] == 0x4);
+
+    vmcs->blacklist_io_access({0x40, 0x41, 0x42, 0x43, 0x47, 0x7FFF, 0x8000});
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_a()[8] == 0x8F);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_a()[0xFFF] == 0x80);
+    this->expect_true(vmcs->m_io_bitmaps->bitmap_b()[0] == 0x01);
+}
+
+void
+eapis_ut::test_share_io_bitmaps()
+{
+    MockRepository mocks;
+    setup_mm(mocks);
+    auto &&vmcs1 = setup_vmcs();
+    auto &&vmcs2 = setup_vmcs();
+
+    vmcs1->pass_through_all_io_accesses();
+    vmcs1->trap_on_io_access(0x42);
+
+    this->expect_true(vmcs1->m_io_bitmaps == vmcs2->m_io_bitmaps);
+    this->expect_true(vmcs2->m_io_bitmaps->bitmap_a()[8] == 0x4);
+
+    vmcs2->share_io_bitmaps(false);
+    this->expect_true(vmcs1->m_io_bitmaps == vmcs2->m_io_bitmaps);
+
+    vmcs2->pass_through_io_access(0x42);
+    this->expect_true(vmcs1->m_io_bitmaps != vmcs2->m_io_bitmaps);
+    this->expect_true(vmcs1->m_io_bitmaps->bitmap_a()[8] == 0x4);
+    this->expect_true(vmcs2->m_io_bitmaps->bitmap_a()[8] == 0x0);
+
+    vmcs1->trap_on_io_access(0x43);
+    this->expect_true(vmcs1->m_io_bitmaps->bitmap_a()[8] == 0xC);
+    this->expect_true(vmcs2->m_io_bitmaps->bitmap_a()[8] == 0x0);
+
+    vmcs2->share_io_bitmaps(true);
+    this->expect_true(vmcs1->m_io_bitmaps == vmcs2->m_io_bitmaps);
+    this->expect_true(vmcs2->m_io_bitmaps == vmcs_intel_x64_eapis::shared_io_bitmaps());
+
+    vmcs1->pass_through_all_io_accesses();
+}
+
+void
+eapis_ut::test_trap_on_rdmsr_access()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs();
+
+    vmcs->pass_through_all_rdmsr_accesses();
+    vmcs->pass_through_all_wrmsr_accesses();
+
+    vmcs->trap_on_rdmsr_access(0x1B);
+    vmcs->trap_on_rdmsr_access(0xC0000080);
+
+    this->expect_true(vmcs->m_msr_bitmap_view[0x003] == 0x08);
+    this->expect_true(vmcs->m_msr_bitmap_view[0x410] == 0x01);
+    this->expect_true(vmcs->m_msr_bitmap_view[0x803] == 0x00);
+    this->expect_true(vmcs->m_msr_bitmap_view[0xC10] == 0x00);
+
+    this->expect_no_exception([&]{ vmcs->trap_on_rdmsr_access(0x40000000); });
+}
+
+void
+eapis_ut::test_trap_on_wrmsr_access()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs();
+
+    vmcs->pass_through_all_rdmsr_accesses();
+    vmcs->pass_through_all_wrmsr_accesses();
+
+    vmcs->trap_on_wrmsr_access(0x1B);
+    vmcs->trap_on_wrmsr_access(0xC0000080);
+
+    this->expect_true(vmcs->m_msr_bitmap_view[0x003] == 0x00);
+    this->expect_true(vmcs->m_msr_bitmap_view[0x410] == 0x00);
+    this->expect_true(vmcs->m_msr_bitmap_view[0x803] == 0x08);
+    this->expect_true(vmcs->m_msr_bitmap_view[0xC10] == 0x01);
+
+    this->expect_no_exception([&]{ vmcs->trap_on_wrmsr_access(0x40000000); });
+}
+
+void
+eapis_ut::test_trap_on_all_msr_accesses()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs();
+
+    auto all_set = 0xFF;
+    for (auto val : vmcs->m_msr_bitmap_view)
+        all_set &= val;
+
+    this->expect_true(all_set == 0xFF);
+
+    vmcs->pass_through_all_rdmsr_accesses();
+    vmcs->pass_through_all_wrmsr_accesses();
+
+    vmcs->trap_on_all_rdmsr_accesses();
+    this->expect_true(vmcs->m_msr_bitmap_view[0x000] == 0xFF);
+    this->expect_true(vmcs->m_msr_bitmap_view[0x7FF] == 0xFF);
+    this->expect_true(vmcs->m_msr_bitmap_view[0x800] == 0x00);
+
+    vmcs->trap_on_all_wrmsr_accesses();
+    this->expect_true(vmcs->m_msr_bitmap_view[0x800] == 0xFF);
+    this->expect_true(vmcs->m_msr_bitmap_view[0xFFF] == 0xFF);
+}
+
+void
+eapis_ut::test_pass_through_rdmsr_access()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs();
+
+    vmcs->pass_through_rdmsr_access(0x1B);
+    vmcs->pass_through_rdmsr_access(0xC0000080);
+
+    this->expect_true(vmcs->m_msr_bitmap_view[0x003] == 0xF7);
+    this->expect_true(vmcs->m_msr_bitmap_view[0x410] == 0xFE);
+    this->expect_true(vmcs->m_msr_bitmap_view[0x803] == 0xFF);
+    this->expect_true(vmcs->m_msr_bitmap_view[0xC10] == 0xFF);
+
+    this->expect_exception([&] { vmcs->pass_through_rdmsr_access(0x40000000); }, ""_ut_ree);
+    this->expect_exception([&] { vmcs->pass_through_rdmsr_access(0xC0002000); }, ""_ut_ree);
+}
+
+void
+eapis_ut::test_pass_through_wrmsr_access()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs();
+
+    vmcs->pass_through_wrmsr_access(0x1B);
+    vmcs->pass_through_wrmsr_access(0xC0000080);
+
+    this->expect_true(vmcs->m_msr_bitmap_view[0x003] == 0xFF);
+    this->expect_true(vmcs->m_msr_bitmap_view[0x410] == 0xFF);
+    this->expect_true(vmcs->m_msr_bitmap_view[0x803] == 0xF7);
+    this->expect_true(vmcs->m_msr_bitmap_view[0xC10] == 0xFE);
+
+    this->expect_exception([&] { vmcs->pass_through_wrmsr_access(0x2000); }, ""_ut_ree);
+}
+
+void
+eapis_ut::test_pass_through_all_msr_accesses()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs();
+
+    vmcs->pass_through_all_rdmsr_accesses();
+    this->expect_true(vmcs->m_msr_bitmap_view[0x000] == 0x00);
+    this->expect_true(vmcs->m_msr_bitmap_view[0x7FF] == 0x00);
+    this->expect_true(vmcs->m_msr_bitmap_view[0x800] == 0xFF);
+
+    vmcs->pass_through_all_wrmsr_accesses();
+
+    auto all_set = 0x0;
+    for (auto val : vmcs->m_msr_bitmap_view)
+        all_set |= val;
+
+    this->expect_true(all_set == 0x0);
+}
+
+void
+eapis_ut::test_whitelist_msr_access()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs();
+
+    vmcs->whitelist_rdmsr_access({0x1B, 0xC0000080});
+    vmcs->whitelist_wrmsr_access({0x1B});
+
+    this->expect_true(vmcs->m_msr_bitmap_view[0x003] == 0xF7);
+    this->expect_true(vmcs->m_msr_bitmap_view[0x410] == 0xFE);
+    this->expect_true(vmcs->m_msr_bitmap_view[0x803] == 0xF7);
+    this->expect_true(vmcs->m_msr_bitmap_view[0xC10] == 0xFF);
+}
+
+void
+eapis_ut::test_blacklist_msr_access()
+{
+    MockRepository mocks;
+    auto &&vmcs = setup_vmcs();
+
+    vmcs->blacklist_rdmsr_access({0x1B, 0xC0000080});
+    vmcs->blacklist_wrmsr_access({0x1B});
+
+    this->expect_true(vmcs->m_msr_bitmap_view[0x003] == 0x08);
+    this->expect_true(vmcs->m_msr_bitmap_view[0x410] == 0x01);
+    this->expect_true(vmcs->m_msr_bitmap_view[0x803] == 0x08);
+    this->expect_true(vmcs->m_msr_bitmap_view[0xC10] == 0x00);
+}
+
+void
+eapis_ut::test_add_auto_switched_msr()
+{
+    MockRepository mocks;
+    setup_mm(mocks);
+    auto &&vmcs = setup_vmcs();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        vmcs->add_auto_switched_msr(0xC0000082, 0x1111, 0x2222);
+        vmcs->add_auto_switched_msr(0xC0000102, 0x3333, 0x4444);
+
+        this->expect_true(vm_entry_msr_load_count::get() == 2);
+        this->expect_true(vm_exit_msr_store_count::get() == 2);
+        this->expect_true(vm_exit_msr_load_count::get() == 2);
+        this->expect_true(vm_entry_msr_load_address::get() == 0x42000);
+        this->expect_true(vm_exit_msr_store_address::get() == 0x42000);
+        this->expect_true(vm_exit_msr_load_address::get() == 0x42000);
+
+        this->expect_true(vmcs->m_auto_msr_guest_area[0].msr == 0xC0000082);
+        this->expect_true(vmcs->m_auto_msr_guest_area[0].value == 0x1111);
+        this->expect_true(vmcs->m_auto_msr_host_area[0].msr == 0xC0000082);
+        this->expect_true(vmcs->m_auto_msr_host_area[0].value == 0x2222);
+
+        vmcs->add_auto_switched_msr(0xC0000082, 0x5555, 0x6666);
+
+        this->expect_true(vm_entry_msr_load_count::get() == 2);
+        this->expect_true(vmcs->auto_switched_msr_guest_value(0xC0000082) == 0x5555);
+        this->expect_true(vmcs->m_auto_msr_host_area[0].value == 0x6666);
+        this->expect_true(vmcs->auto_switched_msrs() == vmcs_intel_x64_eapis::msr_list_type({0xC0000082, 0xC0000102}));
+
+        this->expect_exception([&] { vmcs->auto_switched_msr_guest_value(0xC0000081); }, ""_ut_ree);
+    });
+}
+
+void
+eapis_ut::test_add_auto_switched_msr_dedicated_fields()
+{
+    MockRepository mocks;
+    setup_mm(mocks);
+    auto &&vmcs = setup_vmcs();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        // The host fields belong to the VMCS setup (i.e. the VMM's own
+        // values), and are left alone.
+
+        host_ia32_efer::set(0x500);
+        host_ia32_pat::set(0x0707);
+
+        vmcs->add_auto_switched_msr(msrs::ia32_efer::addr, 0xD01, 0x1111);
+        vmcs->add_auto_switched_msr(msrs::ia32_pat::addr, 0x0606, 0x2222);
+
+        this->expect_true(guest_ia32_efer::get() == 0xD01);
+        this->expect_true(host_ia32_efer::get() == 0x500);
+        this->expect_true(guest_ia32_pat::get() == 0x0606);
+        this->expect_true(host_ia32_pat::get() == 0x0707);
+
+        this->expect_true(vm_entry_controls::load_ia32_efer::is_enabled());
+        this->expect_true(vm_exit_controls::save_ia32_efer::is_enabled());
+        this->expect_true(vm_exit_controls::load_ia32_efer::is_enabled());
+        this->expect_true(vm_entry_controls::load_ia32_pat::is_enabled());
+        this->expect_true(vm_exit_controls::save_ia32_pat::is_enabled());
+        this->expect_true(vm_exit_controls::load_ia32_pat::is_enabled());
+
+        this->expect_true(vmcs->auto_switched_msr_guest_value(msrs::ia32_efer::addr) == 0xD01);
+        this->expect_true(vmcs->auto_switched_msrs().empty());
+        this->expect_true(vmcs->m_auto_msr_guest_area == nullptr);
+
+        this->expect_exception([&] { vmcs->remove_auto_switched_msr(msrs::ia32_efer::addr); }, ""_ut_lee);
+        this->expect_exception([&] { vmcs->remove_auto_switched_msr(msrs::ia32_pat::addr); }, ""_ut_lee);
+    });
+}
+
+void
+eapis_ut::test_remove_auto_switched_msr()
+{
+    MockRepository mocks;
+    setup_mm(mocks);
+    auto &&vmcs = setup_vmcs();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        this->expect_no_exception([&]{ vmcs->remove_auto_switched_msr(0xC0000082); });
+
+        vmcs->add_auto_switched_msr(0xC0000081, 0x1, 0x2);
+        vmcs->add_auto_switched_msr(0xC0000082, 0x3, 0x4);
+        vmcs->add_auto_switched_msr(0xC0000084, 0x5, 0x6);
+
+        vmcs->remove_auto_switched_msr(0xC0000081);
+
+        this->expect_true(vm_entry_msr_load_count::get() == 2);
+        this->expect_true(vm_exit_msr_store_count::get() == 2);
+        this->expect_true(vm_exit_msr_load_count::get() == 2);
+        this->expect_true(vmcs->m_auto_msr_guest_area[0].msr == 0xC0000084);
+        this->expect_true(vmcs->m_auto_msr_host_area[0].value == 0x6);
+
+        vmcs->remove_auto_switched_msr(0xC0000082);
+        vmcs->remove_auto_switched_msr(0xC0000084);
+
+        this->expect_true(vm_entry_msr_load_count::get() == 0);
+        this->expect_true(vmcs->auto_switched_msrs().empty());
+    });
+}
+
+void
+eapis_ut::test_add_auto_switched_msr_full()
+{
+    MockRepository mocks;
+    setup_mm(mocks);
+    auto &&vmcs = setup_vmcs();
+
+    RUN_UNITTEST_WITH_MOCKS(mocks, [&]
+    {
+        for (auto msr = 0U; msr < vmcs_intel_x64_eapis::max_auto_switched_msrs; msr++)
+            vmcs->add_auto_switched_msr(msr, 0, 0);
+
+        this->expect_exception([&] { vmcs->add_auto_switched_msr(0xC0000082, 0, 0); }, ""_ut_ree);
+        this->expect_no_exception([&]{ vmcs->add_auto_switched_msr(0x0, 1, 1); });
+
+        vmcs->remove_auto_switched_msr(0x0);
+        this->expect_no_exception([&]{ vmcs->add_auto_switched_msr(0xC0000082, 0, 0); });
+    });
 }
 
 void
@@ -246,11 +786,71 @@ eapis_ut::test_enable_ept()
 
     vmcs->enable_ept();
     this->expect_true(ept_pointer::memory_type::get() == ept_pointer::memory_type::write_back);
-    this->expect_true(ept_pointer::page_walk_length_minus_one::get() == 3UL);
+    this->expect_true(ept_pointer::page_walk_length_minus_one::get() == ept::page_walk::page_walk_length - 1UL);
+    this->expect_true(ept_pointer::accessed_and_dirty_flags::is_disabled());
     this->expect_true(ept_pointer::phys_addr::get() != 0);
     this->expect_true(secondary_processor_based_vm_execution_controls::enable_ept::is_enabled());
 }
 
+void
+eapis_ut::test_enable_ept_with_config()
+{
+    MockRepository mocks;
+    setup_mm(mocks);
+    auto &&vmcs = setup_vmcs();
+
+    vmcs->enable_ept({ept::memory_type::uc, true});
+    this->expect_true(ept_pointer::memory_type::get() == ept_pointer::memory_type::uncacheable);
+    this->expect_true(ept_pointer::accessed_and_dirty_flags::is_enabled());
+    this->expect_true(secondary_processor_based_vm_execution_controls::enable_ept::is_enabled());
+
+    vmcs->enable_ept();
+    this->expect_true(ept_pointer::memory_type::get() == ept_pointer::memory_type::write_back);
+    this->expect_true(ept_pointer::accessed_and_dirty_flags::is_disabled());
+}
+
+void
+eapis_ut::test_enable_ept_invalid_config()
+{
+    MockRepository mocks;
+    setup_mm(mocks);
+    auto &&vmcs = setup_vmcs();
+
+    this->expect_exception([&] { vmcs->enable_ept({ept::memory_type::wt, false}); }, ""_ut_ree);
+}
+
+void
+eapis_ut::test_enable_ept_unsupported_config()
+{
+    MockRepository mocks;
+    setup_mm(mocks);
+
+    {
+        auto &&vmcs = setup_vmcs(~msrs::ia32_vmx_ept_vpid_cap::memory_type_uncacheable::mask);
+        this->expect_exception([&] { vmcs->enable_ept({ept::memory_type::uc, false}); }, ""_ut_lee);
+        this->expect_no_exception([&]{ vmcs->enable_ept({ept::memory_type::wb, false}); });
+    }
+
+    {
+        auto &&vmcs = setup_vmcs(~msrs::ia32_vmx_ept_vpid_cap::memory_type_write_back::mask);
+        this->expect_exception([&] { vmcs->enable_ept(); }, ""_ut_lee);
+    }
+
+    {
+        auto &&vmcs = setup_vmcs(~msrs::ia32_vmx_ept_vpid_cap::accessed_dirty_flags::mask);
+        this->expect_exception([&] { vmcs->enable_ept({ept::memory_type::wb, true}); }, ""_ut_lee);
+        this->expect_no_exception([&]{ vmcs->enable_ept({ept::memory_type::wb, false}); });
+    }
+
+    // The capabilities are read when the vmcs is created, so a change to
+    // the MSR afterwards has no effect.
+    {
+        auto &&vmcs = setup_vmcs();
+        g_msrs[intel_x64::msrs::ia32_vmx_ept_vpid_cap::addr] = 0;
+        this->expect_no_exception([&]{ vmcs->enable_ept({ept::memory_type::wb, true}); });
+    }
+}
+
 void
 eapis_ut::test_disable_ept()
 {
@@ -1156,7 +1756,7 @@ eapis_ut::test_setup_ept_identity_map_1g_valid()
     setup_mm(mocks);
     auto &&vmcs = setup_vmcs();
 
-    this->expect_no_exception([&] { vmcs->setup_ept_identity_map_1g(0x0, 0x40000000); });
+    this->expect_no_exception([&]{ vmcs->setup_ept_identity_map_1g(0x0, 0x40000000); });
 
     for (auto virt = 0x0UL; virt < 0x40000000UL; virt += ept::pdpt::size_bytes)
         vmcs->unmap(virt);
@@ -1180,7 +1780,7 @@ eapis_ut::test_setup_ept_identity_map_2m_valid()
     setup_mm(mocks);
     auto &&vmcs = setup_vmcs();
 
-    this->expect_no_exception([&] { vmcs->setup_ept_identity_map_2m(0x0, 0x40000000); });
+    this->expect_no_exception([&]{ vmcs->setup_ept_identity_map_2m(0x0, 0x40000000); });
 
     for (auto virt = 0x0UL; virt < 0x40000000UL; virt += ept::pd::size_bytes)
         vmcs->unmap(virt);
@@ -1204,8 +1804,128 @@ eapis_ut::test_setup_ept_identity_map_4k_valid()
     setup_mm(mocks);
     auto &&vmcs = setup_vmcs();
 
-    this->expect_no_exception([&] { vmcs->setup_ept_identity_map_4k(0x0, 0x40000000); });
+    this->expect_no_exception([&]{ vmcs->setup_ept_identity_map_4k(0x0, 0x40000000); });
 
     for (auto virt = 0x0UL; virt < 0x40000000UL; virt += ept::pt::size_bytes)
         vmcs->unmap(virt);
 }
+
+void
+eapis_ut::test_enable_spp()
+{
+    MockRepository mocks;
+    setup_mm(mocks);
+    auto &&vmcs = setup_vmcs();
+
+    vmcs->enable_ept();
+    vmcs->enable_spp();
+    this->expect_true(spp_table_pointer::get() != 0);
+    this->expect_true(secondary_processor_based_vm_execution_controls::sub_page_write_permissions::is_enabled());
+}
+
+void
+eapis_ut::test_enable_spp_without_ept()
+{
+    MockRepository mocks;
+    setup_mm(mocks);
+    auto &&vmcs = setup_vmcs();
+
+    vmcs->disable_ept();
+    vmcs->disable_spp();
+    this->expect_exception([&] { vmcs->enable_spp(); }, ""_ut_lee);
+    this->expect_true(secondary_processor_based_vm_execution_controls::sub_page_write_permissions::is_disabled());
+}
+
+void
+eapis_ut::test_disable_spp()
+{
+    MockRepository mocks;
+    setup_mm(mocks);
+    auto &&vmcs = setup_vmcs();
+
+    vmcs->disable_spp();
+    this->expect_true(spp_table_pointer::get() == 0);
+    this->expect_true(secondary_processor_based_vm_execution_controls::sub_page_write_permissions::is_disabled());
+}
+
+void
+eapis_ut::test_set_spp_write_mask()
+{
+    MockRepository mocks;
+    setup_mm(mocks);
+    auto &&vmcs = setup_vmcs();
+
+    vmcs->map_4k(0x1000UL, 0x1000UL, ept::memory_attr::pt_wb);
+    vmcs->set_spp_write_mask(0x1000UL, 0x00000001);
+
+    auto &&entry = vmcs->gpa_to_epte(0x1000UL);
+    this->expect_true(entry->read_access());
+    this->expect_false(entry->write_access());
+    this->expect_true(entry->execute_access());
+    this->expect_true(entry->sub_page_write_permissions());
+    this->expect_true(vmcs->sppt()->write_mask(0x1000UL) == 0x00000001);
+
+    vmcs->clear_spp_write_mask(0x1000UL);
+    vmcs->unmap(0x1000UL);
+}
+
+void
+eapis_ut::test_set_spp_write_mask_2m()
+{
+    MockRepository mocks;
+    setup_mm(mocks);
+    auto &&vmcs = setup_vmcs();
+
+    vmcs->map_2m(0x200000UL, 0x200000UL, ept::memory_attr::pt_wb);
+    this->expect_exception([&] { vmcs->set_spp_write_mask(0x200000UL, 0x00000001); }, ""_ut_lee);
+    this->expect_exception([&] { vmcs->set_spp_write_mask(0x40000000UL, 0x00000001); }, ""_ut_ree);
+
+    auto &&entry = vmcs->gpa_to_epte(0x200000UL);
+    this->expect_true(entry->write_access());
+    this->expect_false(entry->sub_page_write_permissions());
+
+    vmcs->unmap(0x200000UL);
+}
+
+void
+eapis_ut::test_clear_spp_write_mask()
+{
+    MockRepository mocks;
+    setup_mm(mocks);
+    auto &&vmcs = setup_vmcs();
+
+    vmcs->map_4k(0x1000UL, 0x1000UL, ept::memory_attr::pt_wb);
+    vmcs->set_spp_write_mask(0x1000UL, 0x00000001);
+    vmcs->clear_spp_write_mask(0x1000UL);
+
+    auto &&entry = vmcs->gpa_to_epte(0x1000UL);
+    this->expect_true(entry->write_access());
+    this->expect_false(entry->sub_page_write_permissions());
+    this->expect_exception([&] { vmcs->sppt()->write_mask(0x1000UL); }, ""_ut_ree);
+    this->expect_exception([&] { vmcs->clear_spp_write_mask(0x1000UL); }, ""_ut_ree);
+
+    vmcs->unmap(0x1000UL);
+}
+
+void
+eapis_ut::test_clear_spp_write_mask_read_only()
+{
+    MockRepository mocks;
+    setup_mm(mocks);
+    auto &&vmcs = setup_vmcs();
+
+    vmcs->map_4k(0x1000UL, 0x1000UL, ept::memory_attr::pt_wb);
+
+    auto &&entry = vmcs->gpa_to_epte(0x1000UL);
+    entry->set_write_access(false);
+
+    vmcs->set_spp_write_mask(0x1000UL, 0x00000001);
+    vmcs->set_spp_write_mask(0x1000UL, 0x00000003);
+    vmcs->clear_spp_write_mask(0x1000UL);
+
+    this->expect_false(entry->write_access());
+    this->expect_false(entry->sub_page_write_permissions());
+    this->expect_true(vmcs->spp_read_only_pages().empty());
+
+    vmcs->unmap(0x1000UL);
+}
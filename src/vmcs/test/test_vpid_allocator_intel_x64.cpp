@@ -0,0 +1,93 @@
+//
+// Bareflank Hypervisor Examples
+//
+// Copyright (C) 2015 Assured Information Security, Inc.
+// Author: Rian Quinn        <quinnr@ainfosec.com>
+// Author: Brendan Kerrigan  <kerriganb@ainfosec.com>
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <test.h>
+#include <vmcs/vpid_allocator_intel_x64.h>
+
+void
+eapis_ut::test_vpid_allocator_intel_x64_allocate()
+{
+    auto &&allocator = std::make_unique<vpid_allocator_intel_x64>();
+    auto recycled = true;
+
+    this->expect_true(allocator->is_allocated(0));
+    this->expect_true(allocator->allocate(recycled) == 1);
+    this->expect_false(recycled);
+    this->expect_true(allocator->allocate(recycled) == 2);
+    this->expect_true(allocator->allocate(recycled) == 3);
+
+    this->expect_true(allocator->allocated() == 3);
+    this->expect_true(allocator->high_water_mark() == 4);
+    this->expect_true(allocator->is_allocated(2));
+    this->expect_false(allocator->is_allocated(4));
+}
+
+void
+eapis_ut::test_vpid_allocator_intel_x64_release()
+{
+    auto &&allocator = std::make_unique<vpid_allocator_intel_x64>();
+    auto recycled = true;
+
+    allocator->allocate(recycled);
+    allocator->allocate(recycled);
+    allocator->release(1);
+
+    this->expect_false(allocator->is_allocated(1));
+    this->expect_true(allocator->allocated() == 1);
+
+    // A released VPID is not handed out again until every other VPID
+    // has been tried.
+
+    this->expect_true(allocator->allocate(recycled) == 3);
+    this->expect_false(recycled);
+
+    this->expect_exception([&] { allocator->release(0); }, ""_ut_ffe);
+    this->expect_exception([&] { allocator->release(1); }, ""_ut_lee);
+}
+
+void
+eapis_ut::test_vpid_allocator_intel_x64_recycle()
+{
+    auto &&allocator = std::make_unique<vpid_allocator_intel_x64>();
+    auto recycled = false;
+
+    for (auto i = 1UL; i < vpid_allocator_intel_x64::num_vpids; i++)
+        allocator->allocate(recycled);
+
+    this->expect_false(recycled);
+    this->expect_true(allocator->allocated() == vpid_allocator_intel_x64::num_vpids - 1);
+    this->expect_exception([&] { allocator->allocate(recycled); }, ""_ut_ree);
+
+    allocator->release(42);
+    allocator->release(0xFFFF);
+
+    this->expect_true(allocator->allocate(recycled) == 42);
+    this->expect_true(recycled);
+    this->expect_true(allocator->allocate(recycled) == 0xFFFF);
+    this->expect_true(recycled);
+}
+
+void
+eapis_ut::test_vpid_allocator_intel_x64_instance()
+{
+    auto &&allocator = &vpid_allocator_intel_x64::instance();
+    this->expect_true(allocator == &vpid_allocator_intel_x64::instance());
+}